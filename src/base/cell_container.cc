@@ -34,21 +34,74 @@
 
 #include "cell_container.hh"
 
+#include <sys/mman.h>
+#include <unistd.h>
 #include <zlib.h>
 
+#include "fs_util.hh"
+#include "paths.hh"
+
 namespace lnav {
 
 static constexpr auto DEFAULT_CHUNK_SIZE = size_t{32 * 1024};
 static constexpr auto NULL_CELL_SUB = 0x1;
 
+/**
+ * Integers are stored using the zigzag encoding of the value so that small
+ * negative numbers are small too.  Values up to INLINE_INT_MAX are stored
+ * in the sub-value of the type byte, offset by INLINE_INT_BASE.  Larger
+ * values are stored in the fewest little-endian bytes that hold them and
+ * the number of bytes is the sub-value.
+ */
+static constexpr uint8_t INLINE_INT_BASE = 9;
+static constexpr uint64_t INLINE_INT_MAX = (0xff >> 2) - INLINE_INT_BASE;
+
 static uint8_t
 combine_type_value(uint8_t type, uint8_t subvalue)
 {
     return type | subvalue << 2U;
 }
 
+static uint64_t
+zigzag_encode(int64_t i)
+{
+    return (static_cast<uint64_t>(i) << 1) ^ static_cast<uint64_t>(i >> 63);
+}
+
+static int64_t
+zigzag_decode(uint64_t u)
+{
+    return static_cast<int64_t>(u >> 1) ^ -static_cast<int64_t>(u & 1);
+}
+
+/** @return The number of bytes after the type byte of an integer cell. */
+static size_t
+int_payload_length(uint8_t sub)
+{
+    if (sub >= INLINE_INT_BASE) {
+        return 0;
+    }
+    return sub;
+}
+
+void
+cell_data_deleter::operator()(unsigned char* data) const
+{
+    if (this->cdd_mapped_size > 0) {
+        munmap(data, this->cdd_mapped_size);
+    } else {
+        delete[] data;
+    }
+}
+
+cell_data_t
+cell_chunk::alloc_data(size_t capacity)
+{
+    return cell_data_t(new unsigned char[capacity]());
+}
+
 cell_chunk::cell_chunk(cell_container* parent,
-                       std::unique_ptr<unsigned char[]> data,
+                       cell_data_t data,
                        size_t capacity)
     : cc_parent(parent), cc_data(std::move(data)), cc_capacity(capacity)
 {
@@ -59,10 +112,14 @@ cell_chunk::reset()
 {
     this->cc_next.reset();
     this->cc_size = 0;
-    if (this->cc_data == nullptr) {
-        this->cc_data = std::make_unique<unsigned char[]>(this->cc_capacity);
+    if (this->cc_data == nullptr
+        || this->cc_data.get_deleter().cdd_mapped_size > 0)
+    {
+        this->cc_data = alloc_data(this->cc_capacity);
     }
     this->cc_compressed.reset();
+    this->cc_compressed_size = 0;
+    this->cc_spill_offset = std::nullopt;
 }
 
 void
@@ -72,7 +129,20 @@ cell_chunk::load() const
         return;
     }
 
-    this->cc_data = std::make_unique<unsigned char[]>(this->cc_capacity);
+    if (this->cc_spill_offset) {
+        auto* mapped = mmap(nullptr,
+                            this->cc_size,
+                            PROT_READ,
+                            MAP_PRIVATE,
+                            this->cc_parent->cc_spill_fd.get(),
+                            this->cc_spill_offset.value());
+        ensure(mapped != MAP_FAILED);
+        this->cc_data = cell_data_t(static_cast<unsigned char*>(mapped),
+                                    cell_data_deleter{this->cc_size});
+        return;
+    }
+
+    this->cc_data = alloc_data(this->cc_capacity);
     uLongf cap = this->cc_capacity;
     auto rc = uncompress(this->cc_data.get(),
                          &cap,
@@ -84,7 +154,7 @@ cell_chunk::load() const
 cell_container::cell_container()
     : cc_first(std::make_unique<cell_chunk>(
           this,
-          std::make_unique<unsigned char[]>(DEFAULT_CHUNK_SIZE),
+          cell_chunk::alloc_data(DEFAULT_CHUNK_SIZE),
           DEFAULT_CHUNK_SIZE)),
       cc_last(cc_first.get()),
       cc_compress_buffer(auto_buffer::alloc(compressBound(DEFAULT_CHUNK_SIZE))),
@@ -99,24 +169,29 @@ cell_container::alloc(size_t amount)
     if (this->cc_last->available() < amount) {
         auto last = this->cc_last;
 
-        auto buflen = compressBound(last->cc_size);
-        if (this->cc_compress_buffer.capacity() < buflen) {
-            this->cc_compress_buffer.expand_to(buflen);
-        }
+        if (this->cc_compressed_bytes < this->cc_memory_budget
+            || !this->spill_chunk(*last))
+        {
+            auto buflen = compressBound(last->cc_size);
+            if (this->cc_compress_buffer.capacity() < buflen) {
+                this->cc_compress_buffer.expand_to(buflen);
+            }
 
-        auto rc = compress2(this->cc_compress_buffer.u_in(),
-                            &buflen,
-                            last->cc_data.get(),
-                            last->cc_size,
-                            2);
-        require(rc == Z_OK);
-        this->cc_compress_buffer.resize(buflen);
-        last->cc_compressed = this->cc_compress_buffer.to_unique();
-        last->cc_compressed_size = buflen;
+            auto rc = compress2(this->cc_compress_buffer.u_in(),
+                                &buflen,
+                                last->cc_data.get(),
+                                last->cc_size,
+                                2);
+            require(rc == Z_OK);
+            this->cc_compress_buffer.resize(buflen);
+            last->cc_compressed = this->cc_compress_buffer.to_unique();
+            last->cc_compressed_size = buflen;
+            this->cc_compressed_bytes += buflen;
+        }
 
         auto chunk_size = std::max(amount, DEFAULT_CHUNK_SIZE);
         if (chunk_size > last->cc_capacity) {
-            last->cc_data = std::make_unique<unsigned char[]>(chunk_size);
+            last->cc_data = cell_chunk::alloc_data(chunk_size);
         }
         last->cc_next = std::make_unique<cell_chunk>(
             this, std::move(last->cc_data), chunk_size);
@@ -145,12 +220,69 @@ cell_container::load_chunk_into_cache(const cell_chunk* cc)
     cc->load();
 }
 
+bool
+cell_container::spill_chunk(cell_chunk& cc)
+{
+    static const auto PAGE_SIZE = static_cast<file_off_t>(getpagesize());
+
+    if (cc.cc_size == 0) {
+        return false;
+    }
+
+    if (!this->cc_spill_fd.has_value()) {
+        std::error_code errc;
+        std::filesystem::create_directories(lnav::paths::workdir(), errc);
+        auto open_res = lnav::filesystem::open_temp_file(
+            lnav::paths::workdir() / "cells.XXXXXX");
+        if (open_res.isErr()) {
+            log_error("unable to create cell spill file: %s",
+                      open_res.unwrapErr().c_str());
+            // Keep everything in memory from now on.
+            this->cc_memory_budget = SIZE_MAX;
+            return false;
+        }
+
+        auto tmp_pair = open_res.unwrap();
+        std::filesystem::remove(tmp_pair.first, errc);
+        this->cc_spill_fd = std::move(tmp_pair.second);
+    }
+
+    size_t written = 0;
+    while (written < cc.cc_size) {
+        auto rc = pwrite(this->cc_spill_fd.get(),
+                         cc.cc_data.get() + written,
+                         cc.cc_size - written,
+                         this->cc_spill_size + written);
+        if (rc <= 0) {
+            log_error("unable to write to cell spill file: %s",
+                      strerror(errno));
+            return false;
+        }
+        written += rc;
+    }
+
+    // Keep the chunks page-aligned so they can be mapped.
+    cc.cc_spill_offset = this->cc_spill_size;
+    this->cc_spill_size
+        += (cc.cc_size + PAGE_SIZE - 1) / PAGE_SIZE * PAGE_SIZE;
+
+    return true;
+}
+
 void
 cell_container::reset()
 {
     this->cc_last = this->cc_first.get();
     this->cc_first->reset();
     this->cc_chunk_cache = {};
+    this->cc_compressed_bytes = 0;
+    if (this->cc_spill_fd.has_value()) {
+        if (ftruncate(this->cc_spill_fd.get(), 0) == -1) {
+            log_error("unable to truncate cell spill file: %s",
+                      strerror(errno));
+        }
+        this->cc_spill_size = 0;
+    }
 }
 
 void
@@ -165,19 +297,27 @@ cell_container::push_null_cell()
 void
 cell_container::push_int_cell(int64_t i)
 {
-    auto* cell_data = this->alloc(1 + 8);
+    auto zz = zigzag_encode(i);
 
     // log_debug("push int %d", i);
-    cell_data[0] = combine_type_value(cell_type::CT_INTEGER, 0);
-    const auto* i_bits = reinterpret_cast<const uint8_t*>(&i);
-    cell_data[1] = i_bits[0];
-    cell_data[2] = i_bits[1];
-    cell_data[3] = i_bits[2];
-    cell_data[4] = i_bits[3];
-    cell_data[5] = i_bits[4];
-    cell_data[6] = i_bits[5];
-    cell_data[7] = i_bits[6];
-    cell_data[8] = i_bits[7];
+    if (zz <= INLINE_INT_MAX) {
+        auto* cell_data = this->alloc(1);
+
+        cell_data[0] = combine_type_value(cell_type::CT_INTEGER,
+                                          INLINE_INT_BASE + zz);
+        return;
+    }
+
+    uint8_t len = 1;
+    while (len < sizeof(zz) && (zz >> (len * 8)) != 0) {
+        len += 1;
+    }
+
+    auto* cell_data = this->alloc(1 + len);
+    cell_data[0] = combine_type_value(cell_type::CT_INTEGER, len);
+    for (uint8_t lpc = 0; lpc < len; lpc++) {
+        cell_data[1 + lpc] = (zz >> (lpc * 8)) & 0xff;
+    }
 }
 
 void
@@ -282,6 +422,8 @@ cell_container::cursor::next() const
             break;
         }
         case cell_type::CT_INTEGER:
+            advance = 1 + int_payload_length(this->get_sub_value());
+            break;
         case cell_type::CT_FLOAT:
             advance = 1 + 8 + this->get_sub_value();
             break;
@@ -357,19 +499,18 @@ cell_container::cursor::get_text() const
 int64_t
 cell_container::cursor::get_int() const
 {
-    int64_t retval = 0;
+    auto sub = this->get_sub_value();
 
-    auto* retval_bits = reinterpret_cast<uint8_t*>(&retval);
-    retval_bits[0] = this->udata()[1];
-    retval_bits[1] = this->udata()[2];
-    retval_bits[2] = this->udata()[3];
-    retval_bits[3] = this->udata()[4];
-    retval_bits[4] = this->udata()[5];
-    retval_bits[5] = this->udata()[6];
-    retval_bits[6] = this->udata()[7];
-    retval_bits[7] = this->udata()[8];
+    if (sub >= INLINE_INT_BASE) {
+        return zigzag_decode(sub - INLINE_INT_BASE);
+    }
 
-    return retval;
+    uint64_t zz = 0;
+    for (size_t lpc = 0; lpc < sub; lpc++) {
+        zz |= static_cast<uint64_t>(this->udata()[1 + lpc]) << (lpc * 8);
+    }
+
+    return zigzag_decode(zz);
 }
 
 double
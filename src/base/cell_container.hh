@@ -35,7 +35,9 @@
 #include <memory>
 #include <optional>
 
+#include "auto_fd.hh"
 #include "auto_mem.hh"
+#include "file_range.hh"
 #include "intern_string.hh"
 #include "lnav_log.hh"
 
@@ -52,10 +54,22 @@ constexpr uint8_t CT_TEXT = 3;
 
 struct cell_container;
 
+/**
+ * Releases the data for a chunk, which is either a heap buffer or a
+ * read-only mapping of the container's spill file.
+ */
+struct cell_data_deleter {
+    size_t cdd_mapped_size{0};
+
+    void operator()(unsigned char* data) const;
+};
+
+using cell_data_t = std::unique_ptr<unsigned char[], cell_data_deleter>;
+
 struct cell_chunk {
-    cell_chunk(cell_container* parent,
-               std::unique_ptr<unsigned char[]> data,
-               size_t capacity);
+    static cell_data_t alloc_data(size_t capacity);
+
+    cell_chunk(cell_container* parent, cell_data_t data, size_t capacity);
 
     size_t available() const { return this->cc_capacity - this->cc_size; }
 
@@ -75,11 +89,13 @@ struct cell_chunk {
 
     cell_container* cc_parent;
     std::unique_ptr<cell_chunk> cc_next;
-    mutable std::unique_ptr<unsigned char[]> cc_data;
+    mutable cell_data_t cc_data;
     const size_t cc_capacity;
     size_t cc_size{0};
     std::unique_ptr<const unsigned char[]> cc_compressed;
     size_t cc_compressed_size{0};
+    /** The offset of the chunk in the spill file, if it was spilled. */
+    std::optional<file_off_t> cc_spill_offset;
 };
 
 struct cell_container {
@@ -159,11 +175,24 @@ struct cell_container {
 
     void load_chunk_into_cache(const cell_chunk* cc);
 
+    bool spill_chunk(cell_chunk& cc);
+
     void reset();
 
+    /**
+     * The amount of compressed chunk data to keep in memory.  Once it is
+     * exceeded, full chunks are written uncompressed to a temporary file
+     * and mapped back in when they are read.
+     */
+    static constexpr size_t DEFAULT_MEMORY_BUDGET = 64 * 1024 * 1024;
+
     std::unique_ptr<cell_chunk> cc_first;
     cell_chunk* cc_last;
     auto_buffer cc_compress_buffer;
+    size_t cc_memory_budget{DEFAULT_MEMORY_BUDGET};
+    size_t cc_compressed_bytes{0};
+    auto_fd cc_spill_fd;
+    file_off_t cc_spill_size{0};
 
     static constexpr size_t CHUNK_CACHE_SIZE = 3;
     std::array<const cell_chunk*, CHUNK_CACHE_SIZE> cc_chunk_cache;
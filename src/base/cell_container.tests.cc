@@ -168,3 +168,85 @@ TEST_CASE("cell_container-basic")
         CHECK(cont.cc_last->cc_data[1] == 'a');
     }
 }
+
+TEST_CASE("cell_container-packed-int")
+{
+    const int64_t values[] = {
+        0,
+        1,
+        -1,
+        27,
+        -27,
+        28,
+        300,
+        -300,
+        int64_t{1} << 40,
+        INT64_MAX,
+        INT64_MIN,
+    };
+
+    auto cont = lnav::cell_container();
+    auto start_cursor = cont.end_cursor();
+    for (auto val : values) {
+        cont.push_int_cell(val);
+        cont.push_null_cell();
+    }
+
+    // Small values fit in the type byte and the rest only use the bytes
+    // they need.
+    const size_t expected_size = 1 + 1 + 1 + 1 + 1 + 2 + 3 + 3 + 7 + 9 + 9;
+    CHECK(cont.cc_last->cc_size == expected_size + std::size(values));
+
+    ArenaAlloc::Alloc<char> arena;
+    auto cell = start_cursor.sync();
+    for (auto val : values) {
+        REQUIRE(cell.has_value());
+        CHECK(cell->get_type() == lnav::cell_type::CT_INTEGER);
+        CHECK(cell->get_int() == val);
+        CHECK(cell->to_string_fragment(arena).to_string()
+              == fmt::to_string(val));
+        cell = cell->next();
+        REQUIRE(cell.has_value());
+        CHECK(cell->get_type() == lnav::cell_type::CT_NULL);
+        cell = cell->next();
+    }
+    CHECK(!cell.has_value());
+}
+
+TEST_CASE("cell_container-spill")
+{
+    auto long_str = std::string();
+    long_str.append(100, 'x');
+    auto str1 = string_fragment::from_str(long_str);
+
+    auto cont = lnav::cell_container();
+    cont.cc_memory_budget = 0;
+    auto start_cursor = cont.end_cursor();
+    for (int lpc = 0; lpc < 1000; lpc++) {
+        cont.push_int_cell(lpc);
+        cont.push_text_cell(str1);
+    }
+
+    CHECK(cont.cc_spill_fd.has_value());
+    CHECK(cont.cc_spill_size > 0);
+    CHECK(cont.cc_compressed_bytes == 0);
+
+    auto cell = start_cursor.sync();
+    auto count = 0;
+    while (cell) {
+        CHECK(cell->get_type() == lnav::cell_type::CT_INTEGER);
+        CHECK(cell->get_int() == count);
+        cell = cell->next();
+        REQUIRE(cell.has_value());
+        CHECK(cell->get_text() == str1);
+        cell = cell->next();
+        count += 1;
+    }
+    CHECK(count == 1000);
+
+    cont.reset();
+    CHECK(cont.cc_spill_size == 0);
+    auto cell1 = cont.end_cursor();
+    cont.push_int_cell(123);
+    CHECK(cell1.get_int() == 123);
+}
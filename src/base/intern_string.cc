@@ -29,7 +29,10 @@
  * @file intern_string.cc
  */
 
+#include <atomic>
+#include <memory>
 #include <mutex>
+#include <vector>
 
 #include "intern_string.hh"
 
@@ -44,13 +47,51 @@
 #include "ww898/cp_utf8.hpp"
 #include "xxHash/xxhash.h"
 
-const static int TABLE_SIZE = 4095;
+/**
+ * The interned strings are spread across shards using the top bits of their
+ * hash.  Each shard is an open-addressed table of pointers that is read
+ * without locking.  Insertions take the shard's lock and, when the table
+ * gets too full, build a larger table and publish it for readers.  The old
+ * tables are kept until exit since readers might still be probing them.
+ */
+static constexpr size_t SHARD_BITS = 6;
+static constexpr size_t SHARD_COUNT = 1U << SHARD_BITS;
+static constexpr size_t INITIAL_SLOTS = 256;
 
 struct intern_string::intern_table {
+    struct slot_array {
+        explicit slot_array(size_t size)
+            : sa_mask(size - 1),
+              sa_slots(std::make_unique<std::atomic<intern_string*>[]>(size))
+        {
+        }
+
+        size_t sa_mask;
+        std::unique_ptr<std::atomic<intern_string*>[]> sa_slots;
+    };
+
+    struct alignas(64) shard {
+        std::atomic<slot_array*> s_slots{nullptr};
+        std::mutex s_mutex;
+        size_t s_count{0};
+        intern_string* s_strings{nullptr};
+        std::vector<std::unique_ptr<slot_array>> s_arrays;
+    };
+
+    intern_table()
+    {
+        for (auto& sh : this->it_shards) {
+            sh.s_arrays.emplace_back(
+                std::make_unique<slot_array>(INITIAL_SLOTS));
+            sh.s_slots.store(sh.s_arrays.back().get(),
+                             std::memory_order_release);
+        }
+    }
+
     ~intern_table()
     {
-        for (auto is : this->it_table) {
-            auto curr = is;
+        for (auto& sh : this->it_shards) {
+            auto curr = sh.s_strings;
 
             while (curr != nullptr) {
                 auto next = curr->is_next;
@@ -61,17 +102,59 @@ struct intern_string::intern_table {
         }
     }
 
-    intern_string* it_table[TABLE_SIZE];
+    static const intern_string* find(const slot_array* sa,
+                                     uint64_t h,
+                                     const char* str,
+                                     size_t len)
+    {
+        for (auto index = h & sa->sa_mask;; index = (index + 1) & sa->sa_mask)
+        {
+            const auto* curr
+                = sa->sa_slots[index].load(std::memory_order_acquire);
+
+            if (curr == nullptr) {
+                return nullptr;
+            }
+            if (curr->is_hash == h && curr->is_str.size() == len
+                && memcmp(curr->is_str.data(), str, len) == 0)
+            {
+                return curr;
+            }
+        }
+    }
+
+    static void insert(slot_array* sa, intern_string* is)
+    {
+        for (auto index = is->is_hash & sa->sa_mask;;
+             index = (index + 1) & sa->sa_mask)
+        {
+            if (sa->sa_slots[index].load(std::memory_order_relaxed)
+                == nullptr)
+            {
+                sa->sa_slots[index].store(is, std::memory_order_release);
+                return;
+            }
+        }
+    }
+
+    shard it_shards[SHARD_COUNT];
 };
 
-intern_table_lifetime
-intern_string::get_table_lifetime()
+static intern_table_lifetime&
+table_holder()
 {
-    static intern_table_lifetime retval = std::make_shared<intern_table>();
+    static intern_table_lifetime retval
+        = std::make_shared<intern_string::intern_table>();
 
     return retval;
 }
 
+intern_table_lifetime
+intern_string::get_table_lifetime()
+{
+    return table_holder();
+}
+
 unsigned long
 hash_str(const char* str, size_t len)
 {
@@ -81,36 +164,50 @@ hash_str(const char* str, size_t len)
 const intern_string*
 intern_string::lookup(const char* str, ssize_t len) noexcept
 {
-    unsigned long h;
-    intern_string* curr;
-
     if (len == -1) {
         len = strlen(str);
     }
-    h = hash_str(str, len) % TABLE_SIZE;
 
-    {
-        static std::mutex table_mutex;
+    static auto* tab = table_holder().get();
+    const uint64_t h = XXH3_64bits(str, len);
+    auto& sh = tab->it_shards[h >> (64 - SHARD_BITS)];
 
-        std::lock_guard<std::mutex> lk(table_mutex);
-        auto tab = get_table_lifetime();
+    const auto* retval = intern_table::find(
+        sh.s_slots.load(std::memory_order_acquire), h, str, len);
+    if (retval != nullptr) {
+        return retval;
+    }
 
-        curr = tab->it_table[h];
-        while (curr != nullptr) {
-            if (static_cast<ssize_t>(curr->is_str.size()) == len
-                && strncmp(curr->is_str.c_str(), str, len) == 0)
-            {
-                return curr;
-            }
-            curr = curr->is_next;
-        }
+    std::lock_guard<std::mutex> lk(sh.s_mutex);
+    auto* sa = sh.s_slots.load(std::memory_order_relaxed);
 
-        curr = new intern_string(str, len);
-        curr->is_next = tab->it_table[h];
-        tab->it_table[h] = curr;
+    // Another thread might have added the string while we were waiting.
+    retval = intern_table::find(sa, h, str, len);
+    if (retval != nullptr) {
+        return retval;
+    }
+
+    auto* curr = new intern_string(str, len);
+    curr->is_hash = h;
+    curr->is_next = sh.s_strings;
+    sh.s_strings = curr;
+    sh.s_count += 1;
 
-        return curr;
+    // Keep the load factor at or below one half so probes stay short.
+    if (sh.s_count * 2 > sa->sa_mask + 1) {
+        auto new_sa = std::make_unique<intern_table::slot_array>(
+            (sa->sa_mask + 1) * 2);
+
+        for (auto* is = sh.s_strings; is != nullptr; is = is->is_next) {
+            intern_table::insert(new_sa.get(), is);
+        }
+        sh.s_slots.store(new_sa.get(), std::memory_order_release);
+        sh.s_arrays.emplace_back(std::move(new_sa));
+    } else {
+        intern_table::insert(sa, curr);
     }
+
+    return curr;
 }
 
 const intern_string*
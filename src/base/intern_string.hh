@@ -899,6 +899,7 @@ private:
     }
 
     intern_string* is_next;
+    uint64_t is_hash{0};
     std::string is_str;
 };
 
@@ -28,12 +28,17 @@
  */
 
 #include <cctype>
+#include <chrono>
+#include <future>
 #include <iostream>
+#include <mutex>
+#include <vector>
 
 #include "intern_string.hh"
 
 #include "config.h"
 #include "doctest/doctest.h"
+#include "fmt/format.h"
 
 TEST_CASE("string_fragment::startswith")
 {
@@ -453,3 +458,176 @@ TEST_CASE("string_fragment::word helpers with wide chars")
         CHECK(sf.curr_word(4) == std::optional<int>(0));
     }
 }
+
+TEST_CASE("intern_string::lookup")
+{
+    auto* is1 = intern_string::lookup("intern-lookup-test");
+    auto* is2 = intern_string::lookup(std::string("intern-lookup-test"));
+    auto* is3 = intern_string::lookup("intern-lookup-test-2");
+
+    CHECK(is1 == is2);
+    CHECK(is1 != is3);
+    CHECK(is1->to_string() == "intern-lookup-test");
+    CHECK(intern_string::lookup("", 0)->size() == 0);
+}
+
+static std::vector<std::string>
+make_intern_keys(const char* prefix, size_t count)
+{
+    std::vector<std::string> retval;
+
+    retval.reserve(count);
+    for (size_t lpc = 0; lpc < count; lpc++) {
+        retval.emplace_back(fmt::format(FMT_STRING("{}-{}"), prefix, lpc));
+    }
+
+    return retval;
+}
+
+TEST_CASE("intern_string::lookup-threaded")
+{
+    static constexpr size_t KEY_COUNT = 50 * 1000;
+    static constexpr size_t THREAD_COUNT = 8;
+
+    auto keys = make_intern_keys("threaded", KEY_COUNT);
+    std::vector<std::future<std::vector<const intern_string*>>> workers;
+
+    for (size_t lpc = 0; lpc < THREAD_COUNT; lpc++) {
+        workers.emplace_back(std::async(std::launch::async, [&keys, lpc]() {
+            std::vector<const intern_string*> retval(keys.size());
+
+            // Each thread walks the keys from a different starting point so
+            // that they race to insert the same strings.
+            for (size_t index = 0; index < keys.size(); index++) {
+                auto key_index = (index + lpc * 997) % keys.size();
+
+                retval[key_index] = intern_string::lookup(keys[key_index]);
+            }
+            return retval;
+        }));
+    }
+
+    auto expected = workers[0].get();
+    for (size_t lpc = 1; lpc < THREAD_COUNT; lpc++) {
+        CHECK(workers[lpc].get() == expected);
+    }
+    for (size_t lpc = 0; lpc < KEY_COUNT; lpc++) {
+        CHECK(expected[lpc]->to_string() == keys[lpc]);
+    }
+}
+
+namespace {
+
+/**
+ * The previous implementation of the intern table, a fixed number of
+ * chained buckets behind a single mutex, kept for comparison.
+ */
+class locked_chained_table {
+public:
+    ~locked_chained_table()
+    {
+        for (auto* curr : this->lct_buckets) {
+            while (curr != nullptr) {
+                auto* next = curr->n_next;
+
+                delete curr;
+                curr = next;
+            }
+        }
+    }
+
+    const std::string* lookup(const std::string& str)
+    {
+        auto h = hash_str(str.data(), str.size()) % BUCKET_COUNT;
+        std::lock_guard<std::mutex> lk(this->lct_mutex);
+
+        for (auto* curr = this->lct_buckets[h]; curr != nullptr;
+             curr = curr->n_next)
+        {
+            if (curr->n_str == str) {
+                return &curr->n_str;
+            }
+        }
+
+        auto* retval = new node{str, this->lct_buckets[h]};
+        this->lct_buckets[h] = retval;
+        return &retval->n_str;
+    }
+
+private:
+    static constexpr size_t BUCKET_COUNT = 4095;
+
+    struct node {
+        std::string n_str;
+        node* n_next;
+    };
+
+    std::mutex lct_mutex;
+    node* lct_buckets[BUCKET_COUNT]{};
+};
+
+template<typename F>
+double
+lookups_per_second(const std::vector<std::string>& keys,
+                   size_t thread_count,
+                   F lookup)
+{
+    static constexpr size_t PASSES = 4;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::future<void>> workers;
+    for (size_t lpc = 0; lpc < thread_count; lpc++) {
+        workers.emplace_back(
+            std::async(std::launch::async, [&keys, &lookup, lpc]() {
+                for (size_t pass = 0; pass < PASSES; pass++) {
+                    for (size_t index = 0; index < keys.size(); index++) {
+                        lookup(keys[(index + lpc * 7919) % keys.size()]);
+                    }
+                }
+            }));
+    }
+    for (auto& worker : workers) {
+        worker.get();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    return (double) (keys.size() * PASSES * thread_count)
+        / std::chrono::duration<double>(end - start).count();
+}
+
+}  // namespace
+
+/**
+ * Compares the throughput of the intern table against a single mutex
+ * protecting chained buckets when looking up a mix of new and existing
+ * strings from several threads.  Run it with:
+ *
+ *   test_base --no-skip -tc="intern_string-benchmark"
+ */
+TEST_CASE("intern_string-benchmark" * doctest::skip())
+{
+    static constexpr size_t KEY_COUNT = 200 * 1000;
+
+    for (const size_t thread_count : {1, 8, 32}) {
+        auto keys = make_intern_keys(
+            fmt::format(FMT_STRING("bench{}"), thread_count).c_str(),
+            KEY_COUNT);
+        locked_chained_table baseline;
+
+        auto baseline_rate = lookups_per_second(
+            keys, thread_count, [&baseline](const std::string& key) {
+                baseline.lookup(key);
+            });
+        auto intern_rate = lookups_per_second(
+            keys, thread_count, [](const std::string& key) {
+                intern_string::lookup(key);
+            });
+
+        MESSAGE(fmt::format(FMT_STRING("{:2} threads: locked-chained {:.2f}M "
+                                       "lookups/s, intern_string {:.2f}M "
+                                       "lookups/s"),
+                            thread_count,
+                            baseline_rate / 1e6,
+                            intern_rate / 1e6));
+    }
+}
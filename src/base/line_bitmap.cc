@@ -0,0 +1,466 @@
+/**
+ * Copyright (c) 2026, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *
+ * @file line_bitmap.cc
+ */
+
+#include <algorithm>
+#include <bit>
+#include <iterator>
+#include <utility>
+
+#include "line_bitmap.hh"
+
+namespace lnav {
+
+bool
+line_bitmap::container::contains(uint16_t low) const
+{
+    if (this->is_bitmap()) {
+        return (this->c_bits[low / 64] >> (low % 64)) & 1;
+    }
+
+    return std::binary_search(this->c_array.begin(), this->c_array.end(), low);
+}
+
+void
+line_bitmap::container::add(uint16_t low)
+{
+    if (this->is_bitmap()) {
+        auto& word = this->c_bits[low / 64];
+        auto bit = uint64_t{1} << (low % 64);
+
+        if (!(word & bit)) {
+            word |= bit;
+            this->c_cardinality += 1;
+        }
+        return;
+    }
+
+    // Lines are usually added in order, so check the end first.
+    if (this->c_array.empty() || this->c_array.back() < low) {
+        this->c_array.push_back(low);
+    } else {
+        auto iter
+            = std::lower_bound(this->c_array.begin(), this->c_array.end(), low);
+        if (*iter == low) {
+            return;
+        }
+        this->c_array.insert(iter, low);
+    }
+    this->c_cardinality += 1;
+    if (this->c_cardinality > ARRAY_MAX) {
+        this->to_bitmap();
+    }
+}
+
+void
+line_bitmap::container::remove(uint16_t low)
+{
+    if (this->is_bitmap()) {
+        auto& word = this->c_bits[low / 64];
+        auto bit = uint64_t{1} << (low % 64);
+
+        if (word & bit) {
+            word &= ~bit;
+            this->c_cardinality -= 1;
+            // Leave some room so a line toggling at the threshold does not
+            // convert the container back and forth.
+            if (this->c_cardinality <= ARRAY_MAX / 2) {
+                this->optimize();
+            }
+        }
+        return;
+    }
+
+    if (this->c_array.empty() || this->c_array.back() < low) {
+        return;
+    }
+    auto iter
+        = std::lower_bound(this->c_array.begin(), this->c_array.end(), low);
+    if (*iter == low) {
+        this->c_array.erase(iter);
+        this->c_cardinality -= 1;
+    }
+}
+
+void
+line_bitmap::container::to_bitmap()
+{
+    this->c_bits.assign(BITMAP_WORDS, 0);
+    for (auto low : this->c_array) {
+        this->c_bits[low / 64] |= uint64_t{1} << (low % 64);
+    }
+    this->c_array.clear();
+    this->c_array.shrink_to_fit();
+}
+
+void
+line_bitmap::container::optimize()
+{
+    if (!this->is_bitmap() || this->c_cardinality > ARRAY_MAX) {
+        return;
+    }
+
+    std::vector<uint16_t> array;
+    array.reserve(this->c_cardinality);
+    for (size_t lpc = 0; lpc < BITMAP_WORDS; lpc++) {
+        auto word = this->c_bits[lpc];
+
+        while (word != 0) {
+            array.push_back(lpc * 64 + std::countr_zero(word));
+            word &= word - 1;
+        }
+    }
+    this->c_array = std::move(array);
+    this->c_bits.clear();
+    this->c_bits.shrink_to_fit();
+}
+
+void
+line_bitmap::container::recount()
+{
+    if (!this->is_bitmap()) {
+        this->c_cardinality = this->c_array.size();
+        return;
+    }
+
+    this->c_cardinality = 0;
+    for (auto word : this->c_bits) {
+        this->c_cardinality += std::popcount(word);
+    }
+}
+
+const line_bitmap::container*
+line_bitmap::find(size_t key) const
+{
+    if (this->lb_last_index < this->lb_containers.size()
+        && this->lb_containers[this->lb_last_index].c_key == key)
+    {
+        return &this->lb_containers[this->lb_last_index];
+    }
+
+    auto iter = std::lower_bound(
+        this->lb_containers.begin(),
+        this->lb_containers.end(),
+        key,
+        [](const container& c, size_t key) { return c.c_key < key; });
+    if (iter == this->lb_containers.end() || iter->c_key != key) {
+        return nullptr;
+    }
+
+    this->lb_last_index = std::distance(this->lb_containers.begin(), iter);
+    return &(*iter);
+}
+
+line_bitmap::container*
+line_bitmap::find(size_t key)
+{
+    return const_cast<container*>(std::as_const(*this).find(key));
+}
+
+bool
+line_bitmap::contains(size_t line) const
+{
+    const auto* c = this->find(line >> CHUNK_BITS);
+
+    return c != nullptr && c->contains(line & (CHUNK_LINES - 1));
+}
+
+void
+line_bitmap::set(size_t line, bool value)
+{
+    auto key = line >> CHUNK_BITS;
+    auto low = static_cast<uint16_t>(line & (CHUNK_LINES - 1));
+
+    if (value) {
+        if (this->lb_containers.empty()
+            || this->lb_containers.back().c_key < key)
+        {
+            auto& c = this->lb_containers.emplace_back();
+
+            c.c_key = key;
+            c.add(low);
+            return;
+        }
+
+        auto* c = this->find(key);
+        if (c == nullptr) {
+            auto iter = std::lower_bound(
+                this->lb_containers.begin(),
+                this->lb_containers.end(),
+                key,
+                [](const container& c, size_t key) { return c.c_key < key; });
+
+            iter = this->lb_containers.emplace(iter);
+            iter->c_key = key;
+            c = &(*iter);
+            this->lb_last_index = 0;
+        }
+        c->add(low);
+        return;
+    }
+
+    auto* c = this->find(key);
+    if (c == nullptr) {
+        return;
+    }
+    c->remove(low);
+    if (c->c_cardinality == 0) {
+        this->lb_containers.erase(this->lb_containers.begin()
+                                  + (c - this->lb_containers.data()));
+        this->lb_last_index = 0;
+    }
+}
+
+void
+line_bitmap::truncate(size_t line_count)
+{
+    auto key = line_count >> CHUNK_BITS;
+    auto low = line_count & (CHUNK_LINES - 1);
+
+    while (!this->lb_containers.empty()
+           && (this->lb_containers.back().c_key > key
+               || (this->lb_containers.back().c_key == key && low == 0)))
+    {
+        this->lb_containers.pop_back();
+    }
+    this->lb_last_index = 0;
+    if (this->lb_containers.empty() || this->lb_containers.back().c_key != key)
+    {
+        return;
+    }
+
+    auto& c = this->lb_containers.back();
+    if (c.is_bitmap()) {
+        c.c_bits[low / 64] &= (uint64_t{1} << (low % 64)) - 1;
+        std::fill(c.c_bits.begin() + low / 64 + 1, c.c_bits.end(), 0);
+        c.recount();
+        c.optimize();
+    } else {
+        c.c_array.erase(
+            std::lower_bound(c.c_array.begin(), c.c_array.end(), low),
+            c.c_array.end());
+        c.recount();
+    }
+    if (c.c_cardinality == 0) {
+        this->lb_containers.pop_back();
+    }
+}
+
+void
+line_bitmap::clear()
+{
+    this->lb_containers.clear();
+    this->lb_last_index = 0;
+}
+
+size_t
+line_bitmap::cardinality() const
+{
+    size_t retval = 0;
+
+    for (const auto& c : this->lb_containers) {
+        retval += c.c_cardinality;
+    }
+
+    return retval;
+}
+
+size_t
+line_bitmap::get_size() const
+{
+    size_t retval = this->lb_containers.capacity() * sizeof(container);
+
+    for (const auto& c : this->lb_containers) {
+        retval += c.c_array.capacity() * sizeof(uint16_t)
+            + c.c_bits.capacity() * sizeof(uint64_t);
+    }
+
+    return retval;
+}
+
+void
+line_bitmap::union_with(const line_bitmap& other, size_t start)
+{
+    auto other_iter = std::lower_bound(
+        other.lb_containers.begin(),
+        other.lb_containers.end(),
+        start >> CHUNK_BITS,
+        [](const container& c, size_t key) { return c.c_key < key; });
+    if (other_iter == other.lb_containers.end()) {
+        return;
+    }
+
+    std::vector<container> merged;
+    auto iter = this->lb_containers.begin();
+
+    merged.reserve(this->lb_containers.size()
+                   + std::distance(other_iter, other.lb_containers.end()));
+    while (iter != this->lb_containers.end()
+           || other_iter != other.lb_containers.end())
+    {
+        if (other_iter == other.lb_containers.end()
+            || (iter != this->lb_containers.end()
+                && iter->c_key < other_iter->c_key))
+        {
+            merged.emplace_back(std::move(*iter));
+            ++iter;
+            continue;
+        }
+        if (iter == this->lb_containers.end()
+            || other_iter->c_key < iter->c_key)
+        {
+            merged.emplace_back(*other_iter);
+            ++other_iter;
+            continue;
+        }
+
+        auto& dst = merged.emplace_back(std::move(*iter));
+        const auto& src = *other_iter;
+        if (dst.is_bitmap()) {
+            if (src.is_bitmap()) {
+                for (size_t lpc = 0; lpc < BITMAP_WORDS; lpc++) {
+                    dst.c_bits[lpc] |= src.c_bits[lpc];
+                }
+                dst.recount();
+            } else {
+                for (auto low : src.c_array) {
+                    dst.add(low);
+                }
+            }
+        } else if (src.is_bitmap()) {
+            auto array = std::move(dst.c_array);
+
+            dst.c_array.clear();
+            dst.c_bits = src.c_bits;
+            dst.c_cardinality = src.c_cardinality;
+            for (auto low : array) {
+                dst.add(low);
+            }
+        } else {
+            std::vector<uint16_t> array;
+
+            array.reserve(dst.c_array.size() + src.c_array.size());
+            std::set_union(dst.c_array.begin(),
+                           dst.c_array.end(),
+                           src.c_array.begin(),
+                           src.c_array.end(),
+                           std::back_inserter(array));
+            dst.c_array = std::move(array);
+            dst.recount();
+            if (dst.c_cardinality > ARRAY_MAX) {
+                dst.to_bitmap();
+            }
+        }
+        ++iter;
+        ++other_iter;
+    }
+
+    this->lb_containers = std::move(merged);
+    this->lb_last_index = 0;
+}
+
+void
+line_bitmap::intersect_with(const line_bitmap& other)
+{
+    std::vector<container> kept;
+
+    for (auto& dst : this->lb_containers) {
+        const auto* src = other.find(dst.c_key);
+        if (src == nullptr) {
+            continue;
+        }
+
+        if (!dst.is_bitmap()) {
+            std::erase_if(dst.c_array,
+                          [src](uint16_t low) { return !src->contains(low); });
+        } else if (src->is_bitmap()) {
+            for (size_t lpc = 0; lpc < BITMAP_WORDS; lpc++) {
+                dst.c_bits[lpc] &= src->c_bits[lpc];
+            }
+        } else {
+            std::vector<uint16_t> array;
+
+            for (auto low : src->c_array) {
+                if (dst.contains(low)) {
+                    array.push_back(low);
+                }
+            }
+            dst.c_bits.clear();
+            dst.c_bits.shrink_to_fit();
+            dst.c_array = std::move(array);
+        }
+        dst.recount();
+        dst.optimize();
+        if (dst.c_cardinality > 0) {
+            kept.emplace_back(std::move(dst));
+        }
+    }
+
+    this->lb_containers = std::move(kept);
+    this->lb_last_index = 0;
+}
+
+void
+line_bitmap::subtract(const line_bitmap& other)
+{
+    std::vector<container> kept;
+
+    kept.reserve(this->lb_containers.size());
+    for (auto& dst : this->lb_containers) {
+        const auto* src = other.find(dst.c_key);
+
+        if (src != nullptr) {
+            if (!dst.is_bitmap()) {
+                std::erase_if(dst.c_array, [src](uint16_t low) {
+                    return src->contains(low);
+                });
+            } else if (src->is_bitmap()) {
+                for (size_t lpc = 0; lpc < BITMAP_WORDS; lpc++) {
+                    dst.c_bits[lpc] &= ~src->c_bits[lpc];
+                }
+            } else {
+                for (auto low : src->c_array) {
+                    dst.c_bits[low / 64] &= ~(uint64_t{1} << (low % 64));
+                }
+            }
+            dst.recount();
+            dst.optimize();
+        }
+        if (dst.c_cardinality > 0) {
+            kept.emplace_back(std::move(dst));
+        }
+    }
+
+    this->lb_containers = std::move(kept);
+    this->lb_last_index = 0;
+}
+
+}  // namespace lnav
@@ -0,0 +1,124 @@
+/**
+ * Copyright (c) 2026, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *
+ * @file line_bitmap.hh
+ */
+
+#ifndef lnav_line_bitmap_hh
+#define lnav_line_bitmap_hh
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace lnav {
+
+/**
+ * A compressed set of line numbers in the style of a roaring bitmap.  The
+ * line numbers are split into chunks of 2^16 and each chunk that has a
+ * line in the set is stored in a container.  A container is a sorted array
+ * of the low 16 bits of the lines when it is sparse and a plain bitmap when
+ * it has more than ARRAY_MAX lines.  An empty range of lines takes no space
+ * and a dense one takes one bit per line.
+ */
+class line_bitmap {
+public:
+    /** The most lines in an array container before it becomes a bitmap. */
+    static constexpr size_t ARRAY_MAX = 4096;
+
+    bool contains(size_t line) const;
+
+    /** Add or remove a line from the set. */
+    void set(size_t line, bool value);
+
+    /** Remove the lines at or after the given line. */
+    void truncate(size_t line_count);
+
+    void clear();
+
+    bool empty() const { return this->lb_containers.empty(); }
+
+    /** @return The number of lines in the set. */
+    size_t cardinality() const;
+
+    /** @return The approximate amount of memory used by the set. */
+    size_t get_size() const;
+
+    /**
+     * Add the lines in the other set.  Only the lines in the chunks at or
+     * after the chunk containing the start line are added.
+     */
+    void union_with(const line_bitmap& other, size_t start = 0);
+
+    /** Keep only the lines that are also in the other set. */
+    void intersect_with(const line_bitmap& other);
+
+    /** Remove the lines that are in the other set. */
+    void subtract(const line_bitmap& other);
+
+private:
+    static constexpr size_t CHUNK_BITS = 16;
+    static constexpr size_t CHUNK_LINES = size_t{1} << CHUNK_BITS;
+    static constexpr size_t BITMAP_WORDS = CHUNK_LINES / 64;
+
+    struct container {
+        size_t c_key{0};
+        uint32_t c_cardinality{0};
+        /** The sorted lines in the chunk, used when c_bits is empty. */
+        std::vector<uint16_t> c_array;
+        std::vector<uint64_t> c_bits;
+
+        bool is_bitmap() const { return !this->c_bits.empty(); }
+
+        bool contains(uint16_t low) const;
+
+        void add(uint16_t low);
+
+        void remove(uint16_t low);
+
+        void to_bitmap();
+
+        /** Switch to an array if the container has become sparse. */
+        void optimize();
+
+        void recount();
+    };
+
+    container* find(size_t key);
+
+    const container* find(size_t key) const;
+
+    std::vector<container> lb_containers;
+    /** The position of the last container that was looked up. */
+    mutable size_t lb_last_index{0};
+};
+
+}  // namespace lnav
+
+#endif
@@ -0,0 +1,200 @@
+/**
+ * Copyright (c) 2026, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <random>
+#include <set>
+
+#include "line_bitmap.hh"
+
+#include "doctest/doctest.h"
+
+namespace {
+
+void
+check_same(const lnav::line_bitmap& lb, const std::set<size_t>& expected)
+{
+    CHECK(lb.cardinality() == expected.size());
+    for (auto line : expected) {
+        CHECK(lb.contains(line));
+        CHECK_FALSE(lb.contains(line + 1) != (expected.count(line + 1) > 0));
+    }
+}
+
+std::set<size_t>
+random_lines(std::mt19937& gen, size_t count, size_t max)
+{
+    std::uniform_int_distribution<size_t> dist(0, max);
+    std::set<size_t> retval;
+
+    while (retval.size() < count) {
+        retval.insert(dist(gen));
+    }
+
+    return retval;
+}
+
+}  // namespace
+
+TEST_CASE("line_bitmap-set")
+{
+    lnav::line_bitmap lb;
+
+    CHECK(lb.empty());
+    CHECK_FALSE(lb.contains(0));
+
+    lb.set(10, true);
+    lb.set(5, true);
+    lb.set(70000, true);
+    lb.set(10, true);
+    CHECK(lb.cardinality() == 3);
+    CHECK(lb.contains(5));
+    CHECK(lb.contains(10));
+    CHECK(lb.contains(70000));
+    CHECK_FALSE(lb.contains(11));
+    CHECK_FALSE(lb.contains(65536 + 5));
+
+    lb.set(10, false);
+    lb.set(12, false);
+    CHECK_FALSE(lb.contains(10));
+    CHECK(lb.cardinality() == 2);
+
+    lb.set(70000, false);
+    lb.set(5, false);
+    CHECK(lb.empty());
+}
+
+TEST_CASE("line_bitmap-dense")
+{
+    lnav::line_bitmap lb;
+    std::set<size_t> expected;
+
+    // Every other line goes past the array limit, so the chunk becomes a
+    // bitmap.
+    for (size_t line = 0; line < 3 * lnav::line_bitmap::ARRAY_MAX; line += 2)
+    {
+        lb.set(line, true);
+        expected.insert(line);
+    }
+    check_same(lb, expected);
+    CHECK(lb.get_size() >= 8 * 1024);
+
+    // Removing most of the lines switches back to an array.
+    for (size_t line = 0; line < 3 * lnav::line_bitmap::ARRAY_MAX; line += 2)
+    {
+        if (line % 16 != 0) {
+            lb.set(line, false);
+            expected.erase(line);
+        }
+    }
+    check_same(lb, expected);
+    CHECK(lb.get_size() < 8 * 1024);
+}
+
+TEST_CASE("line_bitmap-truncate")
+{
+    lnav::line_bitmap lb;
+
+    for (size_t line = 0; line < 200000; line += 3) {
+        lb.set(line, true);
+    }
+
+    lb.truncate(150001);
+    CHECK(lb.contains(150000));
+    CHECK_FALSE(lb.contains(150003));
+    CHECK(lb.cardinality() == 50001);
+
+    lb.truncate(131072);
+    CHECK(lb.contains(131070));
+    CHECK_FALSE(lb.contains(131073));
+
+    lb.truncate(0);
+    CHECK(lb.empty());
+}
+
+TEST_CASE("line_bitmap-ops")
+{
+    std::mt19937 gen(1234);
+
+    // Mix sparse and dense chunks so every pair of container kinds is
+    // combined.
+    for (auto count : {100, 5000, 50000}) {
+        auto lhs_lines = random_lines(gen, count, 200000);
+        auto rhs_lines = random_lines(gen, 20000, 150000);
+        lnav::line_bitmap lhs;
+        lnav::line_bitmap rhs;
+
+        for (auto line : lhs_lines) {
+            lhs.set(line, true);
+        }
+        for (auto line : rhs_lines) {
+            rhs.set(line, true);
+        }
+
+        {
+            auto res = lhs;
+            std::set<size_t> expected = lhs_lines;
+
+            res.union_with(rhs);
+            expected.insert(rhs_lines.begin(), rhs_lines.end());
+            check_same(res, expected);
+        }
+        {
+            auto res = lhs;
+            std::set<size_t> expected;
+
+            res.intersect_with(rhs);
+            for (auto line : lhs_lines) {
+                if (rhs_lines.count(line)) {
+                    expected.insert(line);
+                }
+            }
+            check_same(res, expected);
+        }
+        {
+            auto res = lhs;
+            std::set<size_t> expected;
+
+            res.subtract(rhs);
+            for (auto line : lhs_lines) {
+                if (!rhs_lines.count(line)) {
+                    expected.insert(line);
+                }
+            }
+            check_same(res, expected);
+        }
+        {
+            lnav::line_bitmap res;
+
+            res.union_with(rhs, 100000);
+            CHECK(res.contains(*rhs_lines.lower_bound(100000)));
+            CHECK_FALSE(res.contains(*rhs_lines.begin()));
+        }
+    }
+}
@@ -0,0 +1,168 @@
+/**
+ * Copyright (c) 2025, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef lnav_radix_sort_hh
+#define lnav_radix_sort_hh
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <future>
+#include <vector>
+
+namespace lnav {
+
+/**
+ * Map a signed 64-bit value to an unsigned key with the same ordering.
+ */
+inline uint64_t
+radix_key(int64_t value)
+{
+    return static_cast<uint64_t>(value) ^ (1ULL << 63);
+}
+
+/**
+ * Stable least-significant-digit radix sort of the given elements by an
+ * unsigned 64-bit key.  Bytes that are the same for all the keys are
+ * skipped, so timestamps that are close together only take a few passes.
+ * Each pass is split across up to `max_threads` threads.
+ *
+ * @param elems The elements to sort.
+ * @param key_of A function that returns the key for an element.
+ * @param max_threads The maximum number of threads to use.
+ */
+template<typename T, typename F>
+void
+radix_sort(std::vector<T>& elems, F key_of, size_t max_threads = 1)
+{
+    static constexpr size_t MIN_ELEMS_PER_THREAD = 64 * 1024;
+
+    const auto count = elems.size();
+    if (count < 2) {
+        return;
+    }
+
+    const auto thread_count = std::max(
+        size_t{1}, std::min(max_threads, count / MIN_ELEMS_PER_THREAD));
+    const auto chunk_size = (count + thread_count - 1) / thread_count;
+    auto for_each_chunk = [&](auto func) {
+        std::vector<std::future<void>> workers;
+
+        for (size_t lpc = 1; lpc < thread_count; lpc++) {
+            auto start = std::min(count, lpc * chunk_size);
+            auto end = std::min(count, start + chunk_size);
+
+            workers.emplace_back(std::async(
+                std::launch::async, [&func, lpc, start, end]() {
+                    func(lpc, start, end);
+                }));
+        }
+        func(0, 0, std::min(count, chunk_size));
+        for (auto& worker : workers) {
+            worker.get();
+        }
+    };
+
+    std::vector<uint64_t> chunk_or(thread_count, 0);
+    std::vector<uint64_t> chunk_and(thread_count, ~0ULL);
+    for_each_chunk([&](size_t chunk, size_t start, size_t end) {
+        uint64_t key_or = 0, key_and = ~0ULL;
+
+        for (auto lpc = start; lpc < end; lpc++) {
+            auto key = key_of(elems[lpc]);
+
+            key_or |= key;
+            key_and &= key;
+        }
+        chunk_or[chunk] = key_or;
+        chunk_and[chunk] = key_and;
+    });
+
+    uint64_t key_or = 0, key_and = ~0ULL;
+    for (size_t lpc = 0; lpc < thread_count; lpc++) {
+        key_or |= chunk_or[lpc];
+        key_and &= chunk_and[lpc];
+    }
+    const auto differing_bits = key_or ^ key_and;
+    if (differing_bits == 0) {
+        return;
+    }
+
+    std::vector<T> scratch(count);
+    auto* src = &elems;
+    auto* dst = &scratch;
+    std::vector<std::array<size_t, 256>> offsets(thread_count);
+
+    for (unsigned int shift = 0; shift < 64; shift += 8) {
+        if (((differing_bits >> shift) & 0xff) == 0) {
+            continue;
+        }
+
+        for_each_chunk([&](size_t chunk, size_t start, size_t end) {
+            auto& hist = offsets[chunk];
+
+            hist.fill(0);
+            for (auto lpc = start; lpc < end; lpc++) {
+                hist[(key_of((*src)[lpc]) >> shift) & 0xff] += 1;
+            }
+        });
+
+        // Elements from earlier chunks go first within a bucket to keep
+        // the sort stable.
+        size_t next_offset = 0;
+        for (size_t bucket = 0; bucket < 256; bucket++) {
+            for (size_t chunk = 0; chunk < thread_count; chunk++) {
+                auto bucket_size = offsets[chunk][bucket];
+
+                offsets[chunk][bucket] = next_offset;
+                next_offset += bucket_size;
+            }
+        }
+
+        for_each_chunk([&](size_t chunk, size_t start, size_t end) {
+            auto& next = offsets[chunk];
+
+            for (auto lpc = start; lpc < end; lpc++) {
+                auto& elem = (*src)[lpc];
+
+                (*dst)[next[(key_of(elem) >> shift) & 0xff]++] = elem;
+            }
+        });
+
+        std::swap(src, dst);
+    }
+
+    if (src != &elems) {
+        elems.swap(scratch);
+    }
+}
+
+}  // namespace lnav
+
+#endif
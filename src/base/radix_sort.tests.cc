@@ -0,0 +1,168 @@
+/**
+ * Copyright (c) 2025, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <thread>
+
+#include "base/radix_sort.hh"
+
+#include "doctest/doctest.h"
+
+namespace {
+
+struct timed_line {
+    int64_t tl_time;
+    uint32_t tl_line;
+};
+
+std::vector<timed_line>
+make_jittered_lines(size_t count)
+{
+    std::mt19937_64 rng(count);
+    std::uniform_int_distribution<int64_t> jitter(-5000000, 5000000);
+    std::vector<timed_line> retval(count);
+    int64_t base_time = 1700000000000000LL;
+
+    for (size_t lpc = 0; lpc < count; lpc++) {
+        base_time += 1000;
+        retval[lpc] = {base_time + jitter(rng), static_cast<uint32_t>(lpc)};
+    }
+
+    return retval;
+}
+
+bool
+timed_line_lt(const timed_line& lhs, const timed_line& rhs)
+{
+    return lhs.tl_time < rhs.tl_time
+        || (lhs.tl_time == rhs.tl_time && lhs.tl_line < rhs.tl_line);
+}
+
+auto timed_line_key
+    = [](const timed_line& tl) { return lnav::radix_key(tl.tl_time); };
+
+}  // namespace
+
+TEST_CASE("radix_sort-basic")
+{
+    std::vector<timed_line> lines = {
+        {30, 0},
+        {-10, 1},
+        {20, 2},
+        {-10, 3},
+        {0, 4},
+        {30, 5},
+    };
+
+    lnav::radix_sort(lines, timed_line_key);
+
+    std::vector<uint32_t> order;
+    for (const auto& tl : lines) {
+        order.emplace_back(tl.tl_line);
+    }
+    CHECK(order == std::vector<uint32_t>{1, 3, 4, 2, 0, 5});
+}
+
+TEST_CASE("radix_sort-same-keys")
+{
+    std::vector<timed_line> lines = {{5, 2}, {5, 0}, {5, 1}};
+
+    lnav::radix_sort(lines, timed_line_key, 4);
+
+    CHECK(lines[0].tl_line == 2);
+    CHECK(lines[1].tl_line == 0);
+    CHECK(lines[2].tl_line == 1);
+}
+
+TEST_CASE("radix_sort-threaded")
+{
+    auto lines = make_jittered_lines(500 * 1000);
+    auto expected = lines;
+
+    std::stable_sort(expected.begin(), expected.end(), timed_line_lt);
+    lnav::radix_sort(lines, timed_line_key, 8);
+
+    CHECK(std::equal(lines.begin(),
+                     lines.end(),
+                     expected.begin(),
+                     [](const auto& lhs, const auto& rhs) {
+                         return lhs.tl_line == rhs.tl_line;
+                     }));
+}
+
+/**
+ * Compares sorting the lines of a large, slightly out-of-order log by
+ * looking up each line's time, like the logfile_sub_source comparator
+ * does, against radix sorting (time, line) pairs.  Run it with:
+ *
+ *   test_base --no-skip -tc="radix_sort-benchmark"
+ */
+TEST_CASE("radix_sort-benchmark" * doctest::skip())
+{
+    static constexpr size_t LINE_COUNT = 100 * 1000 * 1000;
+
+    auto lines = make_jittered_lines(LINE_COUNT);
+    std::vector<int64_t> times(LINE_COUNT);
+    std::vector<uint32_t> line_numbers(LINE_COUNT);
+
+    for (size_t lpc = 0; lpc < LINE_COUNT; lpc++) {
+        times[lpc] = lines[lpc].tl_time;
+        line_numbers[lpc] = lpc;
+    }
+
+    auto std_start = std::chrono::steady_clock::now();
+    std::sort(line_numbers.begin(),
+              line_numbers.end(),
+              [&times](const auto lhs, const auto rhs) {
+                  return times[lhs] < times[rhs]
+                      || (times[lhs] == times[rhs] && lhs < rhs);
+              });
+    auto std_end = std::chrono::steady_clock::now();
+
+    auto radix_start = std::chrono::steady_clock::now();
+    lnav::radix_sort(
+        lines, timed_line_key, std::thread::hardware_concurrency());
+    auto radix_end = std::chrono::steady_clock::now();
+
+    MESSAGE("std::sort of " << LINE_COUNT << " lines: "
+                            << std::chrono::duration_cast<
+                                   std::chrono::milliseconds>(std_end
+                                                              - std_start)
+                                   .count()
+                            << "ms");
+    MESSAGE("radix_sort of " << LINE_COUNT << " lines: "
+                             << std::chrono::duration_cast<
+                                    std::chrono::milliseconds>(radix_end
+                                                               - radix_start)
+                                    .count()
+                             << "ms");
+    CHECK(std::is_sorted(lines.begin(), lines.end(), timed_line_lt));
+}
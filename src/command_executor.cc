@@ -70,6 +70,10 @@ using namespace lnav::roles::literals;
 exec_context INIT_EXEC_CONTEXT;
 
 static sig_atomic_t sql_counter = 0;
+/** The number of rows of the running query that the DB view is showing. */
+static size_t sql_shown_rows = 0;
+/** True if the running query is filling in the DB view's rows. */
+static bool sql_streaming_to_db = false;
 
 int
 sql_progress(const log_cursor& lc)
@@ -83,11 +87,29 @@ sql_progress(const log_cursor& lc)
     }
 
     if (ui_periodic_timer::singleton().time_to_update(sql_counter)) {
+        const auto& dls = lnav_data.ld_db_row_source;
+        auto* db_tc = &lnav_data.ld_views[LNV_DB];
+        // If the query is filling in the DB view, switch to it as soon
+        // as there is more than one row, which is when the view would
+        // be shown once the query finished anyway, and show the rows
+        // that have been returned so far instead of blocking until the
+        // whole query is done.
+        if (sql_streaming_to_db && dls.dls_row_cursors.size() > 1
+            && lnav_data.ld_view_stack.top() != db_tc)
+        {
+            ensure_view(db_tc);
+        }
+        auto streaming = sql_streaming_to_db
+            && lnav_data.ld_view_stack.top() == db_tc;
         auto* breadcrumb_view = injector::get<breadcrumb_curses*>();
         breadcrumb_view->set_enabled(false);
         lnav_data.ld_status[LNS_TOP].set_enabled(false);
         lnav_data.ld_view_stack.top() |
-            [](auto* tc) { tc->set_enabled(false); };
+            [streaming](auto* tc) { tc->set_enabled(streaming); };
+        if (streaming && dls.dls_row_cursors.size() > sql_shown_rows) {
+            sql_shown_rows = dls.dls_row_cursors.size();
+            db_tc->reload_data();
+        }
         ssize_t total = lnav_data.ld_log_source.text_line_count();
         off_t off = lc.lc_curr_line;
 
@@ -109,6 +131,8 @@ sql_progress(const log_cursor& lc)
 void
 sql_progress_finished()
 {
+    sql_shown_rows = 0;
+    sql_streaming_to_db = false;
     if (sql_counter == 0) {
         return;
     }
@@ -384,6 +408,7 @@ execute_sql(exec_context& ec, const std::string& sql, std::string& alt_msg)
     }
 
     ec.ec_accumulator->clear();
+    sql_streaming_to_db = false;
 
     require(!ec.ec_source.empty());
     const auto& source = ec.ec_source.back();
@@ -467,6 +492,8 @@ execute_sql(exec_context& ec, const std::string& sql, std::string& alt_msg)
                     dls.dls_user_query_vars.clear();
                 }
                 dls.dls_query_start = std::chrono::system_clock::now();
+                sql_streaming_to_db = ec.ec_sql_callback == sql_callback
+                    && &dls == &lnav_data.ld_db_row_source;
                 auto* vtab_mgr = injector::get<log_vtab_manager*>();
                 dls.dls_query_touches_log_data
                     = vtab_mgr->has_log_backed_table(touched_tables);
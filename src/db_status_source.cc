@@ -108,6 +108,12 @@ db_status_source::update_from_db_source()
                 .append(lnav::roles::number(dur));
         } else {
             timing_al.append("started ").append(lnav::roles::time_ago(ago));
+            if (!dls.dls_row_cursors.empty()) {
+                timing_al.append(" with ")
+                    .append(lnav::roles::number(
+                        fmt::to_string(dls.dls_row_cursors.size())))
+                    .append(" rows so far");
+            }
         }
         timing_al.append(" ");
         changed |= this->dss_fields[DSF_TIMING].set_value(timing_al);
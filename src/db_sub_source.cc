@@ -29,6 +29,7 @@
 
 #include <iterator>
 #include <map>
+#include <numeric>
 
 #include "db_sub_source.hh"
 
@@ -674,6 +675,10 @@ db_label_source::clear()
     this->dls_cell_allocator.reset();
     this->dls_header_allocator.reset();
     this->dls_step_rc = SQLITE_OK;
+    this->dls_column_keys.clear();
+    this->dls_query_rows = std::nullopt;
+    this->dls_row_order.clear();
+    this->dls_sort_column = std::nullopt;
     if (this->tss_view != nullptr) {
         this->tss_view->get_bookmarks().clear();
     }
@@ -727,6 +732,30 @@ db_label_source::text_handle_mouse(
 static constexpr string_attr_type<std::string> DBA_DETAILS("details");
 static constexpr string_attr_type<std::string> DBA_COLUMN_NAME("column-name");
 
+static std::optional<size_t>
+column_for_overlay_selection(db_label_source& dls, listview_curses& lv)
+{
+    auto ov_sel = lv.get_overlay_selection();
+    if (!ov_sel) {
+        return std::nullopt;
+    }
+
+    std::vector<attr_line_t> rows;
+    auto* ov_source = lv.get_overlay_source();
+    ov_source->list_value_for_overlay(lv, lv.get_selection().value(), rows);
+    if (ov_sel.value() >= (ssize_t) rows.size()) {
+        return std::nullopt;
+    }
+
+    auto& row_al = rows[ov_sel.value()];
+    auto col_attr = get_string_attr(row_al.al_attrs, DBA_COLUMN_NAME);
+    if (!col_attr) {
+        return std::nullopt;
+    }
+
+    return dls.column_name_to_index(col_attr.value().get());
+}
+
 bool
 db_label_source::list_input_handle_key(listview_curses& lv, const ncinput& ch)
 {
@@ -734,22 +763,10 @@ db_label_source::list_input_handle_key(listview_curses& lv, const ncinput& ch)
         case ' ': {
             auto ov_sel = lv.get_overlay_selection();
             if (ov_sel) {
-                std::vector<attr_line_t> rows;
-                auto* ov_source = lv.get_overlay_source();
-                ov_source->list_value_for_overlay(
-                    lv, lv.get_selection().value(), rows);
-                if (ov_sel.value() < (ssize_t) rows.size()) {
-                    auto& row_al = rows[ov_sel.value()];
-                    auto col_attr
-                        = get_string_attr(row_al.al_attrs, DBA_COLUMN_NAME);
-                    if (col_attr) {
-                        auto col_name = col_attr.value().get();
-                        auto col_opt = this->column_name_to_index(col_name);
-                        if (col_opt) {
-                            this->dls_headers[col_opt.value()].hm_hidden
-                                = !this->dls_headers[col_opt.value()].hm_hidden;
-                        }
-                    }
+                auto col_opt = column_for_overlay_selection(*this, lv);
+                if (col_opt) {
+                    this->dls_headers[col_opt.value()].hm_hidden
+                        = !this->dls_headers[col_opt.value()].hm_hidden;
                 }
                 lv.set_needs_update();
 
@@ -757,6 +774,38 @@ db_label_source::list_input_handle_key(listview_curses& lv, const ncinput& ch)
             }
             break;
         }
+        case 's':
+        case 'f':
+        case 'S': {
+            auto ov_sel = lv.get_overlay_selection();
+            if (!ov_sel) {
+                break;
+            }
+            if (!this->dls_query_end.has_value()) {
+                // The rows are still being added by the query.
+                return true;
+            }
+
+            if (ch.eff_text[0] == 'S') {
+                this->reset_row_order();
+            } else {
+                auto col_opt = column_for_overlay_selection(*this, lv);
+                if (!col_opt) {
+                    return true;
+                }
+
+                if (ch.eff_text[0] == 's') {
+                    this->toggle_sort_rows(col_opt.value());
+                } else {
+                    auto sel = lv.get_selection().value();
+                    this->filter_rows(col_opt.value(), sel);
+                    lv.set_selection(0_vl);
+                }
+            }
+            lv.reload_data();
+
+            return true;
+        }
     }
 
     return false;
@@ -1059,6 +1108,231 @@ db_label_source::reset_user_state()
     for (auto& hm : this->dls_headers) {
         hm.hm_hidden = false;
     }
+    this->reset_row_order();
+}
+
+bool
+db_label_source::column_keys::less(size_t lhs, size_t rhs) const
+{
+    if (this->ck_class[lhs] != this->ck_class[rhs]) {
+        return this->ck_class[lhs] < this->ck_class[rhs];
+    }
+
+    switch (this->ck_class[lhs]) {
+        case key_class::null:
+            return false;
+        case key_class::number:
+            if (this->ck_is_int[lhs] && this->ck_is_int[rhs]) {
+                return this->ck_ints[lhs] < this->ck_ints[rhs];
+            }
+            return this->ck_floats[lhs] < this->ck_floats[rhs];
+        case key_class::text:
+            return this->ck_ints[lhs] < this->ck_ints[rhs];
+    }
+
+    return false;
+}
+
+const db_label_source::column_keys&
+db_label_source::get_column_keys(size_t col)
+{
+    auto iter = this->dls_column_keys.find(col);
+    if (iter != this->dls_column_keys.end()) {
+        return iter->second;
+    }
+
+    const auto& cursors = this->dls_query_rows
+        ? this->dls_query_rows->qr_cursors
+        : this->dls_row_cursors;
+    auto row_count = cursors.size();
+    auto& retval = this->dls_column_keys[col];
+    retval.ck_class.resize(row_count, column_keys::key_class::null);
+    retval.ck_ints.resize(row_count);
+    retval.ck_floats.resize(row_count);
+    retval.ck_is_int.resize(row_count);
+
+    // The text values are replaced by their index in this dictionary and
+    // then by their rank once all the distinct values are known.
+    robin_hood::unordered_map<std::string, int64_t> dict;
+    for (size_t row = 0; row < row_count; row++) {
+        auto cursor = cursors[row].sync();
+        for (size_t lpc = 0; lpc < col && cursor; lpc++) {
+            cursor = cursor->next();
+        }
+        if (!cursor) {
+            continue;
+        }
+
+        switch (cursor->get_type()) {
+            case lnav::cell_type::CT_NULL:
+                break;
+            case lnav::cell_type::CT_INTEGER:
+                retval.ck_class[row] = column_keys::key_class::number;
+                retval.ck_ints[row] = cursor->get_int();
+                retval.ck_floats[row] = cursor->get_int();
+                retval.ck_is_int[row] = true;
+                break;
+            case lnav::cell_type::CT_FLOAT:
+                retval.ck_class[row] = column_keys::key_class::number;
+                retval.ck_floats[row] = cursor->get_float();
+                break;
+            case lnav::cell_type::CT_TEXT: {
+                auto emp_res = dict.emplace(cursor->get_text().to_string(),
+                                            (int64_t) dict.size());
+                retval.ck_class[row] = column_keys::key_class::text;
+                retval.ck_ints[row] = emp_res.first->second;
+                break;
+            }
+        }
+    }
+
+    if (!dict.empty()) {
+        std::vector<std::pair<const std::string*, int64_t>> entries;
+        entries.reserve(dict.size());
+        for (const auto& pair : dict) {
+            entries.emplace_back(&pair.first, pair.second);
+        }
+        std::sort(entries.begin(),
+                  entries.end(),
+                  [](const auto& lhs, const auto& rhs) {
+                      return *lhs.first < *rhs.first;
+                  });
+        std::vector<int64_t> ranks(entries.size());
+        for (size_t lpc = 0; lpc < entries.size(); lpc++) {
+            ranks[entries[lpc].second] = lpc;
+        }
+        for (size_t row = 0; row < row_count; row++) {
+            if (retval.ck_class[row] == column_keys::key_class::text) {
+                retval.ck_ints[row] = ranks[retval.ck_ints[row]];
+            }
+        }
+    }
+
+    return retval;
+}
+
+std::vector<size_t>
+db_label_source::get_row_order() const
+{
+    if (this->dls_query_rows) {
+        return this->dls_row_order;
+    }
+
+    std::vector<size_t> retval(this->dls_row_cursors.size());
+    std::iota(retval.begin(), retval.end(), 0);
+    return retval;
+}
+
+void
+db_label_source::apply_row_order(std::vector<size_t> order)
+{
+    if (!this->dls_query_rows) {
+        this->dls_query_rows = query_rows{
+            std::move(this->dls_row_cursors),
+            std::move(this->dls_time_column),
+            std::move(this->dls_row_styles),
+        };
+    }
+
+    const auto& qr = this->dls_query_rows.value();
+    this->dls_row_cursors.clear();
+    this->dls_time_column.clear();
+    this->dls_row_styles.clear();
+    this->dls_row_cursors.reserve(order.size());
+    for (auto index : order) {
+        this->dls_row_cursors.emplace_back(qr.qr_cursors[index]);
+    }
+    if (qr.qr_time_column.size() == qr.qr_cursors.size()) {
+        for (auto index : order) {
+            this->dls_time_column.emplace_back(qr.qr_time_column[index]);
+        }
+        // The time translation needs the times to be in order.
+        if (!std::is_sorted(this->dls_time_column.begin(),
+                            this->dls_time_column.end()))
+        {
+            this->dls_time_column.clear();
+        }
+    }
+    if (!qr.qr_row_styles.empty()) {
+        for (auto index : order) {
+            if (index < qr.qr_row_styles.size()) {
+                this->dls_row_styles.emplace_back(qr.qr_row_styles[index]);
+            } else {
+                this->dls_row_styles.emplace_back();
+            }
+        }
+    }
+    this->dls_row_order = std::move(order);
+    if (this->tss_view != nullptr) {
+        this->tss_view->get_bookmarks().clear();
+    }
+}
+
+void
+db_label_source::sort_rows(size_t col, bool ascending)
+{
+    if (col >= this->dls_headers.size()) {
+        return;
+    }
+
+    const auto& keys = this->get_column_keys(col);
+    auto order = this->get_row_order();
+    std::stable_sort(
+        order.begin(), order.end(), [&keys, ascending](auto lhs, auto rhs) {
+            return ascending ? keys.less(lhs, rhs) : keys.less(rhs, lhs);
+        });
+    this->dls_sort_column = std::make_pair(col, ascending);
+    this->apply_row_order(std::move(order));
+}
+
+void
+db_label_source::toggle_sort_rows(size_t col)
+{
+    auto ascending = true;
+    if (this->dls_sort_column && this->dls_sort_column->first == col) {
+        ascending = !this->dls_sort_column->second;
+    }
+    this->sort_rows(col, ascending);
+}
+
+void
+db_label_source::filter_rows(size_t col, vis_line_t row)
+{
+    if (col >= this->dls_headers.size() || row < 0_vl
+        || (size_t) row >= this->dls_row_cursors.size())
+    {
+        return;
+    }
+
+    const auto& keys = this->get_column_keys(col);
+    auto order = this->get_row_order();
+    auto target = order[row];
+    order.erase(std::remove_if(order.begin(),
+                               order.end(),
+                               [&keys, target](auto index) {
+                                   return !keys.equal(index, target);
+                               }),
+                order.end());
+    this->apply_row_order(std::move(order));
+}
+
+void
+db_label_source::reset_row_order()
+{
+    if (!this->dls_query_rows) {
+        return;
+    }
+
+    auto& qr = this->dls_query_rows.value();
+    this->dls_row_cursors = std::move(qr.qr_cursors);
+    this->dls_time_column = std::move(qr.qr_time_column);
+    this->dls_row_styles = std::move(qr.qr_row_styles);
+    this->dls_query_rows = std::nullopt;
+    this->dls_row_order.clear();
+    this->dls_sort_column = std::nullopt;
+    if (this->tss_view != nullptr) {
+        this->tss_view->get_bookmarks().clear();
+    }
 }
 
 std::optional<attr_line_t>
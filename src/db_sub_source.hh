@@ -133,6 +133,30 @@ public:
 
     void reset_user_state();
 
+    /**
+     * Reorder the displayed rows by the values in the given column using
+     * the same ordering as SQLite.  Rows with equal values keep their
+     * relative order.
+     */
+    void sort_rows(size_t col, bool ascending);
+
+    /**
+     * Sort the rows in ascending order by the given column or reverse the
+     * order if the rows are already sorted by that column.
+     */
+    void toggle_sort_rows(size_t col);
+
+    /**
+     * Only display the rows that have the same value in the given column
+     * as the given row.
+     */
+    void filter_rows(size_t col, vis_line_t row);
+
+    /** Display all the rows in the order returned by the query. */
+    void reset_row_order();
+
+    bool is_reordered() const { return this->dls_query_rows.has_value(); }
+
     bool is_error() const
     {
         return !(this->dls_step_rc == SQLITE_OK
@@ -177,6 +201,40 @@ public:
         lnav::map::small<int, text_attrs> rs_column_config;
     };
 
+    /**
+     * The values of a column in a form that is cheap to compare.  The keys
+     * are built in a single pass over the cells and kept until the next
+     * query so that sorting and filtering do not need to decode the cells
+     * again.  The keys are indexed by the row number in the query results.
+     */
+    struct column_keys {
+        enum class key_class : uint8_t {
+            null,
+            number,
+            text,
+        };
+
+        std::vector<key_class> ck_class;
+        /** The integer value or the rank of the text in the column. */
+        std::vector<int64_t> ck_ints;
+        std::vector<double> ck_floats;
+        std::vector<bool> ck_is_int;
+
+        bool less(size_t lhs, size_t rhs) const;
+
+        bool equal(size_t lhs, size_t rhs) const
+        {
+            return !this->less(lhs, rhs) && !this->less(rhs, lhs);
+        }
+    };
+
+    /** The rows as they were returned by the query. */
+    struct query_rows {
+        std::vector<lnav::cell_container::cursor> qr_cursors;
+        std::vector<timeval> qr_time_column;
+        std::vector<row_style> qr_row_styles;
+    };
+
     uint32_t dls_generation{0};
     std::string dls_user_query;
     std::optional<source_location> dls_user_query_src_loc;
@@ -203,8 +261,20 @@ public:
     ArenaAlloc::Alloc<char> dls_header_allocator{1024};
     string_attrs_t dls_ansi_attrs;
     int dls_step_rc{SQLITE_OK};
+    std::map<size_t, column_keys> dls_column_keys;
+    std::optional<query_rows> dls_query_rows;
+    /** The index into dls_query_rows of each displayed row. */
+    std::vector<size_t> dls_row_order;
+    std::optional<std::pair<size_t, bool>> dls_sort_column;
 
     static const unsigned char NULL_STR[];
+
+private:
+    const column_keys& get_column_keys(size_t col);
+
+    std::vector<size_t> get_row_order() const;
+
+    void apply_row_order(std::vector<size_t> order);
 };
 
 class db_overlay_source : public list_overlay_source {
@@ -29,20 +29,145 @@
 
 #include <algorithm>
 #include <iterator>
+#include <thread>
 
 #include "filter_observer.hh"
 
+#include <unistd.h>
+
+#include "base/ansi_scrubber.hh"
+#include "base/injector.hh"
 #include "base/lnav_log.hh"
+#include "base/string_util.hh"
 #include "config.h"
 #include "log_format.hh"
+#include "logfile.cfg.hh"
 #include "shared_buffer.hh"
 
+namespace {
+
+constexpr uint8_t LINE_VALID_UTF = 0x01;
+constexpr uint8_t LINE_HAS_ANSI = 0x02;
+
+/**
+ * Evaluate the regexes against a range of lines on a worker thread.  The
+ * line content is prepared the same way as logfile::read_line() so the
+ * result matches what the observer would have computed.
+ *
+ * @param offsets The file offsets of the lines plus the offset of the line
+ *   after the last one.  The line endings are trimmed by the worker.
+ * @param flags The LINE_* flags for each line.
+ * @return A vector of match results for each regex, empty if the evaluation
+ *   was cancelled or the file could not be read.
+ */
+std::vector<std::vector<bool>>
+eval_lines(int fd,
+           std::vector<file_off_t> offsets,
+           std::vector<uint8_t> flags,
+           std::vector<std::shared_ptr<lnav::pcre2pp::code>> regexes,
+           const std::atomic<bool>& cancelled)
+{
+    std::vector<std::vector<bool>> retval;
+    const auto base = offsets.front();
+    std::string buf;
+
+    buf.resize(offsets.back() - base);
+    size_t done = 0;
+    while (done < buf.size()) {
+        if (cancelled.load(std::memory_order_relaxed)) {
+            return retval;
+        }
+        auto rc = pread(fd, buf.data() + done, buf.size() - done, base + done);
+        if (rc <= 0) {
+            log_error("background filter: unable to read at %lld",
+                      (long long) (base + done));
+            return retval;
+        }
+        done += rc;
+    }
+
+    lnav::pcre2pp::code_set cs;
+    std::vector<bool> set_matches;
+    if (regexes.size() > 1) {
+        for (const auto& re : regexes) {
+            cs.add(re);
+        }
+    }
+
+    retval.assign(regexes.size(), std::vector<bool>(flags.size()));
+    for (size_t lpc = 0; lpc < flags.size(); lpc++) {
+        if ((lpc % 1024) == 0 && cancelled.load(std::memory_order_relaxed)) {
+            retval.clear();
+            break;
+        }
+
+        auto* data = buf.data() + (offsets[lpc] - base);
+        size_t len = offsets[lpc + 1] - offsets[lpc];
+        while (len > 0 && is_line_ending(data[len - 1])) {
+            len -= 1;
+        }
+        if (!(flags[lpc] & LINE_VALID_UTF)) {
+            scrub_to_utf8(data, len);
+        }
+        if (flags[lpc] & LINE_HAS_ANSI) {
+            len = erase_ansi_escapes(string_fragment::from_bytes(data, len));
+        }
+
+        auto line = string_fragment::from_bytes(data, len);
+        if (!cs.empty()) {
+            cs.find_in(line, PCRE2_NO_UTF_CHECK, set_matches);
+            for (size_t re_index = 0; re_index < regexes.size(); re_index++) {
+                retval[re_index][lpc] = set_matches[re_index];
+            }
+        } else {
+            retval[0][lpc] = regexes[0]
+                                 ->find_in(line, PCRE2_NO_UTF_CHECK)
+                                 .ignore_error()
+                                 .has_value();
+        }
+    }
+
+    return retval;
+}
+
+}  // namespace
+
+line_filter_observer::~line_filter_observer()
+{
+    this->cancel_background_eval();
+}
+
 void
 line_filter_observer::logline_clear(const logfile& lf)
 {
+    this->cancel_background_eval();
     this->lfo_filter_state.clear_for_rebuild();
 }
 
+void
+line_filter_observer::logline_restart(const logfile& lf,
+                                      file_size_t rollback_size)
+{
+    if (this->lfo_background != nullptr
+        && lf.size() < this->lfo_background->be_end)
+    {
+        // The lines being evaluated were removed, start over with these
+        // filters.
+        auto filters = this->lfo_background->be_filters;
+
+        this->cancel_background_eval();
+        for (const auto& filter : filters) {
+            this->lfo_filter_state.clear_filter_state(filter->get_index());
+        }
+    }
+    for (const auto& filter : this->lfo_filter_stack) {
+        if (this->is_background_filter(*filter)) {
+            continue;
+        }
+        filter->revert_to_last(this->lfo_filter_state, rollback_size);
+    }
+}
+
 bool
 line_filter_observer::logline_new_lines(const logfile& lf,
                                         logfile::const_iterator ll_begin,
@@ -60,37 +185,118 @@ line_filter_observer::logline_new_lines(const logfile& lf,
         return retval;
     }
 
+    this->sync_filter_set();
+
+    auto* format = lf.get_format_ptr();
+    auto raw_sublines = format == nullptr || format->has_raw_sublines();
     for (; ll_begin != ll_end; ++ll_begin) {
-        auto sbr_copy = sbr.clone();
-        auto* format = lf.get_format_ptr();
-        if (format != nullptr) {
-            format->get_subline(
-                lf.get_format_file_state(), *ll_begin, sbr_copy);
-        }
-        sbr_copy.erase_ansi();
-        for (const auto& filter : this->lfo_filter_stack) {
-            if (filter->lf_deleted) {
+        // The line only needs to be copied if its content will change.
+        const auto* line = &sbr;
+        shared_buffer_ref sbr_copy;
+        if (!raw_sublines || ll_begin->has_ansi()) {
+            sbr_copy = sbr.clone();
+            if (format != nullptr) {
+                format->get_subline(
+                    lf.get_format_file_state(), *ll_begin, sbr_copy);
+            }
+            sbr_copy.erase_ansi();
+            line = &sbr_copy;
+        }
+
+        auto set_checked = false;
+        for (const auto& fp : this->lfo_filter_plan) {
+            const auto& filter = fp.fp_filter;
+
+            if (filter->lf_deleted || fp.fp_background) {
                 continue;
             }
-            if (offset >= (ssize_t) this->lfo_filter_state
-                              .tfs_filter_count[filter->get_index()])
+            if (offset < (ssize_t) this->lfo_filter_state.get_filter_count(
+                    filter->get_index()))
             {
+                continue;
+            }
+            if (!fp.fp_set_index) {
                 retval = filter->add_line(
-                             this->lfo_filter_state, ll_begin, sbr_copy)
+                             this->lfo_filter_state, ll_begin, *line)
                     || retval;
+                continue;
+            }
+
+            if (!set_checked) {
+                uint32_t options = 0;
+                if (line->get_metadata().m_valid_utf) {
+                    options |= PCRE2_NO_UTF_CHECK;
+                }
+                this->lfo_code_set.find_in(line->to_string_fragment(),
+                                           options,
+                                           this->lfo_set_matches);
+                set_checked = true;
             }
+            retval = filter->add_line_result(
+                         this->lfo_filter_state,
+                         ll_begin,
+                         this->lfo_set_matches[fp.fp_set_index.value()])
+                || retval;
         }
     }
 
     return retval;
 }
 
+void
+line_filter_observer::sync_filter_set()
+{
+    auto changed
+        = this->lfo_filter_plan.size() != this->lfo_filter_stack.size();
+    auto plan_iter = this->lfo_filter_plan.begin();
+    for (const auto& filter : this->lfo_filter_stack) {
+        if (changed) {
+            break;
+        }
+        if (plan_iter->fp_filter != filter
+            || plan_iter->fp_regex != filter->get_regex()
+            || plan_iter->fp_deleted != filter->lf_deleted
+            || plan_iter->fp_background != this->is_background_filter(*filter))
+        {
+            changed = true;
+        }
+        ++plan_iter;
+    }
+    if (!changed) {
+        return;
+    }
+
+    size_t regex_count = 0;
+    this->lfo_filter_plan.clear();
+    this->lfo_code_set.clear();
+    for (const auto& filter : this->lfo_filter_stack) {
+        auto& fp = this->lfo_filter_plan.emplace_back();
+
+        fp.fp_filter = filter;
+        fp.fp_regex = filter->get_regex();
+        fp.fp_deleted = filter->lf_deleted;
+        fp.fp_background = this->is_background_filter(*filter);
+        if (fp.fp_regex != nullptr && !fp.fp_deleted && !fp.fp_background) {
+            regex_count += 1;
+        }
+    }
+
+    // Scanning for the literals costs more than it saves with one regex.
+    if (regex_count < 2) {
+        return;
+    }
+    for (auto& fp : this->lfo_filter_plan) {
+        if (fp.fp_regex != nullptr && !fp.fp_deleted && !fp.fp_background) {
+            fp.fp_set_index = this->lfo_code_set.add(fp.fp_regex);
+        }
+    }
+}
+
 void
 line_filter_observer::logline_eof(const logfile& lf)
 {
-    this->lfo_filter_state.reserve(lf.size() + lf.estimated_remaining_lines());
     for (const auto& iter : this->lfo_filter_stack) {
-        if (iter->lf_deleted) {
+        if (iter->lf_deleted || this->is_background_filter(*iter)) {
             continue;
         }
         iter->end_of_message(this->lfo_filter_state);
@@ -103,12 +309,12 @@ line_filter_observer::get_min_count(size_t max) const
     size_t retval = max;
 
     for (const auto& filter : this->lfo_filter_stack) {
-        if (filter->lf_deleted) {
+        if (filter->lf_deleted || this->is_background_filter(*filter)) {
             continue;
         }
         retval = std::min(
             retval,
-            this->lfo_filter_state.tfs_filter_count[filter->get_index()]);
+            this->lfo_filter_state.get_filter_count(filter->get_index()));
     }
 
     return retval;
@@ -117,7 +323,7 @@ line_filter_observer::get_min_count(size_t max) const
 void
 line_filter_observer::clear_deleted_filter_state()
 {
-    uint32_t used_mask = 0;
+    std::vector<bool> used;
 
     for (auto& filter : this->lfo_filter_stack) {
         if (filter->lf_deleted) {
@@ -127,7 +333,332 @@ line_filter_observer::clear_deleted_filter_state()
                       filter->get_lang());
             continue;
         }
-        used_mask |= (1UL << filter->get_index());
+        if (filter->get_index() >= used.size()) {
+            used.resize(filter->get_index() + 1);
+        }
+        used[filter->get_index()] = true;
+    }
+    this->lfo_filter_state.clear_deleted_filter_state(used);
+}
+
+void
+line_filter_observer::update_exclusion(const filter_stack::enabled_filters& ef,
+                                       size_t start)
+{
+    const auto& masks = this->lfo_filter_state.tfs_masks;
+    auto add_masks = [&masks, start](lnav::line_bitmap& dst,
+                                     const std::vector<size_t>& indexes) {
+        for (auto index : indexes) {
+            if (index < masks.size()) {
+                dst.union_with(masks[index], start);
+            }
+        }
+    };
+
+    this->lfo_exclusion.clear();
+    this->lfo_exclusion_includes = !ef.ef_include.empty();
+    if (!this->lfo_exclusion_includes) {
+        add_masks(this->lfo_exclusion, ef.ef_exclude);
+        return;
     }
-    this->lfo_filter_state.clear_deleted_filter_state(used_mask);
+
+    add_masks(this->lfo_exclusion, ef.ef_include);
+    if (!ef.ef_exclude.empty()) {
+        lnav::line_bitmap filtered_out;
+
+        add_masks(filtered_out, ef.ef_exclude);
+        this->lfo_exclusion.subtract(filtered_out);
+    }
+}
+
+bool
+line_filter_observer::is_background_filter(const text_filter& tf) const
+{
+    if (this->lfo_background == nullptr) {
+        return false;
+    }
+
+    const auto& filters = this->lfo_background->be_filters;
+    return std::any_of(filters.begin(), filters.end(), [&tf](const auto& f) {
+        return f.get() == &tf;
+    });
+}
+
+void
+line_filter_observer::sync_background_eval()
+{
+    static const auto& cfg = injector::get<const lnav::logfile::config&>();
+
+    const auto& lf = this->lfo_filter_state.tfs_logfile;
+
+    if (lf == nullptr) {
+        return;
+    }
+
+    if (this->lfo_background != nullptr) {
+        auto& be = *this->lfo_background;
+        auto stale = false;
+
+        for (size_t lpc = 0; lpc < be.be_filters.size() && !stale; lpc++) {
+            const auto& filter = be.be_filters[lpc];
+
+            stale = filter->lf_deleted
+                || filter->get_regex() != be.be_regexes[lpc]
+                || std::find(this->lfo_filter_stack.begin(),
+                             this->lfo_filter_stack.end(),
+                             filter)
+                    == this->lfo_filter_stack.end();
+        }
+        if (!stale) {
+            for (const auto& filter : this->lfo_filter_stack) {
+                if (filter->lf_deleted || filter->get_regex() == nullptr
+                    || this->is_background_filter(*filter))
+                {
+                    continue;
+                }
+                auto count = this->lfo_filter_state.get_filter_count(
+                    filter->get_index());
+                if (count + cfg.lc_background_filter_min_lines < lf->size())
+                {
+                    stale = true;
+                    break;
+                }
+            }
+        }
+        if (!stale) {
+            return;
+        }
+        this->stop_background_eval();
+    }
+
+    // The content of the lines needs to be the same as the raw bytes in the
+    // file for the workers to be able to read them on their own.
+    const auto* format = lf->get_format_ptr();
+    if (lf->size() < cfg.lc_background_filter_min_lines || lf->is_compressed()
+        || lf->has_line_metadata() || lf->is_pipe()
+        || (format != nullptr && !format->has_raw_sublines()))
+    {
+        return;
+    }
+
+    // The last message might still be growing, so it is left to the
+    // observer.
+    size_t end = lf->size() - 1;
+    while (end > 0 && !(lf->begin() + end)->is_message()) {
+        end -= 1;
+    }
+
+    auto be = std::make_unique<background_eval>();
+    be->be_begin = end;
+    for (const auto& filter : this->lfo_filter_stack) {
+        auto re = filter->get_regex();
+        if (filter->lf_deleted || re == nullptr) {
+            continue;
+        }
+
+        auto index = filter->get_index();
+        this->lfo_filter_state.ensure_filter(index);
+        auto start = this->lfo_filter_state.tfs_filter_count[index];
+        if (this->lfo_filter_state.tfs_lines_for_message[index] > 0
+            || start + cfg.lc_background_filter_min_lines > end)
+        {
+            continue;
+        }
+        be->be_filters.emplace_back(filter);
+        be->be_regexes.emplace_back(re);
+        be->be_starts.emplace_back(start);
+        be->be_begin = std::min(be->be_begin, start);
+    }
+    if (be->be_filters.empty()) {
+        return;
+    }
+
+    be->be_fd = auto_fd::dup_of(lf->get_fd());
+    if (be->be_fd == -1) {
+        return;
+    }
+    be->be_next = be->be_begin;
+    be->be_merged = be->be_begin;
+    be->be_end = end;
+    log_info("starting background filter of %zu lines with %zu filter(s) -- %s",
+             be->be_end - be->be_begin,
+             be->be_filters.size(),
+             lf->get_filename_as_string().c_str());
+    this->lfo_background = std::move(be);
+    this->lfo_filter_plan.clear();
+    this->launch_background_chunks();
+}
+
+void
+line_filter_observer::launch_background_chunks()
+{
+    static const auto MAX_CHUNKS
+        = std::max(1U, std::thread::hardware_concurrency());
+    static const auto& cfg = injector::get<const lnav::logfile::config&>();
+
+    auto& be = *this->lfo_background;
+    const auto& lf = *this->lfo_filter_state.tfs_logfile;
+
+    while (be.be_chunks.size() < MAX_CHUNKS && be.be_next < be.be_end) {
+        auto chunk_end = std::min<size_t>(
+            be.be_next + cfg.lc_background_filter_chunk_lines, be.be_end);
+        // Chunks end on a message boundary so a message is only evaluated by
+        // one worker.
+        while (chunk_end < be.be_end && !(lf.begin() + chunk_end)->is_message())
+        {
+            chunk_end += 1;
+        }
+
+        std::vector<file_off_t> offsets;
+        std::vector<uint8_t> flags;
+        offsets.reserve(chunk_end - be.be_next + 1);
+        flags.reserve(chunk_end - be.be_next);
+        for (auto iter = lf.begin() + be.be_next;
+             iter != lf.begin() + chunk_end;
+             ++iter)
+        {
+            offsets.emplace_back(iter->get_offset());
+            flags.emplace_back((iter->is_valid_utf() ? LINE_VALID_UTF : 0)
+                               | (iter->has_ansi() ? LINE_HAS_ANSI : 0));
+        }
+        offsets.emplace_back((lf.begin() + chunk_end)->get_offset());
+
+        auto& chunk = be.be_chunks.emplace_back();
+        chunk.bc_start = be.be_next;
+        chunk.bc_end = chunk_end;
+        chunk.bc_result = std::async(std::launch::async,
+                                     eval_lines,
+                                     be.be_fd.get(),
+                                     std::move(offsets),
+                                     std::move(flags),
+                                     be.be_regexes,
+                                     std::cref(be.be_cancelled));
+        be.be_next = chunk_end;
+    }
+}
+
+bool
+line_filter_observer::merge_background_chunks()
+{
+    auto& be = *this->lfo_background;
+    auto& lfs = this->lfo_filter_state;
+    const auto& lf = *lfs.tfs_logfile;
+    auto retval = false;
+
+    lfs.resize(lf.size());
+    while (!be.be_chunks.empty()) {
+        auto& chunk = be.be_chunks.front();
+
+        if (chunk.bc_result.wait_for(std::chrono::seconds(0))
+            != std::future_status::ready)
+        {
+            break;
+        }
+
+        auto results = chunk.bc_result.get();
+        if (results.empty()) {
+            be.be_cancelled = true;
+            break;
+        }
+        for (size_t lpc = 0; lpc < be.be_filters.size(); lpc++) {
+            const auto& filter = be.be_filters[lpc];
+
+            if (filter->lf_deleted) {
+                continue;
+            }
+            for (auto line = std::max(chunk.bc_start, be.be_starts[lpc]);
+                 line < chunk.bc_end;
+                 line++)
+            {
+                filter->add_line_result(lfs,
+                                        lf.begin() + line,
+                                        results[lpc][line - chunk.bc_start]);
+            }
+            // Chunks end on a message boundary, so the last message can be
+            // committed.
+            filter->end_of_message(lfs);
+        }
+        be.be_merged = chunk.bc_end;
+        be.be_chunks.pop_front();
+        retval = true;
+    }
+
+    return retval;
+}
+
+bool
+line_filter_observer::poll_background_eval()
+{
+    if (this->lfo_background == nullptr) {
+        return false;
+    }
+
+    auto retval = this->merge_background_chunks();
+    auto& be = *this->lfo_background;
+    if (be.be_cancelled) {
+        log_error("background filter failed, evaluating inline -- %s",
+                  this->lfo_filter_state.tfs_logfile->get_filename_as_string()
+                      .c_str());
+        this->cancel_background_eval();
+    } else if (be.be_merged == be.be_end) {
+        log_info("background filter finished -- %s",
+                 this->lfo_filter_state.tfs_logfile->get_filename_as_string()
+                     .c_str());
+        this->lfo_background.reset();
+        this->lfo_filter_plan.clear();
+    } else {
+        this->launch_background_chunks();
+    }
+
+    return retval;
+}
+
+void
+line_filter_observer::finish_background_eval()
+{
+    while (this->lfo_background != nullptr) {
+        if (!this->lfo_background->be_chunks.empty()) {
+            this->lfo_background->be_chunks.front().bc_result.wait();
+        }
+        this->poll_background_eval();
+    }
+}
+
+void
+line_filter_observer::stop_background_eval()
+{
+    if (this->lfo_background == nullptr) {
+        return;
+    }
+
+    this->merge_background_chunks();
+    this->cancel_background_eval();
+}
+
+void
+line_filter_observer::cancel_background_eval()
+{
+    if (this->lfo_background == nullptr) {
+        return;
+    }
+
+    // The filter state is only updated a whole chunk at a time, so it is
+    // consistent up to the last merged line.
+    this->lfo_background->be_cancelled = true;
+    for (auto& chunk : this->lfo_background->be_chunks) {
+        chunk.bc_result.wait();
+    }
+    this->lfo_background.reset();
+    this->lfo_filter_plan.clear();
+}
+
+std::pair<size_t, size_t>
+line_filter_observer::get_background_eval_progress() const
+{
+    if (this->lfo_background == nullptr) {
+        return {0, 0};
+    }
+
+    const auto& be = *this->lfo_background;
+    return {be.be_merged - be.be_begin, be.be_end - be.be_begin};
 }
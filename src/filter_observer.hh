@@ -30,11 +30,20 @@
 #ifndef filter_observer_hh
 #define filter_observer_hh
 
+#include <atomic>
 #include <cstdint>
+#include <deque>
+#include <future>
 #include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
 
+#include "base/auto_fd.hh"
 #include "base/file_range.hh"
+#include "base/line_bitmap.hh"
 #include "logfile.hh"
+#include "pcrepp/pcre2pp.hh"
 #include "shared_buffer.hh"
 #include "textview_curses.hh"
 
@@ -45,13 +54,18 @@ public:
     {
     }
 
+    line_filter_observer(const line_filter_observer&) = delete;
+    line_filter_observer& operator=(const line_filter_observer&) = delete;
+
+    ~line_filter_observer() override;
+
     void logline_clear(const logfile& lf) override;
 
-    void logline_restart(const logfile& lf, file_size_t rollback_size) override
+    void logline_restart(const logfile& lf, file_size_t rollback_size) override;
+
+    bool logline_needs_content(const logfile& lf) const override
     {
-        for (const auto& filter : this->lfo_filter_stack) {
-            filter->revert_to_last(this->lfo_filter_state, rollback_size);
-        }
+        return !this->lfo_filter_stack.empty();
     }
 
     bool logline_new_lines(const logfile& lf,
@@ -61,23 +75,124 @@ public:
 
     void logline_eof(const logfile& lf) override;
 
-    bool excluded(uint32_t filter_in_mask,
-                  uint32_t filter_out_mask,
-                  size_t offset) const
+    /**
+     * Combine the bitmaps of the enabled filters into the set of lines that
+     * excluded() checks against.  Only the lines at or after the start line
+     * are guaranteed to be up-to-date.
+     */
+    void update_exclusion(const filter_stack::enabled_filters& ef,
+                          size_t start = 0);
+
+    /** @return True if the line is hidden by the last update_exclusion(). */
+    bool excluded(size_t offset) const
     {
-        bool filtered_in = (filter_in_mask == 0)
-            || (this->lfo_filter_state.tfs_mask[offset] & filter_in_mask) != 0;
-        bool filtered_out
-            = (this->lfo_filter_state.tfs_mask[offset] & filter_out_mask) != 0;
-        return !filtered_in || filtered_out;
+        auto in_set = this->lfo_exclusion.contains(offset);
+
+        return this->lfo_exclusion_includes ? !in_set : in_set;
     }
 
     size_t get_min_count(size_t max) const;
 
     void clear_deleted_filter_state();
 
+    /**
+     * Start evaluating the regex filters that are far behind the end of the
+     * file on worker threads.  A filter is far behind when it has not seen
+     * the "/tuning/logfile/background-filter-min-lines" most recent lines.
+     * A job that is already running is stopped if one of its filters was
+     * removed or another filter has fallen behind, in which case a new job
+     * is started for all of the lagging filters.
+     * Filters that are part of a running job are skipped when lines are
+     * observed and are caught up once the job finishes.
+     */
+    void sync_background_eval();
+
+    /**
+     * Merge the results of the finished parts of the background job into
+     * the filter state and hand out more work.
+     *
+     * @return True if any lines were merged.
+     */
+    bool poll_background_eval();
+
+    /** Block until the background job is finished and merged. */
+    void finish_background_eval();
+
+    /** Stop the background job and drop any results not yet merged. */
+    void cancel_background_eval();
+
+    bool is_background_eval_running() const
+    {
+        return this->lfo_background != nullptr;
+    }
+
+    /**
+     * @return The number of lines that have been evaluated by the background
+     * job and the total number of lines it will evaluate.
+     */
+    std::pair<size_t, size_t> get_background_eval_progress() const;
+
     filter_stack& lfo_filter_stack;
     logfile_filter_state lfo_filter_state;
+
+private:
+    /** The result of evaluating a range of lines on a worker thread. */
+    struct background_chunk {
+        size_t bc_start{0};
+        size_t bc_end{0};
+        std::future<std::vector<std::vector<bool>>> bc_result;
+    };
+
+    struct background_eval {
+        std::vector<std::shared_ptr<text_filter>> be_filters;
+        std::vector<std::shared_ptr<lnav::pcre2pp::code>> be_regexes;
+        /** The line where each filter starts being evaluated. */
+        std::vector<size_t> be_starts;
+        size_t be_begin{0};
+        size_t be_next{0};
+        size_t be_merged{0};
+        /** The start of the last message, which might still be growing. */
+        size_t be_end{0};
+        auto_fd be_fd;
+        std::atomic<bool> be_cancelled{false};
+        std::deque<background_chunk> be_chunks;
+    };
+
+    bool is_background_filter(const text_filter& tf) const;
+
+    void launch_background_chunks();
+
+    /** Merge the chunks at the front of the queue that are finished. */
+    bool merge_background_chunks();
+
+    /** Merge what is finished and stop the job. */
+    void stop_background_eval();
+
+    /**
+     * Rebuild the code set if the filters in the stack have changed.  The
+     * regex filters are combined into a single set when there is more than
+     * one of them so that a line only needs to be scanned once.
+     */
+    void sync_filter_set();
+
+    struct filter_plan {
+        std::shared_ptr<text_filter> fp_filter;
+        std::shared_ptr<lnav::pcre2pp::code> fp_regex;
+        bool fp_deleted{false};
+        bool fp_background{false};
+        std::optional<size_t> fp_set_index;
+    };
+
+    std::vector<filter_plan> lfo_filter_plan;
+    lnav::pcre2pp::code_set lfo_code_set;
+    std::vector<bool> lfo_set_matches;
+    std::unique_ptr<background_eval> lfo_background;
+    /**
+     * The visible lines if there are filter-in filters, otherwise the hidden
+     * lines.
+     */
+    lnav::line_bitmap lfo_exclusion;
+    bool lfo_exclusion_includes{false};
 };
 
 #endif
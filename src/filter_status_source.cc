@@ -243,6 +243,15 @@ filter_status_source::update_filtered(text_sub_source* tss)
     auto& sf = this->tss_fields[TSF_FILTERED];
     auto retval = false;
 
+    auto progress = tss->get_filter_progress();
+    if (progress && progress->second > 0) {
+        // Force the count to be shown again once the filtering is done.
+        this->bss_last_filtered_count = -1;
+        sf.set_role(role_t::VCR_ALERT_STATUS);
+        return sf.set_value(" Filtering %3zu%% ",
+                            progress->first * 100 / progress->second);
+    }
+
     auto curr_filtered_count = tss->get_filtered_count();
     if (curr_filtered_count == 0) {
         if (tss->tss_apply_filters) {
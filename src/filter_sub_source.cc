@@ -271,17 +271,11 @@ filter_sub_source::list_input_handle_key(listview_curses& lv, const ncinput& ch)
             auto& fs = tss->get_filters();
             auto filter_index = fs.next_index();
 
-            if (!filter_index) {
-                lnav_data.ld_filter_help_status_source.fss_error.set_value(
-                    "error: too many filters");
-                return true;
-            }
-
             auto filter_type = ch.eff_text[0] == 'i'
                 ? text_filter::type_t::INCLUDE
                 : text_filter::type_t::EXCLUDE;
             auto ef = std::make_shared<empty_filter>(
-                filter_type, filter_lang_t::REGEX, *filter_index);
+                filter_type, filter_lang_t::REGEX, filter_index);
             fs.add_filter(ef);
 
             auto rows = this->rows_for(top_view);
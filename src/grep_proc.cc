@@ -39,6 +39,7 @@
 #include <signal.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
@@ -52,6 +53,68 @@
 #include "scn/scan.h"
 #include "vis_line.hh"
 
+grep_match_ring*
+grep_match_ring::create()
+{
+    auto* mem = mmap(nullptr,
+                     sizeof(grep_match_ring),
+                     PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_ANONYMOUS,
+                     -1,
+                     0);
+    if (mem == MAP_FAILED) {
+        log_error("unable to map grep match ring -- %s", strerror(errno));
+        return nullptr;
+    }
+
+    return new (mem) grep_match_ring();
+}
+
+void
+grep_match_ring::destroy(grep_match_ring* ring)
+{
+    if (ring == nullptr) {
+        return;
+    }
+
+    ring->~grep_match_ring();
+    munmap(ring, sizeof(grep_match_ring));
+}
+
+grep_task_queue*
+grep_task_queue::create(size_t count)
+{
+    auto map_size = sizeof(grep_task_queue) + count * sizeof(task);
+    auto* mem = mmap(nullptr,
+                     map_size,
+                     PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_ANONYMOUS,
+                     -1,
+                     0);
+    if (mem == MAP_FAILED) {
+        log_error("unable to map grep task queue -- %s", strerror(errno));
+        return nullptr;
+    }
+
+    auto* retval = new (mem) grep_task_queue();
+    retval->tq_count = count;
+    retval->tq_map_size = map_size;
+    retval->tq_tasks = reinterpret_cast<task*>(retval + 1);
+    return retval;
+}
+
+void
+grep_task_queue::destroy(grep_task_queue* queue)
+{
+    if (queue == nullptr) {
+        return;
+    }
+
+    auto map_size = queue->tq_map_size;
+    queue->~grep_task_queue();
+    munmap(queue, map_size);
+}
+
 template<typename LineType>
 grep_proc<LineType>::grep_proc(std::shared_ptr<lnav::pcre2pp::code> code,
                                grep_proc_source<LineType>& gps,
@@ -112,6 +175,7 @@ void
 grep_proc<LineType>::start()
 {
     static constexpr size_t MAX_CHILDREN = 8;
+    static constexpr LineType TASK_SIZE = LineType{10'000};
 
     require(this->invariant());
 
@@ -137,26 +201,83 @@ grep_proc<LineType>::start()
                  (int) elem.second.ru_line);
     }
 
+    // Split the requests into smaller tasks that the children claim from a
+    // shared queue as they finish their previous task.
+    // A search to the end of the source is split at the number of lines
+    // known now, only the final task needs to follow the source to its end
+    // and report the highest line.
+    std::vector<grep_task_queue::task> tasks;
+    for (const auto& [start, until] : this->gp_queue) {
+        auto task_start = start;
+        auto task_until = until.ru_line;
+        std::optional<LineType> eof_start;
+
+        if (until.ru_type == until_type_t::eof) {
+            auto line_count = this->gp_source.grep_line_count();
+
+            if (task_start == -1) {
+                task_start = this->gp_highest_line;
+            }
+            if (line_count && task_start < line_count.value()) {
+                task_until = line_count.value();
+                eof_start = line_count;
+            }
+        }
+        if (!eof_start
+            && (start == -1 || until.ru_type == until_type_t::eof))
+        {
+            tasks.emplace_back(grep_task_queue::task{
+                (int32_t) start,
+                until.ru_type == until_type_t::eof,
+                (int32_t) until.ru_line,
+            });
+            continue;
+        }
+
+        for (; task_start < task_until; task_start += TASK_SIZE) {
+            tasks.emplace_back(grep_task_queue::task{
+                (int32_t) task_start,
+                false,
+                (int32_t) std::min(task_until, task_start + TASK_SIZE),
+            });
+        }
+        if (eof_start) {
+            tasks.emplace_back(grep_task_queue::task{
+                (int32_t) eof_start.value(),
+                true,
+                (int32_t) until.ru_line,
+            });
+        }
+    }
+    std::unique_ptr<grep_task_queue, grep_task_queue::deleter> task_queue(
+        grep_task_queue::create(tasks.size()));
+    if (task_queue) {
+        std::copy(tasks.begin(), tasks.end(), task_queue->tq_tasks);
+    }
+
     auto num_children = std::min({
         static_cast<size_t>(std::thread::hardware_concurrency()),
-        this->gp_queue.size(),
+        task_queue ? tasks.size() : this->gp_queue.size(),
         MAX_CHILDREN,
     });
     if (num_children == 0) {
         num_children = 1;
     }
 
-    // Distribute queue items round-robin across children.
+    // Without a shared queue, distribute queue items round-robin across
+    // children.
     std::vector<std::deque<std::pair<LineType, request_until_t>>> sub_queues(
         num_children);
-    for (size_t i = 0; i < this->gp_queue.size(); i++) {
-        sub_queues[i % num_children].push_back(this->gp_queue[i]);
+    if (!task_queue) {
+        for (size_t i = 0; i < this->gp_queue.size(); i++) {
+            sub_queues[i % num_children].push_back(this->gp_queue[i]);
+        }
     }
 
     this->gp_child_queue_size = this->gp_queue.size();
 
     for (size_t i = 0; i < num_children; i++) {
-        if (sub_queues[i].empty()) {
+        if (!task_queue && sub_queues[i].empty()) {
             continue;
         }
 
@@ -171,6 +292,11 @@ grep_proc<LineType>::start()
             throw error(errno);
         }
 
+        // Matches are sent through shared memory when possible, the pipe is
+        // then only used for notifications and control messages.
+        std::unique_ptr<grep_match_ring, grep_match_ring::deleter> ring(
+            grep_match_ring::create());
+
         auto child_res = lnav::pid::from_fork();
         if (child_res.isErr()) {
             throw error(errno);
@@ -190,6 +316,8 @@ grep_proc<LineType>::start()
 
         if (child.in_child()) {
             this->gp_queue = std::move(sub_queues[i]);
+            this->gp_child_tasks = task_queue.get();
+            this->gp_child_ring = ring.get();
             this->child_init();
             this->child_loop();
             _exit(0);
@@ -204,6 +332,7 @@ grep_proc<LineType>::start()
         auto cs_ptr = std::make_unique<child_state>(std::move(child));
         cs_ptr->cs_line_buffer.set_fd(out_pipe.read_end());
         cs_ptr->cs_err_pipe = std::move(err_pipe.read_end());
+        cs_ptr->cs_match_ring = std::move(ring);
 
         log_debug("grep_proc(%p): started child[%zu] %d",
                   this,
@@ -230,13 +359,14 @@ grep_proc<LineType>::child_loop()
     lnav_log_file
         = make_optional_from_nullable(fopen("/tmp/lnav.grep.err", "a"));
     line_value.reserve(BUFSIZ * 2);
-    while (!this->gp_queue.empty()) {
-        LineType start_line = this->gp_queue.front().first;
-        auto stop_line = this->gp_queue.front().second;
+    auto literals = this->gp_pcre->get_required_literals();
+    std::pair<LineType, request_until_t> req;
+    while (this->child_next_request(req)) {
+        LineType start_line = req.first;
+        auto stop_line = req.second;
         bool done = false;
         LineType line;
 
-        this->gp_queue.pop_front();
         for (line = this->gp_source.grep_initial_line(start_line,
                                                       this->gp_highest_line);
              line != -1
@@ -245,12 +375,17 @@ grep_proc<LineType>::child_loop()
              && !done;
              this->gp_source.grep_next_line(line))
         {
-            line_value.clear();
-            auto val_res
-                = this->gp_source.grep_value_for_line(line, line_value);
-            if (!val_res) {
-                done = true;
-            } else {
+            std::optional<line_info> val_res;
+            if (literals.empty()
+                || this->gp_source.grep_may_match(line, literals))
+            {
+                line_value.clear();
+                val_res = this->gp_source.grep_value_for_line(line, line_value);
+                if (!val_res) {
+                    done = true;
+                }
+            }
+            if (val_res) {
                 auto li = val_res.value();
                 uint32_t re_opts = 0;
                 if (li.li_utf8_scan_result.is_valid()) {
@@ -261,16 +396,30 @@ grep_proc<LineType>::child_loop()
                                      .matches(re_opts)
                                      .ignore_error();
                 if (match_res) {
-                    fmt::println(stdout, FMT_STRING("{}"), (int) line);
+                    auto& pending = this->gp_child_pending;
+
+                    if (this->gp_child_ring == nullptr) {
+                        fmt::println(stdout, FMT_STRING("{}"), (int) line);
+                    } else if (pending.r_count > 0
+                               && pending.r_start + (int32_t) pending.r_count
+                                   == (int32_t) line)
+                    {
+                        pending.r_count += 1;
+                    } else {
+                        this->child_push_matches();
+                        pending = {(int32_t) line, 1};
+                    }
                 }
             }
 
             if (((line + 1) % 10000) == 0) {
                 /* Periodically flush the buffer so the parent sees progress */
+                this->child_notify_matches();
                 this->child_batch();
             }
         }
 
+        this->child_notify_matches();
         if (line > 0 && stop_line.ru_type == until_type_t::eof) {
             // When scanning to the end of the source, we need to return the
             // highest line that was seen so that the next request that
@@ -281,6 +430,72 @@ grep_proc<LineType>::child_loop()
     }
 }
 
+template<typename LineType>
+bool
+grep_proc<LineType>::child_next_request(
+    std::pair<LineType, request_until_t>& req_out)
+{
+    if (this->gp_child_tasks != nullptr) {
+        const auto* task = this->gp_child_tasks->claim();
+        if (task == nullptr) {
+            return false;
+        }
+
+        req_out.first = LineType{task->t_start};
+        req_out.second = request_until_t{
+            task->t_until_eof ? until_type_t::eof : until_type_t::line,
+            LineType{task->t_until_line},
+        };
+        return true;
+    }
+
+    if (this->gp_queue.empty()) {
+        return false;
+    }
+
+    req_out = this->gp_queue.front();
+    this->gp_queue.pop_front();
+    return true;
+}
+
+template<typename LineType>
+void
+grep_proc<LineType>::child_push_matches()
+{
+    if (this->gp_child_ring == nullptr) {
+        return;
+    }
+
+    auto& pending = this->gp_child_pending;
+    if (pending.r_count > 0) {
+        while (!this->gp_child_ring->try_push(pending)) {
+            // The parent needs to drain the ring before there is room.
+            fmt::println(stdout, FMT_STRING("m"));
+            this->child_batch();
+            usleep(1000);
+        }
+        pending.r_count = 0;
+    }
+}
+
+template<typename LineType>
+void
+grep_proc<LineType>::child_notify_matches()
+{
+    if (this->gp_child_ring == nullptr) {
+        return;
+    }
+
+    this->child_push_matches();
+
+    auto written
+        = this->gp_child_ring->mr_written.load(std::memory_order_relaxed);
+    if (written != this->gp_child_notified) {
+        this->gp_child_notified = written;
+        fmt::println(stdout, FMT_STRING("m"));
+    }
+}
+
 template<typename LineType>
 void
 grep_proc<LineType>::cleanup()
@@ -311,10 +526,37 @@ grep_proc<LineType>::cleanup()
 
 template<typename LineType>
 void
-grep_proc<LineType>::dispatch_line(const string_fragment& line)
+grep_proc<LineType>::drain_matches(child_state& cs)
+{
+    if (cs.cs_match_ring == nullptr) {
+        return;
+    }
+
+    cs.cs_match_ring->drain([this](const grep_match_ring::range& r) {
+        if (this->gp_sink == nullptr) {
+            return;
+        }
+        for (uint32_t lpc = 0; lpc < r.r_count; lpc++) {
+            this->gp_sink->grep_match(*this, LineType{r.r_start + (int) lpc});
+        }
+    });
+}
+
+template<typename LineType>
+void
+grep_proc<LineType>::dispatch_line(child_state& cs,
+                                   const string_fragment& line)
 {
     require(line.is_valid());
 
+    if (line == "m") {
+        this->drain_matches(cs);
+        return;
+    }
+
+    // Any matches found before the line was sent need to be handled first.
+    this->drain_matches(cs);
+
     auto sv = line.to_string_view();
     auto h_scan_res = scn::scan<int>(sv, "h{}");
     if (h_scan_res) {
@@ -403,9 +645,9 @@ grep_proc<LineType>::check_poll_set(const std::vector<struct pollfd>& pollfds)
 
                     cs.cs_pipe_range = li.li_file_range;
                     cs.cs_line_buffer.read_range(li.li_file_range)
-                        .then([this](auto sbr) {
+                        .then([this, &cs](auto sbr) {
                             sbr.rtrim(is_line_ending);
-                            this->dispatch_line(sbr.to_string_fragment());
+                            this->dispatch_line(cs, sbr.to_string_fragment());
                         });
 
                     loop_count += 1;
@@ -416,6 +658,7 @@ grep_proc<LineType>::check_poll_set(const std::vector<struct pollfd>& pollfds)
                 }
 
                 if (drained && cs.cs_line_buffer.is_pipe_closed()) {
+                    this->drain_matches(cs);
                     cs.cs_pipe_range.clear();
                     cs.cs_line_buffer.reset();
                     auto finished = std::move(cs.cs_child).wait_for_child();
@@ -425,6 +668,7 @@ grep_proc<LineType>::check_poll_set(const std::vector<struct pollfd>& pollfds)
                     any_finished = true;
                 }
             } catch (line_buffer::error& e) {
+                this->drain_matches(cs);
                 cs.cs_pipe_range.clear();
                 cs.cs_line_buffer.reset();
                 auto finished = std::move(cs.cs_child).wait_for_child();
@@ -32,6 +32,7 @@
 #ifndef grep_proc_hh
 #define grep_proc_hh
 
+#include <atomic>
 #include <deque>
 #include <exception>
 #include <memory>
@@ -40,6 +41,7 @@
 #include <vector>
 
 #include <poll.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -55,6 +57,102 @@
 template<typename LineType>
 class grep_proc;
 
+/**
+ * Single-producer, single-consumer queue of matching line ranges that lives
+ * in memory shared between a grep_proc and one of its children.  Runs of
+ * consecutive matches are sent as a single range so that dense results do
+ * not need to be formatted and parsed a line at a time.
+ */
+struct grep_match_ring {
+    struct range {
+        int32_t r_start;
+        uint32_t r_count;
+    };
+
+    static constexpr size_t CAPACITY = 32 * 1024;
+
+    /** Map a new ring into shared memory, returns nullptr on failure. */
+    static grep_match_ring* create();
+
+    static void destroy(grep_match_ring* ring);
+
+    struct deleter {
+        void operator()(grep_match_ring* ring) const { destroy(ring); }
+    };
+
+    /** Called by the child to add a range, fails if the ring is full. */
+    bool try_push(range r)
+    {
+        auto written = this->mr_written.load(std::memory_order_relaxed);
+
+        if (written - this->mr_read.load(std::memory_order_acquire)
+            >= CAPACITY)
+        {
+            return false;
+        }
+        this->mr_ranges[written % CAPACITY] = r;
+        this->mr_written.store(written + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** Called by the parent to consume the ranges that have been pushed. */
+    template<typename F>
+    void drain(F func)
+    {
+        auto read = this->mr_read.load(std::memory_order_relaxed);
+        auto written = this->mr_written.load(std::memory_order_acquire);
+
+        while (read < written) {
+            func(this->mr_ranges[read % CAPACITY]);
+            read += 1;
+        }
+        this->mr_read.store(read, std::memory_order_release);
+    }
+
+    std::atomic<uint64_t> mr_written{0};
+    std::atomic<uint64_t> mr_read{0};
+    range mr_ranges[CAPACITY];
+};
+
+/**
+ * The search tasks for a grep_proc run, stored in memory shared with the
+ * children.  Each child claims the next unclaimed task when it finishes its
+ * current one, so children that get lines that are quick to search do not
+ * sit idle while others are still busy.
+ */
+struct grep_task_queue {
+    struct task {
+        int32_t t_start;
+        bool t_until_eof;
+        int32_t t_until_line;
+    };
+
+    /** Map a new queue with room for count tasks, nullptr on failure. */
+    static grep_task_queue* create(size_t count);
+
+    static void destroy(grep_task_queue* queue);
+
+    struct deleter {
+        void operator()(grep_task_queue* queue) const { destroy(queue); }
+    };
+
+    /** @return The next task to run or nullptr if there are none left. */
+    const task* claim()
+    {
+        auto index = this->tq_next.fetch_add(1, std::memory_order_relaxed);
+
+        if (index >= this->tq_count) {
+            return nullptr;
+        }
+        return &this->tq_tasks[index];
+    }
+
+    std::atomic<uint64_t> tq_next{0};
+    size_t tq_count{0};
+    size_t tq_map_size{0};
+    task* tq_tasks{nullptr};
+};
+
 /**
  * Data source for lines to be searched using a grep_proc.
  */
@@ -78,6 +176,19 @@ public:
                                                          std::string& value_out)
         = 0;
 
+    /**
+     * Check whether a line might match before its value is retrieved.
+     *
+     * @param line The line to check.
+     * @param literals The strings that must appear in a matching line.
+     * @return False if the line cannot match and can be skipped.
+     */
+    virtual bool grep_may_match(LineType line,
+                                const std::vector<std::string>& literals)
+    {
+        return true;
+    }
+
     virtual LineType grep_initial_line(LineType start, LineType highest)
     {
         if (start == -1) {
@@ -88,6 +199,13 @@ public:
 
     virtual void grep_next_line(LineType& line) { line = line + LineType(1); }
 
+    /**
+     * @return The number of lines currently in the source if they are
+     * numbered sequentially from zero, otherwise nullopt.  A search to the
+     * end of the source is split into tasks up to this line.
+     */
+    virtual std::optional<LineType> grep_line_count() { return std::nullopt; }
+
     grep_proc<LineType>* gps_proc;
 };
 
@@ -241,6 +359,8 @@ public:
         auto_fd cs_err_pipe;
         line_buffer cs_line_buffer;
         file_range cs_pipe_range;
+        std::unique_ptr<grep_match_ring, grep_match_ring::deleter>
+            cs_match_ring;
 
         explicit child_state(auto_pid<process_state::running> child)
             : cs_child(std::move(child))
@@ -252,7 +372,12 @@ protected:
     /**
      * Dispatch a line received from the child.
      */
-    void dispatch_line(const string_fragment& line);
+    void dispatch_line(child_state& cs, const string_fragment& line);
+
+    /**
+     * Pass the matches that the child has put in its ring to the sink.
+     */
+    void drain_matches(child_state& cs);
 
     /**
      * Free any resources used by the object and make sure the child has been
@@ -262,6 +387,24 @@ protected:
 
     void child_loop();
 
+    /**
+     * Get the next request to be processed by a child.
+     *
+     * @return False if there are no more requests.
+     */
+    bool child_next_request(std::pair<LineType, request_until_t>& req_out);
+
+    /**
+     * Add the pending range of matches to the ring shared with the parent.
+     */
+    void child_push_matches();
+
+    /**
+     * Push any pending matches and tell the parent there are new matches to
+     * be drained from the ring.
+     */
+    void child_notify_matches();
+
     virtual void child_init() {};
 
     virtual void child_batch() { fflush(stdout); }
@@ -283,6 +426,13 @@ protected:
                                   */
     grep_proc_sink<LineType>* gp_sink{nullptr}; /*< The sink delegate. */
     grep_proc_control* gp_control{nullptr}; /*< The control delegate. */
+
+    /** The shared queue of tasks, only set in a child. */
+    grep_task_queue* gp_child_tasks{nullptr};
+    /** The ring used to send matches to the parent, only set in a child. */
+    grep_match_ring* gp_child_ring{nullptr};
+    grep_match_ring::range gp_child_pending{0, 0};
+    uint64_t gp_child_notified{0};
 };
 
 #endif
@@ -0,0 +1,403 @@
+/**
+ * Copyright (c) 2026, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file line_buffer.bz2_index.cc
+ */
+
+#include <algorithm>
+#include <future>
+#include <thread>
+
+#include "line_buffer.bz2_index.hh"
+
+#include <string.h>
+#include <unistd.h>
+
+#include "base/lnav_log.hh"
+#include "config.h"
+
+#ifdef HAVE_BZLIB_H
+#    include <bzlib.h>
+#endif
+
+namespace lnav {
+
+namespace {
+
+constexpr uint64_t BLOCK_MAGIC = 0x314159265359ULL;
+constexpr uint64_t EOS_MAGIC = 0x177245385090ULL;
+constexpr uint64_t MAGIC_MASK = (1ULL << 48) - 1;
+constexpr size_t SCAN_SIZE = 1024 * 1024;
+
+size_t
+batch_size()
+{
+    return std::clamp<size_t>(std::thread::hardware_concurrency(), 2, 16);
+}
+
+/** Appends bits to a buffer, most-significant bit first. */
+class bit_writer {
+public:
+    void put(uint64_t value, int count)
+    {
+        for (auto lpc = count - 1; lpc >= 0; lpc--) {
+            this->bw_acc = (this->bw_acc << 1) | ((value >> lpc) & 1);
+            this->bw_count += 1;
+            if (this->bw_count == 8) {
+                this->bw_out.push_back((char) this->bw_acc);
+                this->bw_acc = 0;
+                this->bw_count = 0;
+            }
+        }
+    }
+
+    std::string finish()
+    {
+        if (this->bw_count > 0) {
+            this->put(0, 8 - this->bw_count);
+        }
+        return std::move(this->bw_out);
+    }
+
+    std::string bw_out;
+    uint8_t bw_acc{0};
+    int bw_count{0};
+};
+
+/**
+ * Turn the bits of a single block into a complete bzip2 stream and
+ * decompress it.  The stream gets a header with the largest block size and
+ * an end-of-stream marker whose combined CRC is the CRC of the block.
+ */
+Result<std::string, std::string>
+decode_block(int fd, uint64_t start_bit, uint64_t end_bit)
+{
+#ifdef HAVE_BZLIB_H
+    auto start_byte = static_cast<file_off_t>(start_bit / 8);
+    auto end_byte = static_cast<file_off_t>((end_bit + 7) / 8);
+    // One extra byte so the shifts below never read past the end.
+    std::string in(end_byte - start_byte + 1, '\0');
+    size_t total = 0;
+    while (total < in.size() - 1) {
+        auto rc = pread(
+            fd, &in[total], in.size() - 1 - total, start_byte + total);
+        if (rc == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return Err(std::string(strerror(errno)));
+        }
+        if (rc == 0) {
+            return Err(std::string("unexpected end of file"));
+        }
+        total += rc;
+    }
+
+    const auto shift = start_bit % 8;
+    const auto* ubits = reinterpret_cast<const uint8_t*>(in.data());
+    auto bit_at = [&](uint64_t bit) -> uint64_t {
+        auto rel = bit - start_byte * 8;
+        return (ubits[rel / 8] >> (7 - rel % 8)) & 1;
+    };
+    auto byte_at = [&](size_t index) -> uint8_t {
+        if (shift == 0) {
+            return ubits[index];
+        }
+        return (ubits[index] << shift) | (ubits[index + 1] >> (8 - shift));
+    };
+
+    auto block_bits = end_bit - start_bit;
+    uint64_t crc = 0;
+    for (uint64_t lpc = 0; lpc < 32; lpc++) {
+        crc = (crc << 1) | bit_at(start_bit + 48 + lpc);
+    }
+
+    bit_writer bw;
+    bw.bw_out.reserve(4 + block_bits / 8 + 12);
+    bw.bw_out.append("BZh9");
+    for (size_t lpc = 0; lpc < block_bits / 8; lpc++) {
+        bw.bw_out.push_back((char) byte_at(lpc));
+    }
+    for (auto bit = start_bit + (block_bits / 8) * 8; bit < end_bit; bit++) {
+        bw.put(bit_at(bit), 1);
+    }
+    bw.put(EOS_MAGIC, 48);
+    bw.put(crc, 32);
+    auto stream = bw.finish();
+
+    bz_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    if (BZ2_bzDecompressInit(&strm, 0, 0) != BZ_OK) {
+        return Err(std::string("unable to initialize bzip2 decompression"));
+    }
+
+    std::string retval;
+    retval.resize(std::max<size_t>(stream.size() * 4, 64 * 1024));
+    strm.next_in = stream.data();
+    strm.avail_in = stream.size();
+    size_t produced = 0;
+    std::optional<std::string> error;
+    while (true) {
+        strm.next_out = &retval[produced];
+        strm.avail_out = retval.size() - produced;
+        auto rc = BZ2_bzDecompress(&strm);
+        produced = retval.size() - strm.avail_out;
+        if (rc == BZ_STREAM_END) {
+            break;
+        }
+        if (rc != BZ_OK) {
+            error = "corrupt block (" + std::to_string(rc) + ")";
+            break;
+        }
+        if (strm.avail_out == 0) {
+            retval.resize(retval.size() * 2);
+        } else if (strm.avail_in == 0) {
+            error = std::string("truncated block");
+            break;
+        }
+    }
+    BZ2_bzDecompressEnd(&strm);
+
+    if (error) {
+        return Err(error.value());
+    }
+
+    retval.resize(produced);
+    return Ok(std::move(retval));
+#else
+    return Err(std::string("bzip2 support is not available"));
+#endif
+}
+
+}  // namespace
+
+Result<void, std::string>
+bz2_index::scan(int fd)
+{
+    std::string buf(SCAN_SIZE, '\0');
+
+    auto rc = pread(fd, buf.data(), buf.size(), this->bi_scan_offset);
+    if (rc == -1) {
+        return Err(std::string(strerror(errno)));
+    }
+    if (rc == 0) {
+        this->bi_scan_done = true;
+        return Ok();
+    }
+
+    for (ssize_t lpc = 0; lpc < rc; lpc++) {
+        this->bi_scan_window
+            = (this->bi_scan_window << 8) | static_cast<uint8_t>(buf[lpc]);
+        auto end_bit = static_cast<uint64_t>(this->bi_scan_offset + lpc + 1)
+            * 8;
+        // Check the alignments from the earliest start to the latest.
+        for (int shift = 7; shift >= 0; shift--) {
+            auto bits = (this->bi_scan_window >> shift) & MAGIC_MASK;
+            if (bits != BLOCK_MAGIC && bits != EOS_MAGIC) {
+                continue;
+            }
+            auto start_bit = end_bit - shift - 48;
+            if (end_bit < (uint64_t) shift + 48
+                || (!this->bi_magic_bits.empty()
+                    && start_bit < this->bi_magic_bits.back() + 48))
+            {
+                continue;
+            }
+            this->bi_magic_bits.emplace_back(start_bit);
+            this->bi_magic_is_block.push_back(bits == BLOCK_MAGIC);
+        }
+    }
+    this->bi_scan_offset += rc;
+
+    return Ok();
+}
+
+Result<void, std::string>
+bz2_index::extend(int fd)
+{
+    const auto max_batch = batch_size();
+    std::vector<std::pair<size_t, block>> batch;
+    auto next = this->bi_next_magic;
+
+    while (true) {
+        for (; batch.size() < max_batch
+             && next + 1 < this->bi_magic_bits.size();
+             next++)
+        {
+            if (this->bi_magic_is_block[next]) {
+                batch.emplace_back(next,
+                                   block{
+                                       this->bi_magic_bits[next],
+                                       this->bi_magic_bits[next + 1],
+                                   });
+            }
+        }
+        if (batch.size() >= max_batch || this->bi_scan_done) {
+            break;
+        }
+        TRY(this->scan(fd));
+    }
+
+    if (batch.empty()) {
+        for (; next < this->bi_magic_bits.size(); next++) {
+            if (this->bi_magic_is_block[next]) {
+                return Err(std::string("file ends in the middle of a block"));
+            }
+        }
+        return Ok();
+    }
+
+    std::vector<std::future<Result<std::string, std::string>>> futures;
+    for (const auto& pair : batch) {
+        futures.emplace_back(std::async(std::launch::async,
+                                        decode_block,
+                                        fd,
+                                        pair.second.b_start_bit,
+                                        pair.second.b_end_bit));
+    }
+
+    auto out_offset = this->bi_blocks.empty()
+        ? file_off_t{0}
+        : this->bi_blocks.back().end_offset();
+    std::optional<std::string> error;
+    for (size_t lpc = 0; lpc < batch.size(); lpc++) {
+        auto decode_res = futures[lpc].get();
+        if (error) {
+            continue;
+        }
+        if (decode_res.isErr()) {
+            error = decode_res.unwrapErr();
+            continue;
+        }
+
+        auto data = std::make_shared<const std::string>(decode_res.unwrap());
+        auto& blk = batch[lpc].second;
+        blk.b_out_offset = out_offset;
+        blk.b_out_size = data->size();
+        out_offset += data->size();
+        this->bi_blocks.emplace_back(blk);
+        this->bi_next_magic = batch[lpc].first + 1;
+        this->cache(this->bi_blocks.size() - 1, std::move(data));
+    }
+    if (error) {
+        return Err(error.value());
+    }
+
+    return Ok();
+}
+
+void
+bz2_index::cache(size_t index, std::shared_ptr<const std::string> data)
+{
+    this->bi_use_counter += 1;
+    if (this->bi_cache.size() < batch_size()) {
+        this->bi_cache.emplace_back(
+            cached_block{index, this->bi_use_counter, std::move(data)});
+        return;
+    }
+
+    auto lru = std::min_element(
+        this->bi_cache.begin(),
+        this->bi_cache.end(),
+        [](const auto& lhs, const auto& rhs) {
+            return lhs.cb_last_used < rhs.cb_last_used;
+        });
+    *lru = cached_block{index, this->bi_use_counter, std::move(data)};
+}
+
+Result<std::shared_ptr<const std::string>, std::string>
+bz2_index::decoded(int fd, size_t index)
+{
+    for (auto& cb : this->bi_cache) {
+        if (cb.cb_index == index) {
+            this->bi_use_counter += 1;
+            cb.cb_last_used = this->bi_use_counter;
+            return Ok(cb.cb_data);
+        }
+    }
+
+    const auto& blk = this->bi_blocks[index];
+    auto data = std::make_shared<const std::string>(
+        TRY(decode_block(fd, blk.b_start_bit, blk.b_end_bit)));
+    if (data->size() != blk.b_out_size) {
+        return Err(std::string("block size changed"));
+    }
+    this->cache(index, data);
+
+    return Ok(data);
+}
+
+Result<size_t, std::string>
+bz2_index::read(int fd, void* buf, file_off_t offset, size_t size)
+{
+    auto* dst = static_cast<char*>(buf);
+    size_t retval = 0;
+
+    while (retval < size) {
+        auto pos = offset + static_cast<file_off_t>(retval);
+        auto end_of_index = this->bi_blocks.empty()
+            ? file_off_t{0}
+            : this->bi_blocks.back().end_offset();
+
+        if (pos >= end_of_index) {
+            auto before = this->bi_blocks.size();
+            TRY(this->extend(fd));
+            if (this->bi_blocks.size() == before) {
+                break;
+            }
+            continue;
+        }
+
+        auto iter = std::upper_bound(
+            this->bi_blocks.begin(),
+            this->bi_blocks.end(),
+            pos,
+            [](file_off_t lhs, const block& rhs) {
+                return lhs < rhs.b_out_offset;
+            });
+        auto index = std::distance(this->bi_blocks.begin(), iter) - 1;
+        const auto& blk = this->bi_blocks[index];
+        auto data = TRY(this->decoded(fd, index));
+        auto block_off = static_cast<size_t>(pos - blk.b_out_offset);
+        auto amount = std::min(size - retval, data->size() - block_off);
+
+        memcpy(&dst[retval], data->data() + block_off, amount);
+        retval += amount;
+        this->bi_source_offset = blk.b_end_bit / 8;
+    }
+
+    return Ok(retval);
+}
+
+void
+bz2_index::clear()
+{
+    *this = bz2_index{};
+}
+
+}  // namespace lnav
@@ -0,0 +1,139 @@
+/**
+ * Copyright (c) 2026, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file line_buffer.bz2_index.hh
+ */
+
+#ifndef lnav_line_buffer_bz2_index_hh
+#define lnav_line_buffer_bz2_index_hh
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+#include "base/file_range.hh"
+#include "base/result.h"
+
+namespace lnav {
+
+/**
+ * Random access to the content of a bzip2 file.  A bzip2 stream is made up
+ * of blocks that start with a 48-bit magic number at an arbitrary bit
+ * offset and can be decompressed independently of each other.  The index
+ * finds the block boundaries as the file is read and records the offset of
+ * each block in the uncompressed data.  Blocks are decompressed in batches
+ * on multiple threads and the most recent ones are kept in memory, so a
+ * read only costs the blocks that it covers instead of decompressing the
+ * file from the start.
+ *
+ * The index is built incrementally, reading further into the file only
+ * decompresses the blocks up to that point.
+ */
+class bz2_index {
+public:
+    /**
+     * Read the uncompressed data at the given offset from the file.
+     *
+     * @return The number of bytes read, which is less than the size only
+     * when the end of the data was reached.
+     */
+    Result<size_t, std::string> read(int fd,
+                                     void* buf,
+                                     file_off_t offset,
+                                     size_t size);
+
+    /**
+     * @return The offset in the compressed file after the last block that
+     * was decompressed.
+     */
+    file_off_t get_source_offset() const { return this->bi_source_offset; }
+
+    /**
+     * @return False if an earlier read failed and the file needs to be
+     * read sequentially instead.
+     */
+    bool is_usable() const { return this->bi_usable; }
+
+    void disable() { this->bi_usable = false; }
+
+    void clear();
+
+private:
+    struct block {
+        /** The bit offset of the block magic in the file. */
+        uint64_t b_start_bit;
+        /** The bit offset of the magic that follows the block. */
+        uint64_t b_end_bit;
+        file_off_t b_out_offset{0};
+        size_t b_out_size{0};
+
+        file_off_t end_offset() const
+        {
+            return this->b_out_offset
+                + static_cast<file_off_t>(this->b_out_size);
+        }
+    };
+
+    struct cached_block {
+        size_t cb_index;
+        uint64_t cb_last_used;
+        std::shared_ptr<const std::string> cb_data;
+    };
+
+    /** Find more block boundaries in the file. */
+    Result<void, std::string> scan(int fd);
+
+    /** Decompress the next batch of blocks to learn their sizes. */
+    Result<void, std::string> extend(int fd);
+
+    Result<std::shared_ptr<const std::string>, std::string> decoded(
+        int fd, size_t index);
+
+    void cache(size_t index, std::shared_ptr<const std::string> data);
+
+    bool bi_usable{true};
+    /** The bit offsets of the block and end-of-stream magic numbers. */
+    std::vector<uint64_t> bi_magic_bits;
+    std::vector<bool> bi_magic_is_block;
+    /** The first magic that has not been turned into a block yet. */
+    size_t bi_next_magic{0};
+    /** The blocks whose uncompressed size is known. */
+    std::vector<block> bi_blocks;
+    file_off_t bi_scan_offset{0};
+    uint64_t bi_scan_window{0};
+    bool bi_scan_done{false};
+    file_off_t bi_source_offset{0};
+    uint64_t bi_use_counter{0};
+    std::vector<cached_block> bi_cache;
+};
+
+}  // namespace lnav
+
+#endif
@@ -33,6 +33,8 @@
 #include <fcntl.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include "config.h"
@@ -42,7 +44,10 @@
 #endif
 
 #include <algorithm>
+#include <deque>
+#include <numeric>
 #include <set>
+#include <thread>
 
 #include "base/auto_mem.hh"
 #include "base/auto_pid.hh"
@@ -134,6 +139,79 @@ private:
 
 #define Z_BUFSIZE      65536U
 #define SYNCPOINT_SIZE (1024 * 1024)
+
+static constexpr char GZ_INDEX_MAGIC[8] = "lnavgzi";
+static constexpr uint32_t GZ_INDEX_VERSION = 1;
+
+/**
+ * The syncpoint indexes are small compared to the decompressed content, so
+ * they are kept around longer.
+ */
+static constexpr auto GZ_INDEX_TTL = std::chrono::hours(7 * 24);
+
+/** The identity of the compressed file that the saved syncpoints are for. */
+struct gz_index_header {
+    char gih_magic[sizeof(GZ_INDEX_MAGIC)];
+    uint32_t gih_version;
+    uint32_t gih_window_size;
+    uint64_t gih_dev;
+    uint64_t gih_ino;
+    int64_t gih_size;
+    int64_t gih_mtime;
+    uint64_t gih_count;
+};
+
+struct gz_index_entry {
+    int64_t gie_in;
+    int64_t gie_out;
+    uint8_t gie_bits;
+    uint8_t gie_in_bits;
+    uint32_t gie_window_size; /*< The size of the compressed window. */
+};
+
+static std::filesystem::path
+line_buffer_cache_path()
+{
+    return lnav::paths::workdir() / "buffer-cache";
+}
+
+static gz_index_header
+gz_index_header_for(const struct stat& st)
+{
+    gz_index_header retval;
+
+    memset(&retval, 0, sizeof(retval));
+    memcpy(retval.gih_magic, GZ_INDEX_MAGIC, sizeof(GZ_INDEX_MAGIC));
+    retval.gih_version = GZ_INDEX_VERSION;
+    retval.gih_window_size = GZ_WINSIZE;
+    retval.gih_dev = st.st_dev;
+    retval.gih_ino = st.st_ino;
+    retval.gih_size = st.st_size;
+    retval.gih_mtime = st.st_mtime;
+
+    return retval;
+}
+
+static bool
+pwrite_fully(int fd, const void* buf, size_t len, file_off_t off)
+{
+    const auto* bits = static_cast<const char*>(buf);
+
+    while (len > 0) {
+        auto rc = pwrite(fd, bits, len, off);
+        if (rc == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        bits += rc;
+        off += rc;
+        len -= rc;
+    }
+
+    return true;
+}
 line_buffer::gz_indexed::gz_indexed()
 {
     if ((this->inbuf = auto_mem<Bytef>::malloc(Z_BUFSIZE)) == nullptr) {
@@ -146,10 +224,13 @@ line_buffer::gz_indexed::close()
 {
     // Release old stream, if we were open
     if (*this) {
+        this->save_index();
         inflateEnd(&this->strm);
         ::close(this->gz_fd);
         this->syncpoints.clear();
         this->gz_fd = -1;
+        this->gz_index_path = std::nullopt;
+        this->gz_saved_syncpoints = 0;
     }
 }
 
@@ -259,6 +340,182 @@ line_buffer::gz_indexed::open(int fd, lnav::gzip::header& hd)
     } else {
         log_error("%d: unable to get gzip header", fd);
     }
+
+    struct stat st;
+    if (fstat(fd, &st) == 0) {
+        auto base_name = hasher()
+                             .update(st.st_dev)
+                             .update(st.st_ino)
+                             .update(st.st_size)
+                             .update(st.st_mtime)
+                             .to_string();
+        this->gz_index_path = line_buffer_cache_path()
+            / base_name.substr(0, 2)
+            / fmt::format(FMT_STRING("{}.gzidx"), base_name);
+        this->load_index();
+    }
+}
+
+void
+line_buffer::gz_indexed::load_index()
+{
+    if (!this->gz_index_path) {
+        return;
+    }
+
+    const auto& path = this->gz_index_path.value();
+    std::error_code ec;
+    if (!std::filesystem::exists(path, ec)) {
+        return;
+    }
+
+    auto read_res = lnav::filesystem::read_file(path);
+    if (read_res.isErr()) {
+        log_error("%d: unable to read gzip index: %s -- %s",
+                  this->gz_fd,
+                  path.c_str(),
+                  read_res.unwrapErr().c_str());
+        return;
+    }
+
+    struct stat st;
+    if (fstat(this->gz_fd, &st) == -1) {
+        return;
+    }
+
+    auto content = read_res.unwrap();
+    auto expected = gz_index_header_for(st);
+    gz_index_header hdr;
+    if (content.size() < sizeof(hdr)) {
+        log_error("%d: gzip index is truncated: %s", this->gz_fd, path.c_str());
+        return;
+    }
+    memcpy(&hdr, content.data(), sizeof(hdr));
+    if (memcmp(hdr.gih_magic, expected.gih_magic, sizeof(hdr.gih_magic)) != 0
+        || hdr.gih_version != expected.gih_version
+        || hdr.gih_window_size != expected.gih_window_size
+        || hdr.gih_dev != expected.gih_dev || hdr.gih_ino != expected.gih_ino
+        || hdr.gih_size != expected.gih_size
+        || hdr.gih_mtime != expected.gih_mtime)
+    {
+        log_info(
+            "%d: ignoring stale gzip index: %s", this->gz_fd, path.c_str());
+        return;
+    }
+
+    std::vector<indexDict> loaded;
+    size_t off = sizeof(hdr);
+    // The count in the header is not trusted for the allocation since
+    // every entry takes up at least sizeof(gz_index_entry) bytes.
+    auto max_entries = (content.size() - sizeof(hdr)) / sizeof(gz_index_entry);
+    loaded.reserve(std::min<uint64_t>(hdr.gih_count, max_entries));
+    for (uint64_t lpc = 0; lpc < hdr.gih_count; lpc++) {
+        gz_index_entry entry;
+
+        if (content.size() - off < sizeof(entry)) {
+            log_error("%d: gzip index is truncated: %s",
+                      this->gz_fd,
+                      path.c_str());
+            return;
+        }
+        memcpy(&entry, &content[off], sizeof(entry));
+        off += sizeof(entry);
+        if (content.size() - off < entry.gie_window_size
+            || (!loaded.empty() && entry.gie_out <= loaded.back().out))
+        {
+            log_error(
+                "%d: gzip index is corrupt: %s", this->gz_fd, path.c_str());
+            return;
+        }
+
+        auto& dict = loaded.emplace_back();
+        uLongf window_size = GZ_WINSIZE;
+        auto rc = uncompress(dict.index,
+                             &window_size,
+                             (const Bytef*) &content[off],
+                             entry.gie_window_size);
+        if (rc != Z_OK || window_size != GZ_WINSIZE) {
+            log_error(
+                "%d: gzip index is corrupt: %s", this->gz_fd, path.c_str());
+            return;
+        }
+        off += entry.gie_window_size;
+        dict.in = entry.gie_in;
+        dict.out = entry.gie_out;
+        dict.bits = entry.gie_bits;
+        dict.in_bits = entry.gie_in_bits;
+    }
+
+    log_info("%d: loaded %zu syncpoints from gzip index: %s",
+             this->gz_fd,
+             loaded.size(),
+             path.c_str());
+    this->syncpoints = std::move(loaded);
+    this->gz_saved_syncpoints = this->syncpoints.size();
+    // Keep the index from expiring while the file is in use.
+    std::filesystem::last_write_time(
+        path, std::filesystem::file_time_type::clock::now(), ec);
+}
+
+void
+line_buffer::gz_indexed::save_index()
+{
+    if (!this->gz_index_path
+        || this->syncpoints.size() <= this->gz_saved_syncpoints)
+    {
+        return;
+    }
+
+    struct stat st;
+    if (fstat(this->gz_fd, &st) == -1) {
+        return;
+    }
+
+    const auto& path = this->gz_index_path.value();
+    auto hdr = gz_index_header_for(st);
+    hdr.gih_count = this->syncpoints.size();
+
+    std::string content;
+    content.append((const char*) &hdr, sizeof(hdr));
+    auto window_buf = auto_buffer::alloc(compressBound(GZ_WINSIZE));
+    for (const auto& dict : this->syncpoints) {
+        gz_index_entry entry;
+        uLongf window_size = window_buf.capacity();
+
+        auto rc = compress2(
+            window_buf.u_in(), &window_size, dict.index, GZ_WINSIZE, 1);
+        if (rc != Z_OK) {
+            log_error("%d: unable to compress gzip index window",
+                      this->gz_fd);
+            return;
+        }
+        memset(&entry, 0, sizeof(entry));
+        entry.gie_in = dict.in;
+        entry.gie_out = dict.out;
+        entry.gie_bits = dict.bits;
+        entry.gie_in_bits = dict.in_bits;
+        entry.gie_window_size = window_size;
+        content.append((const char*) &entry, sizeof(entry));
+        content.append(window_buf.in(), window_size);
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+    auto write_res = lnav::filesystem::write_file(
+        path, string_fragment::from_str(content));
+    if (write_res.isErr()) {
+        log_error("%d: unable to write gzip index: %s -- %s",
+                  this->gz_fd,
+                  path.c_str(),
+                  write_res.unwrapErr().c_str());
+        return;
+    }
+
+    log_info("%d: saved %zu syncpoints to gzip index: %s",
+             this->gz_fd,
+             this->syncpoints.size(),
+             path.c_str());
+    this->gz_saved_syncpoints = this->syncpoints.size();
 }
 
 int
@@ -373,6 +630,140 @@ line_buffer::gz_indexed::read(void* buf, size_t offset, size_t size)
     return bytes;
 }
 
+/**
+ * Decompress the data from the given syncpoint, or the start of the file,
+ * up to the end offset and write it at the same offset in the output file.
+ * Only local state is used so that several ranges can be decompressed at
+ * the same time.
+ */
+static Result<void, std::string>
+inflate_range_to(int gz_fd,
+                 line_buffer::gz_indexed::indexDict* start,
+                 file_off_t end_out,
+                 int out_fd)
+{
+    z_stream strm{};
+    file_off_t in_off = 0;
+    file_off_t out_off = 0;
+    auto raw = start != nullptr;
+
+    if (start != nullptr) {
+        if (start->apply(&strm) != Z_OK) {
+            return Err(std::string("unable to apply syncpoint"));
+        }
+        in_off = start->in;
+        out_off = start->out;
+    } else if (inflateInit2(&strm, GZ_HEADER_MODE) != Z_OK) {
+        return Err(std::string("unable to initialize inflate"));
+    }
+
+    auto inbuf = auto_buffer::alloc(Z_BUFSIZE);
+    auto outbuf = auto_buffer::alloc(Z_BUFSIZE);
+    size_t skip_in = 0;
+    std::optional<std::string> error;
+    while (out_off < end_out) {
+        if (strm.avail_in == 0) {
+            auto rc = pread(gz_fd, inbuf.in(), Z_BUFSIZE, in_off);
+            if (rc <= 0) {
+                error = rc == 0 ? std::string("unexpected end of file")
+                                : lnav::from_errno().message();
+                break;
+            }
+            in_off += rc;
+            strm.next_in = inbuf.u_in();
+            strm.avail_in = rc;
+        }
+        if (skip_in > 0) {
+            auto amount = std::min(skip_in, (size_t) strm.avail_in);
+
+            strm.next_in += amount;
+            strm.avail_in -= amount;
+            skip_in -= amount;
+            continue;
+        }
+
+        auto want = std::min((file_off_t) Z_BUFSIZE, end_out - out_off);
+        strm.next_out = outbuf.u_in();
+        strm.avail_out = want;
+        auto err = inflate(&strm, Z_NO_FLUSH);
+        auto produced = want - strm.avail_out;
+        if (produced > 0) {
+            if (!pwrite_fully(out_fd, outbuf.in(), produced, out_off)) {
+                error = lnav::from_errno().message();
+                break;
+            }
+            out_off += produced;
+        }
+        if (err == Z_STREAM_END) {
+            // Another gzip member may follow.  A raw stream stops before
+            // the member trailer, so that needs to be skipped over.
+            if (raw) {
+                skip_in = 8;
+                raw = false;
+            }
+            inflateReset2(&strm, GZ_HEADER_MODE);
+        } else if (err != Z_OK && !(err == Z_BUF_ERROR && strm.avail_in == 0))
+        {
+            error = fmt::format(FMT_STRING("inflate-error at offset {}: {}"),
+                                in_off - strm.avail_in,
+                                err);
+            break;
+        }
+    }
+    inflateEnd(&strm);
+
+    if (error) {
+        return Err(error.value());
+    }
+
+    return Ok();
+}
+
+Result<file_off_t, std::string>
+line_buffer::gz_indexed::inflate_ranges_to(int out_fd)
+{
+    if (this->syncpoints.empty()) {
+        return Ok(file_off_t{0});
+    }
+
+    const size_t max_in_flight
+        = std::max(1U, std::thread::hardware_concurrency());
+    std::deque<std::future<Result<void, std::string>>> in_flight;
+    std::optional<std::string> error;
+
+    auto collect = [&in_flight, &error]() {
+        auto res = in_flight.front().get();
+        in_flight.pop_front();
+        if (res.isErr() && !error) {
+            error = res.unwrapErr();
+        }
+    };
+
+    for (size_t lpc = 0; lpc < this->syncpoints.size(); lpc++) {
+        auto* start = lpc == 0 ? nullptr : &this->syncpoints[lpc - 1];
+        auto end_out = this->syncpoints[lpc].out;
+
+        if (in_flight.size() >= max_in_flight) {
+            collect();
+        }
+        in_flight.emplace_back(std::async(std::launch::async,
+                                          inflate_range_to,
+                                          this->gz_fd,
+                                          start,
+                                          end_out,
+                                          out_fd));
+    }
+    while (!in_flight.empty()) {
+        collect();
+    }
+
+    if (error) {
+        return Err(error.value());
+    }
+
+    return Ok(file_off_t{this->syncpoints.back().out});
+}
+
 line_buffer::line_buffer()
 {
     this->lb_gz_file.writeAccess()->parent = this;
@@ -398,6 +789,9 @@ line_buffer::set_fd(auto_fd& fd)
 {
     file_off_t newoff = 0;
 
+    this->drop_mapping();
+    this->lb_mapping_failed = false;
+
     {
         safe::WriteAccess<safe_gz_indexed> gi(this->lb_gz_file);
 
@@ -408,6 +802,12 @@ line_buffer::set_fd(auto_fd& fd)
 
     if (this->lb_bz_file) {
         this->lb_bz_file = false;
+        this->lb_bz_index.writeAccess()->clear();
+    }
+
+    if (this->lb_zstd_file) {
+        this->lb_zstd_file = false;
+        this->lb_zstd_index.writeAccess()->clear();
     }
 
     if (fd != -1) {
@@ -496,11 +896,31 @@ line_buffer::set_fd(auto_fd& fd)
                     this->lb_compressed_offset = 0;
                 }
 #endif
+#ifdef HAVE_ZSTD_H
+                else if (lnav::zstd_index::is_zstd(gz_id, sizeof(gz_id)))
+                {
+                    this->lb_zstd_file = true;
+                    this->lb_compressed = true;
+
+                    if (this->lb_decompress_extra) {
+                        this->resize_buffer(INITIAL_COMPRESSED_BUFFER_SIZE);
+                    }
+
+                    this->lb_compressed_offset = 0;
+                }
+#endif
             }
             this->lb_seekable = true;
+#ifdef POSIX_FADV_SEQUENTIAL
+            if (!this->lb_compressed) {
+                posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+            }
+#endif
         }
     }
     this->lb_file_offset = newoff;
+    this->lb_last_read_end = -1;
+    this->lb_readahead_end = 0;
     this->lb_buffer.clear();
     this->lb_fd = std::move(fd);
 
@@ -622,6 +1042,112 @@ line_buffer::ensure_available(file_off_t start,
     this->lb_line_col_widths.clear();
 }
 
+#ifdef HAVE_BZLIB_H
+ssize_t
+line_buffer::read_bz2(void* buf, file_off_t offset, size_t size)
+{
+    {
+        safe::WriteAccess<safe_bz2_index> bi(this->lb_bz_index);
+
+        if (bi->is_usable()) {
+            auto read_res = bi->read(this->lb_fd, buf, offset, size);
+            if (read_res.isOk()) {
+                this->lb_compressed_offset = bi->get_source_offset();
+                return read_res.unwrap();
+            }
+
+            log_error("%d: unable to read bzip2 blocks, reading sequentially "
+                      "instead -- %s",
+                      this->lb_fd.get(),
+                      read_res.unwrapErr().c_str());
+            bi->disable();
+        }
+    }
+
+    lock_hack::guard guard;
+    char scratch[32 * 1024];
+    BZFILE* bz_file;
+    file_off_t seek_to;
+    int bzfd;
+
+    /*
+     * Unfortunately, there is no bzseek, so we need to reopen the
+     * file every time we want to do a read.
+     */
+    bzfd = dup(this->lb_fd);
+    if (lseek(this->lb_fd, 0, SEEK_SET) < 0) {
+        close(bzfd);
+        throw error(errno);
+    }
+    if ((bz_file = BZ2_bzdopen(bzfd, "r")) == nullptr) {
+        close(bzfd);
+        if (errno == 0) {
+            throw std::bad_alloc();
+        } else {
+            throw error(errno);
+        }
+    }
+
+    seek_to = offset;
+    while (seek_to > 0) {
+        int count;
+
+        count = BZ2_bzread(
+            bz_file, scratch, std::min((size_t) seek_to, sizeof(scratch)));
+        if (count <= 0) {
+            break;
+        }
+        seek_to -= count;
+    }
+    auto rc = BZ2_bzread(bz_file, buf, size);
+    this->lb_compressed_offset = 0;
+    BZ2_bzclose(bz_file);
+
+    return rc;
+}
+#endif
+
+#ifdef HAVE_ZSTD_H
+ssize_t
+line_buffer::read_zstd(void* buf, file_off_t offset, size_t size)
+{
+    safe::WriteAccess<safe_zstd_index> zi(this->lb_zstd_index);
+
+    auto read_res = zi->read(this->lb_fd, buf, offset, size);
+    if (read_res.isErr()) {
+        log_error("%d: unable to read zstd frames -- %s",
+                  this->lb_fd.get(),
+                  read_res.unwrapErr().c_str());
+        this->lb_decompress_error = fmt::format(
+            FMT_STRING("zstd error at offset {}: {}"),
+            zi->get_source_offset(),
+            read_res.unwrapErr());
+        return 0;
+    }
+
+    this->lb_compressed_offset = zi->get_source_offset();
+    return read_res.unwrap();
+}
+#endif
+
+ssize_t
+line_buffer::read_indexed(void* buf, file_off_t offset, size_t size)
+{
+#ifdef HAVE_BZLIB_H
+    if (this->lb_bz_file) {
+        return this->read_bz2(buf, offset, size);
+    }
+#endif
+#ifdef HAVE_ZSTD_H
+    if (this->lb_zstd_file) {
+        return this->read_zstd(buf, offset, size);
+    }
+#endif
+
+    errno = EINVAL;
+    return -1;
+}
+
 bool
 line_buffer::load_next_buffer()
 {
@@ -641,7 +1167,13 @@ line_buffer::load_next_buffer()
               start + this->lb_alt_buffer->size());
 #endif
     /* ... read in the new data. */
-    if (!this->lb_cached_fd && *gi) {
+    if (this->lb_loader_read.valid()) {
+        rc = this->lb_loader_read.get();
+        if (rc < 0) {
+            errno = -rc;
+            rc = -1;
+        }
+    } else if (!this->lb_cached_fd && *gi) {
         if (this->lb_file_size != (ssize_t) -1 && this->in_range(start)
             && this->in_range(this->lb_file_size - 1))
         {
@@ -671,9 +1203,8 @@ line_buffer::load_next_buffer()
                       this->lb_alt_buffer->capacity());
 #endif
         }
-    }
-#ifdef HAVE_BZLIB_H
-    else if (!this->lb_cached_fd && this->lb_bz_file)
+    } else if (!this->lb_cached_fd
+               && (this->lb_bz_file || this->lb_zstd_file))
     {
         if (this->lb_file_size != (ssize_t) -1
             && (((ssize_t) start >= this->lb_file_size)
@@ -682,47 +1213,10 @@ line_buffer::load_next_buffer()
         {
             rc = 0;
         } else {
-            lock_hack::guard guard;
-            char scratch[32 * 1024];
-            BZFILE* bz_file;
-            file_off_t seek_to;
-            int bzfd;
-
-            /*
-             * Unfortunately, there is no bzseek, so we need to reopen the
-             * file every time we want to do a read.
-             */
-            bzfd = dup(this->lb_fd);
-            if (lseek(this->lb_fd, 0, SEEK_SET) < 0) {
-                close(bzfd);
-                throw error(errno);
-            }
-            if ((bz_file = BZ2_bzdopen(bzfd, "r")) == nullptr) {
-                close(bzfd);
-                if (errno == 0) {
-                    throw std::bad_alloc();
-                } else {
-                    throw error(errno);
-                }
-            }
-
-            seek_to = start + this->lb_alt_buffer.value().size();
-            while (seek_to > 0) {
-                int count;
-
-                count = BZ2_bzread(bz_file,
-                                   scratch,
-                                   std::min((size_t) seek_to, sizeof(scratch)));
-                if (count <= 0) {
-                    break;
-                }
-                seek_to -= count;
-            }
-            rc = BZ2_bzread(bz_file,
-                            this->lb_alt_buffer->end(),
-                            this->lb_alt_buffer->available());
-            this->lb_compressed_offset = 0;
-            BZ2_bzclose(bz_file);
+            rc = this->read_indexed(
+                this->lb_alt_buffer->end(),
+                start + this->lb_alt_buffer.value().size(),
+                this->lb_alt_buffer->available());
 
             if (rc != -1
                 && (rc < (ssize_t) (this->lb_alt_buffer.value().available()))
@@ -736,9 +1230,7 @@ line_buffer::load_next_buffer()
                          this->lb_file_size);
             }
         }
-    }
-#endif
-    else {
+    } else {
         rc = pread(this->lb_cached_fd ? this->lb_cached_fd.value().get()
                                       : this->lb_fd.get(),
                    this->lb_alt_buffer.value().end(),
@@ -904,13 +1396,7 @@ line_buffer::fill_range(file_off_t start,
                           this->lb_loader_file_offset.value());
                 log_debug("launch loader");
 #endif
-                auto prom = std::make_shared<std::promise<bool>>();
-                this->lb_loader_future = prom->get_future();
-                this->lb_stats.s_requested_preloads += 1;
-                isc::to<io_looper&, io_looper_tag>().send(
-                    [this, prom](auto& ioloop) mutable {
-                        prom->set_value(this->load_next_buffer());
-                    });
+                this->start_preload();
             }
         }
     } else if (this->lb_fd != -1) {
@@ -955,9 +1441,8 @@ line_buffer::fill_range(file_off_t start,
                       rc,
                       this->lb_buffer.capacity());
 #endif
-        }
-#ifdef HAVE_BZLIB_H
-        else if (!this->lb_cached_fd && this->lb_bz_file)
+        } else if (!this->lb_cached_fd
+                   && (this->lb_bz_file || this->lb_zstd_file))
         {
             if (this->lb_file_size != (ssize_t) -1
                 && (((ssize_t) start >= this->lb_file_size)
@@ -966,48 +1451,10 @@ line_buffer::fill_range(file_off_t start,
             {
                 rc = 0;
             } else {
-                lock_hack::guard guard;
-                char scratch[32 * 1024];
-                BZFILE* bz_file;
-                file_off_t seek_to;
-                int bzfd;
-
-                /*
-                 * Unfortunately, there is no bzseek, so we need to reopen the
-                 * file every time we want to do a read.
-                 */
-                bzfd = dup(this->lb_fd);
-                if (lseek(this->lb_fd, 0, SEEK_SET) < 0) {
-                    close(bzfd);
-                    throw error(errno);
-                }
-                if ((bz_file = BZ2_bzdopen(bzfd, "r")) == NULL) {
-                    close(bzfd);
-                    if (errno == 0) {
-                        throw std::bad_alloc();
-                    } else {
-                        throw error(errno);
-                    }
-                }
-
-                seek_to = this->lb_file_offset + this->lb_buffer.size();
-                while (seek_to > 0) {
-                    int count;
-
-                    count = BZ2_bzread(
-                        bz_file,
-                        scratch,
-                        std::min((size_t) seek_to, sizeof(scratch)));
-                    if (count <= 0) {
-                        break;
-                    }
-                    seek_to -= count;
-                }
-                rc = BZ2_bzread(bz_file,
-                                this->lb_buffer.end(),
-                                this->lb_buffer.available());
-                this->lb_compressed_offset = 0;
-                BZ2_bzclose(bz_file);
+                rc = this->read_indexed(this->lb_buffer.end(),
+                                        this->lb_file_offset
+                                            + this->lb_buffer.size(),
+                                        this->lb_buffer.available());
 
                 if (rc != -1 && (rc < (ssize_t) this->lb_buffer.available())) {
                     this->lb_file_size
@@ -1017,15 +1464,10 @@ line_buffer::fill_range(file_off_t start,
                              this->lb_file_size);
                 }
             }
-        }
-#endif
-        else if (this->lb_seekable)
-        {
+        } else if (this->lb_seekable) {
             this->lb_stats.s_preads += 1;
-            if (false && this->lb_last_line_offset > 0) {
-                this->lb_stats.s_hist[(this->lb_file_offset * 10)
-                                      / this->lb_last_line_offset] += 1;
-            }
+            this->note_read(this->lb_file_offset + this->lb_buffer.size(),
+                            this->lb_buffer.available());
 #if 0
             log_debug("%d: pread %lld",
                       this->lb_fd.get(),
@@ -1127,13 +1569,7 @@ line_buffer::fill_range(file_off_t start,
                           this->lb_loader_file_offset.value());
                 log_debug("launch loader");
 #endif
-                auto prom = std::make_shared<std::promise<bool>>();
-                this->lb_loader_future = prom->get_future();
-                this->lb_stats.s_requested_preloads += 1;
-                isc::to<io_looper&, io_looper_tag>().send(
-                    [this, prom](auto& ioloop) mutable {
-                        prom->set_value(this->load_next_buffer());
-                    });
+                this->start_preload();
             }
         }
         ensure(this->lb_buffer.size() <= this->lb_buffer.capacity());
@@ -1413,18 +1849,27 @@ line_buffer::read_range(file_range fr, scan_direction dir)
     }
 #endif
 
-    if (!(this->in_range(fr.fr_offset)
-          && this->in_range(fr.fr_offset + fr.fr_size - 1)))
-    {
-        if (!this->fill_range(fr.fr_offset, fr.fr_size, dir)) {
-            return Err(std::string("unable to read file"));
+    auto* share_manager = &this->lb_share_manager;
+    line_start = this->get_mapped_range(fr);
+    if (line_start != nullptr) {
+        this->lb_stats.s_mapped_reads += 1;
+        share_manager = &this->lb_mapping_share_manager;
+    } else {
+        if (!(this->in_range(fr.fr_offset)
+              && this->in_range(fr.fr_offset + fr.fr_size - 1)))
+        {
+            if (!this->fill_range(fr.fr_offset, fr.fr_size, dir)) {
+                return Err(std::string("unable to read file"));
+            }
         }
-    }
-    line_start = this->get_range(fr.fr_offset, avail);
+        line_start = this->get_range(fr.fr_offset, avail);
 
-    if (fr.fr_size > avail) {
-        return Err(fmt::format(
-            FMT_STRING("short-read (need: {}; avail: {})"), fr.fr_size, avail));
+        if (fr.fr_size > avail) {
+            return Err(
+                fmt::format(FMT_STRING("short-read (need: {}; avail: {})"),
+                            fr.fr_size,
+                            avail));
+        }
     }
     if (this->lb_line_metadata) {
         const auto* new_start
@@ -1435,7 +1880,7 @@ line_buffer::read_range(file_range fr, scan_direction dir)
             fr.fr_size -= offset;
         }
     }
-    retval.share(this->lb_share_manager, line_start, fr.fr_size);
+    retval.share(*share_manager, line_start, fr.fr_size);
     retval.get_metadata() = fr.fr_metadata;
 
     return Ok(std::move(retval));
@@ -1490,47 +1935,9 @@ line_buffer::peek_range(file_range fr,
             buf.resize(rc);
             return Ok(std::move(buf));
         }
-#ifdef HAVE_BZLIB_H
-        if (this->lb_bz_file) {
-            lock_hack::guard guard;
-            char scratch[32 * 1024];
-            BZFILE* bz_file;
-            file_off_t seek_to;
-            int bzfd;
-
-            /*
-             * Unfortunately, there is no bzseek, so we need to reopen the
-             * file every time we want to do a read.
-             */
-            bzfd = dup(this->lb_fd);
-            if (lseek(this->lb_fd, 0, SEEK_SET) < 0) {
-                close(bzfd);
-                throw error(errno);
-            }
-            if ((bz_file = BZ2_bzdopen(bzfd, "r")) == nullptr) {
-                close(bzfd);
-                if (errno == 0) {
-                    throw std::bad_alloc();
-                } else {
-                    throw error(errno);
-                }
-            }
-
-            seek_to = fr.fr_offset;
-            while (seek_to > 0) {
-                int count;
-
-                count = BZ2_bzread(bz_file,
-                                   scratch,
-                                   std::min((size_t) seek_to, sizeof(scratch)));
-                if (count <= 0) {
-                    break;
-                }
-                seek_to -= count;
-            }
-            auto rc = BZ2_bzread(bz_file, buf.data(), fr.fr_size);
-            this->lb_compressed_offset = 0;
-            BZ2_bzclose(bz_file);
+        if (this->lb_bz_file || this->lb_zstd_file) {
+            auto rc
+                = this->read_indexed(buf.data(), fr.fr_offset, fr.fr_size);
 
             if (rc == -1) {
                 return Err(lnav::from_errno().message());
@@ -1548,9 +1955,6 @@ line_buffer::peek_range(file_range fr,
             buf.resize(rc);
             return Ok(std::move(buf));
         }
-#else
-        assert(!this->lb_bz_file);
-#endif
     }
 
     auto rc = pread(this->lb_fd, buf.data(), fr.fr_size, fr.fr_offset);
@@ -1635,12 +2039,6 @@ line_buffer::quiesce()
     }
 }
 
-static std::filesystem::path
-line_buffer_cache_path()
-{
-    return lnav::paths::workdir() / "buffer-cache";
-}
-
 void
 line_buffer::enable_cache()
 {
@@ -1703,6 +2101,23 @@ line_buffer::enable_cache()
 
     static constexpr ssize_t FILL_LENGTH = 1024 * 1024;
     auto off = file_off_t{0};
+    {
+        safe::WriteAccess<safe_gz_indexed> gi(this->lb_gz_file);
+
+        if (*gi) {
+            auto inflate_res = gi->inflate_ranges_to(write_fd);
+            if (inflate_res.isOk()) {
+                off = inflate_res.unwrap();
+                log_info("%d: decompressed %lld bytes using syncpoints",
+                         this->lb_fd.get(),
+                         (long long) off);
+            } else {
+                log_error("%d: unable to decompress using syncpoints -- %s",
+                          this->lb_fd.get(),
+                          inflate_res.unwrapErr().c_str());
+            }
+        }
+    }
     while (!done) {
         log_debug("%d: caching file content at %lld", this->lb_fd.get(), off);
         if (!this->fill_range(off, FILL_LENGTH)) {
@@ -1712,11 +2127,7 @@ line_buffer::enable_cache()
             file_ssize_t avail;
 
             const auto* data = this->get_range(off, avail);
-            auto rc = write(write_fd, data, avail);
-            if (rc == -1 && errno == EINTR) {
-                continue;
-            }
-            if (rc != avail) {
+            if (!pwrite_fully(write_fd, data, avail, off)) {
                 log_error("%d: short write!", this->lb_fd.get());
                 return;
             }
@@ -1747,7 +2158,9 @@ line_buffer::cleanup_cache()
                      std::filesystem::directory_iterator(cache_subdir, ec))
                 {
                     auto mtime = std::filesystem::last_write_time(entry.path());
-                    auto exp_time = mtime + 1h;
+                    auto exp_time = mtime
+                        + (entry.path().extension() == ".gzidx" ? GZ_INDEX_TTL
+                                                                 : 1h);
                     if (now < exp_time) {
                         continue;
                     }
@@ -1782,11 +2195,172 @@ line_buffer::send_initial_load()
         this->lb_alt_buffer = auto_buffer::alloc(this->lb_buffer.capacity());
     }
     this->lb_loader_file_offset = 0;
+    this->start_preload();
+}
+
+void
+line_buffer::start_preload()
+{
     auto prom = std::make_shared<std::promise<bool>>();
     this->lb_loader_future = prom->get_future();
     this->lb_stats.s_requested_preloads += 1;
+    if (this->is_plain_read()) {
+        auto& alt = this->lb_alt_buffer.value();
+        auto offset = this->lb_loader_file_offset.value() + alt.size();
+
+        this->note_read(offset, alt.available());
+        if (lnav::uring::available()) {
+            /*
+             * Submit the read now so that it is in flight with the reads
+             * of the other files instead of waiting its turn in the
+             * io_looper.
+             */
+            this->lb_loader_read = lnav::uring::read(
+                this->get_plain_fd(), alt.end(), alt.available(), offset);
+            this->lb_stats.s_uring_reads += 1;
+        }
+    }
     isc::to<io_looper&, io_looper_tag>().send(
         [this, prom](auto& ioloop) mutable {
             prom->set_value(this->load_next_buffer());
         });
 }
+
+size_t
+line_buffer::readahead_size() const
+{
+    static constexpr size_t MIN_READAHEAD = 256 * 1024;
+    static constexpr size_t MAX_READAHEAD = 8 * 1024 * 1024;
+
+    const auto& hist = this->lb_stats.s_hist;
+    auto total = std::accumulate(hist.begin(), hist.end(), uint64_t{0});
+    if (total == 0) {
+        return MIN_READAHEAD;
+    }
+
+    /*
+     * Reads near the end of the indexed data come from indexing or tailing
+     * the file, which goes front-to-back.  Reads elsewhere come from the
+     * user jumping around, where a large readahead would be wasted.
+     */
+    return std::max(MIN_READAHEAD, MAX_READAHEAD * hist[9] / total);
+}
+
+void
+line_buffer::note_read(file_off_t offset, size_t size)
+{
+    if (this->lb_last_line_offset > 0) {
+        auto bucket = std::min(
+            (offset * 10) / this->lb_last_line_offset, file_off_t{9});
+        this->lb_stats.s_hist[bucket] += 1;
+    }
+
+    auto sequential = offset == this->lb_last_read_end;
+    this->lb_last_read_end = offset + size;
+    if (!sequential) {
+        return;
+    }
+
+    auto ra_start = std::max(this->lb_last_read_end, this->lb_readahead_end);
+    auto ra_end = this->lb_last_read_end
+        + static_cast<file_off_t>(this->readahead_size());
+    if (ra_start >= ra_end) {
+        return;
+    }
+
+    if (this->lb_mapping && this->lb_mapping->contains(ra_start, 0)) {
+        this->lb_mapping->advise(ra_start, ra_end - ra_start, MADV_WILLNEED);
+    } else {
+#ifdef POSIX_FADV_WILLNEED
+        posix_fadvise(this->get_plain_fd(),
+                      ra_start,
+                      ra_end - ra_start,
+                      POSIX_FADV_WILLNEED);
+#else
+        return;
+#endif
+    }
+    this->lb_readahead_end = ra_end;
+    this->lb_stats.s_readaheads += 1;
+    this->lb_stats.s_readahead_bytes += ra_end - ra_start;
+}
+
+const char*
+line_buffer::get_mapped_range(const file_range& fr)
+{
+    /*
+     * Files smaller than the buffer fit in it completely, so there is
+     * nothing to gain from mapping them.
+     */
+    static constexpr file_off_t MIN_MAPPING_SIZE = DEFAULT_LINE_BUFFER_SIZE;
+
+    if (!this->lb_seekable || !this->is_plain_read()
+        || !(this->lb_immutable || this->lb_cached_fd))
+    {
+        return nullptr;
+    }
+
+    if (!this->lb_mapping) {
+        if (this->lb_mapping_failed) {
+            return nullptr;
+        }
+
+        struct stat st;
+
+        this->lb_mapping_failed = true;
+        if (fstat(this->get_plain_fd(), &st) == -1
+            || st.st_size < MIN_MAPPING_SIZE)
+        {
+            return nullptr;
+        }
+
+        auto map_res = lnav::mapped_file::map(this->get_plain_fd(), st.st_size);
+        if (map_res.isErr()) {
+            log_warning("fd(%d): unable to map file -- %s",
+                        this->lb_fd.get(),
+                        map_res.unwrapErr().c_str());
+            return nullptr;
+        }
+
+        log_info("fd(%d): mapped %lld bytes of immutable file",
+                 this->lb_fd.get(),
+                 (long long) st.st_size);
+        this->lb_mapping = map_res.unwrap();
+        this->lb_mapping_failed = false;
+        this->lb_mapping_sequential
+            = this->lb_last_line_offset < (file_off_t) st.st_size;
+        if (this->lb_mapping_sequential) {
+            this->lb_mapping->advise(0, st.st_size, MADV_SEQUENTIAL);
+        }
+    }
+
+    if (this->lb_mapping->is_faulted()) {
+        log_error("fd(%d): file was truncated while mapped, reading normally",
+                  this->lb_fd.get());
+        this->drop_mapping();
+        this->lb_mapping_failed = true;
+        return nullptr;
+    }
+
+    auto map_size = static_cast<file_off_t>(this->lb_mapping->size());
+    if (this->lb_mapping_sequential && this->lb_last_line_offset >= map_size)
+    {
+        // Indexing is done, later reads will be wherever the user goes.
+        this->lb_mapping->advise(0, map_size, MADV_NORMAL);
+        this->lb_mapping_sequential = false;
+    }
+
+    if (!this->lb_mapping->contains(fr.fr_offset, fr.fr_size)) {
+        return nullptr;
+    }
+
+    return this->lb_mapping->data() + fr.fr_offset;
+}
+
+void
+line_buffer::drop_mapping()
+{
+    this->lb_mapping_share_manager.invalidate_refs();
+    this->lb_mapping = std::nullopt;
+    this->lb_mapping_sequential = false;
+}
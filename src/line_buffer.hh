@@ -34,7 +34,9 @@
 
 #include <array>
 #include <exception>
+#include <filesystem>
 #include <future>
+#include <optional>
 #include <vector>
 
 #include <errno.h>
@@ -51,6 +53,10 @@
 #include "base/log_level_enum.hh"
 #include "base/piper.file.hh"
 #include "base/result.h"
+#include "line_buffer.bz2_index.hh"
+#include "line_buffer.mmap.hh"
+#include "line_buffer.zstd_index.hh"
+#include "line_buffer.uring.hh"
 #include "mapbox/variant.hpp"
 #include "safe/safe.h"
 #include "shared_buffer.hh"
@@ -120,12 +126,32 @@ public:
          */
         int read(void* buf, size_t offset, size_t size);
 
+        /**
+         * Load the syncpoints saved by an earlier run if the file has not
+         * changed since then.
+         */
+        void load_index();
+
+        /** Save the syncpoints if any were found since the last save. */
+        void save_index();
+
+        /**
+         * Decompress the data up to the last syncpoint into the given file
+         * using multiple threads.  Each thread starts from a syncpoint and
+         * writes its range at the same offset in the output.
+         *
+         * @return The offset in the uncompressed data where the parallel
+         * decompression stopped.
+         */
+        Result<file_off_t, std::string> inflate_ranges_to(int out_fd);
+
         struct indexDict {
             off_t in = 0;
             off_t out = 0;
             unsigned char bits = 0;
             unsigned char in_bits = 0;
             Bytef index[GZ_WINSIZE];
+            indexDict() = default;
             indexDict(z_stream const& s, const file_size_t size);
 
             int apply(z_streamp s);
@@ -137,6 +163,9 @@ public:
             syncpoints; /*< indexed dictionaries as discovered */
         auto_mem<Bytef> inbuf; /*< Compressed data buffer */
         int gz_fd = -1; /*< The file to read data from. */
+        /** Where the syncpoints are persisted between runs. */
+        std::optional<std::filesystem::path> gz_index_path;
+        size_t gz_saved_syncpoints{0}; /*< The count at the last save. */
     };
 
     /** Construct an empty line_buffer. */
@@ -181,6 +210,14 @@ public:
 
     bool has_line_metadata() const { return this->lb_line_metadata; }
 
+    /**
+     * Indicate that the content of the file is not expected to change, like
+     * a rotated log or a file extracted from an archive.  Lines from these
+     * files, and from the decompressed cache files, are read directly from
+     * a memory mapping of the file instead of being copied into the buffer.
+     */
+    void set_immutable(bool val) { this->lb_immutable = val; }
+
     file_off_t get_read_offset(file_off_t off) const
     {
         if (this->is_compressed()) {
@@ -243,6 +280,7 @@ public:
         this->lb_file_size = (ssize_t) -1;
         this->lb_buffer.resize(0);
         this->lb_last_line_offset = -1;
+        this->drop_mapping();
     }
 
     /** Check the invariants for this object. */
@@ -260,13 +298,21 @@ public:
         {
             return this->s_decompressions == 0 && this->s_preads == 0
                 && this->s_requested_preloads == 0
-                && this->s_used_preloads == 0;
+                && this->s_used_preloads == 0 && this->s_uring_reads == 0
+                && this->s_readaheads == 0 && this->s_mapped_reads == 0;
         }
 
         uint32_t s_decompressions{0};
         uint32_t s_preads{0};
         uint32_t s_requested_preloads{0};
         uint32_t s_used_preloads{0};
+        /** Preloads that were read through io_uring. */
+        uint32_t s_uring_reads{0};
+        uint32_t s_readaheads{0};
+        uint64_t s_readahead_bytes{0};
+        /** Ranges that were returned directly from the memory mapping. */
+        uint32_t s_mapped_reads{0};
+        /** Reads by their position relative to the last line, in tenths. */
         std::array<uint32_t, 10> s_hist{};
     };
 
@@ -366,13 +412,63 @@ private:
 
     bool load_next_buffer();
 
+    /** Start loading the next buffer in the background. */
+    void start_preload();
+
+    /** @return True if data is read from the file with pread(). */
+    bool is_plain_read() const
+    {
+        return this->lb_cached_fd || !this->lb_compressed;
+    }
+
+    int get_plain_fd() const
+    {
+        return this->lb_cached_fd ? this->lb_cached_fd.value().get()
+                                  : this->lb_fd.get();
+    }
+
+    /**
+     * Record a read of plain data in the stats and ask the kernel to read
+     * ahead if the reads are sequential.
+     */
+    void note_read(file_off_t offset, size_t size);
+
+    /** @return The amount of data to read ahead of sequential reads. */
+    size_t readahead_size() const;
+
+    /**
+     * @return A pointer to the given range in the memory mapping of the
+     * file or nullptr if the range cannot be read from a mapping.
+     */
+    const char* get_mapped_range(const file_range& fr);
+
+    /** Copy out any shared refs into the mapping and unmap it. */
+    void drop_mapping();
+
+    /**
+     * Read uncompressed data from a bzip2 file, using the block index if
+     * possible and falling back to decompressing from the start otherwise.
+     */
+    ssize_t read_bz2(void* buf, file_off_t offset, size_t size);
+
+    /** Read uncompressed data from a zstd file using the frame index. */
+    ssize_t read_zstd(void* buf, file_off_t offset, size_t size);
+
+    /** Read from a bzip2 or zstd file. */
+    ssize_t read_indexed(void* buf, file_off_t offset, size_t size);
+
     using safe_gz_indexed = safe::Safe<gz_indexed>;
+    using safe_bz2_index = safe::Safe<lnav::bz2_index>;
+    using safe_zstd_index = safe::Safe<lnav::zstd_index>;
 
     shared_buffer lb_share_manager;
 
     auto_fd lb_fd; /*< The file to read data from. */
     safe_gz_indexed lb_gz_file; /*< File reader for gzipped files. */
     bool lb_bz_file{false}; /*< Flag set for bzip2 compressed files. */
+    safe_bz2_index lb_bz_index; /*< Block index for bzip2 files. */
+    bool lb_zstd_file{false}; /*< Flag set for zstd compressed files. */
+    safe_zstd_index lb_zstd_index; /*< Frame index for zstd files. */
     bool lb_line_metadata{false};
     file_ssize_t lb_piper_header_size{0};
 
@@ -383,6 +479,8 @@ private:
     std::vector<bool> lb_alt_line_has_ansi;
     std::vector<size_t> lb_alt_line_col_widths;
     std::future<bool> lb_loader_future;
+    /** The io_uring read for the pending preload, if any. */
+    std::future<ssize_t> lb_loader_read;
     std::optional<file_off_t> lb_loader_file_offset;
 
     file_off_t lb_compressed_offset{
@@ -404,6 +502,17 @@ private:
     bool lb_is_utf8{true};
     bool lb_do_preloading{false};
     file_off_t lb_last_line_offset{-1}; /*< */
+    file_off_t lb_last_read_end{-1}; /*< The end of the last plain read. */
+    file_off_t lb_readahead_end{0}; /*< The end of the advised readahead. */
+
+    bool lb_immutable{false};
+    /** True if mapping the file was tried and failed. */
+    bool lb_mapping_failed{false};
+    /** True while the mapping is advised for sequential access. */
+    bool lb_mapping_sequential{false};
+    std::optional<lnav::mapped_file> lb_mapping;
+    /** The refs into lb_mapping, declared after it so they go first. */
+    shared_buffer lb_mapping_share_manager;
 
     std::vector<uint32_t> lb_line_starts;
     file_off_t lb_next_buffer_offset{0};
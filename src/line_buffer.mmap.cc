@@ -0,0 +1,233 @@
+/**
+ * Copyright (c) 2026, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file line_buffer.mmap.cc
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <utility>
+
+#include "line_buffer.mmap.hh"
+
+#include <errno.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "base/lnav_log.hh"
+#include "fmtlib/fmt/format.h"
+
+namespace lnav {
+
+namespace {
+
+constexpr size_t MAX_MAPPINGS = 256;
+
+/**
+ * The mappings that the SIGBUS handler is responsible for.  This is a fixed
+ * array of atomics so the handler can search it without taking a lock.
+ */
+struct mapping_slot {
+    std::atomic<bool> ms_used{false};
+    std::atomic<uintptr_t> ms_start{0};
+    std::atomic<size_t> ms_size{0};
+    std::atomic<bool> ms_faulted{false};
+};
+
+mapping_slot MAPPING_SLOTS[MAX_MAPPINGS];
+
+struct sigaction PREV_SIGBUS_ACTION;
+
+void
+sigbus_handler(int sig, siginfo_t* info, void* ctx)
+{
+    auto addr = reinterpret_cast<uintptr_t>(info->si_addr);
+
+    for (auto& slot : MAPPING_SLOTS) {
+        auto start = slot.ms_start.load();
+        auto size = slot.ms_size.load();
+
+        if (start == 0 || addr < start || addr >= start + size) {
+            continue;
+        }
+
+        // Swap in zeroed pages so the faulting access can complete.
+        auto* mem = mmap(reinterpret_cast<void*>(start),
+                         size,
+                         PROT_READ,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED,
+                         -1,
+                         0);
+        if (mem != MAP_FAILED) {
+            slot.ms_faulted.store(true);
+            return;
+        }
+        break;
+    }
+
+    /*
+     * Not one of ours, restore the previous handler and return.  The
+     * access will fault again and be handled by that one.
+     */
+    if (PREV_SIGBUS_ACTION.sa_handler == SIG_IGN) {
+        PREV_SIGBUS_ACTION.sa_handler = SIG_DFL;
+    }
+    sigaction(SIGBUS, &PREV_SIGBUS_ACTION, nullptr);
+}
+
+void
+install_handler()
+{
+    static std::once_flag INSTALL_ONCE;
+
+    std::call_once(INSTALL_ONCE, []() {
+        struct sigaction sa;
+
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_flags = SA_SIGINFO | SA_ONSTACK;
+        sigemptyset(&sa.sa_mask);
+        sa.sa_sigaction = sigbus_handler;
+        sigaction(SIGBUS, &sa, &PREV_SIGBUS_ACTION);
+    });
+}
+
+}  // namespace
+
+Result<mapped_file, std::string>
+mapped_file::map(int fd, size_t size)
+{
+    if (size == 0) {
+        return Err(std::string("cannot map an empty file"));
+    }
+
+    auto slot_index = -1;
+    for (size_t lpc = 0; lpc < MAX_MAPPINGS; lpc++) {
+        if (!MAPPING_SLOTS[lpc].ms_used.exchange(true)) {
+            slot_index = lpc;
+            break;
+        }
+    }
+    if (slot_index == -1) {
+        return Err(std::string("too many mapped files"));
+    }
+
+    auto* mem = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (mem == MAP_FAILED) {
+        auto errmsg = fmt::format(FMT_STRING("mmap() failed -- {}"),
+                                  strerror(errno));
+        MAPPING_SLOTS[slot_index].ms_used.store(false);
+        return Err(errmsg);
+    }
+
+    install_handler();
+
+    auto& slot = MAPPING_SLOTS[slot_index];
+    slot.ms_faulted.store(false);
+    slot.ms_size.store(size);
+    slot.ms_start.store(reinterpret_cast<uintptr_t>(mem));
+
+    mapped_file retval;
+    retval.mf_data = static_cast<char*>(mem);
+    retval.mf_size = size;
+    retval.mf_slot = slot_index;
+
+    return Ok(std::move(retval));
+}
+
+mapped_file::mapped_file(mapped_file&& other) noexcept
+    : mf_data(std::exchange(other.mf_data, nullptr)),
+      mf_size(std::exchange(other.mf_size, 0)),
+      mf_slot(std::exchange(other.mf_slot, -1))
+{
+}
+
+mapped_file&
+mapped_file::operator=(mapped_file&& other) noexcept
+{
+    if (this != &other) {
+        this->release();
+        this->mf_data = std::exchange(other.mf_data, nullptr);
+        this->mf_size = std::exchange(other.mf_size, 0);
+        this->mf_slot = std::exchange(other.mf_slot, -1);
+    }
+
+    return *this;
+}
+
+mapped_file::~mapped_file()
+{
+    this->release();
+}
+
+bool
+mapped_file::is_faulted() const
+{
+    return this->mf_slot != -1
+        && MAPPING_SLOTS[this->mf_slot].ms_faulted.load();
+}
+
+void
+mapped_file::advise(file_off_t offset, size_t size, int advice) const
+{
+    static const auto page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+
+    if (this->mf_data == nullptr || offset < 0
+        || static_cast<size_t>(offset) >= this->mf_size)
+    {
+        return;
+    }
+
+    auto start = static_cast<size_t>(offset) & ~(page_size - 1);
+    auto end = std::min(static_cast<size_t>(offset) + size, this->mf_size);
+    if (madvise(this->mf_data + start, end - start, advice) == -1) {
+        log_debug("madvise(%d) failed -- %s", advice, strerror(errno));
+    }
+}
+
+void
+mapped_file::release()
+{
+    if (this->mf_data == nullptr) {
+        return;
+    }
+
+    auto& slot = MAPPING_SLOTS[this->mf_slot];
+    slot.ms_start.store(0);
+    munmap(this->mf_data, this->mf_size);
+    slot.ms_size.store(0);
+    slot.ms_used.store(false);
+
+    this->mf_data = nullptr;
+    this->mf_size = 0;
+    this->mf_slot = -1;
+}
+
+}  // namespace lnav
@@ -0,0 +1,95 @@
+/**
+ * Copyright (c) 2026, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file line_buffer.mmap.hh
+ */
+
+#ifndef lnav_line_buffer_mmap_hh
+#define lnav_line_buffer_mmap_hh
+
+#include <string>
+
+#include <sys/types.h>
+
+#include "base/file_range.hh"
+#include "base/result.h"
+
+namespace lnav {
+
+/**
+ * A read-only mapping of a file that is not expected to change, like a
+ * rotated log or a member extracted from an archive.  Reading through the
+ * mapping avoids copying the data into the line_buffer.
+ *
+ * If the file is truncated anyway, touching the pages past the new end of
+ * the file raises a SIGBUS.  The handler installed by this class replaces
+ * the whole mapping with zero-filled memory so the access can complete and
+ * marks the mapping as faulted.  The owner should then stop using the
+ * mapping and fall back to reading the file normally.
+ */
+class mapped_file {
+public:
+    static Result<mapped_file, std::string> map(int fd, size_t size);
+
+    mapped_file() = default;
+
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    mapped_file(mapped_file&& other) noexcept;
+    mapped_file& operator=(mapped_file&& other) noexcept;
+
+    ~mapped_file();
+
+    const char* data() const { return this->mf_data; }
+
+    size_t size() const { return this->mf_size; }
+
+    bool contains(file_off_t offset, file_ssize_t size) const
+    {
+        return offset >= 0 && size >= 0
+            && static_cast<size_t>(offset + size) <= this->mf_size;
+    }
+
+    /** @return True if an access to the mapping raised a SIGBUS. */
+    bool is_faulted() const;
+
+    /** Pass a madvise(2) hint for the given range of the file. */
+    void advise(file_off_t offset, size_t size, int advice) const;
+
+private:
+    void release();
+
+    char* mf_data{nullptr};
+    size_t mf_size{0};
+    int mf_slot{-1};
+};
+
+}  // namespace lnav
+
+#endif
@@ -0,0 +1,400 @@
+/**
+ * Copyright (c) 2026, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file line_buffer.uring.cc
+ */
+
+#include "line_buffer.uring.hh"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "base/auto_pid.hh"
+#include "base/lnav_log.hh"
+#include "config.h"
+
+#ifdef HAVE_LINUX_IO_URING_H
+#    include <linux/io_uring.h>
+
+// IO_URING_OP_SUPPORTED came with IORING_OP_READ and the probe interface.
+#    ifdef IO_URING_OP_SUPPORTED
+#        define USE_IO_URING
+#    endif
+#endif
+
+#ifdef USE_IO_URING
+#    include <algorithm>
+#    include <condition_variable>
+#    include <mutex>
+#    include <optional>
+#    include <thread>
+#    include <vector>
+
+#    include <sys/mman.h>
+#    include <sys/syscall.h>
+#    include <sys/uio.h>
+
+#    include "base/auto_fd.hh"
+#endif
+
+namespace lnav::uring {
+
+#ifdef USE_IO_URING
+namespace {
+
+constexpr unsigned QUEUE_DEPTH = 64;
+constexpr size_t FIXED_BUFFER_SIZE = 256 * 1024;
+constexpr size_t FIXED_BUFFER_COUNT = 32;
+
+int
+sys_setup(unsigned entries, io_uring_params* params)
+{
+    return syscall(__NR_io_uring_setup, entries, params);
+}
+
+int
+sys_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags)
+{
+    return syscall(
+        __NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0);
+}
+
+int
+sys_register(int fd, unsigned opcode, void* arg, unsigned nr_args)
+{
+    return syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+class ring {
+public:
+    /** @return The shared ring or nullptr if it could not be created. */
+    static ring* get()
+    {
+        // The ring is never destroyed since reads can still be in flight
+        // when the process exits.
+        static ring* retval = []() -> ring* {
+            auto* r = new ring();
+
+            if (!r->init()) {
+                delete r;
+                return nullptr;
+            }
+            return r;
+        }();
+
+        return retval;
+    }
+
+    std::future<ssize_t> read(int fd, void* buf, size_t size, file_off_t offset)
+    {
+        std::unique_lock<std::mutex> lock(this->r_mutex);
+
+        this->r_cond.wait(lock, [this]() {
+            return !this->r_free_requests.empty();
+        });
+
+        auto index = this->r_free_requests.back();
+        this->r_free_requests.pop_back();
+
+        auto& req = this->r_requests[index];
+        req = request{};
+        req.r_dest = static_cast<char*>(buf);
+
+        io_uring_sqe sqe;
+        memset(&sqe, 0, sizeof(sqe));
+        sqe.fd = fd;
+        sqe.off = offset;
+        sqe.len = size;
+        sqe.user_data = index;
+        if (size <= FIXED_BUFFER_SIZE && !this->r_free_fixed.empty()) {
+            auto fixed = this->r_free_fixed.back();
+            this->r_free_fixed.pop_back();
+            req.r_fixed = fixed;
+            sqe.opcode = IORING_OP_READ_FIXED;
+            sqe.addr = reinterpret_cast<uintptr_t>(this->fixed_buffer(fixed));
+            sqe.buf_index = fixed;
+        } else {
+            sqe.opcode = IORING_OP_READ;
+            sqe.addr = reinterpret_cast<uintptr_t>(buf);
+        }
+
+        auto retval = req.r_promise.get_future();
+        this->push(sqe);
+        this->submit();
+
+        return retval;
+    }
+
+private:
+    struct request {
+        std::promise<ssize_t> r_promise;
+        char* r_dest{nullptr};
+        /** The registered buffer the data is read into, if any. */
+        std::optional<size_t> r_fixed;
+    };
+
+    ring() = default;
+
+    void* map(size_t size, off_t offset)
+    {
+        auto* retval = mmap(nullptr,
+                            size,
+                            PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_POPULATE,
+                            this->r_fd.get(),
+                            offset);
+
+        return retval == MAP_FAILED ? nullptr : retval;
+    }
+
+    bool init()
+    {
+        io_uring_params params;
+
+        memset(&params, 0, sizeof(params));
+        this->r_fd = auto_fd(sys_setup(QUEUE_DEPTH, &params));
+        if (this->r_fd == -1) {
+            log_info("io_uring is not available -- %s", strerror(errno));
+            return false;
+        }
+
+        std::vector<char> probe_mem(sizeof(io_uring_probe)
+                                    + 256 * sizeof(io_uring_probe_op));
+        auto* probe = reinterpret_cast<io_uring_probe*>(probe_mem.data());
+        if (sys_register(this->r_fd, IORING_REGISTER_PROBE, probe, 256) < 0
+            || probe->last_op < IORING_OP_READ
+            || !(probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED))
+        {
+            log_info("io_uring does not support reads on this kernel");
+            return false;
+        }
+
+        auto sq_size
+            = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        auto cq_size
+            = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        auto single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mmap) {
+            sq_size = cq_size = std::max(sq_size, cq_size);
+        }
+
+        auto* sq_ptr
+            = static_cast<char*>(this->map(sq_size, IORING_OFF_SQ_RING));
+        auto* cq_ptr = single_mmap
+            ? sq_ptr
+            : static_cast<char*>(this->map(cq_size, IORING_OFF_CQ_RING));
+        this->r_sqes = static_cast<io_uring_sqe*>(this->map(
+            params.sq_entries * sizeof(io_uring_sqe), IORING_OFF_SQES));
+        if (sq_ptr == nullptr || cq_ptr == nullptr
+            || this->r_sqes == nullptr)
+        {
+            log_error("unable to map io_uring -- %s", strerror(errno));
+            return false;
+        }
+
+        this->r_sq_head = reinterpret_cast<unsigned*>(sq_ptr
+                                                      + params.sq_off.head);
+        this->r_sq_tail = reinterpret_cast<unsigned*>(sq_ptr
+                                                      + params.sq_off.tail);
+        this->r_sq_mask = reinterpret_cast<unsigned*>(
+            sq_ptr + params.sq_off.ring_mask);
+        this->r_sq_array = reinterpret_cast<unsigned*>(sq_ptr
+                                                       + params.sq_off.array);
+        this->r_cq_head = reinterpret_cast<unsigned*>(cq_ptr
+                                                      + params.cq_off.head);
+        this->r_cq_tail = reinterpret_cast<unsigned*>(cq_ptr
+                                                      + params.cq_off.tail);
+        this->r_cq_mask = reinterpret_cast<unsigned*>(
+            cq_ptr + params.cq_off.ring_mask);
+        this->r_cqes = reinterpret_cast<io_uring_cqe*>(cq_ptr
+                                                       + params.cq_off.cqes);
+
+        auto* fixed_mem = mmap(nullptr,
+                               FIXED_BUFFER_SIZE * FIXED_BUFFER_COUNT,
+                               PROT_READ | PROT_WRITE,
+                               MAP_PRIVATE | MAP_ANONYMOUS,
+                               -1,
+                               0);
+        if (fixed_mem != MAP_FAILED) {
+            std::vector<iovec> iovs(FIXED_BUFFER_COUNT);
+
+            this->r_fixed_mem = static_cast<char*>(fixed_mem);
+            for (size_t lpc = 0; lpc < FIXED_BUFFER_COUNT; lpc++) {
+                iovs[lpc].iov_base = this->fixed_buffer(lpc);
+                iovs[lpc].iov_len = FIXED_BUFFER_SIZE;
+            }
+            if (sys_register(this->r_fd,
+                             IORING_REGISTER_BUFFERS,
+                             iovs.data(),
+                             iovs.size())
+                == 0)
+            {
+                for (size_t lpc = 0; lpc < FIXED_BUFFER_COUNT; lpc++) {
+                    this->r_free_fixed.emplace_back(lpc);
+                }
+            } else {
+                log_info("unable to register io_uring buffers -- %s",
+                         strerror(errno));
+                munmap(fixed_mem, FIXED_BUFFER_SIZE * FIXED_BUFFER_COUNT);
+                this->r_fixed_mem = nullptr;
+            }
+        }
+
+        this->r_requests.resize(QUEUE_DEPTH);
+        for (unsigned lpc = 0; lpc < QUEUE_DEPTH; lpc++) {
+            this->r_free_requests.emplace_back(lpc);
+        }
+        std::thread(&ring::reap, this).detach();
+
+        log_info("io_uring enabled with %u entries and %zu fixed buffers",
+                 params.sq_entries,
+                 this->r_free_fixed.size());
+
+        return true;
+    }
+
+    char* fixed_buffer(size_t index) const
+    {
+        return this->r_fixed_mem + index * FIXED_BUFFER_SIZE;
+    }
+
+    void push(const io_uring_sqe& sqe)
+    {
+        auto tail = *this->r_sq_tail;
+        auto index = tail & *this->r_sq_mask;
+
+        this->r_sqes[index] = sqe;
+        this->r_sq_array[index] = index;
+        __atomic_store_n(this->r_sq_tail, tail + 1, __ATOMIC_RELEASE);
+    }
+
+    /** Submit all of the entries the kernel has not consumed yet. */
+    void submit()
+    {
+        auto pending = *this->r_sq_tail
+            - __atomic_load_n(this->r_sq_head, __ATOMIC_ACQUIRE);
+
+        while (pending > 0) {
+            auto rc = sys_enter(this->r_fd, pending, 0, 0);
+            if (rc >= 0) {
+                pending -= rc;
+                continue;
+            }
+            if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+                std::this_thread::yield();
+                continue;
+            }
+            // The entries stay in the queue and go out with the next read.
+            log_error("io_uring submit failed -- %s", strerror(errno));
+            break;
+        }
+    }
+
+    void reap()
+    {
+        log_set_thread_prefix("uring");
+        while (true) {
+            auto rc = sys_enter(this->r_fd, 0, 1, IORING_ENTER_GETEVENTS);
+            if (rc < 0 && errno != EINTR) {
+                log_error("io_uring wait failed -- %s", strerror(errno));
+                return;
+            }
+
+            std::lock_guard<std::mutex> lock(this->r_mutex);
+            auto head = *this->r_cq_head;
+            auto tail = __atomic_load_n(this->r_cq_tail, __ATOMIC_ACQUIRE);
+            for (; head != tail; head++) {
+                const auto& cqe = this->r_cqes[head & *this->r_cq_mask];
+                auto& req = this->r_requests[cqe.user_data];
+
+                if (req.r_fixed) {
+                    if (cqe.res > 0) {
+                        memcpy(req.r_dest,
+                               this->fixed_buffer(req.r_fixed.value()),
+                               cqe.res);
+                    }
+                    this->r_free_fixed.emplace_back(req.r_fixed.value());
+                }
+                req.r_promise.set_value(cqe.res);
+                this->r_free_requests.emplace_back(cqe.user_data);
+            }
+            __atomic_store_n(this->r_cq_head, head, __ATOMIC_RELEASE);
+            this->r_cond.notify_all();
+        }
+    }
+
+    auto_fd r_fd;
+    unsigned* r_sq_head{nullptr};
+    unsigned* r_sq_tail{nullptr};
+    unsigned* r_sq_mask{nullptr};
+    unsigned* r_sq_array{nullptr};
+    io_uring_sqe* r_sqes{nullptr};
+    unsigned* r_cq_head{nullptr};
+    unsigned* r_cq_tail{nullptr};
+    unsigned* r_cq_mask{nullptr};
+    io_uring_cqe* r_cqes{nullptr};
+    char* r_fixed_mem{nullptr};
+
+    std::mutex r_mutex;
+    std::condition_variable r_cond;
+    std::vector<request> r_requests;
+    std::vector<size_t> r_free_requests;
+    std::vector<size_t> r_free_fixed;
+};
+
+}  // namespace
+#endif
+
+bool
+available()
+{
+#ifdef USE_IO_URING
+    return !lnav::pid::in_child && ring::get() != nullptr;
+#else
+    return false;
+#endif
+}
+
+std::future<ssize_t>
+read(int fd, void* buf, size_t size, file_off_t offset)
+{
+#ifdef USE_IO_URING
+    if (available()) {
+        return ring::get()->read(fd, buf, size, offset);
+    }
+#endif
+
+    std::promise<ssize_t> prom;
+    auto rc = pread(fd, buf, size, offset);
+
+    prom.set_value(rc == -1 ? -errno : rc);
+    return prom.get_future();
+}
+
+}  // namespace lnav::uring
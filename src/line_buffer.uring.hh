@@ -0,0 +1,66 @@
+/**
+ * Copyright (c) 2026, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file line_buffer.uring.hh
+ */
+
+#ifndef lnav_line_buffer_uring_hh
+#define lnav_line_buffer_uring_hh
+
+#include <future>
+
+#include <sys/types.h>
+
+#include "base/file_range.hh"
+
+/**
+ * Asynchronous reads through a Linux io_uring that is shared by all of the
+ * line_buffers.  The preloads for many files can then be in flight at the
+ * same time instead of being issued one at a time from the I/O thread.
+ * Small reads go through a set of registered buffers so the kernel does not
+ * have to map the destination pages for every request.
+ */
+namespace lnav::uring {
+
+/**
+ * @return True if reads can be submitted to the ring.  This is false on
+ * other platforms, on kernels without io_uring or IORING_OP_READ, when the
+ * ring cannot be created, and in child processes.
+ */
+bool available();
+
+/**
+ * Start reading from a file.  The buffer must stay valid until the
+ * returned future is ready.  The result is the same as pread(), except
+ * that errors are returned as a negated errno value.
+ */
+std::future<ssize_t> read(int fd, void* buf, size_t size, file_off_t offset);
+
+}  // namespace lnav::uring
+
+#endif
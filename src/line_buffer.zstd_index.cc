@@ -0,0 +1,742 @@
+/**
+ * Copyright (c) 2026, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file line_buffer.zstd_index.cc
+ */
+
+#include <algorithm>
+#include <future>
+#include <thread>
+
+#include "line_buffer.zstd_index.hh"
+
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "base/lnav_log.hh"
+#include "config.h"
+
+#ifdef HAVE_ZSTD_H
+#    include <zstd.h>
+#endif
+
+namespace lnav {
+
+namespace {
+
+constexpr uint32_t FRAME_MAGIC = 0xFD2FB528U;
+constexpr uint32_t SKIPPABLE_MAGIC = 0x184D2A50U;
+constexpr uint32_t SKIPPABLE_MAGIC_MASK = 0xFFFFFFF0U;
+constexpr uint32_t SEEK_TABLE_FRAME_MAGIC = 0x184D2A5EU;
+constexpr uint32_t SEEKABLE_MAGIC = 0x8F92EAB1U;
+constexpr size_t SKIPPABLE_HEADER_SIZE = 8;
+constexpr size_t SEEK_TABLE_FOOTER_SIZE = 9;
+constexpr size_t FRAME_HEADER_MAX = 18;
+constexpr size_t BLOCK_HEADER_SIZE = 3;
+constexpr size_t CHECKSUM_SIZE = 4;
+/** Frames that decompress to more than this are read as a stream. */
+constexpr size_t MAX_CACHED_FRAME = 4 * 1024 * 1024;
+constexpr size_t STREAM_READ_SIZE = 128 * 1024;
+
+uint32_t
+read_le32(const unsigned char* buf)
+{
+    return static_cast<uint32_t>(buf[0]) | static_cast<uint32_t>(buf[1]) << 8
+        | static_cast<uint32_t>(buf[2]) << 16
+        | static_cast<uint32_t>(buf[3]) << 24;
+}
+
+[[maybe_unused]] size_t
+batch_size()
+{
+    return std::clamp<size_t>(std::thread::hardware_concurrency(), 2, 16);
+}
+
+[[maybe_unused]] Result<void, std::string>
+pread_fully(int fd, void* buf, size_t size, file_off_t offset)
+{
+    auto* dst = static_cast<char*>(buf);
+    size_t total = 0;
+
+    while (total < size) {
+        auto rc = pread(fd, &dst[total], size - total, offset + total);
+        if (rc == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return Err(std::string(strerror(errno)));
+        }
+        if (rc == 0) {
+            return Err(std::string("unexpected end of file"));
+        }
+        total += rc;
+    }
+
+    return Ok();
+}
+
+#ifdef HAVE_ZSTD_H
+/**
+ * Decompress a whole frame into memory.
+ *
+ * @return The uncompressed data or nullopt if it would be larger than
+ * max_out.
+ */
+Result<std::optional<std::string>, std::string>
+decode_frame(int fd, file_off_t in_offset, size_t in_size, size_t max_out)
+{
+    std::string in(in_size, '\0');
+    TRY(pread_fully(fd, in.data(), in.size(), in_offset));
+
+    auto content_size = ZSTD_getFrameContentSize(in.data(), in.size());
+    if (content_size == ZSTD_CONTENTSIZE_ERROR) {
+        return Err(std::string("invalid frame header"));
+    }
+    if (content_size != ZSTD_CONTENTSIZE_UNKNOWN && content_size > max_out) {
+        return Ok(std::optional<std::string>{});
+    }
+
+    std::unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)> dctx(
+        ZSTD_createDCtx(), ZSTD_freeDCtx);
+    if (dctx == nullptr) {
+        return Err(std::string("unable to create zstd context"));
+    }
+
+    std::string retval;
+    if (content_size != ZSTD_CONTENTSIZE_UNKNOWN) {
+        retval.resize(content_size);
+        auto rc = ZSTD_decompressDCtx(
+            dctx.get(), retval.data(), retval.size(), in.data(), in.size());
+        if (ZSTD_isError(rc)) {
+            return Err(std::string(ZSTD_getErrorName(rc)));
+        }
+        if (rc != content_size) {
+            return Err(std::string("frame size does not match its header"));
+        }
+        return Ok(std::make_optional(std::move(retval)));
+    }
+
+    ZSTD_inBuffer zin{in.data(), in.size(), 0};
+    retval.resize(
+        std::min(max_out, std::max<size_t>(in.size() * 4, 64 * 1024)));
+    size_t produced = 0;
+    while (true) {
+        ZSTD_outBuffer zout{retval.data(), retval.size(), produced};
+        auto rc = ZSTD_decompressStream(dctx.get(), &zout, &zin);
+        produced = zout.pos;
+        if (ZSTD_isError(rc)) {
+            return Err(std::string(ZSTD_getErrorName(rc)));
+        }
+        if (rc == 0) {
+            break;
+        }
+        if (zout.pos == zout.size) {
+            if (retval.size() >= max_out) {
+                return Ok(std::optional<std::string>{});
+            }
+            retval.resize(std::min(max_out, retval.size() * 2));
+        } else if (zin.pos == zin.size) {
+            return Err(std::string("truncated frame"));
+        }
+    }
+
+    retval.resize(produced);
+    return Ok(std::make_optional(std::move(retval)));
+}
+#endif
+
+}  // namespace
+
+bool
+zstd_index::is_zstd(const char* buffer, size_t len)
+{
+    return len >= 4
+        && read_le32(reinterpret_cast<const unsigned char*>(buffer))
+        == FRAME_MAGIC;
+}
+
+void
+zstd_index::clear()
+{
+    *this = zstd_index{};
+}
+
+#ifdef HAVE_ZSTD_H
+struct zstd_index::stream {
+    stream() : s_dctx(ZSTD_createDCtx()), s_in(STREAM_READ_SIZE, '\0') {}
+
+    ~stream() { ZSTD_freeDCtx(this->s_dctx); }
+
+    void reset(size_t index, const frame& fr)
+    {
+        ZSTD_DCtx_reset(this->s_dctx, ZSTD_reset_session_only);
+        this->s_frame = index;
+        this->s_in_offset = fr.f_in_offset;
+        this->s_in_end = fr.f_in_offset + fr.f_in_size;
+        this->s_out_offset = 0;
+        this->s_done = false;
+        this->s_zin = {this->s_in.data(), 0, 0};
+    }
+
+    /**
+     * Decompress the next chunk of the frame.
+     *
+     * @return The number of bytes produced, zero at the end of the frame.
+     */
+    Result<size_t, std::string> pump(int fd, char* out, size_t size)
+    {
+        size_t retval = 0;
+
+        while (retval < size && !this->s_done) {
+            if (this->s_zin.pos == this->s_zin.size
+                && this->s_in_offset < this->s_in_end)
+            {
+                auto amount = std::min(
+                    static_cast<file_off_t>(this->s_in.size()),
+                    this->s_in_end - this->s_in_offset);
+                TRY(pread_fully(
+                    fd, this->s_in.data(), amount, this->s_in_offset));
+                this->s_in_offset += amount;
+                this->s_zin = {this->s_in.data(), (size_t) amount, 0};
+            }
+
+            ZSTD_outBuffer zout{&out[retval], size - retval, 0};
+            auto rc = ZSTD_decompressStream(this->s_dctx, &zout, &this->s_zin);
+            if (ZSTD_isError(rc)) {
+                return Err(std::string(ZSTD_getErrorName(rc)));
+            }
+            retval += zout.pos;
+            this->s_out_offset += zout.pos;
+            if (rc == 0) {
+                this->s_done = true;
+            } else if (zout.pos == 0 && this->s_zin.pos == this->s_zin.size
+                       && this->s_in_offset == this->s_in_end)
+            {
+                return Err(std::string("truncated frame"));
+            }
+        }
+
+        return Ok(retval);
+    }
+
+    ZSTD_DCtx* s_dctx;
+    std::string s_in;
+    ZSTD_inBuffer s_zin{nullptr, 0, 0};
+    std::optional<size_t> s_frame;
+    file_off_t s_in_offset{0};
+    file_off_t s_in_end{0};
+    size_t s_out_offset{0};
+    bool s_done{false};
+};
+
+bool
+zstd_index::frame::is_cacheable() const
+{
+    return this->f_out_size && this->f_out_size.value() <= MAX_CACHED_FRAME;
+}
+
+Result<bool, std::string>
+zstd_index::load_seek_table(int fd)
+{
+    struct stat st;
+
+    if (fstat(fd, &st) == -1) {
+        return Err(std::string(strerror(errno)));
+    }
+    if (st.st_size < static_cast<file_off_t>(SKIPPABLE_HEADER_SIZE
+                                             + SEEK_TABLE_FOOTER_SIZE))
+    {
+        return Ok(false);
+    }
+
+    unsigned char footer[SEEK_TABLE_FOOTER_SIZE];
+    TRY(pread_fully(fd, footer, sizeof(footer), st.st_size - sizeof(footer)));
+    if (read_le32(&footer[5]) != SEEKABLE_MAGIC) {
+        return Ok(false);
+    }
+
+    auto frame_count = read_le32(footer);
+    auto descriptor = footer[4];
+    // Bits 2-6 of the descriptor are reserved and must be zero.
+    if (descriptor & 0x7c) {
+        return Ok(false);
+    }
+    size_t entry_size = (descriptor & 0x80) ? 12 : 8;
+    auto table_size = static_cast<uint64_t>(frame_count) * entry_size
+        + SEEK_TABLE_FOOTER_SIZE;
+    if (table_size + SKIPPABLE_HEADER_SIZE
+        > static_cast<uint64_t>(st.st_size))
+    {
+        return Ok(false);
+    }
+
+    auto table_offset = st.st_size
+        - static_cast<file_off_t>(table_size + SKIPPABLE_HEADER_SIZE);
+    std::string table(
+        table_size + SKIPPABLE_HEADER_SIZE - SEEK_TABLE_FOOTER_SIZE, '\0');
+    TRY(pread_fully(fd, table.data(), table.size(), table_offset));
+    const auto* utable = reinterpret_cast<const unsigned char*>(table.data());
+    if (read_le32(utable) != SEEK_TABLE_FRAME_MAGIC
+        || read_le32(&utable[4]) != table_size)
+    {
+        return Ok(false);
+    }
+
+    std::vector<frame> frames;
+    file_off_t in_offset = 0;
+    file_off_t out_offset = 0;
+    frames.reserve(frame_count);
+    for (uint32_t lpc = 0; lpc < frame_count; lpc++) {
+        const auto* entry = &utable[SKIPPABLE_HEADER_SIZE + lpc * entry_size];
+        auto& fr = frames.emplace_back();
+
+        fr.f_in_offset = in_offset;
+        fr.f_in_size = read_le32(entry);
+        fr.f_out_offset = out_offset;
+        fr.f_out_size = read_le32(&entry[4]);
+        in_offset += fr.f_in_size;
+        out_offset += fr.f_out_size.value();
+    }
+    if (in_offset != table_offset) {
+        log_warning("zstd seek table does not cover the file, ignoring it");
+        return Ok(false);
+    }
+
+    log_info("loaded zstd seek table with %u frames", frame_count);
+    this->zi_frames = std::move(frames);
+    this->zi_seekable = true;
+    this->zi_scan_offset = st.st_size;
+    this->zi_scan_done = true;
+
+    return Ok(true);
+}
+
+Result<std::optional<zstd_index::frame>, std::string>
+zstd_index::scan(int fd)
+{
+    unsigned char hdr[FRAME_HEADER_MAX];
+
+    while (true) {
+        auto rc = pread(fd, hdr, sizeof(hdr), this->zi_scan_offset);
+        if (rc == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return Err(std::string(strerror(errno)));
+        }
+        if (rc == 0) {
+            this->zi_scan_done = true;
+            return Ok(std::optional<frame>{});
+        }
+        if (rc < 8) {
+            return Err(std::string("truncated frame header"));
+        }
+
+        auto magic = read_le32(hdr);
+        if ((magic & SKIPPABLE_MAGIC_MASK) == SKIPPABLE_MAGIC) {
+            this->zi_scan_offset += SKIPPABLE_HEADER_SIZE + read_le32(&hdr[4]);
+            continue;
+        }
+        if (magic != FRAME_MAGIC) {
+            return Err(std::string("invalid frame magic"));
+        }
+
+        static constexpr size_t DICT_ID_SIZES[] = {0, 1, 2, 4};
+        static constexpr size_t CONTENT_SIZE_SIZES[] = {0, 2, 4, 8};
+        auto descriptor = hdr[4];
+        auto single_segment = (descriptor >> 5) & 1;
+        auto has_checksum = (descriptor >> 2) & 1;
+        auto content_size_size = CONTENT_SIZE_SIZES[descriptor >> 6];
+        if (content_size_size == 0 && single_segment) {
+            content_size_size = 1;
+        }
+        size_t header_size = 5 + (single_segment ? 0 : 1)
+            + DICT_ID_SIZES[descriptor & 3] + content_size_size;
+        if (static_cast<size_t>(rc) < header_size) {
+            return Err(std::string("truncated frame header"));
+        }
+
+        frame fr;
+        fr.f_in_offset = this->zi_scan_offset;
+        if (content_size_size > 0) {
+            const auto* fcs = &hdr[header_size - content_size_size];
+            uint64_t content_size = 0;
+            for (auto lpc = content_size_size; lpc > 0; lpc--) {
+                content_size = (content_size << 8) | fcs[lpc - 1];
+            }
+            if (content_size_size == 2) {
+                content_size += 256;
+            }
+            fr.f_out_size = content_size;
+        }
+
+        // Walk the block headers to find the end of the frame.
+        auto offset
+            = this->zi_scan_offset + static_cast<file_off_t>(header_size);
+        while (true) {
+            unsigned char bh[BLOCK_HEADER_SIZE];
+            TRY(pread_fully(fd, bh, sizeof(bh), offset));
+
+            auto value = static_cast<uint32_t>(bh[0])
+                | static_cast<uint32_t>(bh[1]) << 8
+                | static_cast<uint32_t>(bh[2]) << 16;
+            auto last = value & 1;
+            auto type = (value >> 1) & 3;
+            auto size = value >> 3;
+
+            offset += BLOCK_HEADER_SIZE;
+            switch (type) {
+                case 0:  // raw
+                case 2:  // compressed
+                    offset += size;
+                    break;
+                case 1:  // RLE
+                    offset += 1;
+                    break;
+                default:
+                    return Err(std::string("invalid block type"));
+            }
+            if (last) {
+                break;
+            }
+        }
+        if (has_checksum) {
+            offset += CHECKSUM_SIZE;
+        }
+
+        // Make sure the last byte of the frame is really there.
+        unsigned char last_byte;
+        TRY(pread_fully(fd, &last_byte, 1, offset - 1));
+
+        fr.f_in_size = offset - fr.f_in_offset;
+        this->zi_scan_offset = offset;
+
+        return Ok(std::make_optional(fr));
+    }
+}
+
+Result<void, std::string>
+zstd_index::extend(int fd)
+{
+    if (!this->zi_seek_table_checked) {
+        this->zi_seek_table_checked = true;
+        if (TRY(this->load_seek_table(fd))) {
+            return Ok();
+        }
+    }
+
+    const auto max_batch = batch_size();
+    std::vector<frame> batch;
+    while (batch.size() < max_batch && !this->zi_scan_done) {
+        auto scan_res = TRY(this->scan(fd));
+        if (scan_res) {
+            batch.emplace_back(scan_res.value());
+        }
+    }
+
+    // Frames without a content size in their header have to be
+    // decompressed to find where the next frame starts in the output.
+    std::vector<std::future<Result<std::optional<std::string>, std::string>>>
+        futures(batch.size());
+    for (size_t lpc = 0; lpc < batch.size(); lpc++) {
+        const auto& fr = batch[lpc];
+
+        if (!fr.f_out_size && fr.f_in_size <= MAX_CACHED_FRAME) {
+            futures[lpc] = std::async(std::launch::async,
+                                      decode_frame,
+                                      fd,
+                                      fr.f_in_offset,
+                                      fr.f_in_size,
+                                      MAX_CACHED_FRAME);
+        }
+    }
+
+    auto out_offset = this->zi_frames.empty()
+        ? file_off_t{0}
+        : this->zi_frames.back().end_offset();
+    auto stopped = false;
+    std::optional<std::string> error;
+    for (size_t lpc = 0; lpc < batch.size(); lpc++) {
+        auto& fr = batch[lpc];
+        std::shared_ptr<const std::string> data;
+
+        if (futures[lpc].valid()) {
+            auto decode_res = futures[lpc].get();
+            if (decode_res.isErr()) {
+                if (!error && !stopped) {
+                    error = decode_res.unwrapErr();
+                }
+                continue;
+            }
+            auto decoded = decode_res.unwrap();
+            if (decoded) {
+                fr.f_out_size = decoded->size();
+                data = std::make_shared<const std::string>(
+                    std::move(decoded.value()));
+            }
+        }
+        if (error || stopped) {
+            continue;
+        }
+
+        fr.f_out_offset = out_offset;
+        this->zi_frames.emplace_back(fr);
+        if (data) {
+            this->cache(this->zi_frames.size() - 1, std::move(data));
+        }
+        if (!fr.f_out_size) {
+            // The size of this frame is only known after it has been read
+            // as a stream, so the frames after it are scanned again later.
+            stopped = true;
+            this->zi_scan_offset = fr.f_in_offset + fr.f_in_size;
+            this->zi_scan_done = false;
+            continue;
+        }
+        out_offset += fr.f_out_size.value();
+    }
+    if (error) {
+        return Err(error.value());
+    }
+
+    return Ok();
+}
+
+Result<std::optional<size_t>, std::string>
+zstd_index::find_frame(int fd, file_off_t offset)
+{
+    while (true) {
+        if (!this->zi_frames.empty()) {
+            const auto& last = this->zi_frames.back();
+
+            if (!last.f_out_size || offset < last.end_offset()) {
+                auto iter = std::upper_bound(
+                    this->zi_frames.begin(),
+                    this->zi_frames.end(),
+                    offset,
+                    [](file_off_t lhs, const frame& rhs) {
+                        return lhs < rhs.f_out_offset;
+                    });
+
+                return Ok(std::make_optional<size_t>(
+                    std::distance(this->zi_frames.begin(), iter) - 1));
+            }
+        }
+        if (this->zi_scan_done) {
+            return Ok(std::optional<size_t>{});
+        }
+        TRY(this->extend(fd));
+    }
+}
+
+zstd_index::cached_frame*
+zstd_index::find_cached(size_t index)
+{
+    for (auto& cf : this->zi_cache) {
+        if (cf.cf_index == index) {
+            return &cf;
+        }
+    }
+
+    return nullptr;
+}
+
+void
+zstd_index::cache(size_t index, std::shared_ptr<const std::string> data)
+{
+    this->zi_use_counter += 1;
+    if (this->zi_cache.size() < batch_size()) {
+        this->zi_cache.emplace_back(
+            cached_frame{index, this->zi_use_counter, std::move(data)});
+        return;
+    }
+
+    auto lru = std::min_element(
+        this->zi_cache.begin(),
+        this->zi_cache.end(),
+        [](const auto& lhs, const auto& rhs) {
+            return lhs.cf_last_used < rhs.cf_last_used;
+        });
+    *lru = cached_frame{index, this->zi_use_counter, std::move(data)};
+}
+
+Result<std::shared_ptr<const std::string>, std::string>
+zstd_index::decoded(int fd, size_t index)
+{
+    auto* hit = this->find_cached(index);
+    if (hit != nullptr) {
+        this->zi_use_counter += 1;
+        hit->cf_last_used = this->zi_use_counter;
+        return Ok(hit->cf_data);
+    }
+
+    // Decompress the following frames as well since reads are usually
+    // sequential.
+    const auto max_batch = batch_size();
+    std::vector<size_t> batch;
+    for (auto lpc = index;
+         lpc < this->zi_frames.size() && batch.size() < max_batch;
+         lpc++)
+    {
+        if (!this->zi_frames[lpc].is_cacheable()) {
+            break;
+        }
+        if (lpc == index || this->find_cached(lpc) == nullptr) {
+            batch.emplace_back(lpc);
+        }
+    }
+
+    std::vector<std::future<Result<std::optional<std::string>, std::string>>>
+        futures;
+    for (auto frame_index : batch) {
+        const auto& fr = this->zi_frames[frame_index];
+
+        futures.emplace_back(std::async(std::launch::async,
+                                        decode_frame,
+                                        fd,
+                                        fr.f_in_offset,
+                                        fr.f_in_size,
+                                        MAX_CACHED_FRAME));
+    }
+
+    std::shared_ptr<const std::string> retval;
+    std::optional<std::string> error;
+    for (size_t lpc = 0; lpc < batch.size(); lpc++) {
+        auto decode_res = futures[lpc].get();
+        if (error) {
+            continue;
+        }
+        if (decode_res.isErr()) {
+            error = decode_res.unwrapErr();
+            continue;
+        }
+
+        auto decoded = decode_res.unwrap();
+        const auto& fr = this->zi_frames[batch[lpc]];
+        if (!decoded || decoded->size() != fr.f_out_size.value()) {
+            error = std::string("frame size changed");
+            continue;
+        }
+        auto data
+            = std::make_shared<const std::string>(std::move(decoded.value()));
+        if (batch[lpc] == index) {
+            retval = data;
+        }
+        this->cache(batch[lpc], std::move(data));
+    }
+    if (error) {
+        return Err(error.value());
+    }
+
+    return Ok(retval);
+}
+
+Result<size_t, std::string>
+zstd_index::stream_read(
+    int fd, size_t index, size_t frame_offset, char* buf, size_t size)
+{
+    if (!this->zi_stream) {
+        this->zi_stream = std::make_shared<stream>();
+        if (this->zi_stream->s_dctx == nullptr) {
+            this->zi_stream.reset();
+            return Err(std::string("unable to create zstd context"));
+        }
+    }
+
+    auto& st = *this->zi_stream;
+    if (st.s_frame != index || st.s_out_offset > frame_offset) {
+        st.reset(index, this->zi_frames[index]);
+    }
+
+    char scratch[32 * 1024];
+    while (st.s_out_offset < frame_offset && !st.s_done) {
+        TRY(st.pump(
+            fd,
+            scratch,
+            std::min(sizeof(scratch), frame_offset - st.s_out_offset)));
+    }
+
+    size_t retval = 0;
+    if (st.s_out_offset == frame_offset) {
+        retval = TRY(st.pump(fd, buf, size));
+    }
+    if (st.s_done) {
+        auto& fr = this->zi_frames[index];
+
+        if (!fr.f_out_size) {
+            fr.f_out_size = st.s_out_offset;
+        } else if (fr.f_out_size.value() != st.s_out_offset) {
+            return Err(std::string("frame size does not match its header"));
+        }
+    }
+    this->zi_source_offset = st.s_in_offset;
+
+    return Ok(retval);
+}
+
+Result<size_t, std::string>
+zstd_index::read(int fd, void* buf, file_off_t offset, size_t size)
+{
+    auto* dst = static_cast<char*>(buf);
+    size_t retval = 0;
+
+    while (retval < size) {
+        auto pos = offset + static_cast<file_off_t>(retval);
+        auto index_opt = TRY(this->find_frame(fd, pos));
+        if (!index_opt) {
+            break;
+        }
+
+        auto index = index_opt.value();
+        const auto fr = this->zi_frames[index];
+        auto frame_offset = static_cast<size_t>(pos - fr.f_out_offset);
+        if (!fr.is_cacheable()) {
+            retval += TRY(this->stream_read(
+                fd, index, frame_offset, &dst[retval], size - retval));
+            continue;
+        }
+
+        auto data = TRY(this->decoded(fd, index));
+        auto amount = std::min(size - retval, data->size() - frame_offset);
+
+        memcpy(&dst[retval], data->data() + frame_offset, amount);
+        retval += amount;
+        this->zi_source_offset = fr.f_in_offset + fr.f_in_size;
+    }
+
+    return Ok(retval);
+}
+#else
+Result<size_t, std::string>
+zstd_index::read(int fd, void* buf, file_off_t offset, size_t size)
+{
+    return Err(std::string("zstd support is not available"));
+}
+#endif
+
+}  // namespace lnav
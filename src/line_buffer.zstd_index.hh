@@ -0,0 +1,152 @@
+/**
+ * Copyright (c) 2026, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file line_buffer.zstd_index.hh
+ */
+
+#ifndef lnav_line_buffer_zstd_index_hh
+#define lnav_line_buffer_zstd_index_hh
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+#include "base/file_range.hh"
+#include "base/result.h"
+
+namespace lnav {
+
+/**
+ * Random access to the content of a zstd file.  A zstd file is a sequence
+ * of frames that can be decompressed independently of each other.  If the
+ * file ends with the seek table from the zstd seekable format, the offsets
+ * of all the frames are known up front.  Otherwise, the frames are found by
+ * walking the block headers in each frame as the file is read.
+ *
+ * Frames that decompress to a reasonable size are decompressed in batches
+ * on multiple threads and the most recent ones are kept in memory.  Larger
+ * frames, like the single frame written by the zstd command-line tool, are
+ * decompressed as a stream that can only move forward, so random access
+ * within those is as slow as for other compressed files.
+ */
+class zstd_index {
+public:
+    /** @return True if the given data starts with a zstd frame. */
+    static bool is_zstd(const char* buffer, size_t len);
+
+    /**
+     * Read the uncompressed data at the given offset from the file.
+     *
+     * @return The number of bytes read, which is less than the size only
+     * when the end of the data was reached.
+     */
+    Result<size_t, std::string> read(int fd,
+                                     void* buf,
+                                     file_off_t offset,
+                                     size_t size);
+
+    /**
+     * @return The offset in the compressed file after the last data that
+     * was decompressed.
+     */
+    file_off_t get_source_offset() const { return this->zi_source_offset; }
+
+    /** @return True if the file had a seek table. */
+    bool is_seekable() const { return this->zi_seekable; }
+
+    void clear();
+
+private:
+    struct frame {
+        file_off_t f_in_offset{0};
+        size_t f_in_size{0};
+        file_off_t f_out_offset{0};
+        /** Only unknown for the last frame in the index. */
+        std::optional<size_t> f_out_size;
+
+        bool is_cacheable() const;
+
+        file_off_t end_offset() const
+        {
+            return this->f_out_offset
+                + static_cast<file_off_t>(this->f_out_size.value_or(0));
+        }
+    };
+
+    struct cached_frame {
+        size_t cf_index;
+        uint64_t cf_last_used;
+        std::shared_ptr<const std::string> cf_data;
+    };
+
+    /** The decompression state for a frame that is read as a stream. */
+    struct stream;
+
+    /** Try to load the index from the seek table at the end of the file. */
+    Result<bool, std::string> load_seek_table(int fd);
+
+    /** Find the next data frame after the scan offset, if any. */
+    Result<std::optional<frame>, std::string> scan(int fd);
+
+    /** Add the next batch of frames to the index. */
+    Result<void, std::string> extend(int fd);
+
+    /**
+     * @return The index of the frame that contains the given offset or
+     * nullopt if the offset is past the end of the data.
+     */
+    Result<std::optional<size_t>, std::string> find_frame(int fd,
+                                                          file_off_t offset);
+
+    Result<std::shared_ptr<const std::string>, std::string> decoded(
+        int fd, size_t index);
+
+    Result<size_t, std::string> stream_read(
+        int fd, size_t index, size_t frame_offset, char* buf, size_t size);
+
+    cached_frame* find_cached(size_t index);
+
+    void cache(size_t index, std::shared_ptr<const std::string> data);
+
+    bool zi_seek_table_checked{false};
+    bool zi_seekable{false};
+    std::vector<frame> zi_frames;
+    file_off_t zi_scan_offset{0};
+    bool zi_scan_done{false};
+    file_off_t zi_source_offset{0};
+    uint64_t zi_use_counter{0};
+    std::vector<cached_frame> zi_cache;
+    std::shared_ptr<stream> zi_stream;
+};
+
+}  // namespace lnav
+
+#endif
@@ -106,6 +106,7 @@
 #include "lnav_commands.hh"
 #include "lnav_config.hh"
 #include "lnav_util.hh"
+#include "log_aggregate_vtab.hh"
 #include "log_data_helper.hh"
 #include "log_data_table.hh"
 #include "log_format_loader.hh"
@@ -113,6 +114,7 @@
 #include "log_stmt_vtab.hh"
 #include "log_vtab_impl.hh"
 #include "logfile.hh"
+#include "logfile.index_cache.hh"
 #include "logfile_sub_source.hh"
 #include "logline_window.hh"
 #include "md4cpp.hh"
@@ -1243,6 +1245,8 @@ run_cleanup_tasks()
                                archive_manager::cleanup_cache());
     CLEANUP_TASKS.emplace_back("tailer", tailer::cleanup_cache());
     CLEANUP_TASKS.emplace_back("piper", lnav::piper::cleanup());
+    CLEANUP_TASKS.emplace_back("index_cache",
+                               lnav::logfile::index_cache::cleanup());
     CLEANUP_TASKS.emplace_back("file_converter_manager",
                                file_converter_manager::cleanup());
 }
@@ -2982,6 +2986,7 @@ main(int argc, char* argv[])
     register_regexp_vtab(lnav_data.ld_db.in());
     register_xpath_vtab(lnav_data.ld_db.in());
     register_fstat_vtab(lnav_data.ld_db.in());
+    register_log_aggregate_vtab(lnav_data.ld_db.in());
     lnav::events::register_events_tab(lnav_data.ld_db.in());
     register_log_stmt_vtab(lnav_data.ld_db.in());
 
@@ -90,6 +90,11 @@ public:
         return retval;
     }
 
+    bool logfile_indexing_interrupted() const override
+    {
+        return lnav_data.ld_sigint_count.load() > 0 || !lnav_data.ld_looping;
+    }
+
     off_t lo_last_offset{0};
 };
 
@@ -473,6 +478,10 @@ rebuild_indexes(std::optional<ui_clock::time_point> deadline)
         retval.rir_changes += 1;
     }
 
+    if (lss.update_background_filters()) {
+        retval.rir_changes += 1;
+    }
+
     if (retval.rir_changes > 0) {
         log_trace("updating top/selections");
         if (exec_phase.interactive()) {
@@ -562,6 +571,10 @@ rebuild_indexes_repeatedly()
             rescan_files(false);
             continue;
         }
+        if (lnav_data.ld_log_source.finish_background_filters()) {
+            log_info("background filters finished, rebuilding indexes...");
+            continue;
+        }
         if (rebuild_res.rir_changes == 0) {
             break;
         }
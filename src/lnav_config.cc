@@ -1487,6 +1487,74 @@ static const struct json_path_container logfile_handlers = {
         .with_min_value(1)
         .for_field(&_lnav_config::lc_logfile,
                    &lnav::logfile::config::lc_max_unrecognized_lines),
+    yajlpp::property_handler("index-cache-min-size")
+        .with_synopsis("<bytes>")
+        .with_description("The minimum amount of indexed data, in bytes, "
+                          "before the index for a log file is saved to disk "
+                          "for reuse.  A value of zero disables the cache")
+        .with_min_value(0)
+        .for_field(&_lnav_config::lc_logfile,
+                   &lnav::logfile::config::lc_index_cache_min_size),
+    yajlpp::property_handler("index-cache-ttl")
+        .with_synopsis("<duration>")
+        .with_description(
+            "The time-to-live for saved log file indexes, expressed as a "
+            "duration (e.g. '3d' for three days)")
+        .with_example("3d"_frag)
+        .with_example("12h"_frag)
+        .for_field(&_lnav_config::lc_logfile,
+                   &lnav::logfile::config::lc_index_cache_ttl),
+    yajlpp::property_handler("column-cache-max-size")
+        .with_synopsis("<bytes>")
+        .with_description("The maximum amount of memory, in bytes, used to "
+                          "cache the values extracted from log messages.  A "
+                          "value of zero disables the cache")
+        .with_min_value(0)
+        .for_field(&_lnav_config::lc_logfile,
+                   &lnav::logfile::config::lc_column_cache_max_size),
+    yajlpp::property_handler("search-index-min-size")
+        .with_synopsis("<bytes>")
+        .with_description("The minimum size, in bytes, of a log file before "
+                          "an index of its content is built in the background "
+                          "to speed up searches.  A value of zero disables "
+                          "the index")
+        .with_min_value(0)
+        .for_field(&_lnav_config::lc_logfile,
+                   &lnav::logfile::config::lc_search_index_min_size),
+    yajlpp::property_handler("value-index-max-size")
+        .with_synopsis("<bytes>")
+        .with_description("The maximum amount of memory, in bytes, used by "
+                          "the indexes of column values that are built for "
+                          "SQL queries on a log file.  Once the limit is "
+                          "reached, the indexes for the file are dropped "
+                          "and queries scan the file instead")
+        .with_min_value(0)
+        .for_field(&_lnav_config::lc_logfile,
+                   &lnav::logfile::config::lc_value_index_max_size),
+    yajlpp::property_handler("parallel-index-chunk-size")
+        .with_synopsis("<bytes>")
+        .with_description("The minimum amount of unindexed data, in bytes, "
+                          "handed to each thread when a large log file is "
+                          "indexed in parallel")
+        .with_min_value(1)
+        .for_field(&_lnav_config::lc_logfile,
+                   &lnav::logfile::config::lc_parallel_index_chunk_size),
+    yajlpp::property_handler("background-filter-min-lines")
+        .with_synopsis("<lines>")
+        .with_description("The number of lines a regex filter needs to be "
+                          "behind before it is evaluated on worker threads "
+                          "instead of inline")
+        .with_min_value(1)
+        .for_field(&_lnav_config::lc_logfile,
+                   &lnav::logfile::config::lc_background_filter_min_lines),
+    yajlpp::property_handler("background-filter-chunk-lines")
+        .with_synopsis("<lines>")
+        .with_description("The number of lines handed to a worker thread at a "
+                          "time when evaluating regex filters in the "
+                          "background")
+        .with_min_value(1)
+        .for_field(&_lnav_config::lc_logfile,
+                   &lnav::logfile::config::lc_background_filter_chunk_lines),
 };
 
 static const struct json_path_container ssh_config_handlers = {
@@ -0,0 +1,216 @@
+/**
+ * Copyright (c) 2026, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *
+ * @file log.expr_params.cc
+ */
+
+#include <chrono>
+#include <cmath>
+#include <unordered_set>
+
+#include "log.expr_params.hh"
+
+#include <stdlib.h>
+
+#include "log_format.hh"
+#include "sql_util.hh"
+
+namespace lnav::log {
+
+namespace {
+
+/** The special parameters that lookup() can provide. */
+const std::unordered_set<std::string> NATIVE_PARAMS = {
+    ":log_level",
+    ":log_time",
+    ":log_time_msecs",
+    ":log_mark",
+    ":log_format",
+    ":log_path",
+    ":log_unique_path",
+    ":log_text",
+    ":log_body",
+    ":log_opid",
+};
+
+/** The special parameters that are only bound when using SQLite. */
+const std::unordered_set<std::string> SQLITE_PARAMS = {
+    ":log_comment",
+    ":log_annotations",
+    ":log_tags",
+    ":log_format_regex",
+    ":log_raw_text",
+    ":log_opid_definition",
+    ":log_src_file",
+    ":log_src_line",
+    ":log_thread_id",
+    ":log_duration",
+};
+
+}  // namespace
+
+expr_params::expr_params(logfile& lf, logfile::const_iterator ll)
+    : ep_file(lf), ep_line(ll)
+{
+}
+
+bool
+expr_params::is_native(const std::string& name)
+{
+    return SQLITE_PARAMS.count(name) == 0;
+}
+
+bool
+expr_params::is_field(const std::string& name)
+{
+    return !name.empty() && name[0] != '$' && NATIVE_PARAMS.count(name) == 0
+        && SQLITE_PARAMS.count(name) == 0;
+}
+
+logline_value_vector&
+expr_params::get_values()
+{
+    if (!this->ep_values) {
+        auto& values = this->ep_values.emplace();
+        auto& sbr = values.lvv_sbr;
+
+        this->ep_file.read_full_message(this->ep_line, sbr);
+        sbr.erase_ansi();
+        this->ep_file.get_format()->annotate(
+            &this->ep_file,
+            std::distance(this->ep_file.cbegin(), this->ep_line),
+            this->ep_attrs,
+            values);
+    }
+
+    return this->ep_values.value();
+}
+
+string_fragment
+expr_params::get_timestamp()
+{
+    if (this->ep_timestamp_len == 0) {
+        this->ep_timestamp_len = sql_strftime(this->ep_timestamp,
+                                              sizeof(this->ep_timestamp),
+                                              this->ep_line->get_timeval(),
+                                              'T');
+    }
+
+    return string_fragment::from_bytes(this->ep_timestamp,
+                                       this->ep_timestamp_len);
+}
+
+std::optional<expr_params::value>
+expr_params::lookup(const std::string& name)
+{
+    if (name[0] == '$') {
+        const auto* env_value = getenv(&name[1]);
+
+        if (env_value == nullptr) {
+            return value{};
+        }
+        return value::from_text(string_fragment::from_c_str(env_value));
+    }
+    if (name == ":log_level") {
+        return value::from_text(this->ep_line->get_level_name());
+    }
+    if (name == ":log_time") {
+        return value::from_text(this->get_timestamp());
+    }
+    if (name == ":log_time_msecs") {
+        return value::from_int(
+            this->ep_line->get_time<std::chrono::milliseconds>().count());
+    }
+    if (name == ":log_mark") {
+        return value::from_int(this->ep_line->is_marked());
+    }
+    if (name == ":log_format") {
+        return value::from_text(
+            this->ep_file.get_format()->get_name().to_string_fragment());
+    }
+    if (name == ":log_path") {
+        return value::from_text(
+            string_fragment::from_str(this->ep_file.get_filename().native()));
+    }
+    if (name == ":log_unique_path") {
+        return value::from_text(string_fragment::from_str(
+            this->ep_file.get_unique_path().native()));
+    }
+
+    const auto& values = this->get_values();
+    const auto& sbr = values.lvv_sbr;
+    if (name == ":log_text") {
+        return value::from_text(
+            string_fragment::from_bytes(sbr.get_data(), sbr.length()));
+    }
+    if (name == ":log_body") {
+        auto body_attr_opt = get_string_attr(this->ep_attrs, SA_BODY);
+        if (!body_attr_opt) {
+            return value{};
+        }
+
+        const auto& sar = body_attr_opt.value().saw_string_attr->sa_range;
+        return value::from_text(string_fragment::from_bytes(
+            sbr.get_data_at(sar.lr_start), sar.length()));
+    }
+    if (name == ":log_opid") {
+        if (!values.lvv_opid_value) {
+            return value{};
+        }
+        return value::from_text(
+            string_fragment::from_str(values.lvv_opid_value.value()));
+    }
+
+    for (const auto& lv : values.lvv_values) {
+        if (lv.lv_meta.lvm_name != &name[1]) {
+            continue;
+        }
+
+        switch (lv.lv_meta.lvm_kind) {
+            case value_kind_t::VALUE_BOOLEAN:
+            case value_kind_t::VALUE_INTEGER:
+                return value::from_int(lv.lv_value.i);
+            case value_kind_t::VALUE_FLOAT:
+                // SQLite binds a NaN as NULL.
+                if (std::isnan(lv.lv_value.d)) {
+                    return value{};
+                }
+                return value::from_real(lv.lv_value.d);
+            case value_kind_t::VALUE_NULL:
+                return value{};
+            default:
+                return value::from_text(string_fragment::from_bytes(
+                    lv.text_value(), lv.text_length()));
+        }
+    }
+
+    return std::nullopt;
+}
+
+}  // namespace lnav::log
@@ -0,0 +1,102 @@
+/**
+ * Copyright (c) 2026, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *
+ * @file log.expr_params.hh
+ */
+
+#ifndef lnav_log_expr_params_hh
+#define lnav_log_expr_params_hh
+
+#include <optional>
+#include <string>
+
+#include "logfile.hh"
+#include "sql_predicate.hh"
+
+namespace lnav::log {
+
+/**
+ * Provides the values of the parameters that can be used in the SQL
+ * expressions for filters, marks, and watches (e.g. ":log_level" or a
+ * field like ":sc_status") for a single message.  The message is only read
+ * and annotated when one of the parameters needs its content.
+ */
+class expr_params {
+public:
+    using value = lnav::sql::predicate::value;
+
+    expr_params(logfile& lf, logfile::const_iterator ll);
+
+    /**
+     * @return True if lookup() can provide the given parameter.  The
+     *   parameters for the bookmark metadata and other details that are
+     *   rarely used in expressions are only available when binding to
+     *   SQLite.
+     */
+    static bool is_native(const std::string& name);
+
+    /**
+     * @return True if the parameter refers to a field of the message
+     *   instead of one of the special ":log_*" parameters or an
+     *   environment variable.
+     */
+    static bool is_field(const std::string& name);
+
+    /**
+     * @return The value of the given parameter or nullopt if it names a
+     *   field that is not in the message.  Text values point into this
+     *   object and are only valid for its lifetime.
+     */
+    std::optional<value> lookup(const std::string& name);
+
+    /** @return The values in the message, reading it if necessary. */
+    logline_value_vector& get_values();
+
+    /** @return The attributes of the message, reading it if necessary. */
+    const string_attrs_t& get_attrs()
+    {
+        this->get_values();
+        return this->ep_attrs;
+    }
+
+    /** @return The message timestamp formatted for SQL. */
+    string_fragment get_timestamp();
+
+private:
+    logfile& ep_file;
+    logfile::const_iterator ep_line;
+    char ep_timestamp[64];
+    size_t ep_timestamp_len{0};
+    std::optional<logline_value_vector> ep_values;
+    string_attrs_t ep_attrs;
+};
+
+}  // namespace lnav::log
+
+#endif
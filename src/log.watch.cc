@@ -27,6 +27,9 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <algorithm>
+#include <vector>
+
 #include "log.watch.hh"
 
 #include <sqlite3.h>
@@ -36,6 +39,7 @@
 #include "bound_tags.hh"
 #include "lnav.events.hh"
 #include "lnav_config_fwd.hh"
+#include "log.expr_params.hh"
 #include "log_format.hh"
 #include "logfile_sub_source.cfg.hh"
 #include "readline_highlighters.hh"
@@ -48,6 +52,13 @@ namespace lnav::log::watch {
 
 struct compiled_watch_expr {
     auto_mem<sqlite3_stmt> cwe_stmt{sqlite3_finalize};
+    /** The native version of the expression, if it could be compiled. */
+    std::optional<lnav::sql::predicate> cwe_predicate;
+    /**
+     * The message fields used by the expression, the expression is
+     * skipped for messages that do not have all of them.
+     */
+    std::vector<intern_string_t> cwe_fields;
     bool cwe_enabled{true};
 };
 
@@ -101,6 +112,29 @@ struct expressions : public lnav_config_listener {
                 continue;
             }
 
+            auto count = sqlite3_bind_parameter_count(cwe.cwe_stmt.in());
+            for (int lpc = 0; lpc < count; lpc++) {
+                const auto* name
+                    = sqlite3_bind_parameter_name(cwe.cwe_stmt.in(), lpc + 1);
+
+                if (name != nullptr && expr_params::is_field(name)) {
+                    cwe.cwe_fields.emplace_back(
+                        intern_string::lookup(&name[1]));
+                }
+            }
+            cwe.cwe_predicate = lnav::sql::predicate::compile(
+                string_fragment::from_str(pair.second.we_expr));
+            if (cwe.cwe_predicate) {
+                const auto& vars = cwe.cwe_predicate->get_variables();
+
+                if (!std::all_of(vars.begin(), vars.end(), [](const auto& var) {
+                        return expr_params::is_native(var);
+                    }))
+                {
+                    cwe.cwe_predicate = std::nullopt;
+                }
+            }
+
             this->e_watch_exprs.insert(pair.first, std::move(cwe));
         }
     }
@@ -112,297 +146,371 @@ struct expressions : public lnav_config_listener {
 
 static expressions exprs;
 
-void
-eval_with(logfile& lf, logfile::iterator ll)
+bool
+any_enabled()
 {
-    if (std::none_of(exprs.e_watch_exprs.begin(),
-                     exprs.e_watch_exprs.end(),
-                     [](const auto& elem) { return elem.second.cwe_enabled; }))
-    {
-        return;
-    }
+    return std::any_of(
+        exprs.e_watch_exprs.begin(),
+        exprs.e_watch_exprs.end(),
+        [](const auto& elem) { return elem.second.cwe_enabled; });
+}
 
-    static auto& lnav_db = injector::get<auto_sqlite3&>();
+namespace {
 
-    char timestamp_buffer[64] = "";
+/**
+ * Bind the parameters for a message to the statement and step it.
+ *
+ * @return The result of sqlite3_step() or nullopt if the expression uses
+ *   a field that is not in the message.
+ */
+std::optional<int>
+bind_and_step(sqlite3_stmt* stmt,
+              logfile& lf,
+              logfile::iterator ll,
+              expr_params& params)
+{
     shared_buffer_ref raw_sbr;
-    logline_value_vector values;
-    lf.read_full_message(ll, values.lvv_sbr);
-    values.lvv_sbr.erase_ansi();
+    auto& values = params.get_values();
+    const auto& sa = params.get_attrs();
     auto format = lf.get_format();
-    string_attrs_t sa;
     auto line_number = std::distance(lf.begin(), ll);
-    format->annotate(&lf, line_number, sa, values);
     auto lffs = lf.get_format_file_state();
 
-    for (auto watch_pair : exprs.e_watch_exprs) {
-        if (!watch_pair.second.cwe_enabled) {
-            continue;
-        }
+    sqlite3_reset(stmt);
 
-        auto* stmt = watch_pair.second.cwe_stmt.in();
-        sqlite3_reset(stmt);
+    auto count = sqlite3_bind_parameter_count(stmt);
+    for (int lpc = 0; lpc < count; lpc++) {
+        const auto* name = sqlite3_bind_parameter_name(stmt, lpc + 1);
 
-        auto count = sqlite3_bind_parameter_count(stmt);
-        auto missing_column = false;
-        for (int lpc = 0; lpc < count; lpc++) {
-            const auto* name = sqlite3_bind_parameter_name(stmt, lpc + 1);
+        if (name[0] == '$') {
+            const char* env_value;
 
-            if (name[0] == '$') {
-                const char* env_value;
-
-                if ((env_value = getenv(&name[1])) != nullptr) {
-                    sqlite3_bind_text(
-                        stmt, lpc + 1, env_value, -1, SQLITE_STATIC);
-                }
-                continue;
-            }
-            if (strcmp(name, ":log_level") == 0) {
-                auto lvl = ll->get_level_name();
-                sqlite3_bind_text(
-                    stmt, lpc + 1, lvl.data(), lvl.length(), SQLITE_STATIC);
-                continue;
+            if ((env_value = getenv(&name[1])) != nullptr) {
+                sqlite3_bind_text(stmt, lpc + 1, env_value, -1, SQLITE_STATIC);
             }
-            if (strcmp(name, ":log_time") == 0) {
-                auto len = sql_strftime(timestamp_buffer,
-                                        sizeof(timestamp_buffer),
-                                        ll->get_timeval(),
-                                        'T');
-                sqlite3_bind_text(
-                    stmt, lpc + 1, timestamp_buffer, len, SQLITE_STATIC);
-                continue;
-            }
-            if (strcmp(name, ":log_time_msecs") == 0) {
-                sqlite3_bind_int64(
-                    stmt,
-                    lpc + 1,
-                    ll->get_time<std::chrono::milliseconds>().count());
-                continue;
-            }
-            if (strcmp(name, ":log_format") == 0) {
-                const auto format_name = format->get_name();
-                sqlite3_bind_text(stmt,
-                                  lpc + 1,
-                                  format_name.get(),
-                                  format_name.size(),
-                                  SQLITE_STATIC);
-                continue;
-            }
-            if (strcmp(name, ":log_format_regex") == 0) {
-                const auto pat_name = format->get_pattern_name(
-                    lffs.lffs_pattern_locks, line_number);
-                sqlite3_bind_text(stmt,
-                                  lpc + 1,
-                                  pat_name.get(),
-                                  pat_name.size(),
-                                  SQLITE_STATIC);
-                continue;
-            }
-            if (strcmp(name, ":log_path") == 0) {
-                const auto& filename = lf.get_filename();
+            continue;
+        }
+        if (strcmp(name, ":log_level") == 0) {
+            auto lvl = ll->get_level_name();
+            sqlite3_bind_text(
+                stmt, lpc + 1, lvl.data(), lvl.length(), SQLITE_STATIC);
+            continue;
+        }
+        if (strcmp(name, ":log_time") == 0) {
+            auto ts = params.get_timestamp();
+            sqlite3_bind_text(
+                stmt, lpc + 1, ts.data(), ts.length(), SQLITE_STATIC);
+            continue;
+        }
+        if (strcmp(name, ":log_time_msecs") == 0) {
+            sqlite3_bind_int64(
+                stmt,
+                lpc + 1,
+                ll->get_time<std::chrono::milliseconds>().count());
+            continue;
+        }
+        if (strcmp(name, ":log_mark") == 0) {
+            sqlite3_bind_int(stmt, lpc + 1, ll->is_marked());
+            continue;
+        }
+        if (strcmp(name, ":log_format") == 0) {
+            const auto format_name = format->get_name();
+            sqlite3_bind_text(stmt,
+                              lpc + 1,
+                              format_name.get(),
+                              format_name.size(),
+                              SQLITE_STATIC);
+            continue;
+        }
+        if (strcmp(name, ":log_format_regex") == 0) {
+            const auto pat_name = format->get_pattern_name(
+                lffs.lffs_pattern_locks, line_number);
+            sqlite3_bind_text(
+                stmt, lpc + 1, pat_name.get(), pat_name.size(), SQLITE_STATIC);
+            continue;
+        }
+        if (strcmp(name, ":log_path") == 0) {
+            const auto& filename = lf.get_filename();
+            sqlite3_bind_text(stmt,
+                              lpc + 1,
+                              filename.c_str(),
+                              filename.native().length(),
+                              SQLITE_STATIC);
+            continue;
+        }
+        if (strcmp(name, ":log_unique_path") == 0) {
+            const auto& filename = lf.get_unique_path();
+            sqlite3_bind_text(stmt,
+                              lpc + 1,
+                              filename.c_str(),
+                              filename.native().length(),
+                              SQLITE_STATIC);
+            continue;
+        }
+        if (strcmp(name, ":log_text") == 0) {
+            sqlite3_bind_text(stmt,
+                              lpc + 1,
+                              values.lvv_sbr.get_data(),
+                              values.lvv_sbr.length(),
+                              SQLITE_STATIC);
+            continue;
+        }
+        if (strcmp(name, ":log_body") == 0) {
+            auto body_attr_opt = get_string_attr(sa, SA_BODY);
+            if (body_attr_opt) {
+                const auto& sar
+                    = body_attr_opt.value().saw_string_attr->sa_range;
+
                 sqlite3_bind_text(stmt,
                                   lpc + 1,
-                                  filename.c_str(),
-                                  filename.native().length(),
+                                  values.lvv_sbr.get_data_at(sar.lr_start),
+                                  sar.length(),
                                   SQLITE_STATIC);
-                continue;
+            } else {
+                sqlite3_bind_null(stmt, lpc + 1);
             }
-            if (strcmp(name, ":log_unique_path") == 0) {
-                const auto& filename = lf.get_unique_path();
-                sqlite3_bind_text(stmt,
-                                  lpc + 1,
-                                  filename.c_str(),
-                                  filename.native().length(),
-                                  SQLITE_STATIC);
-                continue;
+            continue;
+        }
+        if (strcmp(name, ":log_opid") == 0) {
+            bind_to_sqlite(stmt, lpc + 1, values.lvv_opid_value);
+            continue;
+        }
+        if (strcmp(name, ":log_src_file") == 0) {
+            bind_to_sqlite(stmt, lpc + 1, values.lvv_src_file_value);
+            continue;
+        }
+        if (strcmp(name, ":log_src_line") == 0) {
+            bind_to_sqlite(stmt, lpc + 1, values.lvv_src_line_value);
+            continue;
+        }
+        if (strcmp(name, ":log_thread_id") == 0) {
+            bind_to_sqlite(stmt, lpc + 1, values.lvv_thread_id_value);
+            continue;
+        }
+        if (strcmp(name, ":log_duration") == 0) {
+            if (values.lvv_duration_value) {
+                bind_to_sqlite(stmt,
+                               lpc + 1,
+                               values.lvv_duration_value->count() / 1000000.0);
+            } else {
+                sqlite3_bind_null(stmt, lpc + 1);
             }
-            if (strcmp(name, ":log_text") == 0) {
+            continue;
+        }
+        if (strcmp(name, ":log_raw_text") == 0) {
+            auto res = lf.read_raw_message(ll);
+
+            if (res.isOk()) {
+                raw_sbr = res.unwrap();
                 sqlite3_bind_text(stmt,
                                   lpc + 1,
-                                  values.lvv_sbr.get_data(),
-                                  values.lvv_sbr.length(),
+                                  raw_sbr.get_data(),
+                                  raw_sbr.length(),
                                   SQLITE_STATIC);
-                continue;
             }
-            if (strcmp(name, ":log_body") == 0) {
-                auto body_attr_opt = get_string_attr(sa, SA_BODY);
-                if (body_attr_opt) {
-                    const auto& sar
-                        = body_attr_opt.value().saw_string_attr->sa_range;
+            continue;
+        }
+        if (strcmp(name, ":log_tags") == 0) {
+            const auto& bm = lf.get_bookmark_metadata();
+            auto bm_iter = bm.find(line_number);
+            if (bm_iter != bm.end() && !bm_iter->second.bm_tags.empty()) {
+                const auto& meta = bm_iter->second;
+                yajlpp_gen gen;
 
-                    sqlite3_bind_text(stmt,
-                                      lpc + 1,
-                                      values.lvv_sbr.get_data_at(sar.lr_start),
-                                      sar.length(),
-                                      SQLITE_STATIC);
-                } else {
-                    sqlite3_bind_null(stmt, lpc + 1);
+                yajl_gen_config(gen, yajl_gen_beautify, false);
+
+                {
+                    yajlpp_array arr(gen);
+
+                    for (const auto& entry : meta.bm_tags) {
+                        arr.gen(entry.te_tag);
+                    }
                 }
-                continue;
-            }
-            if (strcmp(name, ":log_opid") == 0) {
-                bind_to_sqlite(stmt, lpc + 1, values.lvv_opid_value);
-                continue;
-            }
-            if (strcmp(name, ":log_src_file") == 0) {
-                bind_to_sqlite(stmt, lpc + 1, values.lvv_src_file_value);
-                continue;
-            }
-            if (strcmp(name, ":log_src_line") == 0) {
-                bind_to_sqlite(stmt, lpc + 1, values.lvv_src_line_value);
-                continue;
-            }
-            if (strcmp(name, ":log_thread_id") == 0) {
-                bind_to_sqlite(stmt, lpc + 1, values.lvv_thread_id_value);
-                continue;
+
+                string_fragment sf = gen.to_string_fragment();
+
+                sqlite3_bind_text(
+                    stmt, lpc + 1, sf.data(), sf.length(), SQLITE_TRANSIENT);
             }
-            if (strcmp(name, ":log_duration") == 0) {
-                if (values.lvv_duration_value) {
-                    bind_to_sqlite(
-                        stmt,
-                        lpc + 1,
-                        values.lvv_duration_value->count() / 1000000.0);
-                } else {
-                    sqlite3_bind_null(stmt, lpc + 1);
-                }
+            continue;
+        }
+        auto found = false;
+        for (const auto& lv : values.lvv_values) {
+            if (lv.lv_meta.lvm_name != &name[1]) {
                 continue;
             }
-            if (strcmp(name, ":log_raw_text") == 0) {
-                auto res = lf.read_raw_message(ll);
 
-                if (res.isOk()) {
-                    raw_sbr = res.unwrap();
+            found = true;
+            switch (lv.lv_meta.lvm_kind) {
+                case value_kind_t::VALUE_BOOLEAN:
+                    sqlite3_bind_int64(stmt, lpc + 1, lv.lv_value.i);
+                    break;
+                case value_kind_t::VALUE_FLOAT:
+                    sqlite3_bind_double(stmt, lpc + 1, lv.lv_value.d);
+                    break;
+                case value_kind_t::VALUE_INTEGER:
+                    sqlite3_bind_int64(stmt, lpc + 1, lv.lv_value.i);
+                    break;
+                case value_kind_t::VALUE_NULL:
+                    sqlite3_bind_null(stmt, lpc + 1);
+                    break;
+                default:
                     sqlite3_bind_text(stmt,
                                       lpc + 1,
-                                      raw_sbr.get_data(),
-                                      raw_sbr.length(),
-                                      SQLITE_STATIC);
-                }
-                continue;
+                                      lv.text_value(),
+                                      lv.text_length(),
+                                      SQLITE_TRANSIENT);
+                    break;
             }
-            if (strcmp(name, ":log_tags") == 0) {
-                const auto& bm = lf.get_bookmark_metadata();
-                auto bm_iter = bm.find(line_number);
-                if (bm_iter != bm.end() && !bm_iter->second.bm_tags.empty()) {
-                    const auto& meta = bm_iter->second;
-                    yajlpp_gen gen;
+            break;
+        }
+        if (!found) {
+            return std::nullopt;
+        }
+    }
+
+    return sqlite3_step(stmt);
+}
 
-                    yajl_gen_config(gen, yajl_gen_beautify, false);
+void
+publish_match(const std::string& watch_name,
+              logfile& lf,
+              logfile::iterator ll,
+              expr_params& params)
+{
+    static auto& lnav_db = injector::get<auto_sqlite3&>();
 
-                    {
-                        yajlpp_array arr(gen);
+    auto lmd = lnav::events::log::msg_detected{
+        watch_name,
+        lf.get_filename(),
+        lf.get_format_name().to_string(),
+        (uint32_t) std::distance(lf.begin(), ll),
+        params.get_timestamp().to_string(),
+    };
+    for (const auto& lv : params.get_values().lvv_values) {
+        switch (lv.lv_meta.lvm_kind) {
+            case value_kind_t::VALUE_NULL:
+                lmd.md_values[lv.lv_meta.lvm_name.to_string()]
+                    = null_value_t{};
+                break;
+            case value_kind_t::VALUE_BOOLEAN:
+                lmd.md_values[lv.lv_meta.lvm_name.to_string()]
+                    = lv.lv_value.i ? true : false;
+                break;
+            case value_kind_t::VALUE_INTEGER:
+                lmd.md_values[lv.lv_meta.lvm_name.to_string()]
+                    = lv.lv_value.i;
+                break;
+            case value_kind_t::VALUE_FLOAT:
+                lmd.md_values[lv.lv_meta.lvm_name.to_string()]
+                    = lv.lv_value.d;
+                break;
+            default:
+                lmd.md_values[lv.lv_meta.lvm_name.to_string()]
+                    = lv.to_string();
+                break;
+        }
+    }
+    lnav::events::publish(lnav_db, lmd);
+}
 
-                        for (const auto& entry : meta.bm_tags) {
-                            arr.gen(entry.te_tag);
-                        }
-                    }
+}  // namespace
 
-                    string_fragment sf = gen.to_string_fragment();
+void
+eval_with(logfile& lf, logfile::iterator begin, logfile::iterator end)
+{
+    if (begin == end || !any_enabled()) {
+        return;
+    }
 
-                    sqlite3_bind_text(stmt,
-                                      lpc + 1,
-                                      sf.data(),
-                                      sf.length(),
-                                      SQLITE_TRANSIENT);
-                }
+    static auto& lnav_db = injector::get<auto_sqlite3&>();
+
+    // Drop the expressions that use fields this format never has before
+    // looking at any messages, so watches on other formats cost nothing.
+    auto format = lf.get_format();
+    std::vector<std::pair<const std::string*, compiled_watch_expr*>>
+        applicable;
+    for (auto watch_pair : exprs.e_watch_exprs) {
+        auto& cwe = watch_pair.second;
+
+        if (!cwe.cwe_enabled) {
+            continue;
+        }
+        if (!std::all_of(cwe.cwe_fields.begin(),
+                         cwe.cwe_fields.end(),
+                         [&format](const auto& field) {
+                             return format->may_have_value(field);
+                         }))
+        {
+            continue;
+        }
+        applicable.emplace_back(&watch_pair.first, &cwe);
+    }
+    if (applicable.empty()) {
+        return;
+    }
+
+    std::vector<lnav::sql::predicate::value> vars;
+    for (auto ll = begin; ll != end; ++ll) {
+        if (ll->is_continued() || !ll->is_valid_utf()) {
+            continue;
+        }
+
+        expr_params params(lf, ll);
+        for (auto& [watch_name, cwe] : applicable) {
+            if (!cwe->cwe_enabled) {
                 continue;
             }
-            auto found = false;
-            for (const auto& lv : values.lvv_values) {
-                if (lv.lv_meta.lvm_name != &name[1]) {
+
+            if (cwe->cwe_predicate) {
+                auto missing_field = false;
+
+                vars.clear();
+                for (const auto& var : cwe->cwe_predicate->get_variables()) {
+                    auto val = params.lookup(var);
+                    if (!val) {
+                        missing_field = true;
+                        break;
+                    }
+                    vars.emplace_back(val.value());
+                }
+                if (missing_field) {
                     continue;
                 }
 
-                found = true;
-                switch (lv.lv_meta.lvm_kind) {
-                    case value_kind_t::VALUE_BOOLEAN:
-                        sqlite3_bind_int64(stmt, lpc + 1, lv.lv_value.i);
-                        break;
-                    case value_kind_t::VALUE_FLOAT:
-                        sqlite3_bind_double(stmt, lpc + 1, lv.lv_value.d);
-                        break;
-                    case value_kind_t::VALUE_INTEGER:
-                        sqlite3_bind_int64(stmt, lpc + 1, lv.lv_value.i);
-                        break;
-                    case value_kind_t::VALUE_NULL:
-                        sqlite3_bind_null(stmt, lpc + 1);
-                        break;
-                    default:
-                        sqlite3_bind_text(stmt,
-                                          lpc + 1,
-                                          lv.text_value(),
-                                          lv.text_length(),
-                                          SQLITE_TRANSIENT);
-                        break;
+                auto pred_res = cwe->cwe_predicate->eval(vars);
+                if (pred_res) {
+                    if (pred_res.value()) {
+                        publish_match(*watch_name, lf, ll, params);
+                    }
+                    continue;
                 }
-                break;
-            }
-            if (!found) {
-                missing_column = true;
-                break;
             }
-        }
 
-        if (missing_column) {
-            continue;
-        }
-
-        auto step_res = sqlite3_step(stmt);
-
-        switch (step_res) {
-            case SQLITE_OK:
-            case SQLITE_DONE:
-                continue;
-            case SQLITE_ROW:
-                break;
-            default: {
-                log_error("failed to execute watch expression: %s -- %s",
-                          watch_pair.first.c_str(),
-                          sqlite3_errmsg(lnav_db));
-                watch_pair.second.cwe_enabled = false;
+            auto step_res
+                = bind_and_step(cwe->cwe_stmt.in(), lf, ll, params);
+            if (!step_res) {
                 continue;
             }
-        }
 
-        if (!timestamp_buffer[0]) {
-            sql_strftime(timestamp_buffer,
-                         sizeof(timestamp_buffer),
-                         ll->get_timeval(),
-                         'T');
-        }
-        auto lmd = lnav::events::log::msg_detected{
-            watch_pair.first,
-            lf.get_filename(),
-            lf.get_format_name().to_string(),
-            (uint32_t) line_number,
-            timestamp_buffer,
-        };
-        for (const auto& lv : values.lvv_values) {
-            switch (lv.lv_meta.lvm_kind) {
-                case value_kind_t::VALUE_NULL:
-                    lmd.md_values[lv.lv_meta.lvm_name.to_string()]
-                        = null_value_t{};
-                    break;
-                case value_kind_t::VALUE_BOOLEAN:
-                    lmd.md_values[lv.lv_meta.lvm_name.to_string()]
-                        = lv.lv_value.i ? true : false;
-                    break;
-                case value_kind_t::VALUE_INTEGER:
-                    lmd.md_values[lv.lv_meta.lvm_name.to_string()]
-                        = lv.lv_value.i;
-                    break;
-                case value_kind_t::VALUE_FLOAT:
-                    lmd.md_values[lv.lv_meta.lvm_name.to_string()]
-                        = lv.lv_value.d;
-                    break;
-                default:
-                    lmd.md_values[lv.lv_meta.lvm_name.to_string()]
-                        = lv.to_string();
+            switch (step_res.value()) {
+                case SQLITE_OK:
+                case SQLITE_DONE:
+                    continue;
+                case SQLITE_ROW:
                     break;
+                default: {
+                    log_error("failed to execute watch expression: %s -- %s",
+                              watch_name->c_str(),
+                              sqlite3_errmsg(lnav_db));
+                    cwe->cwe_enabled = false;
+                    continue;
+                }
             }
+
+            publish_match(*watch_name, lf, ll, params);
         }
-        lnav::events::publish(lnav_db, lmd);
     }
 }
 
-}  // namespace lnav::log::watch
\ No newline at end of file
+}  // namespace lnav::log::watch
@@ -34,7 +34,16 @@
 
 namespace lnav::log::watch {
 
-void eval_with(logfile& lf, logfile::iterator ll);
+/**
+ * Evaluate the watch expressions against the messages in the given range
+ * of newly indexed lines and publish an event for each match.
+ */
+void eval_with(logfile& lf, logfile::iterator begin, logfile::iterator end);
+
+/**
+ * @return True if any of the configured watch expressions are enabled.
+ */
+bool any_enabled();
 
 }
 
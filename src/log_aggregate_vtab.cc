@@ -0,0 +1,1384 @@
+/**
+ * Copyright (c) 2026, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file log_aggregate_vtab.cc
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <future>
+#include <memory>
+#include <thread>
+
+#include "log_aggregate_vtab.hh"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "base/ansi_scrubber.hh"
+#include "base/auto_fd.hh"
+#include "base/injector.hh"
+#include "base/lnav.console.hh"
+#include "base/lnav_log.hh"
+#include "base/string_util.hh"
+#include "config.h"
+#include "fmt/format.h"
+#include "log_format_ext.hh"
+#include "log_vtab_impl.hh"
+#include "logfile_sub_source.hh"
+#include "robin_hood/robin_hood.h"
+#include "sql_help.hh"
+#include "sql_predicate.hh"
+#include "sql_util.hh"
+#include "vtab_module.hh"
+#include "yajlpp/yajlpp.hh"
+
+namespace {
+
+enum {
+    AGG_COL_GROUPS,
+    AGG_COL_RESULTS,
+    AGG_COL_TBL,
+    AGG_COL_GROUP_BY,
+    AGG_COL_AGGREGATES,
+    AGG_COL_WHERE,
+};
+
+/** The number of messages handed to a worker at a time. */
+constexpr size_t CHUNK_MESSAGES = 64 * 1024;
+
+constexpr uint8_t MSG_VALID_UTF = 0x01;
+constexpr uint8_t MSG_HAS_ANSI = 0x02;
+
+using pred_value = lnav::sql::predicate::value;
+using pred_kind = lnav::sql::predicate::value::kind;
+
+/** A copy of a value that outlives the message it was read from. */
+struct owned_value {
+    static owned_value from(const pred_value& val)
+    {
+        owned_value retval;
+
+        retval.ov_kind = val.v_kind;
+        retval.ov_int = val.v_int;
+        retval.ov_real = val.v_real;
+        if (val.v_kind == pred_kind::text) {
+            retval.ov_text = val.v_text.to_string();
+        }
+        return retval;
+    }
+
+    pred_value to_value() const
+    {
+        switch (this->ov_kind) {
+            case pred_kind::null:
+                break;
+            case pred_kind::integer:
+                return pred_value::from_int(this->ov_int);
+            case pred_kind::real:
+                return pred_value::from_real(this->ov_real);
+            case pred_kind::text:
+                return pred_value::from_text(
+                    string_fragment::from_str(this->ov_text));
+        }
+        return pred_value{};
+    }
+
+    void gen(yajlpp_generator& gen) const
+    {
+        switch (this->ov_kind) {
+            case pred_kind::null:
+                gen();
+                break;
+            case pred_kind::integer:
+                gen(this->ov_int);
+                break;
+            case pred_kind::real:
+                gen(this->ov_real);
+                break;
+            case pred_kind::text:
+                gen(this->ov_text);
+                break;
+        }
+    }
+
+    pred_kind ov_kind{pred_kind::null};
+    int64_t ov_int{0};
+    double ov_real{0.0};
+    std::string ov_text;
+};
+
+enum class agg_func : uint8_t {
+    count,
+    sum,
+    avg,
+    min,
+    max,
+    percentile,
+};
+
+struct agg_spec {
+    agg_func as_func{agg_func::count};
+    std::string as_label;
+    /** The index of the column in the plan, nullopt for count(*). */
+    std::optional<size_t> as_column;
+    double as_percent{0.0};
+};
+
+/** The running state of an aggregate within one group. */
+struct agg_state {
+    /** The number of non-NULL values, or rows for count(*). */
+    int64_t as_count{0};
+    int64_t as_int_sum{0};
+    double as_total{0.0};
+    bool as_has_real{false};
+    bool as_overflow{false};
+    std::optional<owned_value> as_extreme;
+    std::unique_ptr<logline_value_stats> as_stats;
+
+    void add_number(const pred_value& val)
+    {
+        if (val.v_kind == pred_kind::integer) {
+            this->as_total += val.v_int;
+            if (__builtin_add_overflow(
+                    this->as_int_sum, val.v_int, &this->as_int_sum))
+            {
+                this->as_overflow = true;
+            }
+        } else {
+            this->as_total += val.v_real;
+            this->as_has_real = true;
+        }
+    }
+
+    void add_extreme(const pred_value& val, int sign)
+    {
+        if (!this->as_extreme
+            || pred_value::compare(val, this->as_extreme->to_value()) * sign > 0)
+        {
+            this->as_extreme = owned_value::from(val);
+        }
+    }
+
+    void merge(agg_state& other, int sign)
+    {
+        this->as_count += other.as_count;
+        if (__builtin_add_overflow(
+                this->as_int_sum, other.as_int_sum, &this->as_int_sum))
+        {
+            this->as_overflow = true;
+        }
+        this->as_overflow = this->as_overflow || other.as_overflow;
+        this->as_total += other.as_total;
+        this->as_has_real = this->as_has_real || other.as_has_real;
+        if (other.as_extreme) {
+            this->add_extreme(other.as_extreme->to_value(), sign);
+        }
+        if (other.as_stats != nullptr) {
+            // tdigest::insert() only copies the merged centroids.
+            other.as_stats->lvs_tdigest.merge();
+            if (this->as_stats == nullptr) {
+                this->as_stats = std::move(other.as_stats);
+            } else {
+                this->as_stats->merge(*other.as_stats);
+            }
+        }
+    }
+};
+
+int
+extreme_sign(agg_func func)
+{
+    return func == agg_func::min ? -1 : 1;
+}
+
+/** The parsed arguments of a call to the function. */
+struct aggregate_plan {
+    struct column {
+        intern_string_t c_name;
+        value_kind_t c_kind{value_kind_t::VALUE_TEXT};
+        /** True if this is the level of the message. */
+        bool c_is_level{false};
+    };
+
+    Result<size_t, std::string> add_column(const external_log_format& format,
+                                           string_fragment name,
+                                           bool numeric)
+    {
+        if (name.startswith("\"") && name.endswith("\"")
+            && name.length() >= 2)
+        {
+            name = name.sub_range(1, name.length() - 1);
+        }
+        if (name.empty()) {
+            return Err(std::string("expecting a column name"));
+        }
+
+        auto iname = intern_string::lookup(name);
+        for (size_t lpc = 0; lpc < this->ap_columns.size(); lpc++) {
+            const auto& col = this->ap_columns[lpc];
+
+            if (col.c_name != iname) {
+                continue;
+            }
+            if (numeric && col.c_kind == value_kind_t::VALUE_TEXT) {
+                return Err(
+                    fmt::format(FMT_STRING("column {} is not numeric"), name));
+            }
+            return Ok(lpc);
+        }
+
+        column col;
+        col.c_name = iname;
+        if (name == "log_level") {
+            col.c_is_level = true;
+        } else {
+            auto vd_iter = format.elf_value_defs.find(iname);
+            if (vd_iter == format.elf_value_defs.end()) {
+                return Err(fmt::format(FMT_STRING("unknown column {}"), name));
+            }
+
+            const auto& vd = *vd_iter->second;
+            switch (vd.vd_meta.lvm_kind) {
+                case value_kind_t::VALUE_TEXT:
+                    if (!vd.vd_meta.lvm_struct_name.empty()) {
+                        return Err(fmt::format(
+                            FMT_STRING("column {} holds structured values"),
+                            name));
+                    }
+                    if (!vd.vd_collate.empty()) {
+                        return Err(fmt::format(
+                            FMT_STRING("column {} uses the {} collation"),
+                            name,
+                            vd.vd_collate));
+                    }
+                    break;
+                case value_kind_t::VALUE_INTEGER:
+                case value_kind_t::VALUE_FLOAT:
+                case value_kind_t::VALUE_BOOLEAN:
+                    break;
+                default:
+                    return Err(fmt::format(
+                        FMT_STRING("column {} has an unsupported type"),
+                        name));
+            }
+            col.c_kind = vd.vd_meta.lvm_kind;
+        }
+        if (numeric && col.c_kind == value_kind_t::VALUE_TEXT) {
+            return Err(
+                fmt::format(FMT_STRING("column {} is not numeric"), name));
+        }
+
+        this->ap_columns.emplace_back(col);
+        return Ok(this->ap_columns.size() - 1);
+    }
+
+    intern_string_t ap_format_name;
+    std::vector<column> ap_columns;
+    /** The indexes of the grouping columns in ap_columns. */
+    std::vector<size_t> ap_group_by;
+    std::vector<agg_spec> ap_aggs;
+    std::optional<lnav::sql::predicate> ap_where;
+    /** The index in ap_columns of each variable in the where expression. */
+    std::vector<size_t> ap_where_columns;
+};
+
+/**
+ * Split the given string on the commas that are not nested in parentheses
+ * or quotes.
+ */
+std::vector<string_fragment>
+split_top_level(string_fragment sf)
+{
+    std::vector<string_fragment> retval;
+    int depth = 0;
+    char quote = '\0';
+    int start = 0;
+
+    for (int lpc = 0; lpc < sf.length(); lpc++) {
+        auto ch = sf[lpc];
+
+        if (quote != '\0') {
+            if (ch == quote) {
+                quote = '\0';
+            }
+            continue;
+        }
+        switch (ch) {
+            case '\'':
+            case '"':
+                quote = ch;
+                break;
+            case '(':
+                depth += 1;
+                break;
+            case ')':
+                depth -= 1;
+                break;
+            case ',':
+                if (depth == 0) {
+                    retval.emplace_back(sf.sub_range(start, lpc).trim());
+                    start = lpc + 1;
+                }
+                break;
+        }
+    }
+    retval.emplace_back(sf.substr(start).trim());
+
+    return retval;
+}
+
+Result<agg_spec, std::string>
+parse_aggregate(aggregate_plan& plan,
+                const external_log_format& format,
+                string_fragment expr)
+{
+    agg_spec retval;
+
+    auto close = expr.rfind(')');
+    auto open = expr.find('(');
+    if (!close || !open || open.value() > close.value()) {
+        return Err(fmt::format(
+            FMT_STRING("expecting an aggregate function call, found: {}"),
+            expr));
+    }
+
+    auto tail = expr.substr(close.value() + 1).trim();
+    if (tail.empty()) {
+        retval.as_label = expr.to_string();
+    } else if (tail.length() > 3 && tail.sub_range(0, 2).iequal("as"_frag)
+               && isspace(tail[2]))
+    {
+        auto alias = tail.substr(3).trim();
+        if (alias.length() >= 2 && alias.startswith("\"")
+            && alias.endswith("\""))
+        {
+            alias = alias.sub_range(1, alias.length() - 1);
+        }
+        retval.as_label = alias.to_string();
+    } else {
+        return Err(fmt::format(
+            FMT_STRING("unexpected text after aggregate function: {}"),
+            tail));
+    }
+
+    auto name = tolower(expr.sub_range(0, open.value()).trim().to_string());
+    auto args
+        = split_top_level(expr.sub_range(open.value() + 1, close.value()));
+    auto numeric = true;
+    size_t arg_count = 1;
+
+    if (name == "count") {
+        retval.as_func = agg_func::count;
+        numeric = false;
+    } else if (name == "sum") {
+        retval.as_func = agg_func::sum;
+    } else if (name == "avg") {
+        retval.as_func = agg_func::avg;
+    } else if (name == "min") {
+        retval.as_func = agg_func::min;
+        numeric = false;
+    } else if (name == "max") {
+        retval.as_func = agg_func::max;
+        numeric = false;
+    } else if (name == "percentile") {
+        retval.as_func = agg_func::percentile;
+        arg_count = 2;
+    } else {
+        return Err(fmt::format(
+            FMT_STRING("unsupported aggregate function: {}"), name));
+    }
+
+    if (args.size() != arg_count) {
+        return Err(fmt::format(FMT_STRING("{}() expects {} argument(s)"),
+                               name,
+                               arg_count));
+    }
+    if (retval.as_func == agg_func::count && args[0] == "*") {
+        return Ok(std::move(retval));
+    }
+    retval.as_column = TRY(plan.add_column(format, args[0], numeric));
+    if (retval.as_func == agg_func::percentile) {
+        auto pct_str = args[1].to_string();
+        char* end = nullptr;
+
+        retval.as_percent = strtod(pct_str.c_str(), &end);
+        if (pct_str.empty() || *end != '\0' || retval.as_percent < 0.0
+            || retval.as_percent > 100.0)
+        {
+            return Err(fmt::format(
+                FMT_STRING("percentile() expects a number between 0 and 100, "
+                           "found: {}"),
+                args[1]));
+        }
+    }
+
+    return Ok(std::move(retval));
+}
+
+Result<aggregate_plan, std::string>
+compile_plan(const external_log_format& format,
+             string_fragment group_by,
+             string_fragment aggregates,
+             std::optional<string_fragment> where)
+{
+    aggregate_plan retval;
+
+    retval.ap_format_name = format.get_name();
+    if (!group_by.trim().empty()) {
+        for (const auto& name : split_top_level(group_by)) {
+            retval.ap_group_by.emplace_back(
+                TRY(retval.add_column(format, name, false)));
+        }
+    }
+    for (const auto& expr : split_top_level(aggregates)) {
+        retval.ap_aggs.emplace_back(
+            TRY(parse_aggregate(retval, format, expr)));
+    }
+    if (where && !where->trim().empty()) {
+        retval.ap_where = lnav::sql::predicate::compile(where.value());
+        if (!retval.ap_where) {
+            return Err(
+                std::string("the where expression uses syntax that is not "
+                            "supported, only comparisons of columns and "
+                            "literals combined with AND/OR/NOT can be used"));
+        }
+        for (const auto& var : retval.ap_where->get_variables()) {
+            retval.ap_where_columns.emplace_back(TRY(retval.add_column(
+                format, string_fragment::from_str(var).substr(1), false)));
+        }
+    }
+
+    return Ok(std::move(retval));
+}
+
+struct group_state {
+    std::vector<owned_value> gs_key;
+    std::vector<agg_state> gs_aggs;
+};
+
+/** The groups collected from a part of the messages. */
+struct partial_result {
+    robin_hood::unordered_map<std::string, group_state> pr_groups;
+    std::optional<std::string> pr_error;
+
+    void merge(const aggregate_plan& plan, partial_result& other)
+    {
+        if (other.pr_error && !this->pr_error) {
+            this->pr_error = std::move(other.pr_error);
+        }
+        for (auto& group : other.pr_groups) {
+            auto iter = this->pr_groups.find(group.first);
+            if (iter == this->pr_groups.end()) {
+                this->pr_groups.emplace(group.first, std::move(group.second));
+                continue;
+            }
+            for (size_t lpc = 0; lpc < plan.ap_aggs.size(); lpc++) {
+                iter->second.gs_aggs[lpc].merge(
+                    group.second.gs_aggs[lpc],
+                    extreme_sign(plan.ap_aggs[lpc].as_func));
+            }
+        }
+    }
+};
+
+/** Folds rows with the values of the plan columns into groups. */
+class accumulator {
+public:
+    explicit accumulator(const aggregate_plan& plan) : a_plan(plan) {}
+
+    void add_row(const std::vector<pred_value>& row)
+    {
+        if (this->a_result.pr_error) {
+            return;
+        }
+
+        const auto& plan = this->a_plan;
+        if (plan.ap_where) {
+            this->a_where_vars.clear();
+            for (auto index : plan.ap_where_columns) {
+                this->a_where_vars.emplace_back(row[index]);
+            }
+            auto eval_res = plan.ap_where->eval(this->a_where_vars);
+            if (!eval_res) {
+                this->a_result.pr_error
+                    = "the where expression could not be evaluated for a "
+                      "message, the types of the values might not be "
+                      "supported";
+                return;
+            }
+            if (!eval_res.value()) {
+                return;
+            }
+        }
+
+        this->a_key.clear();
+        for (auto index : plan.ap_group_by) {
+            append_key(this->a_key, row[index]);
+        }
+        auto iter = this->a_result.pr_groups.find(this->a_key);
+        if (iter == this->a_result.pr_groups.end()) {
+            group_state gs;
+
+            for (auto index : plan.ap_group_by) {
+                gs.gs_key.emplace_back(owned_value::from(row[index]));
+            }
+            gs.gs_aggs.resize(plan.ap_aggs.size());
+            iter = this->a_result.pr_groups.emplace(this->a_key, std::move(gs))
+                       .first;
+        }
+
+        for (size_t lpc = 0; lpc < plan.ap_aggs.size(); lpc++) {
+            const auto& spec = plan.ap_aggs[lpc];
+            auto& state = iter->second.gs_aggs[lpc];
+
+            if (!spec.as_column) {
+                state.as_count += 1;
+                continue;
+            }
+
+            const auto& val = row[spec.as_column.value()];
+            if (val.is_null()) {
+                continue;
+            }
+            state.as_count += 1;
+            switch (spec.as_func) {
+                case agg_func::count:
+                    break;
+                case agg_func::sum:
+                case agg_func::avg:
+                    state.add_number(val);
+                    break;
+                case agg_func::min:
+                case agg_func::max:
+                    state.add_extreme(val, extreme_sign(spec.as_func));
+                    break;
+                case agg_func::percentile:
+                    if (state.as_stats == nullptr) {
+                        state.as_stats
+                            = std::make_unique<logline_value_stats>();
+                    }
+                    state.as_stats->add_value(
+                        val.v_kind == pred_kind::integer ? (double) val.v_int
+                                                         : val.v_real);
+                    break;
+            }
+        }
+    }
+
+    partial_result a_result;
+
+private:
+    static void append_key(std::string& key, const pred_value& val)
+    {
+        key.push_back((char) val.v_kind);
+        switch (val.v_kind) {
+            case pred_kind::null:
+                break;
+            case pred_kind::integer:
+                key.append((const char*) &val.v_int, sizeof(val.v_int));
+                break;
+            case pred_kind::real:
+                key.append((const char*) &val.v_real, sizeof(val.v_real));
+                break;
+            case pred_kind::text: {
+                auto len = (uint32_t) val.v_text.length();
+
+                key.append((const char*) &len, sizeof(len));
+                key.append(val.v_text.data(), len);
+                break;
+            }
+        }
+    }
+
+    const aggregate_plan& a_plan;
+    std::vector<pred_value> a_where_vars;
+    std::string a_key;
+};
+
+pred_value
+to_value(const logline_value& lv)
+{
+    switch (lv.lv_meta.lvm_kind) {
+        case value_kind_t::VALUE_NULL:
+            return pred_value{};
+        case value_kind_t::VALUE_INTEGER:
+        case value_kind_t::VALUE_BOOLEAN:
+            return pred_value::from_int(lv.lv_value.i);
+        case value_kind_t::VALUE_FLOAT:
+            return pred_value::from_real(lv.lv_value.d);
+        default:
+            return pred_value::from_text(lv.text_value_fragment());
+    }
+}
+
+/** Where the values of the plan columns are captured in a file's messages. */
+struct file_layout {
+    std::vector<std::shared_ptr<external_log_format::pattern>> fl_patterns;
+    /** The capture index of each plan column for each pattern, or -1. */
+    std::vector<std::vector<int>> fl_captures;
+};
+
+/**
+ * @return The layout of the values in the given file or nullptr if the
+ *   workers cannot extract the values from the raw bytes in the file.
+ */
+std::shared_ptr<const file_layout>
+layout_for(const aggregate_plan& plan, const logfile& lf)
+{
+    const auto* format
+        = dynamic_cast<const external_log_format*>(lf.get_format_ptr());
+
+    if (format == nullptr
+        || format->elf_type != external_log_format::elf_type_t::ELF_TYPE_TEXT
+        || lf.is_compressed() || lf.has_line_metadata() || lf.is_pipe()
+        || !format->has_raw_sublines())
+    {
+        return nullptr;
+    }
+
+    auto retval = std::make_shared<file_layout>();
+    for (const auto& pat : format->elf_pattern_order) {
+        auto& captures = retval->fl_captures.emplace_back(
+            plan.ap_columns.size(), -1);
+
+        for (const auto& ivd : pat->p_value_by_index) {
+            for (size_t lpc = 0; lpc < plan.ap_columns.size(); lpc++) {
+                if (plan.ap_columns[lpc].c_name
+                    != ivd.ivd_value_def->vd_meta.lvm_name)
+                {
+                    continue;
+                }
+                // Values with units are scaled by annotate().
+                if (ivd.ivd_unit_field_index >= 0) {
+                    return nullptr;
+                }
+                captures[lpc] = ivd.ivd_index;
+            }
+        }
+        retval->fl_patterns.emplace_back(pat);
+    }
+
+    return retval;
+}
+
+struct chunk_message {
+    file_off_t cm_offset;
+    file_ssize_t cm_length;
+    int cm_pattern;
+    uint8_t cm_flags;
+    uint8_t cm_level;
+};
+
+bool
+read_fully(int fd, char* buf, size_t len, file_off_t off)
+{
+    size_t done = 0;
+
+    while (done < len) {
+        auto rc = pread(fd, buf + done, len - done, off + done);
+        if (rc <= 0) {
+            log_error("aggregate: unable to read at %lld",
+                      (long long) (off + done));
+            return false;
+        }
+        done += rc;
+    }
+
+    return true;
+}
+
+/**
+ * Aggregate a chunk of messages on a worker thread.  The messages are read
+ * from the file and prepared the same way as logfile::read_full_message()
+ * before the pattern is matched to extract the values.
+ */
+partial_result
+aggregate_chunk(const aggregate_plan& plan,
+                std::shared_ptr<const file_layout> layout,
+                auto_fd fd,
+                std::vector<chunk_message> msgs,
+                const std::atomic<bool>& cancelled)
+{
+    thread_local auto md = lnav::pcre2pp::match_data::unitialized();
+
+    accumulator acc(plan);
+    std::string buf;
+    file_off_t buf_offset = 0;
+    file_off_t span = msgs.back().cm_offset + msgs.back().cm_length
+        - msgs.front().cm_offset;
+    file_off_t total = 0;
+
+    for (const auto& msg : msgs) {
+        total += msg.cm_length;
+    }
+    // Read the whole range at once unless filtering left it sparse.
+    auto contiguous = span <= total * 2;
+    if (contiguous) {
+        buf_offset = msgs.front().cm_offset;
+        buf.resize(span);
+        if (!read_fully(fd, buf.data(), buf.size(), buf_offset)) {
+            acc.a_result.pr_error = "unable to read the log file";
+            return std::move(acc.a_result);
+        }
+    }
+
+    // The captures are converted by the same logline_value code that
+    // annotate() uses.
+    std::vector<logline_value> captured;
+    captured.reserve(plan.ap_columns.size());
+    for (const auto& col : plan.ap_columns) {
+        captured.emplace_back(logline_value_meta{col.c_name, col.c_kind},
+                              string_fragment{});
+    }
+
+    std::string msg_buf;
+    std::vector<pred_value> row;
+    for (size_t lpc = 0; lpc < msgs.size(); lpc++) {
+        const auto& msg = msgs[lpc];
+
+        if ((lpc % 1024) == 0 && cancelled.load(std::memory_order_relaxed)) {
+            break;
+        }
+
+        char* data;
+        size_t len = msg.cm_length;
+        if (contiguous) {
+            data = buf.data() + (msg.cm_offset - buf_offset);
+        } else {
+            msg_buf.resize(len);
+            data = msg_buf.data();
+            if (!read_fully(fd, data, len, msg.cm_offset)) {
+                acc.a_result.pr_error = "unable to read the log file";
+                break;
+            }
+        }
+        while (len > 0 && is_line_ending(data[len - 1])) {
+            len -= 1;
+        }
+        if (!(msg.cm_flags & MSG_VALID_UTF)) {
+            scrub_to_utf8(data, len);
+        }
+        if (msg.cm_flags & MSG_HAS_ANSI) {
+            len = erase_ansi_escapes(string_fragment::from_bytes(data, len));
+        }
+
+        row.assign(plan.ap_columns.size(), pred_value{});
+        if (msg.cm_pattern >= 0
+            && (size_t) msg.cm_pattern < layout->fl_patterns.size())
+        {
+            const auto& pat = *layout->fl_patterns[msg.cm_pattern];
+            const auto& captures = layout->fl_captures[msg.cm_pattern];
+            auto match_res
+                = pat.p_pcre.pp_value
+                      ->capture_from(string_fragment::from_bytes(data, len))
+                      .into(md)
+                      .matches(PCRE2_NO_UTF_CHECK)
+                      .ignore_error();
+
+            if (match_res) {
+                for (size_t col = 0; col < captures.size(); col++) {
+                    if (captures[col] < 0) {
+                        continue;
+                    }
+                    auto cap = md[captures[col]];
+                    if (cap) {
+                        captured[col].set_from_capture(cap.value());
+                        row[col] = to_value(captured[col]);
+                    }
+                }
+            }
+        }
+        for (size_t col = 0; col < plan.ap_columns.size(); col++) {
+            if (plan.ap_columns[col].c_is_level) {
+                row[col] = pred_value::from_text(level_names[msg.cm_level]);
+            }
+        }
+        acc.add_row(row);
+    }
+
+    return std::move(acc.a_result);
+}
+
+/**
+ * Drives an aggregation over the visible messages in the log view.  The
+ * messages of plain text files are handed out to worker threads in chunks
+ * while the messages of other files are aggregated on this thread.
+ */
+class aggregate_run {
+public:
+    explicit aggregate_run(const aggregate_plan& plan)
+        : ar_plan(plan), ar_serial(plan)
+    {
+    }
+
+    ~aggregate_run()
+    {
+        this->ar_cancelled = true;
+        this->ar_chunks.clear();
+    }
+
+    Result<partial_result, std::string> run(logfile_sub_source& lss)
+    {
+        auto total = vis_line_t(lss.text_line_count());
+
+        for (auto vl = 0_vl; vl < total; ++vl) {
+            if ((vl % 4096) == 0) {
+                TRY(this->check_progress(vl));
+            }
+
+            auto cl = lss.at(vl);
+            auto* lf = lss.find_file_ptr(cl);
+            auto ll = lf->begin() + cl;
+            const auto* format = lf->get_format_ptr();
+
+            if (ll->is_continued() || format == nullptr
+                || format->get_name() != this->ar_plan.ap_format_name)
+            {
+                continue;
+            }
+
+            auto& fs = this->ar_files[lf];
+            if (!fs.fs_init) {
+                fs.fs_init = true;
+                fs.fs_layout = layout_for(this->ar_plan, *lf);
+                log_debug("aggregate: %s is %s",
+                          lf->get_filename_as_string().c_str(),
+                          fs.fs_layout != nullptr
+                              ? "read by the workers"
+                              : "aggregated on the main thread");
+            }
+            if (fs.fs_layout == nullptr) {
+                this->add_serial(lf, ll, cl);
+                continue;
+            }
+
+            auto fr = lf->get_file_range(ll, true);
+            uint8_t flags = 0;
+            if (fr.fr_metadata.m_valid_utf) {
+                flags |= MSG_VALID_UTF;
+            }
+            if (fr.fr_metadata.m_has_ansi) {
+                flags |= MSG_HAS_ANSI;
+            }
+            fs.fs_pending.emplace_back(chunk_message{
+                fr.fr_offset,
+                std::min(fr.fr_size,
+                         (file_ssize_t) line_buffer::MAX_LINE_BUFFER_SIZE),
+                lf->get_format_file_state()
+                    .lffs_pattern_locks.pattern_index_for_line(cl),
+                flags,
+                (uint8_t) ll->get_msg_level(),
+            });
+            if (fs.fs_pending.size() >= CHUNK_MESSAGES) {
+                TRY(this->launch(lf, fs, vl));
+            }
+        }
+        for (auto& file : this->ar_files) {
+            if (!file.second.fs_pending.empty()) {
+                TRY(this->launch(file.first, file.second, total));
+            }
+        }
+        while (!this->ar_chunks.empty()) {
+            TRY(this->finish_front(total));
+        }
+
+        if (this->ar_serial.a_result.pr_error) {
+            return Err(this->ar_serial.a_result.pr_error.value());
+        }
+        return Ok(std::move(this->ar_serial.a_result));
+    }
+
+private:
+    struct file_state {
+        bool fs_init{false};
+        std::shared_ptr<const file_layout> fs_layout;
+        std::vector<chunk_message> fs_pending;
+    };
+
+    Result<void, std::string> check_progress(vis_line_t vl)
+    {
+        if (!log_vtab_data.lvd_looping) {
+            return Err(std::string("interrupted"));
+        }
+        if (log_vtab_data.lvd_progress != nullptr) {
+            log_cursor lc;
+
+            lc.lc_curr_line = vl;
+            if (log_vtab_data.lvd_progress(lc)) {
+                return Err(std::string("interrupted"));
+            }
+        }
+
+        return Ok();
+    }
+
+    void add_serial(logfile* lf,
+                    logfile::const_iterator ll,
+                    content_line_t line_number)
+    {
+        auto& values = this->ar_values;
+        const auto& plan = this->ar_plan;
+
+        values.clear();
+        this->ar_attrs.clear();
+        lf->read_full_message(ll, values.lvv_sbr);
+        values.lvv_sbr.erase_ansi();
+        lf->get_format()->annotate(
+            lf, (uint64_t) line_number, this->ar_attrs, values);
+
+        this->ar_row.assign(plan.ap_columns.size(), pred_value{});
+        for (size_t col = 0; col < plan.ap_columns.size(); col++) {
+            const auto& pc = plan.ap_columns[col];
+
+            if (pc.c_is_level) {
+                this->ar_row[col] = pred_value::from_text(ll->get_level_name());
+                continue;
+            }
+            for (const auto& lv : values.lvv_values) {
+                if (lv.lv_meta.lvm_name == pc.c_name) {
+                    this->ar_row[col] = to_value(lv);
+                    break;
+                }
+            }
+        }
+        this->ar_serial.add_row(this->ar_row);
+    }
+
+    Result<void, std::string> launch(logfile* lf,
+                                     file_state& fs,
+                                     vis_line_t vl)
+    {
+        static const auto MAX_CHUNKS
+            = std::max(1U, std::thread::hardware_concurrency());
+
+        while (this->ar_chunks.size() >= MAX_CHUNKS) {
+            TRY(this->finish_front(vl));
+        }
+
+        auto fd = auto_fd::dup_of(lf->get_fd());
+        if (fd == -1) {
+            return Err(fmt::format(FMT_STRING("unable to open file: {}"),
+                                   lf->get_filename_as_string()));
+        }
+        this->ar_chunks.emplace_back(std::async(std::launch::async,
+                                                aggregate_chunk,
+                                                std::cref(this->ar_plan),
+                                                fs.fs_layout,
+                                                std::move(fd),
+                                                std::move(fs.fs_pending),
+                                                std::cref(this->ar_cancelled)));
+        fs.fs_pending = {};
+        fs.fs_pending.reserve(CHUNK_MESSAGES);
+
+        return Ok();
+    }
+
+    Result<void, std::string> finish_front(vis_line_t vl)
+    {
+        auto& front = this->ar_chunks.front();
+
+        while (front.wait_for(std::chrono::milliseconds(100))
+               != std::future_status::ready)
+        {
+            TRY(this->check_progress(vl));
+        }
+
+        auto pr = front.get();
+        this->ar_chunks.pop_front();
+        if (pr.pr_error) {
+            return Err(pr.pr_error.value());
+        }
+        this->ar_serial.a_result.merge(this->ar_plan, pr);
+
+        return Ok();
+    }
+
+    const aggregate_plan& ar_plan;
+    accumulator ar_serial;
+    logline_value_vector ar_values;
+    string_attrs_t ar_attrs;
+    std::vector<pred_value> ar_row;
+    robin_hood::unordered_map<logfile*, file_state> ar_files;
+    std::atomic<bool> ar_cancelled{false};
+    std::deque<std::future<partial_result>> ar_chunks;
+};
+
+struct output_row {
+    std::string or_groups;
+    std::string or_results;
+};
+
+std::string
+gen_results(const aggregate_plan& plan, std::vector<agg_state>& aggs)
+{
+    yajlpp_gen gen;
+    {
+        yajlpp_map root(gen);
+
+        for (size_t lpc = 0; lpc < plan.ap_aggs.size(); lpc++) {
+            const auto& spec = plan.ap_aggs[lpc];
+            auto& state = aggs[lpc];
+
+            root.gen(spec.as_label);
+            if (spec.as_func == agg_func::count) {
+                root.gen(state.as_count);
+                continue;
+            }
+            if (state.as_count == 0) {
+                root.gen();
+                continue;
+            }
+            switch (spec.as_func) {
+                case agg_func::count:
+                    break;
+                case agg_func::sum:
+                    if (state.as_has_real) {
+                        root.gen(state.as_total);
+                    } else {
+                        root.gen(state.as_int_sum);
+                    }
+                    break;
+                case agg_func::avg:
+                    root.gen(state.as_total / state.as_count);
+                    break;
+                case agg_func::min:
+                case agg_func::max:
+                    state.as_extreme->gen(root.gen);
+                    break;
+                case agg_func::percentile:
+                    state.as_stats->lvs_tdigest.merge();
+                    root.gen(
+                        state.as_stats->lvs_tdigest.quantile(spec.as_percent));
+                    break;
+            }
+        }
+    }
+
+    return gen.to_string_fragment().to_string();
+}
+
+Result<std::vector<output_row>, std::string>
+finish_groups(const aggregate_plan& plan, partial_result& pr)
+{
+    std::vector<group_state*> groups;
+
+    // Like SQLite, an aggregate without a GROUP BY always has one row.
+    if (pr.pr_groups.empty() && plan.ap_group_by.empty()) {
+        group_state gs;
+
+        gs.gs_aggs.resize(plan.ap_aggs.size());
+        pr.pr_groups.emplace(std::string(), std::move(gs));
+    }
+
+    groups.reserve(pr.pr_groups.size());
+    for (auto& group : pr.pr_groups) {
+        groups.emplace_back(&group.second);
+    }
+    std::sort(groups.begin(),
+              groups.end(),
+              [](const group_state* lhs, const group_state* rhs) {
+                  for (size_t lpc = 0; lpc < lhs->gs_key.size(); lpc++) {
+                      auto rc = pred_value::compare(
+                          lhs->gs_key[lpc].to_value(),
+                          rhs->gs_key[lpc].to_value());
+                      if (rc != 0) {
+                          return rc < 0;
+                      }
+                  }
+                  return false;
+              });
+
+    std::vector<output_row> retval;
+    retval.reserve(groups.size());
+    for (auto* gs : groups) {
+        for (size_t lpc = 0; lpc < plan.ap_aggs.size(); lpc++) {
+            const auto& state = gs->gs_aggs[lpc];
+
+            if (plan.ap_aggs[lpc].as_func == agg_func::sum
+                && state.as_overflow && !state.as_has_real)
+            {
+                return Err(std::string("integer overflow"));
+            }
+        }
+
+        auto& row = retval.emplace_back();
+        yajlpp_gen gen;
+        {
+            yajlpp_map root(gen);
+
+            for (size_t lpc = 0; lpc < plan.ap_group_by.size(); lpc++) {
+                root.gen(plan.ap_columns[plan.ap_group_by[lpc]].c_name);
+                gs->gs_key[lpc].gen(root.gen);
+            }
+        }
+        row.or_groups = gen.to_string_fragment().to_string();
+        row.or_results = gen_results(plan, gs->gs_aggs);
+    }
+
+    return Ok(std::move(retval));
+}
+
+/**
+ * @feature f0:sql.tables.lnav_aggregate
+ */
+struct aggregate_table {
+    static constexpr const char* NAME = "lnav_aggregate";
+    static constexpr const char* CREATE_STMT = R"(
+-- The lnav_aggregate() table-valued function computes aggregates over the
+-- messages in a log table using multiple threads.
+CREATE TABLE lnav_db.lnav_aggregate (
+    groups TEXT,
+    results TEXT,
+    tbl TEXT HIDDEN,
+    group_by TEXT HIDDEN,
+    aggregates TEXT HIDDEN,
+    where_expr TEXT HIDDEN
+);
+)";
+
+    struct cursor {
+        sqlite3_vtab_cursor base;
+        std::string c_table;
+        std::string c_group_by;
+        std::string c_aggregates;
+        std::optional<std::string> c_where;
+        std::vector<output_row> c_rows;
+        size_t c_index{0};
+
+        explicit cursor(sqlite3_vtab* vt) : base({vt}) {}
+
+        int next()
+        {
+            if (this->c_index < this->c_rows.size()) {
+                this->c_index += 1;
+            }
+
+            return SQLITE_OK;
+        }
+
+        int reset() { return SQLITE_OK; }
+
+        int eof() { return this->c_index >= this->c_rows.size(); }
+
+        int get_rowid(sqlite3_int64& rowid_out)
+        {
+            rowid_out = this->c_index;
+
+            return SQLITE_OK;
+        }
+    };
+
+    int get_column(const cursor& vc, sqlite3_context* ctx, int col)
+    {
+        const auto& row = vc.c_rows[vc.c_index];
+
+        switch (col) {
+            case AGG_COL_GROUPS:
+                to_sqlite(ctx, row.or_groups);
+                sqlite3_result_subtype(ctx, JSON_SUBTYPE);
+                break;
+            case AGG_COL_RESULTS:
+                to_sqlite(ctx, row.or_results);
+                sqlite3_result_subtype(ctx, JSON_SUBTYPE);
+                break;
+            case AGG_COL_TBL:
+                to_sqlite(ctx, vc.c_table);
+                break;
+            case AGG_COL_GROUP_BY:
+                to_sqlite(ctx, vc.c_group_by);
+                break;
+            case AGG_COL_AGGREGATES:
+                to_sqlite(ctx, vc.c_aggregates);
+                break;
+            case AGG_COL_WHERE:
+                if (vc.c_where) {
+                    to_sqlite(ctx, vc.c_where.value());
+                } else {
+                    sqlite3_result_null(ctx);
+                }
+                break;
+        }
+
+        return SQLITE_OK;
+    }
+};
+
+int
+rcBestIndex(sqlite3_vtab* tab, sqlite3_index_info* pIdxInfo)
+{
+    vtab_index_constraints vic(pIdxInfo);
+    vtab_index_usage viu(pIdxInfo);
+
+    for (auto iter = vic.begin(); iter != vic.end(); ++iter) {
+        if (iter->op != SQLITE_INDEX_CONSTRAINT_EQ) {
+            continue;
+        }
+
+        switch (iter->iColumn) {
+            case AGG_COL_TBL:
+            case AGG_COL_GROUP_BY:
+            case AGG_COL_AGGREGATES:
+            case AGG_COL_WHERE:
+                viu.column_used(iter);
+                break;
+        }
+    }
+
+    viu.allocate_args(AGG_COL_TBL, AGG_COL_WHERE, 3);
+    return SQLITE_OK;
+}
+
+int
+rcFilter(sqlite3_vtab_cursor* pVtabCursor,
+         int idxNum,
+         const char* idxStr,
+         int argc,
+         sqlite3_value** argv)
+{
+    static auto& lss = injector::get<logfile_sub_source&>();
+
+    auto* pCur = (aggregate_table::cursor*) pVtabCursor;
+
+    pCur->c_rows.clear();
+    pCur->c_index = 0;
+    if (argc != 3 && argc != 4) {
+        return SQLITE_OK;
+    }
+
+    auto text_arg = [argv](int index) {
+        const auto* text = (const char*) sqlite3_value_text(argv[index]);
+
+        return text == nullptr ? std::string() : std::string(text);
+    };
+    pCur->c_table = text_arg(0);
+    pCur->c_group_by = text_arg(1);
+    pCur->c_aggregates = text_arg(2);
+    pCur->c_where = std::nullopt;
+    if (argc == 4 && sqlite3_value_type(argv[3]) != SQLITE_NULL) {
+        pCur->c_where = text_arg(3);
+    }
+
+    auto fail = [pVtabCursor, pCur](const std::string& reason) {
+        auto um = lnav::console::user_message::error(
+                      attr_line_t("unable to aggregate over table ")
+                          .append(lnav::roles::symbol(pCur->c_table)))
+                      .with_reason(reason)
+                      .move();
+
+        set_vtable_errmsg(pVtabCursor->pVtab, um);
+        return SQLITE_ERROR;
+    };
+
+    auto format = std::dynamic_pointer_cast<external_log_format>(
+        log_format::find_root_format(pCur->c_table.c_str()));
+    if (format == nullptr) {
+        return fail("the table is not a log format table");
+    }
+
+    std::optional<string_fragment> where;
+    if (pCur->c_where) {
+        where = string_fragment::from_str(pCur->c_where.value());
+    }
+    auto plan_res = compile_plan(*format,
+                                 string_fragment::from_str(pCur->c_group_by),
+                                 string_fragment::from_str(pCur->c_aggregates),
+                                 where);
+    if (plan_res.isErr()) {
+        return fail(plan_res.unwrapErr());
+    }
+
+    auto plan = plan_res.unwrap();
+    auto run_res = aggregate_run(plan).run(lss);
+    if (run_res.isErr()) {
+        return fail(run_res.unwrapErr());
+    }
+
+    auto pr = run_res.unwrap();
+    auto rows_res = finish_groups(plan, pr);
+    if (rows_res.isErr()) {
+        return fail(rows_res.unwrapErr());
+    }
+    pCur->c_rows = rows_res.unwrap();
+
+    return SQLITE_OK;
+}
+
+}  // namespace
+
+int
+register_log_aggregate_vtab(sqlite3* db)
+{
+    static vtab_module<tvt_no_update<aggregate_table>> AGGREGATE_MODULE;
+    static auto aggregate_help
+        = help_text("lnav_aggregate",
+                    "A table-valued function that computes aggregates over "
+                    "the messages in a log table.  The messages are split "
+                    "into chunks that are aggregated in parallel and then "
+                    "merged, which is faster than a GROUP BY query for "
+                    "large files.")
+              .sql_table_valued_function()
+              .with_parameter({"tbl", "The name of the log table."})
+              .with_parameter(
+                  {"group_by",
+                   "A comma-separated list of the columns to group by or an "
+                   "empty string to aggregate all of the messages."})
+              .with_parameter(
+                  {"aggregates",
+                   "A comma-separated list of the aggregates to compute, "
+                   "one of: count(*), count(col), sum(col), avg(col), "
+                   "min(col), max(col), or percentile(col, P).  An "
+                   "aggregate can be labeled with 'AS name'."})
+              .with_parameter(help_text{
+                  "where",
+                  "An expression used to select the messages to aggregate.  "
+                  "Columns are referenced as parameters, like :col."}
+                                  .optional())
+              .with_result({"groups",
+                            "A JSON object with the values of the group_by "
+                            "columns."})
+              .with_result({"results",
+                            "A JSON object with the value of each "
+                            "aggregate."});
+
+    int rc;
+
+    AGGREGATE_MODULE.vm_module.xBestIndex = rcBestIndex;
+    AGGREGATE_MODULE.vm_module.xFilter = rcFilter;
+
+    rc = AGGREGATE_MODULE.create(db, "lnav_aggregate");
+    sqlite_function_help.emplace("lnav_aggregate", &aggregate_help);
+    aggregate_help.index_tags();
+
+    ensure(rc == SQLITE_OK);
+
+    return rc;
+}
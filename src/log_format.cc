@@ -445,16 +445,36 @@ logline_value::logline_value(logline_value_meta lvm,
         case value_kind_t::VALUE_W3C_QUOTED:
         case value_kind_t::VALUE_TIMESTAMP:
             require(origin.lr_end != -1);
-            this->lv_frag = string_fragment::from_byte_range(
-                sbr.get_data(), origin.lr_start, origin.lr_end);
+            this->set_from_capture(string_fragment::from_byte_range(
+                sbr.get_data(), origin.lr_start, origin.lr_end));
             break;
 
         case value_kind_t::VALUE_NULL:
             break;
 
+        case value_kind_t::VALUE_INTEGER:
+        case value_kind_t::VALUE_FLOAT:
+        case value_kind_t::VALUE_BOOLEAN:
+            this->set_from_capture(string_fragment::from_bytes(
+                sbr.get_data_at(origin.lr_start), origin.length()));
+            break;
+
+        case value_kind_t::VALUE_UNKNOWN:
+        case value_kind_t::VALUE__MAX:
+            ensure(0);
+            break;
+    }
+}
+
+void
+logline_value::set_from_capture(string_fragment sf)
+{
+    switch (this->lv_meta.lvm_kind) {
+        case value_kind_t::VALUE_NULL:
+            break;
+
         case value_kind_t::VALUE_INTEGER: {
-            auto scan_res
-                = scn::scan_value<int64_t>(sbr.to_string_view(origin));
+            auto scan_res = scn::scan_value<int64_t>(sf.to_string_view());
             if (scan_res) {
                 this->lv_value.i = scan_res->value();
             } else {
@@ -464,7 +484,7 @@ logline_value::logline_value(logline_value_meta lvm,
         }
 
         case value_kind_t::VALUE_FLOAT: {
-            auto scan_res = scn::scan_value<double>(sbr.to_string_view(origin));
+            auto scan_res = scn::scan_value<double>(sf.to_string_view());
             if (scan_res) {
                 this->lv_value.d = scan_res->value();
             } else {
@@ -474,12 +494,8 @@ logline_value::logline_value(logline_value_meta lvm,
         }
 
         case value_kind_t::VALUE_BOOLEAN:
-            if (strncmp(
-                    sbr.get_data_at(origin.lr_start), "true", origin.length())
-                    == 0
-                || strncmp(
-                       sbr.get_data_at(origin.lr_start), "yes", origin.length())
-                    == 0)
+            if (strncmp(sf.data(), "true", sf.length()) == 0
+                || strncmp(sf.data(), "yes", sf.length()) == 0)
             {
                 this->lv_value.i = 1;
             } else {
@@ -487,9 +503,8 @@ logline_value::logline_value(logline_value_meta lvm,
             }
             break;
 
-        case value_kind_t::VALUE_UNKNOWN:
-        case value_kind_t::VALUE__MAX:
-            ensure(0);
+        default:
+            this->lv_frag = sf;
             break;
     }
 }
@@ -5354,6 +5369,18 @@ external_log_format::specialized(int fmt_lock)
     return retval;
 }
 
+std::shared_ptr<log_format>
+external_log_format::clone_for_scan() const
+{
+    // JSON formats keep the parser state in the format, so only the regex
+    // formats can be cloned.
+    if (this->elf_type != elf_type_t::ELF_TYPE_TEXT || !this->lf_specialized) {
+        return nullptr;
+    }
+
+    return std::make_shared<external_log_format>(*this);
+}
+
 log_format::match_name_result
 external_log_format::match_name(const std::string& filename)
 {
@@ -36,6 +36,7 @@
 #include <sys/time.h>
 #include <time.h>
 #define __STDC_FORMAT_MACROS
+#include <bitset>
 #include <limits>
 #include <memory>
 #include <set>
@@ -229,6 +230,18 @@ public:
 
     virtual std::shared_ptr<log_format> specialized(int fmt_lock = -1) = 0;
 
+    /**
+     * Create a copy of this specialized format that can be used to scan a
+     * range of lines on another thread.
+     *
+     * @return The copy or nullptr if the lines in a file can only be scanned
+     *   in order.
+     */
+    virtual std::shared_ptr<log_format> clone_for_scan() const
+    {
+        return nullptr;
+    }
+
     virtual std::shared_ptr<log_vtab_impl> get_vtab_impl() const
     {
         return nullptr;
@@ -241,6 +254,12 @@ public:
     {
     }
 
+    /**
+     * @return True if get_subline() leaves the content of a line as it is
+     * in the file, so the raw bytes can be searched instead.
+     */
+    virtual bool has_raw_sublines() const { return true; }
+
     virtual const std::vector<std::string>* get_actions(
         const logline_value& lv) const
     {
@@ -298,6 +317,16 @@ public:
         return {};
     }
 
+    /**
+     * @return False if messages in this format can never have a value with
+     *   the given name.  Formats that discover their fields while parsing
+     *   should always return true.
+     */
+    virtual bool may_have_value(const intern_string_t name) const
+    {
+        return true;
+    }
+
     virtual bool format_changed() { return false; }
 
     bool operator<(const log_format& rhs) const
@@ -343,6 +372,32 @@ public:
     bool lf_specialized{false};
     bool lf_level_hideable{true};
     std::optional<uint64_t> lf_max_unrecognized_lines;
+
+    /**
+     * A quick check of whether a line could be matched by this format.  It
+     * is built from the format's patterns when the formats are loaded and is
+     * used to skip calling scan() while detecting the format of a file.
+     */
+    struct line_prefilter {
+        std::bitset<256> lp_first_bytes{std::bitset<256>().set()};
+        size_t lp_min_length{0};
+
+        bool might_match(string_fragment line) const
+        {
+            if (static_cast<size_t>(line.length()) < this->lp_min_length) {
+                return false;
+            }
+            if (line.empty()) {
+                return true;
+            }
+
+            return this->lp_first_bytes.test(
+                static_cast<unsigned char>(line.front()));
+        }
+    };
+
+    line_prefilter lf_line_prefilter;
+
     std::map<const intern_string_t, std::shared_ptr<format_tag_def>>
         lf_tag_defs;
 
@@ -189,6 +189,13 @@ public:
 
     std::shared_ptr<log_format> specialized(int fmt_lock) override;
 
+    std::shared_ptr<log_format> clone_for_scan() const override;
+
+    bool has_raw_sublines() const override
+    {
+        return this->elf_type == elf_type_t::ELF_TYPE_TEXT;
+    }
+
     std::optional<size_t> stats_index_for_value(
         const intern_string_t& name) const override;
 
@@ -300,6 +307,14 @@ public:
         return iter != this->elf_value_defs.end();
     }
 
+    bool may_have_value(const intern_string_t name) const override
+    {
+        // The values for text formats only come from the captures in the
+        // patterns, structured formats can have arbitrary fields.
+        return this->elf_type != elf_type_t::ELF_TYPE_TEXT
+            || this->has_value_def(name);
+    }
+
     std::string get_pattern_path(const pattern_locks& pl,
                                  uint64_t line_number) const override
     {
@@ -661,6 +661,13 @@ public:
                   shared_buffer_ref& sbr,
                   line_range origin);
 
+    /**
+     * Set the value from the text that a pattern captured for it.  The text
+     * is converted based on the kind of the value and text values refer to
+     * the given fragment.
+     */
+    void set_from_capture(string_fragment sf);
+
     void apply_scaling(const scaling_factor* sf);
 
     std::string to_string() const;
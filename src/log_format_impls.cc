@@ -91,6 +91,8 @@ public:
         log_format::annotate(lf, line_number, sa, values);
     }
 
+    bool has_raw_sublines() const override { return false; }
+
     void get_subline(const log_format_file_state& lffs,
                      const logline& ll,
                      shared_buffer_ref& sbr,
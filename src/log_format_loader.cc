@@ -1496,6 +1496,58 @@ load_from_path(const std::filesystem::path& path,
     }
 }
 
+/**
+ * Build the prefilter used to skip scanning lines that could not match any
+ * of the format's patterns while detecting the format of a file.
+ */
+static void
+build_line_prefilter(external_log_format& elf)
+{
+    auto& lp = elf.lf_line_prefilter;
+
+    lp = {};
+    switch (elf.elf_type) {
+        case external_log_format::elf_type_t::ELF_TYPE_JSON:
+            // An unspecialized JSON format only matches objects.
+            lp.lp_first_bytes.reset();
+            lp.lp_first_bytes.set('{');
+            lp.lp_min_length = 1;
+            break;
+        case external_log_format::elf_type_t::ELF_TYPE_TEXT:
+        case external_log_format::elf_type_t::ELF_TYPE_CSV: {
+            if (elf.elf_pattern_order.empty()) {
+                return;
+            }
+
+            std::bitset<256> first_bytes;
+            std::optional<size_t> min_length;
+            for (const auto& pat : elf.elf_pattern_order) {
+                if (pat->p_pcre.pp_value == nullptr) {
+                    return;
+                }
+
+                auto si = pat->p_pcre.pp_value->get_start_info();
+                if (si.si_anchored && si.si_first_bytes) {
+                    first_bytes |= si.si_first_bytes.value();
+                } else {
+                    first_bytes.set();
+                }
+                if (!min_length || si.si_min_length < min_length.value()) {
+                    min_length = si.si_min_length;
+                }
+            }
+            lp.lp_first_bytes = first_bytes;
+            lp.lp_min_length = min_length.value_or(0);
+            break;
+        }
+    }
+
+    log_debug("%s: line prefilter accepts %zu first bytes, min length %zu",
+              elf.get_name().get(),
+              lp.lp_first_bytes.count(),
+              lp.lp_min_length);
+}
+
 void
 load_formats(const std::vector<std::filesystem::path>& extra_paths,
              std::vector<lnav::console::user_message>& errors)
@@ -1535,6 +1587,7 @@ load_formats(const std::vector<std::filesystem::path>& extra_paths,
     for (auto iter = LOG_FORMATS.begin(); iter != LOG_FORMATS.end(); ++iter) {
         auto& elf = iter->second;
         elf->build(errors);
+        build_line_prefilter(*elf);
 
         for (auto& check_iter : LOG_FORMATS) {
             if (iter->first == check_iter.first) {
@@ -47,6 +47,7 @@ static auto match_rowid_name = intern_string::lookup("match_rowid");
 log_search_table::log_search_table(std::shared_ptr<lnav::pcre2pp::code> code,
                                    intern_string_t table_name)
     : log_vtab_impl(table_name), lst_regex(code),
+      lst_literals(this->lst_regex->get_required_literals()),
       lst_match_data(this->lst_regex->create_match_data())
 {
 }
@@ -200,6 +201,18 @@ log_search_table::next(log_cursor& lc, logfile_sub_source& lss)
         return false;
     }
 
+    // Consult the search index before reading the message.
+    auto msg_end = std::next(lf_iter);
+    while (msg_end != lf->end() && !msg_end->is_message()) {
+        ++msg_end;
+    }
+    if (!lf->lines_may_contain(
+            cl, std::distance(lf->begin(), msg_end), this->lst_literals))
+    {
+        this->lst_mismatch_bitmap.set_bit(lc.lc_curr_line);
+        return false;
+    }
+
     // log_debug("%d: doing message", (int) lc.lc_curr_line);
     auto& sbr = this->lst_line_values_cache.lvv_sbr;
     lf->read_full_message(lf_iter, sbr);
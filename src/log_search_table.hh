@@ -76,6 +76,7 @@ public:
     bool matches(logline_value_vector& values) override;
 
     std::shared_ptr<lnav::pcre2pp::code> lst_regex;
+    std::vector<std::string> lst_literals;
     lnav::pcre2pp::match_data lst_match_data;
     string_fragment lst_content;
     string_fragment lst_remaining;
@@ -575,6 +575,10 @@ populate_indexed_columns(vtab_cursor* vc, log_vtab* vt)
             vc->cache_msg(lf, ll);
             require(vc->line_values.lvv_sbr.get_data() != nullptr);
             vt->vi->extract(lf, line_number, vc->attrs, vc->line_values);
+            if (vt->vi->extracts_format_values()) {
+                lf->get_column_cache().record(line_number,
+                                              vc->line_values.lvv_values);
+            }
         }
 
         auto sub_col = logline_value_meta::table_column{
@@ -611,6 +615,134 @@ populate_indexed_columns(vtab_cursor* vc, log_vtab* vt)
     }
 }
 
+/**
+ * Find the lines to visit for the cursor's constrained columns using the
+ * column indexes of the files.  The indexes are keyed by the line number
+ * in the file, so they are not affected by changes to the lines in the
+ * view, like when a filter is toggled.
+ *
+ * @return False if one of the files cannot be indexed and the whole range
+ * needs to be scanned.
+ */
+static bool
+find_lines_from_file_indexes(vtab_cursor* vc, log_vtab* vt)
+{
+    auto& lc = vc->log_cursor;
+    auto scan_range
+        = msg_range::empty()
+              .expand_to(lc.lc_curr_line)
+              .expand_to(lc.lc_end_line
+                         - (lc.lc_direction > 0 ? 1_vl : -1_vl))
+              .get_valid()
+              .value();
+    std::vector<vis_line_t> lines;
+
+    for (auto iter = vt->lss->begin(); iter != vt->lss->end(); ++iter) {
+        auto* lf = (*iter)->get_file_ptr();
+
+        if (lf == nullptr || lf->get_format_name() != vt->vi->get_name()) {
+            continue;
+        }
+
+        // SQLite checks the other constraints, so only the lines for the
+        // most selective one need to be visited.
+        const std::vector<uint32_t>* file_lines = nullptr;
+        for (const auto& icol : lc.lc_indexed_columns) {
+            const auto* ci = lf->get_column_index(
+                logline_value_meta::table_column{
+                    (size_t) (icol.cc_column - VT_COL_MAX)});
+            if (ci == nullptr) {
+                return false;
+            }
+
+            static const std::vector<uint32_t> NO_LINES;
+            const auto* col_lines = &NO_LINES;
+            auto value_iter
+                = ci->ci_value_to_lines.find(icol.cc_constraint.sc_value);
+            if (value_iter != ci->ci_value_to_lines.end()) {
+                col_lines = &value_iter->second;
+            }
+            if (file_lines == nullptr || col_lines->size() < file_lines->size())
+            {
+                file_lines = col_lines;
+            }
+        }
+
+        auto base_cl = vt->lss->get_file_base_content_line(iter);
+        for (auto line : *file_lines) {
+            auto vl_opt
+                = vt->lss->find_from_content(content_line_t(base_cl + line));
+
+            if (vl_opt && scan_range.contains(vl_opt.value())) {
+                lines.push_back(vl_opt.value());
+            }
+        }
+    }
+
+    log_info("found %zu lines using the column indexes of the files",
+             lines.size());
+    lc.lc_indexed_lines = std::move(lines);
+    lc.lc_indexed_lines_range = msg_range::empty()
+                                    .expand_to(scan_range.v_min_line)
+                                    .expand_to(scan_range.v_max_line - 1_vl);
+    // vt_next() starts one line before the scan range, so the first line
+    // also comes from the index.
+    lc.lc_indexed_lines_range.expand_to(lc.lc_curr_line - lc.lc_direction);
+    if (lc.lc_direction < 0) {
+        lc.lc_indexed_lines.push_back(scan_range.v_min_line - 1_vl);
+        std::sort(lc.lc_indexed_lines.begin(),
+                  lc.lc_indexed_lines.end(),
+                  std::less<>());
+    } else {
+        lc.lc_indexed_lines.push_back(scan_range.v_max_line);
+        std::sort(lc.lc_indexed_lines.begin(),
+                  lc.lc_indexed_lines.end(),
+                  std::greater<>());
+    }
+
+    return true;
+}
+
+/**
+ * Count the row the cursor is about to move to against the LIMIT that was
+ * pushed down by vt_best_index().
+ *
+ * @return true if the limit was reached and the cursor was moved to EOF.
+ */
+static bool
+consume_row_limit(vtab_cursor* vc)
+{
+    auto& remaining = vc->log_cursor.lc_rows_remaining;
+
+    if (!remaining) {
+        return false;
+    }
+    if (remaining.value() <= 0) {
+        vc->log_cursor.set_eof();
+        return true;
+    }
+    remaining.value() -= 1;
+    return false;
+}
+
+/**
+ * Move the cursor to the next line to check.  If the cursor is within the
+ * range covered by an index, that is the next line from the index.
+ */
+static void
+advance_line(log_cursor& lc)
+{
+    if (!lc.lc_indexed_lines.empty()
+        && lc.lc_indexed_lines_range.contains(lc.lc_curr_line))
+    {
+        lc.lc_curr_line = lc.lc_indexed_lines.back();
+        lc.lc_indexed_lines.pop_back();
+    } else {
+        lc.lc_curr_line += lc.lc_direction;
+    }
+    lc.lc_sub_index = 0;
+}
+
 static int
 vt_next(sqlite3_vtab_cursor* cur)
 {
@@ -626,16 +758,10 @@ vt_next(sqlite3_vtab_cursor* cur)
 #endif
 
     vc->invalidate();
-    if (!vc->log_cursor.lc_indexed_lines.empty()
-        && vc->log_cursor.lc_indexed_lines_range.contains(
-            vc->log_cursor.lc_curr_line))
-    {
-        vc->log_cursor.lc_curr_line = vc->log_cursor.lc_indexed_lines.back();
-        vc->log_cursor.lc_indexed_lines.pop_back();
-    } else {
-        vc->log_cursor.lc_curr_line += vc->log_cursor.lc_direction;
+    if (consume_row_limit(vc)) {
+        return SQLITE_OK;
     }
-    vc->log_cursor.lc_sub_index = 0;
+    advance_line(vc->log_cursor);
     do {
         log_cursor_latest = vc->log_cursor;
         if (((log_cursor_latest.lc_curr_line % 1024) == 0)
@@ -648,8 +774,7 @@ vt_next(sqlite3_vtab_cursor* cur)
         while (vc->log_cursor.lc_curr_line != -1_vl && !vc->log_cursor.is_eof()
                && !vt->vi->is_valid(vc->log_cursor, *vt->lss))
         {
-            vc->log_cursor.lc_curr_line += vc->log_cursor.lc_direction;
-            vc->log_cursor.lc_sub_index = 0;
+            advance_line(vc->log_cursor);
         }
         if (vc->log_cursor.is_eof()) {
             log_info("vt_next at EOF (%d:%d:%d), scanned rows %lu",
@@ -672,17 +797,7 @@ vt_next(sqlite3_vtab_cursor* cur)
                 vt->vi->expand_indexes_to(vc->log_cursor.lc_indexed_columns,
                                           vc->log_cursor.lc_curr_line);
             } else {
-                if (!vc->log_cursor.lc_indexed_lines.empty()
-                    && vc->log_cursor.lc_indexed_lines_range.contains(
-                        vc->log_cursor.lc_curr_line))
-                {
-                    vc->log_cursor.lc_curr_line
-                        = vc->log_cursor.lc_indexed_lines.back();
-                    vc->log_cursor.lc_indexed_lines.pop_back();
-                } else {
-                    vc->log_cursor.lc_curr_line += vc->log_cursor.lc_direction;
-                }
-                vc->log_cursor.lc_sub_index = 0;
+                advance_line(vc->log_cursor);
             }
         }
     } while (!done);
@@ -705,6 +820,9 @@ vt_next_no_rowid(sqlite3_vtab_cursor* cur)
     auto done = false;
 
     vc->invalidate();
+    if (consume_row_limit(vc)) {
+        return SQLITE_OK;
+    }
     do {
         log_cursor_latest = vc->log_cursor;
         if (((log_cursor_latest.lc_curr_line % 1024) == 0)
@@ -983,13 +1101,26 @@ vt_column(sqlite3_vtab_cursor* cur, sqlite3_context* ctx, int col)
                         break;
                     }
                     case log_footer_columns::filters: {
-                        const auto& filter_mask
-                            = (*ld)->ld_filter_state.lfo_filter_state.tfs_mask;
+                        const auto& lfs
+                            = (*ld)->ld_filter_state.lfo_filter_state;
+                        const auto& filters = vt->lss->get_filters();
+                        std::vector<size_t> matched;
+
+                        for (const auto& filter : filters) {
+                            if (filter->lf_deleted) {
+                                continue;
+                            }
+
+                            if (lfs.is_matched(filter->get_index(),
+                                               line_number))
+                            {
+                                matched.emplace_back(filter->get_index());
+                            }
+                        }
 
-                        if (!filter_mask[line_number]) {
+                        if (matched.empty()) {
                             sqlite3_result_null(ctx);
                         } else {
-                            const auto& filters = vt->lss->get_filters();
                             yajlpp_gen gen;
 
                             yajl_gen_config(gen, yajl_gen_beautify, false);
@@ -997,17 +1128,8 @@ vt_column(sqlite3_vtab_cursor* cur, sqlite3_context* ctx, int col)
                             {
                                 yajlpp_array arr(gen);
 
-                                for (const auto& filter : filters) {
-                                    if (filter->lf_deleted) {
-                                        continue;
-                                    }
-
-                                    uint32_t mask
-                                        = (1UL << filter->get_index());
-
-                                    if (filter_mask[line_number] & mask) {
-                                        arr.gen(filter->get_index());
-                                    }
+                                for (auto index : matched) {
+                                    arr.gen(index);
                                 }
                             }
 
@@ -1268,15 +1390,52 @@ vt_column(sqlite3_vtab_cursor* cur, sqlite3_context* ctx, int col)
                     }
                 }
             } else {
+                auto sub_col = logline_value_meta::table_column{
+                    (size_t) (col - VT_COL_MAX)};
+
                 if (vc->line_values.lvv_values.empty()) {
+                    if (vt->vi->extracts_format_values()) {
+                        using cell_kind = lnav::column_cache::cell_kind;
+
+                        auto cv_opt = lf->get_column_cache().lookup(
+                            line_number, sub_col);
+                        if (cv_opt && cv_opt->cv_kind != cell_kind::uncached) {
+                            switch (cv_opt->cv_kind) {
+                                case cell_kind::boolean:
+                                case cell_kind::integer:
+                                    sqlite3_result_int64(
+                                        ctx, cv_opt->cv_value.cv_int);
+                                    break;
+                                case cell_kind::real:
+                                    sqlite3_result_double(
+                                        ctx, cv_opt->cv_value.cv_real);
+                                    break;
+                                case cell_kind::text: {
+                                    auto text = cv_opt->get_text();
+                                    sqlite3_result_text(ctx,
+                                                        text.get(),
+                                                        text.size(),
+                                                        SQLITE_STATIC);
+                                    break;
+                                }
+                                default:
+                                    sqlite3_result_null(ctx);
+                                    break;
+                            }
+                            return SQLITE_OK;
+                        }
+                    }
+
                     vc->cache_msg(lf, ll);
                     require(vc->line_values.lvv_sbr.get_data() != nullptr);
                     vt->vi->extract(
                         lf, line_number, vc->attrs, vc->line_values);
+                    if (vt->vi->extracts_format_values()) {
+                        lf->get_column_cache().record(
+                            line_number, vc->line_values.lvv_values);
+                    }
                 }
 
-                auto sub_col = logline_value_meta::table_column{
-                    (size_t) (col - VT_COL_MAX)};
                 auto lv_iter = find_if(vc->line_values.lvv_values.begin(),
                                        vc->line_values.lvv_values.end(),
                                        logline_value_col_eq(sub_col));
@@ -1495,6 +1654,13 @@ vt_rowid(sqlite3_vtab_cursor* cur, sqlite_int64* p_rowid)
 void
 log_cursor::update(unsigned char op, vis_line_t vl, constraint_t cons)
 {
+    if (this->lc_direction < 0) {
+        this->flip_direction();
+        this->update(op, vl, cons);
+        this->flip_direction();
+        return;
+    }
+
     switch (op) {
         case SQLITE_INDEX_CONSTRAINT_EQ:
             if (vl < 0_vl) {
@@ -1531,14 +1697,8 @@ log_cursor::update(unsigned char op, vis_line_t vl, constraint_t cons)
         case SQLITE_INDEX_CONSTRAINT_LT:
             if (vl <= 0_vl) {
                 this->lc_curr_line = this->lc_end_line;
-            } else if (this->lc_direction > 0) {
-                if (vl < this->lc_end_line) {
-                    this->lc_end_line = vl;
-                }
-            } else if (this->lc_direction < 0) {
-                if (vl <= this->lc_curr_line) {
-                    this->lc_curr_line = vl - 1_vl;
-                }
+            } else if (vl < this->lc_end_line) {
+                this->lc_end_line = vl;
             }
             break;
     }
@@ -1683,6 +1843,8 @@ vt_filter(sqlite3_vtab_cursor* p_vtc,
         p_cur->log_cursor.lc_end_line = vis_line_t(vt->lss->text_line_count());
     }
     p_cur->log_cursor.lc_scanned_rows = 0;
+    p_cur->log_cursor.lc_rows_remaining = std::nullopt;
+    p_cur->log_cursor.lc_indexed_columns.clear();
     p_cur->log_cursor.lc_indexed_lines.clear();
     p_cur->log_cursor.lc_indexed_lines_range = msg_range::empty();
 
@@ -1691,10 +1853,25 @@ vt_filter(sqlite3_vtab_cursor* p_vtc,
     std::optional<uint64_t> tid_val;
     std::vector<log_cursor::string_constraint> log_path_constraints;
     std::vector<log_cursor::string_constraint> log_unique_path_constraints;
+    int64_t row_offset = 0;
 
     for (int lpc = 0; lpc < idxNum; lpc++) {
         auto col = index[lpc].iColumn;
         auto op = index[lpc].op;
+#ifdef SQLITE_INDEX_CONSTRAINT_OFFSET
+        if (op == SQLITE_INDEX_CONSTRAINT_LIMIT) {
+            auto limit = sqlite3_value_int64(argv[lpc]);
+            if (limit >= 0) {
+                p_cur->log_cursor.lc_rows_remaining = limit;
+            }
+            continue;
+        }
+        if (op == SQLITE_INDEX_CONSTRAINT_OFFSET) {
+            row_offset = std::max(
+                int64_t{sqlite3_value_int64(argv[lpc])}, int64_t{0});
+            continue;
+        }
+#endif
         switch (col) {
             case VT_COL_LINE_NUMBER: {
                 auto vl = vis_line_t(sqlite3_value_int64(argv[lpc]));
@@ -2025,6 +2202,15 @@ vt_filter(sqlite3_vtab_cursor* p_vtc,
     }
 
     if (p_cur->log_cursor.lc_curr_line == p_cur->log_cursor.lc_end_line) {
+    } else if (!p_cur->log_cursor.lc_indexed_columns.empty()
+               && vt->vi->extracts_format_values())
+    {
+        if (!find_lines_from_file_indexes(p_cur, vt)) {
+            log_info("column indexes are not available, scanning instead");
+        }
+        // The lines come from the files, so the scan does not need to
+        // index anything.
+        p_cur->log_cursor.lc_indexed_columns.clear();
     } else if (!p_cur->log_cursor.lc_indexed_columns.empty()) {
         auto min_index_range = msg_range::invalid();
         auto scan_range
@@ -2173,6 +2359,13 @@ vt_filter(sqlite3_vtab_cursor* p_vtc,
                 p_cur->log_cursor.lc_indexed_lines.push_back(
                     index_valid_opt->v_max_line);
             }
+            if (vt->base.pModule->xNext != vt_next_no_rowid) {
+                // vt_next() starts one line before the scan range, so the
+                // first line also comes from the index.
+                p_cur->log_cursor.lc_indexed_lines_range.expand_to(
+                    p_cur->log_cursor.lc_curr_line
+                    - p_cur->log_cursor.lc_direction);
+            }
         }
 
         if (p_cur->log_cursor.lc_direction < 0) {
@@ -2194,6 +2387,12 @@ vt_filter(sqlite3_vtab_cursor* p_vtc,
 #endif
     }
 
+    // The time range is found in ascending order.
+    auto flipped = false;
+    if (log_time_range && p_cur->log_cursor.lc_direction < 0) {
+        p_cur->log_cursor.flip_direction();
+        flipped = true;
+    }
     if (!log_time_range) {
     } else if (log_time_range->empty()) {
 #ifdef DEBUG_INDEXING
@@ -2239,6 +2438,9 @@ vt_filter(sqlite3_vtab_cursor* p_vtc,
             }
         }
     }
+    if (flipped) {
+        p_cur->log_cursor.flip_direction();
+    }
 
     p_cur->log_cursor.lc_opid_bloom_bits = opid_val;
     p_cur->log_cursor.lc_tid_bloom_bits = tid_val;
@@ -2262,7 +2464,21 @@ vt_filter(sqlite3_vtab_cursor* p_vtc,
     if (vt->base.pModule->xNext != vt_next_no_rowid) {
         p_cur->log_cursor.lc_curr_line -= p_cur->log_cursor.lc_direction;
     }
-    vt->base.pModule->xNext(p_vtc);
+    auto at_eof = false;
+    if (row_offset > 0) {
+        // Skip the OFFSET rows here so they are not counted against the
+        // LIMIT and SQLite does not have to step over them.
+        auto limit = std::exchange(p_cur->log_cursor.lc_rows_remaining,
+                                   std::nullopt);
+        for (int64_t lpc = 0; lpc < row_offset && !at_eof; lpc++) {
+            vt->base.pModule->xNext(p_vtc);
+            at_eof = p_cur->log_cursor.is_eof();
+        }
+        p_cur->log_cursor.lc_rows_remaining = limit;
+    }
+    if (!at_eof) {
+        vt->base.pModule->xNext(p_vtc);
+    }
 
 #ifdef DEBUG_INDEXING
     log_debug("vt_filter() -> cursor_range(%d:%d:%d)",
@@ -2296,12 +2512,29 @@ vt_best_index(sqlite3_vtab* tab, sqlite3_index_info* p_info)
                      orderby_info.desc ? "DESC" : "ASC");
         }
 
-        if (p_info->aOrderBy[0].iColumn == 0) {
-            if (p_info->aOrderBy[0].desc) {
-                log_info("  consuming ORDER BY log_line DESC");
+        // The log messages are sorted by time and line number, so the
+        // cursor can return them in either order by log_line or log_time.
+        // The log_time is not unique, so it can only be followed by an
+        // ORDER BY log_line in the same direction.
+        const auto& first_order = p_info->aOrderBy[0];
+        auto consumable = false;
+        if (first_order.iColumn == VT_COL_LINE_NUMBER) {
+            consumable = true;
+        } else if (first_order.iColumn == VT_COL_LOG_TIME) {
+            consumable = p_info->nOrderBy == 1
+                || (p_info->nOrderBy == 2
+                    && p_info->aOrderBy[1].iColumn == VT_COL_LINE_NUMBER
+                    && p_info->aOrderBy[1].desc == first_order.desc);
+        }
+        if (consumable) {
+            auto* col_name = first_order.iColumn == VT_COL_LINE_NUMBER
+                ? "log_line"
+                : "log_time";
+            if (first_order.desc) {
+                log_info("  consuming ORDER BY %s DESC", col_name);
                 direction = -1;
             } else {
-                log_info("  consuming ORDER BY log_line ASC");
+                log_info("  consuming ORDER BY %s ASC", col_name);
                 direction = 1;
             }
             p_info->orderByConsumed = 1;
@@ -2311,8 +2544,42 @@ vt_best_index(sqlite3_vtab* tab, sqlite3_index_info* p_info)
         p_info->orderByConsumed = 0;
         return SQLITE_OK;
     }
+
+    // A LIMIT can only be applied by the cursor when it returns exactly
+    // the rows of the result in the right order.  The other constraints
+    // are only used to narrow the scan and are checked again by SQLite,
+    // so the LIMIT is not used if there are any.
+    auto limit_usable = p_info->nOrderBy == 0 || p_info->orderByConsumed;
+    for (int lpc = 0; lpc < p_info->nConstraint && limit_usable; lpc++) {
+        const auto& constraint = p_info->aConstraint[lpc];
+#ifdef SQLITE_INDEX_CONSTRAINT_OFFSET
+        if (constraint.op == SQLITE_INDEX_CONSTRAINT_OFFSET
+            || constraint.op == SQLITE_INDEX_CONSTRAINT_LIMIT)
+        {
+            limit_usable = constraint.usable;
+            continue;
+        }
+#endif
+        limit_usable = false;
+    }
     for (int lpc = 0; lpc < p_info->nConstraint; lpc++) {
         const auto& constraint = p_info->aConstraint[lpc];
+#ifdef SQLITE_INDEX_CONSTRAINT_OFFSET
+        if (limit_usable
+            && (constraint.op == SQLITE_INDEX_CONSTRAINT_LIMIT
+                || constraint.op == SQLITE_INDEX_CONSTRAINT_OFFSET))
+        {
+            auto is_limit = constraint.op == SQLITE_INDEX_CONSTRAINT_LIMIT;
+
+            argvInUse += 1;
+            indexes.push_back(constraint);
+            p_info->aConstraintUsage[lpc].argvIndex = argvInUse;
+            // The cursor skips the OFFSET rows itself.
+            p_info->aConstraintUsage[lpc].omit = !is_limit;
+            index_desc.emplace_back(is_limit ? "LIMIT ?" : "OFFSET ?");
+            continue;
+        }
+#endif
         if (!constraint.usable || constraint.op == SQLITE_INDEX_CONSTRAINT_MATCH
 #ifdef SQLITE_INDEX_CONSTRAINT_OFFSET
             || constraint.op == SQLITE_INDEX_CONSTRAINT_OFFSET
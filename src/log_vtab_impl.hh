@@ -239,6 +239,11 @@ struct log_cursor {
     msg_range lc_indexed_lines_range = msg_range::empty();
 
     size_t lc_scanned_rows{0};
+    /**
+     * The number of rows that can still be returned if a LIMIT was pushed
+     * down to the cursor.
+     */
+    std::optional<int64_t> lc_rows_remaining;
 
     enum class constraint_t {
         none,
@@ -247,7 +252,25 @@ struct log_cursor {
 
     void update(unsigned char op, vis_line_t vl, constraint_t cons);
 
-    void set_eof() { this->lc_curr_line = this->lc_end_line = 0_vl; }
+    void set_eof()
+    {
+        this->lc_curr_line = this->lc_end_line = 0_vl;
+        this->lc_indexed_lines.clear();
+    }
+
+    /**
+     * Reverse the direction of the cursor while keeping the same range of
+     * lines.  The constraints are applied to an ascending range, so a
+     * descending cursor is flipped before and after they are applied.
+     */
+    void flip_direction()
+    {
+        auto curr = this->lc_curr_line;
+
+        this->lc_curr_line = this->lc_end_line - this->lc_direction;
+        this->lc_end_line = curr - this->lc_direction;
+        this->lc_direction = 0_vl - this->lc_direction;
+    }
 
     bool is_eof() const
     {
@@ -340,6 +363,13 @@ public:
 
     virtual bool matches(logline_value_vector& values) { return false; }
 
+    /**
+     * @return True if the data columns of this table are the values
+     * extracted by the log format, which allows them to be read from the
+     * column cache of the file.
+     */
+    virtual bool extracts_format_values() const { return false; }
+
     struct column_index {
         robin_hood::
             unordered_map<string_fragment, std::deque<vis_line_t>, frag_hasher>
@@ -378,6 +408,8 @@ public:
 
     virtual bool next(log_cursor& lc, logfile_sub_source& lss);
 
+    bool extracts_format_values() const override { return true; }
+
 protected:
     std::shared_ptr<const log_format> lfvi_format;
 };
@@ -29,10 +29,13 @@
  * @file logfile.cc
  */
 
+#include <atomic>
 #include <chrono>
 #include <filesystem>
+#include <future>
 #include <memory>
 #include <optional>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -45,6 +48,7 @@
 #include <sys/resource.h>
 #include <sys/stat.h>
 #include <time.h>
+#include <unistd.h>
 
 #include "base/ansi_scrubber.hh"
 #include "base/attr_line.builder.hh"
@@ -65,6 +69,7 @@
 #include "log.watch.hh"
 #include "log_format.hh"
 #include "logfile.cfg.hh"
+#include "logfile.index_cache.hh"
 #include "piper.header.hh"
 #include "shared_buffer.hh"
 #include "text_format.hh"
@@ -92,6 +97,25 @@ get_file_header_handlers()
     return retval;
 }
 
+/**
+ * @return True if the path looks like a log that was rotated out of the way,
+ * like "syslog.1", and is not going to be written to anymore.
+ */
+static bool
+is_rotated_path(const std::filesystem::path& path)
+{
+    // Only short suffixes are taken as rotation numbers since names like
+    // "app.2024" or "server.8080" are often live files.
+    static constexpr size_t MAX_ROTATION_DIGITS = 3;
+
+    const auto ext = path.extension().string();
+
+    return ext.size() > 1 && ext.size() <= MAX_ROTATION_DIGITS + 1
+        && std::all_of(ext.begin() + 1, ext.end(), [](char ch) {
+               return isdigit(static_cast<unsigned char>(ch));
+           });
+}
+
 Result<std::shared_ptr<logfile>, std::string>
 logfile::open(std::filesystem::path filename,
               const logfile_open_options& loo,
@@ -159,6 +183,12 @@ logfile::open(std::filesystem::path filename,
     }
 
     lf->lf_line_buffer.set_fd(lf_fd);
+    if (lf->lf_options.loo_source == logfile_name_source::ARCHIVE
+        || (lf->lf_actual_path && !lf->lf_line_buffer.is_piper()
+            && is_rotated_path(lf->lf_actual_path.value())))
+    {
+        lf->lf_line_buffer.set_immutable(true);
+    }
     lf->lf_index.reserve(INDEX_RESERVE_INCREMENT);
 
     lf->lf_indexing = lf->lf_options.loo_is_visible;
@@ -258,6 +288,7 @@ logfile::~logfile()
     log_info("destructing logfile(%p): %s",
              this,
              this->lf_filename_as_string.c_str());
+    this->reset_search_index();
 }
 
 bool
@@ -321,6 +352,8 @@ logfile::reset_internal_state_for_reindex()
     this->lf_index_size = 0;
     this->lf_level_stats = {};
     this->lf_partial_line = false;
+    this->lf_watch_checked_offset = -1;
+    this->lf_watch_partial_range = std::nullopt;
     this->lf_longest_line = 0;
     this->lf_sort_needed = true;
     this->lf_out_of_time_order_count = 0;
@@ -329,11 +362,839 @@ logfile::reset_internal_state_for_reindex()
     this->lf_opids.writeAccess()->clear();
     this->lf_thread_ids.writeAccess()->clear();
     this->lf_allocator.reset();
+    this->lf_chunk_allocators.clear();
+    this->lf_index_cache_checked = false;
+    this->lf_index_cache_size = 0;
+    this->lf_column_cache.clear();
+    this->lf_column_indexes.clear();
+    this->lf_column_indexes_size = 0;
+    this->lf_column_indexes_full = false;
+    this->reset_search_index();
     if (this->lf_logline_observer) {
         this->lf_logline_observer->logline_clear(*this);
     }
 }
 
+bool
+logfile::index_cache_is_applicable() const
+{
+    static const auto& cfg = injector::get<const lnav::logfile::config&>();
+
+    // The cache is keyed and validated using the raw file content, so only
+    // plain files that were opened by name can be cached.  The index also
+    // can't contain any state that was derived from the user's actions.
+    return cfg.lc_index_cache_min_size > 0 && this->lf_format != nullptr
+        && this->lf_actual_path && !this->is_compressed()
+        && !this->has_line_metadata() && !this->is_time_adjusted()
+        && !this->lf_options.loo_time_range.has_bounds();
+}
+
+void
+logfile::restore_index_cache(const struct stat& st)
+{
+    if (this->lf_index.empty() || !this->index_cache_is_applicable()) {
+        return;
+    }
+
+    auto path_res = lnav::logfile::index_cache::path_for(
+        st, this->lf_line_buffer.get_fd());
+    if (path_res.isErr()) {
+        log_error("%s: unable to compute index cache path -- %s",
+                  this->lf_filename_as_string.c_str(),
+                  path_res.unwrapErr().c_str());
+        return;
+    }
+
+    auto cache_path = path_res.unwrap();
+    auto open_res = lnav::filesystem::open_file(cache_path, O_RDONLY);
+    if (open_res.isErr()) {
+        log_debug("%s: no index cache found at %s",
+                  this->lf_filename_as_string.c_str(),
+                  cache_path.c_str());
+        return;
+    }
+
+    auto old_size = this->lf_index.size();
+    auto load_res = this->load_index_cache(open_res.unwrap(), st);
+    if (load_res.isErr()) {
+        log_info("%s: ignoring index cache %s -- %s",
+                 this->lf_filename_as_string.c_str(),
+                 cache_path.c_str(),
+                 load_res.unwrapErr().c_str());
+        return;
+    }
+
+    log_info("%s: restored %zu lines (%lld bytes) from index cache %s",
+             this->lf_filename_as_string.c_str(),
+             this->lf_index.size(),
+             (long long) this->lf_index_size,
+             cache_path.c_str());
+
+    std::error_code ec;
+    std::filesystem::last_write_time(
+        cache_path, std::filesystem::file_time_type::clock::now(), ec);
+
+    if (this->lf_logline_observer != nullptr) {
+        auto restored_start = this->begin() + old_size;
+
+        if (this->lf_logline_observer->logline_needs_content(*this)) {
+            this->reobserve_from(restored_start);
+        } else {
+            this->lf_logline_observer->logline_new_lines(
+                *this, restored_start, this->end(), shared_buffer_ref{});
+            this->lf_logline_observer->logline_eof(*this);
+        }
+    }
+
+    // The watch expressions have not seen the restored lines yet.
+    this->eval_watch_exprs_from(old_size);
+}
+
+void
+logfile::eval_watch_exprs_from(size_t start)
+{
+    auto begin = this->begin() + start;
+    auto end = this->end();
+
+    // A partial last line is checked once the rest of it has been read.
+    if (this->lf_partial_line && begin != end) {
+        --end;
+    }
+    // The lines that were rolled back and read again have been checked
+    // already, unless they were partial.
+    while (begin != end
+           && begin->get_offset() <= this->lf_watch_checked_offset)
+    {
+        ++begin;
+    }
+    // A partial line that was checked at the end of the file does not need
+    // to be checked again if only the line ending was added to it.
+    if (begin != end && this->lf_watch_partial_range) {
+        auto fr = this->get_file_range(begin, false);
+
+        if (fr.fr_offset == this->lf_watch_partial_range->fr_offset
+            && fr.fr_size == this->lf_watch_partial_range->fr_size)
+        {
+            ++begin;
+        }
+    }
+    if (begin == end) {
+        return;
+    }
+
+    lnav::log::watch::eval_with(*this, begin, end);
+    this->lf_watch_checked_offset = std::prev(end)->get_offset();
+    this->lf_watch_partial_range = std::nullopt;
+}
+
+void
+logfile::eval_watch_exprs_for_partial_line()
+{
+    if (!this->lf_partial_line || this->lf_index.empty()) {
+        return;
+    }
+
+    auto last = std::prev(this->end());
+    if (last->get_offset() <= this->lf_watch_checked_offset) {
+        return;
+    }
+
+    auto fr = this->get_file_range(last, false);
+    if (this->lf_watch_partial_range
+        && this->lf_watch_partial_range->fr_offset == fr.fr_offset
+        && this->lf_watch_partial_range->fr_size == fr.fr_size)
+    {
+        return;
+    }
+
+    lnav::log::watch::eval_with(*this, last, this->end());
+    this->lf_watch_partial_range = fr;
+}
+
+static constexpr char INDEX_CACHE_MAGIC[8] = "lnavidx";
+static constexpr char INDEX_CACHE_TRAILER[8] = "xdivanl";
+
+Result<void, std::string>
+logfile::load_index_cache(auto_fd fd, const struct stat& st)
+{
+    auto rd = lnav::logfile::index_cache::reader(std::move(fd));
+    char magic[sizeof(INDEX_CACHE_MAGIC)];
+
+    TRY(rd.read(magic, sizeof(magic)));
+    if (memcmp(magic, INDEX_CACHE_MAGIC, sizeof(magic)) != 0) {
+        return Err(std::string("invalid magic number"));
+    }
+    auto version = TRY(rd.read_pod<uint32_t>());
+    auto line_size = TRY(rd.read_pod<uint32_t>());
+    auto lnav_version = TRY(rd.read_str());
+    if (version != lnav::logfile::index_cache::FORMAT_VERSION
+        || line_size != sizeof(logline) || lnav_version != PACKAGE_VERSION)
+    {
+        return Err(fmt::format(FMT_STRING("incompatible cache version {}/{}"),
+                               version,
+                               lnav_version));
+    }
+
+    auto format_name = TRY(rd.read_str());
+    if (format_name != this->lf_format->get_name().to_string()) {
+        return Err(fmt::format(FMT_STRING("format mismatch ({} vs {})"),
+                               format_name,
+                               this->lf_format->get_name()));
+    }
+
+    auto index_size = TRY(rd.read_pod<int64_t>());
+    if (index_size <= this->lf_index_size || index_size > st.st_size) {
+        return Err(fmt::format(FMT_STRING("cached size {} is out of range"),
+                               index_size));
+    }
+    auto cached_tail = TRY(rd.read_str());
+    auto curr_tail = TRY(lnav::logfile::index_cache::tail_fingerprint(
+        this->lf_line_buffer.get_fd(), index_size));
+    if (cached_tail != curr_tail) {
+        return Err(std::string("file content has changed"));
+    }
+
+    auto input_lines = TRY(rd.read_pod<uint64_t>());
+    auto longest_line = TRY(rd.read_pod<uint64_t>());
+    auto level_stats = TRY(rd.read_level_stats());
+
+    auto line_count = TRY(rd.read_pod<uint64_t>());
+    if (line_count < this->lf_index.size()) {
+        return Err(std::string("cached index is smaller than current index"));
+    }
+    TRY(rd.check_count(line_count, sizeof(logline)));
+    std::vector<logline> lines(
+        line_count, logline{0, std::chrono::microseconds{0}, LEVEL_UNKNOWN});
+    TRY(rd.read(lines.data(), line_count * sizeof(logline)));
+
+    // The lines indexed so far were scanned with the current format
+    // definition, so they should match the cached copies exactly.
+    for (size_t lpc = 0; lpc < this->lf_index.size(); lpc++) {
+        const auto& curr = this->lf_index[lpc];
+        const auto& cached = lines[lpc];
+
+        if (curr.get_offset() != cached.get_offset()
+            || curr.get_sub_offset() != cached.get_sub_offset()
+            || curr.get_time<std::chrono::microseconds>()
+                != cached.get_time<std::chrono::microseconds>()
+            || curr.get_msg_level() != cached.get_msg_level())
+        {
+            return Err(fmt::format(FMT_STRING("line {} does not match"), lpc));
+        }
+    }
+
+    pattern_locks locks;
+    auto lock_count = TRY(rd.read_pod<uint64_t>());
+    TRY(rd.check_count(lock_count, sizeof(uint32_t) + sizeof(int32_t)));
+    locks.pl_lines.reserve(lock_count);
+    for (uint64_t lpc = 0; lpc < lock_count; lpc++) {
+        auto pfl_line = TRY(rd.read_pod<uint32_t>());
+        auto pfl_pat_index = TRY(rd.read_pod<int32_t>());
+
+        locks.pl_lines.emplace_back(pfl_line, pfl_pat_index);
+    }
+
+    auto value_stats = TRY(rd.read_value_stats());
+
+    log_opid_state opids;
+    TRY(rd.read_opids(this->lf_allocator, opids));
+    log_thread_id_state tids;
+    TRY(rd.read_tids(this->lf_allocator, tids));
+
+    std::vector<std::pair<uint32_t, bookmark_metadata>> bookmarks;
+    auto bm_count = TRY(rd.read_pod<uint32_t>());
+    for (uint32_t lpc = 0; lpc < bm_count; lpc++) {
+        auto line_number = TRY(rd.read_pod<uint32_t>());
+        bookmark_metadata bm;
+
+        bm.bm_name = TRY(rd.read_str());
+        auto tag_count = TRY(rd.read_pod<uint32_t>());
+        for (uint32_t tag_index = 0; tag_index < tag_count; tag_index++) {
+            bm.add_tag(TRY(rd.read_str()),
+                       bookmark_metadata::meta_source::format);
+        }
+        if (line_number >= line_count) {
+            return Err(fmt::format(FMT_STRING("invalid bookmark line {}"),
+                                   line_number));
+        }
+        bookmarks.emplace_back(line_number, std::move(bm));
+    }
+
+    char trailer[sizeof(INDEX_CACHE_TRAILER)];
+    TRY(rd.read(trailer, sizeof(trailer)));
+    if (memcmp(trailer, INDEX_CACHE_TRAILER, sizeof(trailer)) != 0) {
+        return Err(std::string("invalid trailer"));
+    }
+
+    for (auto& ll : lines) {
+        ll.set_mark(false).set_expr_mark(false).set_meta_mark(false);
+    }
+    for (auto& bm_pair : bookmarks) {
+        auto& bm = this->lf_bookmark_metadata[bm_pair.first];
+
+        lines[bm_pair.first].set_meta_mark(true);
+        if (!bm_pair.second.bm_name.empty() && bm.bm_name.empty()) {
+            bm.bm_name = bm_pair.second.bm_name;
+            bm.bm_name_source = bookmark_metadata::meta_source::format;
+        }
+        for (const auto& te : bm_pair.second.bm_tags) {
+            bm.add_tag(te.te_tag, bookmark_metadata::meta_source::format);
+        }
+    }
+
+    this->lf_index = std::move(lines);
+    this->lf_index_size = index_size;
+    this->lf_index_cache_size = index_size;
+    this->lf_input_lines = input_lines;
+    this->lf_longest_line = std::max(this->lf_longest_line, (size_t) longest_line);
+    this->lf_level_stats = level_stats;
+    this->lf_pattern_locks = std::move(locks);
+    this->lf_value_stats = std::move(value_stats);
+    *this->lf_opids.writeAccess() = std::move(opids);
+    *this->lf_thread_ids.writeAccess() = std::move(tids);
+    this->lf_sort_needed = true;
+
+    return Ok();
+}
+
+void
+logfile::save_index_cache(const struct stat& st)
+{
+    static const auto& cfg = injector::get<const lnav::logfile::config&>();
+
+    if (!this->index_cache_is_applicable()
+        || this->lf_index_size < (file_off_t) cfg.lc_index_cache_min_size
+        || (this->lf_index_size - this->lf_index_cache_size)
+            < (file_off_t) cfg.lc_index_cache_min_size)
+    {
+        return;
+    }
+
+    std::vector<std::pair<uint32_t, const bookmark_metadata*>> bookmarks;
+    for (const auto& bm_pair : this->lf_bookmark_metadata) {
+        if (!bm_pair.second.bm_opid.empty()) {
+            log_debug("%s: not saving index cache since opids were set",
+                      this->lf_filename_as_string.c_str());
+            return;
+        }
+        if (bm_pair.second.bm_name_source
+                == bookmark_metadata::meta_source::format
+            || bm_pair.second.user_tag_count() < bm_pair.second.bm_tags.size())
+        {
+            bookmarks.emplace_back(bm_pair.first, &bm_pair.second);
+        }
+    }
+
+    auto path_res = lnav::logfile::index_cache::path_for(
+        st, this->lf_line_buffer.get_fd());
+    auto tail_res = lnav::logfile::index_cache::tail_fingerprint(
+        this->lf_line_buffer.get_fd(), this->lf_index_size);
+    if (path_res.isErr() || tail_res.isErr()) {
+        log_error("%s: unable to fingerprint file for index cache",
+                  this->lf_filename_as_string.c_str());
+        return;
+    }
+
+    auto cache_path = path_res.unwrap();
+    std::error_code ec;
+    std::filesystem::create_directories(cache_path.parent_path(), ec);
+    if (ec) {
+        log_error("unable to create index cache directory: %s -- %s",
+                  cache_path.parent_path().c_str(),
+                  ec.message().c_str());
+        return;
+    }
+
+    auto tmp_pattern = cache_path;
+    tmp_pattern += ".XXXXXX";
+    auto tmp_res = lnav::filesystem::open_temp_file(tmp_pattern);
+    if (tmp_res.isErr()) {
+        log_error("%s", tmp_res.unwrapErr().c_str());
+        return;
+    }
+
+    auto tmp_pair = tmp_res.unwrap();
+    auto wr = lnav::logfile::index_cache::writer(std::move(tmp_pair.second));
+
+    wr.write(INDEX_CACHE_MAGIC, sizeof(INDEX_CACHE_MAGIC))
+        .write_pod(lnav::logfile::index_cache::FORMAT_VERSION)
+        .write_pod(static_cast<uint32_t>(sizeof(logline)))
+        .write_str(std::string(PACKAGE_VERSION))
+        .write_str(this->lf_format->get_name().to_string_fragment())
+        .write_pod(static_cast<int64_t>(this->lf_index_size))
+        .write_str(tail_res.unwrap())
+        .write_pod(static_cast<uint64_t>(this->lf_input_lines))
+        .write_pod(static_cast<uint64_t>(this->lf_longest_line))
+        .write_level_stats(this->lf_level_stats)
+        .write_pod(static_cast<uint64_t>(this->lf_index.size()))
+        .write(this->lf_index.data(), this->lf_index.size() * sizeof(logline));
+
+    wr.write_pod(static_cast<uint64_t>(this->lf_pattern_locks.pl_lines.size()));
+    for (const auto& pfl : this->lf_pattern_locks.pl_lines) {
+        wr.write_pod(pfl.pfl_line).write_pod(static_cast<int32_t>(pfl.pfl_pat_index));
+    }
+    wr.write_value_stats(this->lf_value_stats);
+    wr.write_opids(*this->lf_opids.readAccess());
+    wr.write_tids(*this->lf_thread_ids.readAccess());
+    wr.write_pod(static_cast<uint32_t>(bookmarks.size()));
+    for (const auto& bm_pair : bookmarks) {
+        const auto* bm = bm_pair.second;
+
+        wr.write_pod(bm_pair.first);
+        if (bm->bm_name_source == bookmark_metadata::meta_source::format) {
+            wr.write_str(bm->bm_name);
+        } else {
+            wr.write_str(string_fragment{});
+        }
+
+        auto format_tag_count = bm->bm_tags.size() - bm->user_tag_count();
+        wr.write_pod(static_cast<uint32_t>(format_tag_count));
+        for (const auto& te : bm->bm_tags) {
+            if (te.te_source == bookmark_metadata::meta_source::format) {
+                wr.write_str(te.te_tag);
+            }
+        }
+    }
+    wr.write(INDEX_CACHE_TRAILER, sizeof(INDEX_CACHE_TRAILER));
+
+    auto finish_res = wr.finish();
+    if (finish_res.isErr()) {
+        log_error("%s: unable to write index cache -- %s",
+                  tmp_pair.first.c_str(),
+                  finish_res.unwrapErr().c_str());
+        std::filesystem::remove(tmp_pair.first, ec);
+        return;
+    }
+
+    std::filesystem::rename(tmp_pair.first, cache_path, ec);
+    if (ec) {
+        log_error("%s: unable to rename index cache -- %s",
+                  cache_path.c_str(),
+                  ec.message().c_str());
+        std::filesystem::remove(tmp_pair.first, ec);
+        return;
+    }
+
+    log_info("%s: saved %zu lines (%lld bytes) to index cache %s",
+             this->lf_filename_as_string.c_str(),
+             this->lf_index.size(),
+             (long long) this->lf_index_size,
+             cache_path.c_str());
+    this->lf_index_cache_size = this->lf_index_size;
+}
+
+static constexpr char SEARCH_INDEX_MAGIC[8] = "lnavsrc";
+static constexpr char SEARCH_INDEX_TRAILER[8] = "crsvanl";
+
+/** The maximum number of bytes to scan for the search index at a time. */
+static constexpr file_off_t SEARCH_INDEX_BATCH_SIZE = 64 * 1024 * 1024;
+
+static Result<lnav::search_index, std::string>
+load_search_index(auto_fd cache_fd,
+                  int fd,
+                  const std::vector<logline>& lines)
+{
+    auto rd = lnav::logfile::index_cache::reader(std::move(cache_fd));
+    char magic[sizeof(SEARCH_INDEX_MAGIC)];
+
+    TRY(rd.read(magic, sizeof(magic)));
+    if (memcmp(magic, SEARCH_INDEX_MAGIC, sizeof(magic)) != 0) {
+        return Err(std::string("invalid magic number"));
+    }
+    auto version = TRY(rd.read_pod<uint32_t>());
+    if (version != lnav::logfile::index_cache::FORMAT_VERSION) {
+        return Err(fmt::format(FMT_STRING("incompatible cache version {}"),
+                               version));
+    }
+
+    lnav::search_index retval;
+    TRY(retval.load(rd));
+    auto cached_tail = TRY(rd.read_str());
+
+    char trailer[sizeof(SEARCH_INDEX_TRAILER)];
+    TRY(rd.read(trailer, sizeof(trailer)));
+    if (memcmp(trailer, SEARCH_INDEX_TRAILER, sizeof(trailer)) != 0) {
+        return Err(std::string("invalid trailer"));
+    }
+
+    // The blocks need to line up with the lines found by the current
+    // format and the content of the file must not have changed.
+    auto line_count = retval.get_line_count();
+    if (line_count >= lines.size()) {
+        return Err(std::string("cached index covers more lines than the file"));
+    }
+    for (size_t block = 0; block < retval.get_block_count(); block++) {
+        const auto& ll = lines[block * lnav::search_index::BLOCK_LINES];
+
+        if (ll.get_offset() != retval.get_block_offset(block)) {
+            return Err(fmt::format(FMT_STRING("block {} does not match"),
+                                   block));
+        }
+    }
+    if (lines[line_count].get_offset() != retval.get_end_offset()) {
+        return Err(std::string("end of the index does not match"));
+    }
+    auto curr_tail = TRY(lnav::logfile::index_cache::tail_fingerprint(
+        fd, retval.get_end_offset()));
+    if (cached_tail != curr_tail) {
+        return Err(std::string("file content has changed"));
+    }
+
+    return Ok(std::move(retval));
+}
+
+bool
+logfile::search_index_is_applicable(const struct stat& st) const
+{
+    static const auto& cfg = injector::get<const lnav::logfile::config&>();
+
+    // The index is built from the raw bytes in the file, so the content of
+    // the lines that are searched needs to be the same as the file.
+    return cfg.lc_search_index_min_size > 0
+        && st.st_size >= (off_t) cfg.lc_search_index_min_size
+        && this->lf_format != nullptr && this->lf_format->has_raw_sublines()
+        && !this->is_compressed() && !this->has_line_metadata()
+        && !this->lf_line_buffer.is_pipe();
+}
+
+void
+logfile::reset_search_index()
+{
+    if (this->lf_search_index_future.valid()) {
+        this->lf_search_index_cancelled = true;
+        this->lf_search_index_future.wait();
+        this->lf_search_index_future = {};
+    }
+    this->lf_search_index.clear();
+    this->lf_search_index_checked = false;
+    this->lf_search_index_saved_size = 0;
+}
+
+void
+logfile::update_search_index(const struct stat& st)
+{
+    static constexpr auto BLOCK_LINES = lnav::search_index::BLOCK_LINES;
+
+    if (this->lf_search_index_future.valid()) {
+        if (this->lf_search_index_future.wait_for(std::chrono::seconds(0))
+            != std::future_status::ready)
+        {
+            return;
+        }
+
+        auto blocks = this->lf_search_index_future.get();
+        for (const auto& bt : blocks) {
+            auto start = this->lf_search_index.get_line_count();
+
+            if (start + BLOCK_LINES >= this->lf_index.size()
+                || this->lf_index[start].get_offset() != bt.bt_range.br_start
+                || this->lf_index[start + BLOCK_LINES].get_offset()
+                    != bt.bt_range.br_end)
+            {
+                log_warning("%s: lines changed while building search index",
+                            this->lf_filename_as_string.c_str());
+                break;
+            }
+            this->lf_search_index.add_block(bt);
+        }
+    }
+
+    if (!this->search_index_is_applicable(st)
+        || this->lf_index_size < st.st_size)
+    {
+        return;
+    }
+
+    if (!this->lf_search_index_checked) {
+        this->lf_search_index_checked = true;
+        this->restore_search_index(st);
+    }
+
+    // A block is only indexed once the line after it has been seen so that
+    // the last line in the block is known to be complete.
+    std::vector<lnav::search_index::block_range> ranges;
+    file_off_t batch_size = 0;
+    for (auto start = this->lf_search_index.get_line_count();
+         start + BLOCK_LINES < this->lf_index.size()
+         && batch_size < SEARCH_INDEX_BATCH_SIZE;
+         start += BLOCK_LINES)
+    {
+        auto start_iter = this->begin() + start;
+        auto end_iter = start_iter + BLOCK_LINES;
+        auto& br = ranges.emplace_back();
+
+        br.br_start = start_iter->get_offset();
+        br.br_end = end_iter->get_offset();
+        br.br_indexable = std::all_of(start_iter, end_iter, [](const auto& ll) {
+            return ll.is_valid_utf() && !ll.has_ansi()
+                && ll.get_sub_offset() == 0;
+        });
+        batch_size += br.br_end - br.br_start;
+    }
+
+    if (ranges.empty()) {
+        this->save_search_index(st);
+        return;
+    }
+
+    this->lf_search_index_cancelled = false;
+    this->lf_search_index_future = std::async(
+        std::launch::async,
+        [this,
+         fd = auto_fd::dup_of(this->lf_line_buffer.get_fd()),
+         ranges = std::move(ranges)]() {
+            return lnav::search_index::scan_blocks(
+                fd, ranges, this->lf_search_index_cancelled);
+        });
+}
+
+void
+logfile::restore_search_index(const struct stat& st)
+{
+    if (!this->lf_actual_path || this->lf_index.empty()) {
+        return;
+    }
+
+    auto path_res = lnav::logfile::index_cache::path_for(
+        st, this->lf_line_buffer.get_fd());
+    if (path_res.isErr()) {
+        return;
+    }
+
+    auto cache_path = path_res.unwrap().replace_extension(".search");
+    auto open_res = lnav::filesystem::open_file(cache_path, O_RDONLY);
+    if (open_res.isErr()) {
+        return;
+    }
+
+    auto load_res = load_search_index(
+        open_res.unwrap(), this->lf_line_buffer.get_fd(), this->lf_index);
+    if (load_res.isErr()) {
+        log_info("%s: ignoring search index %s -- %s",
+                 this->lf_filename_as_string.c_str(),
+                 cache_path.c_str(),
+                 load_res.unwrapErr().c_str());
+        return;
+    }
+
+    this->lf_search_index = load_res.unwrap();
+    this->lf_search_index_saved_size = this->lf_search_index.get_end_offset();
+    log_info("%s: restored search index for %zu lines from %s",
+             this->lf_filename_as_string.c_str(),
+             this->lf_search_index.get_line_count(),
+             cache_path.c_str());
+
+    std::error_code ec;
+    std::filesystem::last_write_time(
+        cache_path, std::filesystem::file_time_type::clock::now(), ec);
+}
+
+void
+logfile::save_search_index(const struct stat& st)
+{
+    static const auto& cfg = injector::get<const lnav::logfile::config&>();
+
+    if (cfg.lc_index_cache_min_size == 0 || !this->lf_actual_path
+        || (this->lf_search_index.get_end_offset()
+            - this->lf_search_index_saved_size)
+            < (file_off_t) cfg.lc_index_cache_min_size)
+    {
+        return;
+    }
+
+    auto path_res = lnav::logfile::index_cache::path_for(
+        st, this->lf_line_buffer.get_fd());
+    auto tail_res = lnav::logfile::index_cache::tail_fingerprint(
+        this->lf_line_buffer.get_fd(), this->lf_search_index.get_end_offset());
+    if (path_res.isErr() || tail_res.isErr()) {
+        log_error("%s: unable to fingerprint file for search index",
+                  this->lf_filename_as_string.c_str());
+        return;
+    }
+
+    auto cache_path = path_res.unwrap().replace_extension(".search");
+    std::error_code ec;
+    std::filesystem::create_directories(cache_path.parent_path(), ec);
+    if (ec) {
+        log_error("unable to create index cache directory: %s -- %s",
+                  cache_path.parent_path().c_str(),
+                  ec.message().c_str());
+        return;
+    }
+
+    auto tmp_pattern = cache_path;
+    tmp_pattern += ".XXXXXX";
+    auto tmp_res = lnav::filesystem::open_temp_file(tmp_pattern);
+    if (tmp_res.isErr()) {
+        log_error("%s", tmp_res.unwrapErr().c_str());
+        return;
+    }
+
+    auto tmp_pair = tmp_res.unwrap();
+    auto wr = lnav::logfile::index_cache::writer(std::move(tmp_pair.second));
+
+    wr.write(SEARCH_INDEX_MAGIC, sizeof(SEARCH_INDEX_MAGIC))
+        .write_pod(lnav::logfile::index_cache::FORMAT_VERSION);
+    this->lf_search_index.save(wr);
+    wr.write_str(tail_res.unwrap())
+        .write(SEARCH_INDEX_TRAILER, sizeof(SEARCH_INDEX_TRAILER));
+
+    auto finish_res = wr.finish();
+    if (finish_res.isErr()) {
+        log_error("%s: unable to write search index -- %s",
+                  tmp_pair.first.c_str(),
+                  finish_res.unwrapErr().c_str());
+        std::filesystem::remove(tmp_pair.first, ec);
+        return;
+    }
+
+    std::filesystem::rename(tmp_pair.first, cache_path, ec);
+    if (ec) {
+        log_error("%s: unable to rename search index -- %s",
+                  cache_path.c_str(),
+                  ec.message().c_str());
+        std::filesystem::remove(tmp_pair.first, ec);
+        return;
+    }
+
+    log_info("%s: saved search index for %zu lines (%zu bytes) to %s",
+             this->lf_filename_as_string.c_str(),
+             this->lf_search_index.get_line_count(),
+             this->lf_search_index.get_size(),
+             cache_path.c_str());
+    this->lf_search_index_saved_size = this->lf_search_index.get_end_offset();
+}
+
+const logfile::column_index*
+logfile::get_column_index(logline_value_meta::table_column col)
+{
+    if (this->lf_format == nullptr || this->lf_column_indexes_full) {
+        return nullptr;
+    }
+
+    auto& retval = this->lf_column_indexes[col.value];
+    this->update_column_indexes();
+    if (this->lf_column_indexes_full) {
+        return nullptr;
+    }
+
+    return &retval;
+}
+
+void
+logfile::update_column_indexes()
+{
+    static const auto& cfg = injector::get<const lnav::logfile::config&>();
+
+    auto end = this->lf_index.size();
+    auto start = end;
+    for (const auto& ci_pair : this->lf_column_indexes) {
+        start = std::min(start, ci_pair.second.ci_line_count);
+    }
+    if (start >= end) {
+        return;
+    }
+
+    // If the new lines continue the last message that was indexed, the
+    // values of that message might have changed, so it is indexed again.
+    if (!this->lf_index[start].is_message()) {
+        while (start > 0 && !this->lf_index[start].is_message()) {
+            start -= 1;
+        }
+        this->truncate_column_indexes(start);
+    }
+
+    log_debug("%s: indexing column values for lines [%zu:%zu)",
+              this->lf_filename_as_string.c_str(),
+              start,
+              end);
+
+    auto* format = this->lf_format.get();
+    auto& cache = this->get_column_cache();
+    logline_value_vector values;
+    string_attrs_t sa;
+    ArenaAlloc::Alloc<char> value_alloc{1024};
+    for (auto line = start; line < end; line++) {
+        auto ll = this->begin() + line;
+
+        if (!ll->is_message()) {
+            continue;
+        }
+
+        auto& sbr = values.lvv_sbr;
+        values.clear();
+        values.lvv_allocator.reset();
+        value_alloc.reset();
+        sa.clear();
+        this->read_full_message(ll, sbr);
+        sbr.erase_ansi();
+        format->annotate(this, line, sa, values);
+        cache.record(line, values.lvv_values);
+        for (auto& [col, ci] : this->lf_column_indexes) {
+            if (line < ci.ci_line_count) {
+                continue;
+            }
+
+            auto lv_iter = std::find_if(
+                values.lvv_values.begin(),
+                values.lvv_values.end(),
+                logline_value_col_eq(logline_value_meta::table_column{col}));
+            if (lv_iter == values.lvv_values.end()
+                || lv_iter->lv_meta.lvm_kind == value_kind_t::VALUE_NULL)
+            {
+                continue;
+            }
+
+            auto value = lv_iter->to_string_fragment(value_alloc);
+            auto iter = ci.ci_value_to_lines.find(value);
+            if (iter == ci.ci_value_to_lines.end()) {
+                iter = ci.ci_value_to_lines
+                           .emplace(value.to_owned(ci.ci_string_arena),
+                                    std::vector<uint32_t>{})
+                           .first;
+                this->lf_column_indexes_size += value.length();
+            }
+            iter->second.push_back(line);
+            this->lf_column_indexes_size += sizeof(uint32_t);
+        }
+
+        if (this->lf_column_indexes_size > cfg.lc_value_index_max_size) {
+            log_info("%s: column indexes are over the size limit of %llu "
+                     "bytes",
+                     this->lf_filename_as_string.c_str(),
+                     (unsigned long long) cfg.lc_value_index_max_size);
+            this->lf_column_indexes.clear();
+            this->lf_column_indexes_size = 0;
+            this->lf_column_indexes_full = true;
+            return;
+        }
+    }
+    for (auto& ci_pair : this->lf_column_indexes) {
+        ci_pair.second.ci_line_count = end;
+    }
+}
+
+void
+logfile::truncate_column_indexes(size_t line_count)
+{
+    for (auto& ci_pair : this->lf_column_indexes) {
+        auto& ci = ci_pair.second;
+
+        if (ci.ci_line_count <= line_count) {
+            continue;
+        }
+        for (auto& value_pair : ci.ci_value_to_lines) {
+            auto& line_vec = value_pair.second;
+
+            while (!line_vec.empty() && line_vec.back() >= line_count) {
+                line_vec.pop_back();
+                this->lf_column_indexes_size -= sizeof(uint32_t);
+            }
+        }
+        ci.ci_line_count = line_count;
+    }
+}
+
 logfile::map_entry_result
 logfile::find_content_map_entry(file_off_t offset, map_read_requirement req)
 {
@@ -838,6 +1699,28 @@ logfile::get_content_time_range() const
     };
 }
 
+void
+logfile::log_prefilter_rejects()
+{
+    if (this->lf_prefilter_rejects.empty()) {
+        return;
+    }
+
+    std::vector<std::pair<intern_string_t, size_t>> rejects(
+        this->lf_prefilter_rejects.begin(), this->lf_prefilter_rejects.end());
+    std::sort(rejects.begin(),
+              rejects.end(),
+              [](const auto& lhs, const auto& rhs) {
+                  return lhs.second > rhs.second;
+              });
+    log_info("%s: lines rejected by format prefilters",
+             this->lf_filename_as_string.c_str());
+    for (const auto& reject : rejects) {
+        log_info("  %s: %zu", reject.first.get(), reject.second);
+    }
+    this->lf_prefilter_rejects.clear();
+}
+
 bool
 logfile::process_prefix(shared_buffer_ref& sbr,
                         const line_info& li,
@@ -945,6 +1828,15 @@ logfile::process_prefix(shared_buffer_ref& sbr,
             }
 
             scan_count += 1;
+            if (!this->lf_index.empty()
+                && (this->lf_format == nullptr
+                    || this->lf_format->lf_root_format != curr.get())
+                && !curr->lf_line_prefilter.might_match(
+                    sbr.to_string_fragment()))
+            {
+                this->lf_prefilter_rejects[curr->get_name()] += 1;
+                continue;
+            }
             curr->clear();
             this->set_format_base_time(curr.get(), li);
             log_format::scan_result_t scan_res{mapbox::util::no_init{}};
@@ -1097,6 +1989,7 @@ logfile::process_prefix(shared_buffer_ref& sbr,
             log_info("%s: no formats available to scan, no longer detecting",
                      this->lf_filename_as_string.c_str());
             this->lf_options.loo_detect_format = false;
+            this->log_prefilter_rejects();
         }
 
         if (best_match
@@ -1113,6 +2006,7 @@ logfile::process_prefix(shared_buffer_ref& sbr,
                      this->lf_filename_as_string.c_str(),
                      this->lf_index.size(),
                      curr->get_name().get());
+            this->log_prefilter_rejects();
 
             auto match_um = lnav::console::user_message::ok(
                 attr_line_t()
@@ -1321,6 +2215,494 @@ logfile::process_prefix(shared_buffer_ref& sbr,
     return retval;
 }
 
+namespace {
+
+struct index_chunk {
+    file_off_t ic_start{0};
+    file_off_t ic_end{0};
+    std::shared_ptr<log_format> ic_format;
+    std::vector<logline> ic_lines;
+    ArenaAlloc::Alloc<char> ic_allocator{64 * 1024};
+    pattern_locks ic_pattern_locks;
+    std::vector<logline_value_stats> ic_value_stats;
+    log_opid_state ic_opids;
+    log_thread_id_state ic_tids;
+    size_t ic_input_lines{0};
+    size_t ic_longest_line{0};
+    size_t ic_scan_errors{0};
+    /** The lines at the start of the chunk that did not match a pattern. */
+    size_t ic_leading_lines{0};
+    uint32_t ic_out_of_time_order_count{0};
+    bool ic_sort_needed{false};
+    file_range ic_last_range;
+    /** True if the scan reached the end of the chunk before being stopped. */
+    bool ic_complete{false};
+    std::optional<std::string> ic_error;
+    std::atomic<file_off_t> ic_progress{0};
+};
+
+/**
+ * Scan the lines in the given chunk of a file using a private copy of the
+ * file's format.  This mirrors the work done by logfile::process_prefix()
+ * for a format that is already locked, but the fixups that need the line
+ * before the chunk are left for the caller.
+ */
+void
+scan_chunk(logfile& lf,
+           int fd,
+           index_chunk& ic,
+           const std::atomic<bool>& stopped)
+{
+    line_buffer lb;
+    auto chunk_fd = auto_fd::dup_of(fd);
+    lb.set_fd(chunk_fd);
+    scan_batch_context sbc{ic.ic_allocator, ic.ic_pattern_locks};
+    auto prev_range = file_range{ic.ic_start};
+    auto matched = false;
+
+    while (!stopped.load(std::memory_order_relaxed)) {
+        auto load_res = lb.load_next_line(prev_range);
+        if (load_res.isErr()) {
+            ic.ic_error = load_res.unwrapErr();
+            return;
+        }
+
+        auto li = load_res.unwrap();
+        if (li.li_file_range.empty() || li.li_partial
+            || li.li_file_range.fr_offset >= ic.ic_end)
+        {
+            ic.ic_complete = true;
+            break;
+        }
+
+        auto read_res = lb.read_range(li.li_file_range);
+        if (read_res.isErr()) {
+            ic.ic_error = read_res.unwrapErr();
+            return;
+        }
+
+        auto sbr = read_res.unwrap();
+        sbr.rtrim(is_line_ending);
+        if (li.li_utf8_scan_result.is_valid()
+            && li.li_utf8_scan_result.usr_has_ansi)
+        {
+            sbr.erase_ansi();
+        }
+        prev_range = li.li_file_range;
+        ic.ic_last_range = li.li_file_range;
+        ic.ic_input_lines += 1;
+        ic.ic_longest_line = std::max(
+            ic.ic_longest_line, li.li_utf8_scan_result.usr_column_width_guess);
+
+        auto prescan_size = ic.ic_lines.size();
+        auto found = ic.ic_format->scan(lf, ic.ic_lines, li, sbr, sbc);
+        if (found.is<log_format::scan_match>()) {
+            auto& last_line = ic.ic_lines.back();
+
+            last_line.set_valid_utf(last_line.is_valid_utf()
+                                    && li.li_utf8_scan_result.is_valid());
+            last_line.set_has_ansi(last_line.has_ansi()
+                                   || li.li_utf8_scan_result.usr_has_ansi);
+            if (found.get<log_format::scan_match>().sm_quality > 0) {
+                matched = true;
+            }
+            if (prescan_size > ic.ic_leading_lines
+                && prescan_size < ic.ic_lines.size())
+            {
+                auto& second_to_last = ic.ic_lines[prescan_size - 1];
+                auto& latest = ic.ic_lines[prescan_size];
+
+                if (!second_to_last.is_ignored() && latest < second_to_last) {
+                    if (ic.ic_format->lf_time_ordered) {
+                        ic.ic_out_of_time_order_count += 1;
+                        for (auto lpc = prescan_size;
+                             lpc < ic.ic_lines.size();
+                             lpc++)
+                        {
+                            auto& line_to_update = ic.ic_lines[lpc];
+
+                            line_to_update.set_time_skew(true);
+                            line_to_update.set_time(
+                                second_to_last
+                                    .get_time<std::chrono::microseconds>());
+                        }
+                    } else {
+                        ic.ic_sort_needed = true;
+                    }
+                }
+            }
+        } else if (found.is<log_format::scan_no_match>()
+                   || found.is<log_format::scan_incomplete>())
+        {
+            auto last_time = std::chrono::microseconds{0};
+            auto last_level = LEVEL_UNKNOWN;
+
+            if (!ic.ic_lines.empty()) {
+                const auto& ll = ic.ic_lines.back();
+
+                last_time = ll.get_time<std::chrono::microseconds>();
+                last_level = ll.get_msg_level();
+            }
+            ic.ic_lines.emplace_back(
+                li.li_file_range.fr_offset, last_time, last_level);
+            auto& new_line = ic.ic_lines.back();
+            new_line.set_continued(true);
+            new_line.set_valid_utf(li.li_utf8_scan_result.is_valid());
+            new_line.set_has_ansi(li.li_utf8_scan_result.usr_has_ansi);
+        } else {
+            ic.ic_scan_errors += 1;
+        }
+        if (!matched) {
+            ic.ic_leading_lines = ic.ic_lines.size();
+        }
+
+        ic.ic_progress.store(li.li_file_range.next_offset() - ic.ic_start,
+                             std::memory_order_relaxed);
+    }
+
+    ic.ic_value_stats = std::move(sbc.sbc_value_stats);
+    ic.ic_opids = std::move(sbc.sbc_opids);
+    ic.ic_tids = std::move(sbc.sbc_tids);
+}
+
+}  // namespace
+
+bool
+logfile::can_index_concurrently() const
+{
+    // Format detection scans lines with the root formats, which are shared
+    // by all files, and the watch expressions are evaluated using the
+    // main database connection.
+    return this->lf_indexing && !this->lf_is_closed
+        && this->lf_format != nullptr
+        && (!this->lf_options.loo_detect_format
+            || this->lf_index.size() >= RETRY_MATCH_SIZE)
+        && !lnav::log::watch::any_enabled();
+}
+
+size_t
+logfile::index_thread_count() const
+{
+    if (this->lf_index_thread_limit > 0) {
+        return this->lf_index_thread_limit;
+    }
+
+    return std::max(1U, std::thread::hardware_concurrency());
+}
+
+/**
+ * @return The number of bytes after the given offset that can be indexed
+ *   within the line limit for a call to rebuild_index().  The average length
+ *   of the lines indexed so far is used to convert the limit into bytes.
+ */
+file_off_t
+logfile::parallel_index_extent(file_off_t off,
+                               const struct stat& st,
+                               size_t limit) const
+{
+    auto retval = st.st_size - off;
+
+    if (limit != SIZE_MAX && !this->lf_index.empty()) {
+        auto avg_line_size = std::max(
+            file_off_t{1},
+            this->lf_index_size
+                / static_cast<file_off_t>(this->lf_index.size()));
+
+        if (static_cast<file_off_t>(limit) < retval / avg_line_size) {
+            retval = static_cast<file_off_t>(limit) * avg_line_size;
+        }
+    }
+
+    return retval;
+}
+
+bool
+logfile::parallel_index_is_applicable(file_off_t off,
+                                      const struct stat& st,
+                                      size_t limit) const
+{
+    static const auto& cfg = injector::get<const lnav::logfile::config&>();
+
+    // The lines are only handed off once format detection is complete and
+    // when the scan of a line does not depend on anything more than the
+    // line before it.
+    return this->lf_format != nullptr
+        && this->lf_index.size() >= RETRY_MATCH_SIZE
+        && this->index_thread_count() > 1
+        && this->parallel_index_extent(off, st, limit)
+            >= 2 * static_cast<file_off_t>(cfg.lc_parallel_index_chunk_size)
+        && !this->is_compressed() && !this->has_line_metadata()
+        && !this->lf_line_buffer.is_pipe()
+        && !this->lf_options.loo_time_range.has_bounds()
+        && !this->lf_upper_bound_size && this->lf_applicable_taggers.empty()
+        && this->lf_applicable_partitioners.empty()
+        && (this->lf_format->lf_timestamp_flags & ETF_YEAR_SET);
+}
+
+std::optional<file_range>
+logfile::index_in_parallel(file_off_t off,
+                           const struct stat& st,
+                           scan_batch_context& sbc,
+                           bool& sort_needed,
+                           size_t& limit,
+                           std::optional<ui_clock::time_point> deadline)
+{
+    static const auto& cfg = injector::get<const lnav::logfile::config&>();
+
+    auto extent = this->parallel_index_extent(off, st, limit);
+    auto end_off = off + extent;
+    auto chunk_count = std::min(
+        static_cast<file_off_t>(this->index_thread_count()),
+        std::max(file_off_t{1},
+                 extent
+                     / static_cast<file_off_t>(
+                         cfg.lc_parallel_index_chunk_size)));
+    auto nominal_size = extent / chunk_count;
+    auto fd = this->lf_line_buffer.get_fd();
+    std::vector<file_off_t> starts{off};
+
+    // Move each split point up to the start of the next line.
+    for (file_off_t lpc = 1; lpc < chunk_count; lpc++) {
+        auto split = std::max(off + lpc * nominal_size, starts.back());
+        char buf[8 * 1024];
+        std::optional<file_off_t> line_start;
+
+        while (!line_start && split < end_off) {
+            auto rc = pread(fd, buf, sizeof(buf), split);
+            if (rc <= 0) {
+                break;
+            }
+            const auto* nl = static_cast<const char*>(memchr(buf, '\n', rc));
+            if (nl != nullptr) {
+                line_start = split + (nl - buf) + 1;
+            } else {
+                split += rc;
+            }
+        }
+        if (!line_start || line_start.value() >= end_off) {
+            break;
+        }
+        if (line_start.value() > starts.back()) {
+            starts.emplace_back(line_start.value());
+        }
+    }
+
+    auto avg_line_size = std::max(
+        file_off_t{1},
+        this->lf_index_size / static_cast<file_off_t>(this->lf_index.size()));
+    std::vector<index_chunk> chunks(starts.size());
+    for (size_t lpc = 0; lpc < chunks.size(); lpc++) {
+        auto& ic = chunks[lpc];
+
+        ic.ic_start = starts[lpc];
+        ic.ic_end = lpc + 1 < starts.size() ? starts[lpc + 1] : end_off;
+        ic.ic_format = this->lf_format->clone_for_scan();
+        if (ic.ic_format == nullptr) {
+            return std::nullopt;
+        }
+        ic.ic_lines.reserve((ic.ic_end - ic.ic_start) / avg_line_size);
+    }
+
+    log_info("%s: indexing %lld bytes using %zu threads",
+             this->lf_filename_as_string.c_str(),
+             (long long) extent,
+             chunks.size());
+
+    // The workers are stopped when the deadline passes or the user
+    // interrupts.  For a deadline, the lines that were scanned up to the
+    // first incomplete chunk are kept and the rest is left for the next
+    // call, like the serial loop does with its limit.
+    std::atomic<bool> stopped{false};
+    auto interrupted = false;
+    std::vector<std::future<void>> futures;
+    futures.reserve(chunks.size());
+    for (auto& ic : chunks) {
+        futures.emplace_back(
+            std::async(std::launch::async, [this, fd, &ic, &stopped]() {
+                scan_chunk(*this, fd, ic, stopped);
+            }));
+    }
+
+    for (auto& fut : futures) {
+        while (fut.wait_for(std::chrono::milliseconds(100))
+               != std::future_status::ready)
+        {
+            if (stopped) {
+                continue;
+            }
+            if (deadline && ui_clock::now() > deadline.value()) {
+                log_debug("parallel indexing ran past deadline");
+                stopped = true;
+                continue;
+            }
+            if (this->lf_logfile_observer == nullptr) {
+                continue;
+            }
+
+            auto progress = off;
+            for (const auto& ic : chunks) {
+                progress += ic.ic_progress.load(std::memory_order_relaxed);
+            }
+            auto indexing_res = this->lf_logfile_observer->logfile_indexing(
+                this, progress, this->get_content_size());
+            if (indexing_res == lnav::progress_result_t::interrupt) {
+                log_debug("parallel indexing interrupted");
+                interrupted = true;
+                stopped = true;
+            }
+        }
+    }
+
+    if (interrupted) {
+        return std::nullopt;
+    }
+    for (const auto& ic : chunks) {
+        if (ic.ic_error) {
+            log_error("%s: parallel indexing failed -- %s",
+                      this->lf_filename_as_string.c_str(),
+                      ic.ic_error->c_str());
+            return std::nullopt;
+        }
+    }
+
+    // Stitch the chunks together, fixing up anything that depended on the
+    // last line of the previous chunk.
+    auto begin_size = this->lf_index.size();
+    auto last_range = file_range{off};
+    auto total_lines = begin_size;
+    for (const auto& ic : chunks) {
+        total_lines += ic.ic_lines.size();
+    }
+    this->lf_index.reserve(total_lines);
+    for (auto& ic : chunks) {
+        if (ic.ic_lines.empty()) {
+            if (!ic.ic_complete) {
+                break;
+            }
+            continue;
+        }
+
+        auto base = this->lf_index.size();
+        for (size_t lpc = 0; lpc < ic.ic_lines.size(); lpc++) {
+            auto& ll = ic.ic_lines[lpc];
+            const auto* prev = lpc == 0 ? (base > 0 ? &this->lf_index.back()
+                                                    : nullptr)
+                                        : &ic.ic_lines[lpc - 1];
+
+            if (prev == nullptr) {
+                continue;
+            }
+            if (lpc < ic.ic_leading_lines) {
+                ll.set_time(prev->get_time<std::chrono::microseconds>());
+                if (this->lf_format->lf_multiline) {
+                    ll.set_level(prev->get_msg_level());
+                } else {
+                    ll.set_level(LEVEL_INVALID);
+                    ll.set_continued(false);
+                }
+                continue;
+            }
+            if (ll.is_continued()) {
+                ll.set_time(prev->get_time<std::chrono::microseconds>());
+                continue;
+            }
+            if (prev->is_ignored() || !(ll < *prev)) {
+                break;
+            }
+            if (!this->lf_format->lf_time_ordered) {
+                sort_needed = true;
+                break;
+            }
+            this->lf_out_of_time_order_count += 1;
+            ll.set_time_skew(true);
+            ll.set_time(prev->get_time<std::chrono::microseconds>());
+        }
+
+        for (const auto& ll : ic.ic_lines) {
+            if (ll.is_continued()) {
+                continue;
+            }
+            this->lf_level_stats.update_msg_count(ll.get_msg_level());
+            if (ll.get_msg_level() == LEVEL_INVALID) {
+                if (this->lf_invalid_lines.ili_lines.size()
+                    < invalid_line_info::MAX_INVALID_LINES)
+                {
+                    this->lf_invalid_lines.ili_lines.push_back(
+                        base + (&ll - ic.ic_lines.data()));
+                }
+                this->lf_invalid_lines.ili_total += 1;
+            }
+        }
+        this->lf_invalid_lines.ili_total += ic.ic_scan_errors;
+        this->lf_out_of_time_order_count += ic.ic_out_of_time_order_count;
+        sort_needed = sort_needed || ic.ic_sort_needed;
+
+        this->lf_index.insert(
+            this->lf_index.end(), ic.ic_lines.begin(), ic.ic_lines.end());
+        for (const auto& pfl : ic.ic_pattern_locks.pl_lines) {
+            if (pfl.pfl_pat_index
+                == sbc.sbc_pattern_locks.last_pattern_index())
+            {
+                continue;
+            }
+            sbc.sbc_pattern_locks.pl_lines.emplace_back(base + pfl.pfl_line,
+                                                        pfl.pfl_pat_index);
+        }
+        if (sbc.sbc_value_stats.size() < ic.ic_value_stats.size()) {
+            sbc.sbc_value_stats.resize(ic.ic_value_stats.size());
+        }
+        for (size_t lpc = 0; lpc < ic.ic_value_stats.size(); lpc++) {
+            sbc.sbc_value_stats[lpc].merge(ic.ic_value_stats[lpc]);
+        }
+        for (const auto& opid_pair : ic.ic_opids.los_opid_ranges) {
+            auto opid_iter
+                = sbc.sbc_opids.los_opid_ranges.find(opid_pair.first);
+
+            if (opid_iter == sbc.sbc_opids.los_opid_ranges.end()) {
+                sbc.sbc_opids.los_opid_ranges.emplace(opid_pair);
+            } else {
+                opid_iter->second |= opid_pair.second;
+            }
+        }
+        for (const auto& tid_pair : ic.ic_tids.ltis_tid_ranges) {
+            auto tid_iter = sbc.sbc_tids.ltis_tid_ranges.find(tid_pair.first);
+
+            if (tid_iter == sbc.sbc_tids.ltis_tid_ranges.end()) {
+                sbc.sbc_tids.ltis_tid_ranges.emplace(tid_pair);
+            } else {
+                tid_iter->second |= tid_pair.second;
+            }
+        }
+        // The opid and thread-id strings live in the chunk's arena.
+        this->lf_chunk_allocators.emplace_back(ic.ic_allocator);
+
+        this->lf_input_lines += ic.ic_input_lines;
+        this->lf_longest_line
+            = std::max(this->lf_longest_line, ic.ic_longest_line);
+        last_range = ic.ic_last_range;
+        if (!ic.ic_complete) {
+            break;
+        }
+    }
+
+    if (this->lf_index.size() == begin_size) {
+        return std::nullopt;
+    }
+
+    limit -= std::min(limit, this->lf_index.size() - begin_size);
+    if (stopped) {
+        limit = 0;
+    }
+
+    this->lf_index_size = last_range.next_offset();
+    this->lf_partial_line = false;
+    log_info("%s: parallel indexing found %zu lines",
+             this->lf_filename_as_string.c_str(),
+             this->lf_index.size() - begin_size);
+
+    return last_range;
+}
+
 logfile::rebuild_result_t
 logfile::rebuild_index(std::optional<ui_clock::time_point> deadline)
 {
@@ -1459,6 +2841,11 @@ logfile::rebuild_index(std::optional<ui_clock::time_point> deadline)
     {
         this->lf_activity.la_reads += 1;
 
+        if (this->lf_format != nullptr && !this->lf_index_cache_checked) {
+            this->lf_index_cache_checked = true;
+            this->restore_index_cache(st);
+        }
+
         // We haven't reached the end of the file.  Note that we use the
         // line buffer's notion of the file size since it may be compressed.
         bool has_format = this->lf_format.get() != nullptr;
@@ -1493,6 +2880,13 @@ logfile::rebuild_index(std::optional<ui_clock::time_point> deadline)
             this->lf_index.pop_back();
             rollback_index_start = this->lf_index.size();
             rollback_size += 1;
+            this->lf_column_cache.truncate(rollback_index_start);
+            this->truncate_column_indexes(rollback_index_start);
+            if (this->lf_search_index.get_line_count()
+                > rollback_index_start)
+            {
+                this->reset_search_index();
+            }
 
             if (!this->lf_index.empty()) {
                 auto last_line = std::prev(this->lf_index.end());
@@ -1582,6 +2976,31 @@ logfile::rebuild_index(std::optional<ui_clock::time_point> deadline)
         sbc.sbc_opids.los_opid_ranges.reserve(32);
         sbc.sbc_tids.ltis_tid_ranges.reserve(8);
         auto prev_range = file_range{off};
+        if (has_format && this->parallel_index_is_applicable(off, st, limit))
+        {
+            auto par_size = this->lf_index.size();
+            auto par_res = this->index_in_parallel(
+                off, st, sbc, sort_needed, limit, deadline);
+
+            if (par_res) {
+                prev_range = par_res.value();
+                if (this->lf_logline_observer != nullptr) {
+                    auto par_start = this->begin() + par_size;
+
+                    if (this->lf_logline_observer->logline_needs_content(
+                            *this))
+                    {
+                        this->reobserve_from(par_start);
+                        if (rollback_size > 0) {
+                            sort_needed = true;
+                        }
+                    } else {
+                        this->lf_logline_observer->logline_new_lines(
+                            *this, par_start, this->end(), shared_buffer_ref{});
+                    }
+                }
+            }
+        }
         while (limit > 0) {
             auto load_result = this->lf_line_buffer.load_next_line(prev_range);
             if (load_result.isErr()) {
@@ -1864,10 +3283,6 @@ logfile::rebuild_index(std::optional<ui_clock::time_point> deadline)
                             = bookmark_metadata::meta_source::format;
                     }
                 }
-
-                if (!this->back().is_continued()) {
-                    lnav::log::watch::eval_with(*this, this->end() - 1);
-                }
             }
 
             if (li.li_partial) {
@@ -1884,6 +3299,18 @@ logfile::rebuild_index(std::optional<ui_clock::time_point> deadline)
             limit -= 1;
         }
 
+        // The watch expressions are checked in one pass over the new lines,
+        // starting with the ones that were rolled back since their content
+        // might have changed.
+        if (has_format) {
+            this->eval_watch_exprs_from(
+                rollback_size > 0 ? rollback_index_start : begin_size);
+        }
+        // Only the columns that have been used in a query are indexed.
+        if (has_format && !this->lf_column_indexes.empty()) {
+            this->update_column_indexes();
+        }
+
         if (this->lf_format == nullptr
             && this->lf_options.loo_visible_size_limit > 0
             && prev_range.fr_offset > 256 * 1024
@@ -2021,14 +3448,26 @@ logfile::rebuild_index(std::optional<ui_clock::time_point> deadline)
                 log_debug("stats[] p25=%f p50=%f p75=%f", p25, p50, p75);
             }
         }
+
+        if (this->lf_index_size >= st.st_size) {
+            this->save_index_cache(st);
+        }
     } else {
         this->lf_stat = st;
         if (this->lf_sort_needed) {
             retval = rebuild_result_t::NEW_ORDER;
             this->lf_sort_needed = false;
         }
+        if (this->lf_format != nullptr) {
+            // Nothing was appended to a partial last line since the last
+            // rebuild, so it is checked now instead of waiting for a
+            // newline that might never come.
+            this->eval_watch_exprs_for_partial_line();
+        }
     }
 
+    this->update_search_index(st);
+
     this->lf_index_time
         = std::chrono::seconds{this->lf_line_buffer.get_file_time()};
     if (this->lf_index_time.count() == 0) {
@@ -2525,6 +3964,11 @@ logfile::dump_stats()
     log_info("  preads=%u", buf_stats.s_preads);
     log_info("  requested_preloads=%u", buf_stats.s_requested_preloads);
     log_info("  used_preloads=%u", buf_stats.s_used_preloads);
+    log_info("  uring_reads=%u", buf_stats.s_uring_reads);
+    log_info("  readaheads=%u (%llu bytes)",
+             buf_stats.s_readaheads,
+             (unsigned long long) buf_stats.s_readahead_bytes);
+    log_info("  mapped_reads=%u", buf_stats.s_mapped_reads);
 }
 
 void
@@ -32,10 +32,20 @@
 #ifndef lnav_logfile_cfg_hh
 #define lnav_logfile_cfg_hh
 
+#include <chrono>
+
 namespace lnav::logfile {
 
 struct config {
     uint64_t lc_max_unrecognized_lines{1000};
+    uint64_t lc_index_cache_min_size{64 * 1024 * 1024};
+    std::chrono::seconds lc_index_cache_ttl{std::chrono::hours(7 * 24)};
+    uint64_t lc_column_cache_max_size{128 * 1024 * 1024};
+    uint64_t lc_search_index_min_size{128 * 1024 * 1024};
+    uint64_t lc_value_index_max_size{64 * 1024 * 1024};
+    uint64_t lc_parallel_index_chunk_size{32 * 1024 * 1024};
+    uint64_t lc_background_filter_min_lines{100 * 1000};
+    uint64_t lc_background_filter_chunk_lines{64 * 1024};
 };
 
 }  // namespace lnav::logfile
@@ -0,0 +1,325 @@
+/**
+ * Copyright (c) 2026, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file logfile.column_cache.cc
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
+#include "logfile.column_cache.hh"
+
+#include "base/injector.hh"
+#include "base/lnav_log.hh"
+#include "log_format.hh"
+#include "logfile.cfg.hh"
+
+namespace lnav {
+
+namespace {
+
+struct cache_registry {
+    std::mutex cr_mutex;
+    std::vector<column_cache*> cr_caches;
+    size_t cr_total_size{0};
+};
+
+cache_registry&
+registry()
+{
+    static auto* retval = new cache_registry();
+
+    return *retval;
+}
+
+std::atomic<uint64_t> last_used_tick{0};
+
+}  // namespace
+
+column_cache::cached_value
+column_cache::to_cached_value(const logline_value& lv)
+{
+    cached_value retval;
+
+    if (!lv.lv_meta.lvm_struct_name.empty()) {
+        retval.cv_kind = cell_kind::uncached;
+        return retval;
+    }
+
+    switch (lv.lv_meta.lvm_kind) {
+        case value_kind_t::VALUE_NULL:
+            retval.cv_kind = cell_kind::none;
+            break;
+        case value_kind_t::VALUE_BOOLEAN:
+            retval.cv_kind = cell_kind::boolean;
+            retval.cv_value.cv_int = lv.lv_value.i;
+            break;
+        case value_kind_t::VALUE_INTEGER:
+            retval.cv_kind = cell_kind::integer;
+            retval.cv_value.cv_int = lv.lv_value.i;
+            break;
+        case value_kind_t::VALUE_FLOAT:
+            retval.cv_kind = cell_kind::real;
+            retval.cv_value.cv_real = lv.lv_value.d;
+            break;
+        case value_kind_t::VALUE_TEXT:
+            // Only identifiers are interned since they come from a small
+            // set of values, interning arbitrary text would never be freed.
+            if (lv.lv_meta.lvm_identifier) {
+                retval.cv_kind = cell_kind::text;
+                retval.cv_value.cv_text
+                    = intern_string::lookup(lv.text_value_fragment());
+            } else {
+                retval.cv_kind = cell_kind::uncached;
+            }
+            break;
+        default:
+            retval.cv_kind = cell_kind::uncached;
+            break;
+    }
+
+    return retval;
+}
+
+column_cache::column_cache()
+{
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lg(reg.cr_mutex);
+
+    reg.cr_caches.emplace_back(this);
+}
+
+column_cache::~column_cache()
+{
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lg(reg.cr_mutex);
+
+    reg.cr_total_size -= this->cc_size;
+    std::erase(reg.cr_caches, this);
+}
+
+void
+column_cache::sync(int index_generation)
+{
+    if (this->cc_generation == index_generation) {
+        return;
+    }
+
+    this->clear();
+    this->cc_generation = index_generation;
+}
+
+std::optional<column_cache::cached_value>
+column_cache::lookup(size_t line, intern_string_t name)
+{
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lg(reg.cr_mutex);
+
+    return this->lookup_internal(line, name);
+}
+
+std::optional<column_cache::cached_value>
+column_cache::lookup(size_t line, logline_value_meta::table_column col)
+{
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lg(reg.cr_mutex);
+
+    auto iter = this->cc_table_columns.find(col.value);
+    if (iter == this->cc_table_columns.end()) {
+        return std::nullopt;
+    }
+
+    return this->lookup_internal(line, iter->second);
+}
+
+std::optional<column_cache::cached_value>
+column_cache::lookup_internal(size_t line, intern_string_t name)
+{
+    if (!this->is_recorded(line)) {
+        return std::nullopt;
+    }
+
+    this->cc_last_used = ++last_used_tick;
+
+    cached_value retval;
+    auto iter = this->cc_columns.find(name);
+    if (iter == this->cc_columns.end() || line >= iter->second.c_kinds.size()
+        || iter->second.c_kinds[line] == cell_kind::unknown)
+    {
+        // The line was recorded without a value for this column.
+        return retval;
+    }
+
+    retval.cv_kind = iter->second.c_kinds[line];
+    retval.cv_value = iter->second.c_values[line];
+    return retval;
+}
+
+void
+column_cache::record(size_t line, const std::vector<logline_value>& values)
+{
+    static const auto& cfg = injector::get<const lnav::logfile::config&>();
+
+    if (cfg.lc_column_cache_max_size == 0) {
+        return;
+    }
+
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lg(reg.cr_mutex);
+
+    if (this->cc_full || this->is_recorded(line)) {
+        return;
+    }
+
+    for (const auto& lv : values) {
+        auto& col = this->cc_columns[lv.lv_meta.lvm_name];
+
+        if (line >= col.c_kinds.size()) {
+            col.c_kinds.resize(line + 1, cell_kind::unknown);
+            col.c_values.resize(line + 1);
+        } else if (col.c_kinds[line] != cell_kind::unknown) {
+            continue;
+        }
+
+        auto cv = to_cached_value(lv);
+        col.c_kinds[line] = cv.cv_kind;
+        col.c_values[line] = cv.cv_value;
+
+        if (lv.lv_meta.lvm_struct_name.empty()
+            && lv.lv_meta.lvm_column.is<logline_value_meta::table_column>())
+        {
+            auto tc
+                = lv.lv_meta.lvm_column.get<logline_value_meta::table_column>();
+
+            this->cc_table_columns.emplace(tc.value, lv.lv_meta.lvm_name);
+        }
+    }
+    if (line >= this->cc_recorded.size()) {
+        this->cc_recorded.resize(line + 1);
+    }
+    this->cc_recorded[line] = true;
+    this->cc_last_used = ++last_used_tick;
+
+    auto new_size = this->compute_size();
+    reg.cr_total_size += new_size - this->cc_size;
+    this->cc_size = new_size;
+
+    while (reg.cr_total_size > cfg.lc_column_cache_max_size) {
+        column_cache* lru = nullptr;
+
+        for (auto* cc : reg.cr_caches) {
+            if (cc == this || cc->cc_size == 0) {
+                continue;
+            }
+            if (lru == nullptr || cc->cc_last_used < lru->cc_last_used) {
+                lru = cc;
+            }
+        }
+        if (lru == nullptr) {
+            break;
+        }
+
+        log_info("evicting column cache with %zu bytes", lru->cc_size);
+        reg.cr_total_size -= lru->cc_size;
+        lru->clear_internal();
+    }
+
+    if (reg.cr_total_size > cfg.lc_column_cache_max_size) {
+        log_info("column cache is full at %zu bytes, no longer recording",
+                 this->cc_size);
+        reg.cr_total_size -= this->cc_size;
+        this->clear_internal();
+        this->cc_full = true;
+    }
+}
+
+void
+column_cache::truncate(size_t line_count)
+{
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lg(reg.cr_mutex);
+
+    if (line_count >= this->cc_recorded.size()) {
+        return;
+    }
+
+    this->cc_recorded.resize(line_count);
+    for (auto& col_pair : this->cc_columns) {
+        auto& col = col_pair.second;
+
+        if (line_count < col.c_kinds.size()) {
+            col.c_kinds.resize(line_count);
+            col.c_values.resize(line_count);
+        }
+    }
+}
+
+void
+column_cache::clear()
+{
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lg(reg.cr_mutex);
+
+    reg.cr_total_size -= this->cc_size;
+    this->clear_internal();
+    this->cc_full = false;
+}
+
+size_t
+column_cache::get_size() const
+{
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lg(reg.cr_mutex);
+
+    return this->cc_size;
+}
+
+size_t
+column_cache::compute_size() const
+{
+    size_t retval = this->cc_recorded.capacity() / 8;
+
+    for (const auto& col_pair : this->cc_columns) {
+        retval += col_pair.second.c_kinds.capacity() * sizeof(cell_kind)
+            + col_pair.second.c_values.capacity() * sizeof(cell_value);
+    }
+
+    return retval;
+}
+
+void
+column_cache::clear_internal()
+{
+    this->cc_size = 0;
+    this->cc_recorded = std::vector<bool>();
+    this->cc_columns.clear();
+    this->cc_table_columns.clear();
+}
+
+}  // namespace lnav
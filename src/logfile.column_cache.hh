@@ -0,0 +1,153 @@
+/**
+ * Copyright (c) 2026, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file logfile.column_cache.hh
+ */
+
+#ifndef lnav_logfile_column_cache_hh
+#define lnav_logfile_column_cache_hh
+
+#include <map>
+#include <optional>
+#include <vector>
+
+#include <stdint.h>
+
+#include "base/intern_string.hh"
+#include "log_format_fwd.hh"
+
+namespace lnav {
+
+/**
+ * An in-memory, column-oriented copy of the values extracted from the
+ * messages in a log file.  Extracting values requires reading and parsing
+ * the whole message, which is expensive when a view like the spectrogram
+ * or a SQL query only needs one or two columns over many lines.  The cache
+ * is filled as messages are parsed and is bounded by the
+ * "/tuning/logfile/column-cache-max-size" setting.  When the total size of
+ * all caches exceeds the limit, the caches of the least-recently-used files
+ * are dropped.
+ *
+ * Only scalar values and identifier strings are cached, other values are
+ * reported as uncached and must be extracted from the message.
+ *
+ * Recording a value in one cache can evict the values of another, so all
+ * of the caches are guarded by a single mutex.  The caches can then be
+ * used from the threads that index or query files.
+ */
+class column_cache {
+public:
+    enum class cell_kind : uint8_t {
+        unknown,
+        none,
+        boolean,
+        integer,
+        real,
+        text,
+        uncached,
+    };
+
+    union cell_value {
+        int64_t cv_int;
+        double cv_real;
+        const intern_string* cv_text;
+    };
+
+    struct cached_value {
+        cell_kind cv_kind{cell_kind::none};
+        cell_value cv_value{0};
+
+        intern_string_t get_text() const { return this->cv_value.cv_text; }
+    };
+
+    static cached_value to_cached_value(const logline_value& lv);
+
+    column_cache();
+
+    column_cache(const column_cache&) = delete;
+    column_cache& operator=(const column_cache&) = delete;
+
+    ~column_cache();
+
+    /**
+     * Drop the cached values if the index of the file was rebuilt since
+     * they were recorded.
+     */
+    void sync(int index_generation);
+
+    /**
+     * @return The cached value of the named column for the given line or
+     * nullopt if the line has not been recorded.
+     */
+    std::optional<cached_value> lookup(size_t line, intern_string_t name);
+
+    std::optional<cached_value> lookup(
+        size_t line, logline_value_meta::table_column col);
+
+    /**
+     * Save the values extracted from the message at the given line.
+     */
+    void record(size_t line, const std::vector<logline_value>& values);
+
+    /** Drop the values for lines at or after the given line. */
+    void truncate(size_t line_count);
+
+    void clear();
+
+    size_t get_size() const;
+
+private:
+    struct column {
+        std::vector<cell_kind> c_kinds;
+        std::vector<cell_value> c_values;
+    };
+
+    bool is_recorded(size_t line) const
+    {
+        return line < this->cc_recorded.size() && this->cc_recorded[line];
+    }
+
+    std::optional<cached_value> lookup_internal(size_t line,
+                                                intern_string_t name);
+
+    size_t compute_size() const;
+
+    void clear_internal();
+
+    int cc_generation{0};
+    size_t cc_size{0};
+    uint64_t cc_last_used{0};
+    bool cc_full{false};
+    std::vector<bool> cc_recorded;
+    std::map<intern_string_t, column> cc_columns;
+    std::map<size_t, intern_string_t> cc_table_columns;
+};
+
+}  // namespace lnav
+
+#endif
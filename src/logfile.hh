@@ -32,8 +32,11 @@
 #ifndef logfile_hh
 #define logfile_hh
 
+#include <atomic>
 #include <chrono>
 #include <filesystem>
+#include <future>
+#include <map>
 #include <string>
 #include <utility>
 #include <vector>
@@ -55,8 +58,11 @@
 #include "file_options.hh"
 #include "line_buffer.hh"
 #include "log_format_fwd.hh"
+#include "logfile.column_cache.hh"
+#include "logfile.search_index.hh"
 #include "logfile_fwd.hh"
 #include "mapbox/variant.hpp"
+#include "robin_hood/robin_hood.h"
 #include "safe/safe.h"
 #include "shared_buffer.hh"
 #include "unique_path.hh"
@@ -79,6 +85,13 @@ public:
     virtual lnav::progress_result_t logfile_indexing(const logfile* lf,
                                                      file_off_t off,
                                                      file_ssize_t total) = 0;
+
+    /**
+     * @return True if the indexing should be stopped.  This can be called
+     * from a worker thread, so it should only look at state that is safe to
+     * read concurrently.
+     */
+    virtual bool logfile_indexing_interrupted() const { return false; }
 };
 
 struct logfile_activity {
@@ -160,6 +173,8 @@ public:
 
     bool is_compressed() const { return this->lf_line_buffer.is_compressed(); }
 
+    bool is_pipe() const { return this->lf_line_buffer.is_pipe(); }
+
     bool has_line_metadata() const
     {
         return this->lf_line_buffer.has_line_metadata();
@@ -180,6 +195,53 @@ public:
 
     int get_index_generation() const { return this->lf_index_generation; }
 
+    /**
+     * @return The cache of values extracted from the messages in this file.
+     */
+    lnav::column_cache& get_column_cache() const
+    {
+        this->lf_column_cache.sync(this->lf_index_generation);
+        return this->lf_column_cache;
+    }
+
+    /** The lines in this file that have each value of a column. */
+    struct column_index {
+        robin_hood::unordered_map<string_fragment,
+                                  std::vector<uint32_t>,
+                                  frag_hasher>
+            ci_value_to_lines;
+        /** The number of lines at the start of the file that are indexed. */
+        size_t ci_line_count{0};
+
+        ArenaAlloc::Alloc<char> ci_string_arena;
+    };
+
+    /**
+     * Get the index from the values of a column in the format's table to
+     * the lines that have them.  The index is built the first time it is
+     * requested and is then extended by rebuild_index() as lines are
+     * appended.
+     *
+     * @return The index or nullptr if the file does not have a format or
+     * the indexes for this file have grown past the
+     * "/tuning/logfile/value-index-max-size" setting.
+     */
+    const column_index* get_column_index(
+        logline_value_meta::table_column col);
+
+    /**
+     * Check the search index to see if any of the lines in the range
+     * [start, end) might contain all of the given literals.
+     *
+     * @return False if none of the lines can match, true otherwise.
+     */
+    bool lines_may_contain(size_t start,
+                           size_t end,
+                           const std::vector<std::string>& literals) const
+    {
+        return this->lf_search_index.may_contain(start, end, literals);
+    }
+
     file_ssize_t get_content_size() const
     {
         auto lb_size = this->lf_line_buffer.get_file_size();
@@ -391,8 +453,41 @@ public:
         this->lf_logfile_observer = lo;
     }
 
+    logfile_observer* get_logfile_observer() const
+    {
+        return this->lf_logfile_observer;
+    }
+
     void set_logline_observer(logline_observer* llo);
 
+    /**
+     * Replace the logline observer without replaying the existing lines to
+     * the new observer.
+     *
+     * @return The previous observer.
+     */
+    logline_observer* exchange_logline_observer(logline_observer* llo)
+    {
+        return std::exchange(this->lf_logline_observer, llo);
+    }
+
+    /**
+     * @return True if indexing new data in this file does not touch any
+     * state that is shared with other files, so rebuild_index() can be
+     * called on a thread other than the main one.  The observers must be
+     * swapped out for ones that are safe to call from the other thread.
+     */
+    bool can_index_concurrently() const;
+
+    /**
+     * Limit the number of threads used to index a large file in parallel.
+     * A limit of zero means one thread per hardware thread.
+     */
+    void set_index_thread_limit(size_t limit)
+    {
+        this->lf_index_thread_limit = limit;
+    }
+
     logline_observer* get_logline_observer() const
     {
         return this->lf_logline_observer;
@@ -547,6 +642,8 @@ protected:
 
     void set_format_base_time(log_format* lf, const line_info& li);
 
+    void log_prefilter_rejects();
+
 private:
     logfile(std::filesystem::path filename, const logfile_open_options& loo);
 
@@ -554,6 +651,60 @@ private:
 
     void reset_internal_state_for_reindex();
 
+    bool index_cache_is_applicable() const;
+
+    void restore_index_cache(const struct stat& st);
+
+    /**
+     * Evaluate the watch expressions against the messages starting at the
+     * given line that have not been checked yet.
+     */
+    void eval_watch_exprs_from(size_t start);
+
+    /**
+     * Evaluate the watch expressions against a partial last line that has
+     * not changed since the last rebuild, like the end of a file that is
+     * not terminated by a newline.
+     */
+    void eval_watch_exprs_for_partial_line();
+
+    Result<void, std::string> load_index_cache(auto_fd fd,
+                                               const struct stat& st);
+
+    void save_index_cache(const struct stat& st);
+
+    bool search_index_is_applicable(const struct stat& st) const;
+
+    void update_search_index(const struct stat& st);
+
+    void reset_search_index();
+
+    void restore_search_index(const struct stat& st);
+
+    void save_search_index(const struct stat& st);
+
+    void update_column_indexes();
+
+    void truncate_column_indexes(size_t line_count);
+
+    size_t index_thread_count() const;
+
+    file_off_t parallel_index_extent(file_off_t off,
+                                     const struct stat& st,
+                                     size_t limit) const;
+
+    bool parallel_index_is_applicable(file_off_t off,
+                                      const struct stat& st,
+                                      size_t limit) const;
+
+    std::optional<file_range> index_in_parallel(
+        file_off_t off,
+        const struct stat& st,
+        scan_batch_context& sbc,
+        bool& sort_needed,
+        size_t& limit,
+        std::optional<ui_clock::time_point> deadline);
+
     std::filesystem::path lf_filename;
     std::string lf_filename_as_string;
     logfile_open_options lf_options;
@@ -578,6 +729,8 @@ private:
     bool lf_is_closed{false};
     bool lf_indexing{true};
     bool lf_partial_line{false};
+    file_off_t lf_watch_checked_offset{-1};
+    std::optional<file_range> lf_watch_partial_range;
     bool lf_zoned_to_local_state{true};
     robin_hood::unordered_set<string_fragment,
                               frag_hasher,
@@ -598,10 +751,25 @@ private:
     ArenaAlloc::Alloc<char> lf_allocator{64 * 1024};
     std::optional<time_t> lf_cached_base_time;
     std::optional<tm> lf_cached_base_tm;
+    bool lf_index_cache_checked{false};
+    file_off_t lf_index_cache_size{0};
+    mutable lnav::column_cache lf_column_cache;
+    lnav::search_index lf_search_index;
+    std::map<size_t, column_index> lf_column_indexes;
+    size_t lf_column_indexes_size{0};
+    bool lf_column_indexes_full{false};
+    std::future<std::vector<lnav::search_index::block_trigrams>>
+        lf_search_index_future;
+    std::atomic<bool> lf_search_index_cancelled{false};
+    bool lf_search_index_checked{false};
+    file_off_t lf_search_index_saved_size{0};
+    std::vector<ArenaAlloc::Alloc<char>> lf_chunk_allocators;
+    size_t lf_index_thread_limit{0};
 
     std::optional<std::pair<file_off_t, size_t>> lf_next_line_cache;
     robin_hood::unordered_set<intern_string_t, intern_hasher>
         lf_mismatched_formats;
+    std::map<intern_string_t, size_t> lf_prefilter_rejects;
     robin_hood::unordered_map<uint32_t, bookmark_metadata> lf_bookmark_metadata;
 
     std::vector<std::shared_ptr<format_tag_def>> lf_applicable_taggers;
@@ -654,6 +822,16 @@ public:
     virtual void logline_restart(const logfile& lf, file_size_t rollback_size)
         = 0;
 
+    /**
+     * @return True if logline_new_lines() needs to be passed the content of
+     * each line.  Lines restored from the index cache are only read back
+     * from the file when this returns true.
+     */
+    virtual bool logline_needs_content(const logfile& lf) const
+    {
+        return true;
+    }
+
     virtual bool logline_new_lines(const logfile& lf,
                                    logfile::const_iterator ll_begin,
                                    logfile::const_iterator ll_end,
@@ -0,0 +1,539 @@
+/**
+ * Copyright (c) 2026, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file logfile.index_cache.cc
+ */
+
+#include <algorithm>
+#include <chrono>
+
+#include "logfile.index_cache.hh"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "base/fs_util.hh"
+#include "base/injector.hh"
+#include "base/lnav_log.hh"
+#include "base/paths.hh"
+#include "config.h"
+#include "fmt/format.h"
+#include "hasher.hh"
+#include "logfile.cfg.hh"
+
+namespace lnav::logfile::index_cache {
+
+static constexpr size_t BUFFER_SIZE = 256 * 1024;
+
+std::filesystem::path
+cache_path()
+{
+    return lnav::paths::workdir() / "index-cache";
+}
+
+static Result<size_t, std::string>
+pread_fully(int fd, char* buf, size_t len, file_off_t off)
+{
+    size_t total = 0;
+
+    while (total < len) {
+        auto rc = pread(fd, &buf[total], len - total, off + total);
+        if (rc == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return Err(fmt::format(FMT_STRING("pread failed -- {}"),
+                                   lnav::from_errno()));
+        }
+        if (rc == 0) {
+            break;
+        }
+        total += rc;
+    }
+
+    return Ok(total);
+}
+
+Result<std::filesystem::path, std::string>
+path_for(const struct stat& st, int fd)
+{
+    auto head = auto_buffer::alloc(HEAD_FINGERPRINT_SIZE);
+    auto head_len = TRY(pread_fully(fd, head.in(), HEAD_FINGERPRINT_SIZE, 0));
+
+    auto base_name = hasher()
+                         .update(st.st_dev)
+                         .update(st.st_ino)
+                         .update(head.in(), head_len)
+                         .to_string();
+
+    return Ok(cache_path() / base_name.substr(0, 2)
+              / fmt::format(FMT_STRING("{}.idx"), base_name));
+}
+
+Result<std::string, std::string>
+tail_fingerprint(int fd, file_off_t end)
+{
+    char buf[TAIL_FINGERPRINT_SIZE];
+    auto start = std::max(file_off_t{0},
+                          end - static_cast<file_off_t>(sizeof(buf)));
+    auto len = TRY(pread_fully(fd, buf, end - start, start));
+
+    if (start + static_cast<file_off_t>(len) != end) {
+        return Err(std::string("file is shorter than the indexed size"));
+    }
+
+    return Ok(hasher().update(end).update(buf, len).to_string());
+}
+
+writer::writer(auto_fd fd) : w_fd(std::move(fd))
+{
+    this->w_buffer.reserve(BUFFER_SIZE);
+}
+
+writer&
+writer::write(const void* data, size_t len)
+{
+    if (this->w_error) {
+        return *this;
+    }
+
+    if (this->w_buffer.size() + len > BUFFER_SIZE) {
+        auto flush_res = this->flush();
+        if (flush_res.isErr()) {
+            this->w_error = flush_res.unwrapErr();
+            return *this;
+        }
+    }
+
+    if (len >= BUFFER_SIZE) {
+        // Large blocks, like the line index, are written straight through.
+        const auto* bits = static_cast<const char*>(data);
+        while (len > 0) {
+            auto rc = ::write(this->w_fd, bits, len);
+            if (rc == -1) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                this->w_error = fmt::format(FMT_STRING("write failed -- {}"),
+                                            lnav::from_errno());
+                return *this;
+            }
+            bits += rc;
+            len -= rc;
+        }
+        return *this;
+    }
+
+    const auto* bits = static_cast<const char*>(data);
+    this->w_buffer.insert(this->w_buffer.end(), bits, bits + len);
+
+    return *this;
+}
+
+writer&
+writer::write_str(string_fragment sf)
+{
+    this->write_pod(static_cast<uint32_t>(sf.length()));
+    return this->write(sf.data(), sf.length());
+}
+
+writer&
+writer::write_range(const time_range& tr)
+{
+    this->write_pod(static_cast<int64_t>(tr.tr_begin.count()));
+    return this->write_pod(static_cast<int64_t>(tr.tr_end.count()));
+}
+
+writer&
+writer::write_level_stats(const log_level_stats& lls)
+{
+    return this->write_pod(lls);
+}
+
+writer&
+writer::write_value_stats(const std::vector<logline_value_stats>& stats)
+{
+    this->write_pod(static_cast<uint32_t>(stats.size()));
+    for (const auto& lvs : stats) {
+        this->write_pod(lvs.lvs_width)
+            .write_pod(lvs.lvs_count)
+            .write_pod(lvs.lvs_total)
+            .write_pod(lvs.lvs_min_value)
+            .write_pod(lvs.lvs_max_value);
+
+        auto centroids = lvs.lvs_tdigest.get();
+        this->write_pod(static_cast<uint32_t>(centroids.size()));
+        for (const auto& cent : centroids) {
+            this->write_pod(cent.first).write_pod(cent.second);
+        }
+    }
+
+    return *this;
+}
+
+writer&
+writer::write_opids(const log_opid_state& los)
+{
+    this->write_pod(static_cast<uint64_t>(los.los_opid_ranges.size()));
+    for (const auto& opid_pair : los.los_opid_ranges) {
+        const auto& otr = opid_pair.second;
+
+        this->write_str(opid_pair.first)
+            .write_range(otr.otr_range)
+            .write_level_stats(otr.otr_level_stats);
+
+        const auto& desc = otr.otr_description;
+        this->write_pod(static_cast<uint8_t>(desc.lod_index.has_value()))
+            .write_pod(static_cast<uint64_t>(desc.lod_index.value_or(0)))
+            .write_pod(static_cast<uint32_t>(desc.lod_elements.values().size()));
+        for (const auto& elem : desc.lod_elements) {
+            this->write_pod(static_cast<uint64_t>(elem.first))
+                .write_str(elem.second);
+        }
+
+        this->write_pod(static_cast<uint32_t>(otr.otr_sub_ops.size()));
+        for (const auto& sub : otr.otr_sub_ops) {
+            this->write_str(sub.ostr_subid)
+                .write_range(sub.ostr_range)
+                .write_pod(static_cast<uint8_t>(sub.ostr_open))
+                .write_level_stats(sub.ostr_level_stats)
+                .write_str(sub.ostr_description);
+        }
+    }
+
+    return *this;
+}
+
+writer&
+writer::write_tids(const log_thread_id_state& ltis)
+{
+    this->write_pod(static_cast<uint64_t>(ltis.ltis_tid_ranges.size()));
+    for (const auto& tid_pair : ltis.ltis_tid_ranges) {
+        this->write_str(tid_pair.first)
+            .write_range(tid_pair.second.titr_range)
+            .write_level_stats(tid_pair.second.titr_level_stats);
+    }
+
+    return *this;
+}
+
+Result<void, std::string>
+writer::flush()
+{
+    const auto* bits = this->w_buffer.data();
+    auto len = this->w_buffer.size();
+
+    while (len > 0) {
+        auto rc = ::write(this->w_fd, bits, len);
+        if (rc == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return Err(fmt::format(FMT_STRING("write failed -- {}"),
+                                   lnav::from_errno()));
+        }
+        bits += rc;
+        len -= rc;
+    }
+    this->w_buffer.clear();
+
+    return Ok();
+}
+
+Result<void, std::string>
+writer::finish()
+{
+    if (this->w_error) {
+        return Err(this->w_error.value());
+    }
+
+    TRY(this->flush());
+    this->w_fd.reset();
+
+    return Ok();
+}
+
+reader::reader(auto_fd fd) : r_fd(std::move(fd))
+{
+    struct stat st;
+
+    if (fstat(this->r_fd, &st) == 0 && st.st_size > 0) {
+        this->r_remaining = st.st_size;
+    }
+}
+
+Result<void, std::string>
+reader::check_count(uint64_t count, size_t min_size)
+{
+    if (count > this->r_remaining / std::max(min_size, size_t{1})) {
+        return Err(fmt::format(
+            FMT_STRING("count {} exceeds the remaining {} bytes in the file"),
+            count,
+            this->r_remaining));
+    }
+
+    return Ok();
+}
+
+Result<void, std::string>
+reader::read(void* data, size_t len)
+{
+    auto* bits = static_cast<char*>(data);
+
+    if (len > this->r_remaining) {
+        return Err(std::string("unexpected end of file"));
+    }
+    this->r_remaining -= len;
+    while (len > 0) {
+        auto avail = this->r_buffer.size() - this->r_offset;
+        if (avail > 0) {
+            auto amount = std::min(avail, len);
+
+            memcpy(bits, &this->r_buffer[this->r_offset], amount);
+            this->r_offset += amount;
+            bits += amount;
+            len -= amount;
+            continue;
+        }
+
+        if (len >= BUFFER_SIZE) {
+            auto rc = ::read(this->r_fd, bits, len);
+            if (rc == -1) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return Err(fmt::format(FMT_STRING("read failed -- {}"),
+                                       lnav::from_errno()));
+            }
+            if (rc == 0) {
+                return Err(std::string("unexpected end of file"));
+            }
+            bits += rc;
+            len -= rc;
+            continue;
+        }
+
+        this->r_buffer.resize(BUFFER_SIZE);
+        this->r_offset = 0;
+        auto rc = ::read(this->r_fd, this->r_buffer.data(), BUFFER_SIZE);
+        if (rc == -1) {
+            this->r_buffer.clear();
+            if (errno == EINTR) {
+                continue;
+            }
+            return Err(fmt::format(FMT_STRING("read failed -- {}"),
+                                   lnav::from_errno()));
+        }
+        this->r_buffer.resize(rc);
+        if (rc == 0) {
+            return Err(std::string("unexpected end of file"));
+        }
+    }
+
+    return Ok();
+}
+
+Result<std::string, std::string>
+reader::read_str()
+{
+    auto len = TRY(this->read_pod<uint32_t>());
+    std::string retval;
+
+    TRY(this->check_count(len, 1));
+    retval.resize(len);
+    TRY(this->read(retval.data(), len));
+
+    return Ok(std::move(retval));
+}
+
+Result<string_fragment, std::string>
+reader::read_frag(ArenaAlloc::Alloc<char>& alloc)
+{
+    auto len = TRY(this->read_pod<uint32_t>());
+    TRY(this->check_count(len, 1));
+    auto* bits = alloc.allocate(len + 1);
+
+    TRY(this->read(bits, len));
+    bits[len] = '\0';
+
+    return Ok(string_fragment::from_bytes(bits, len));
+}
+
+Result<time_range, std::string>
+reader::read_range()
+{
+    auto begin = TRY(this->read_pod<int64_t>());
+    auto end = TRY(this->read_pod<int64_t>());
+
+    return Ok(time_range{
+        std::chrono::microseconds{begin},
+        std::chrono::microseconds{end},
+    });
+}
+
+Result<log_level_stats, std::string>
+reader::read_level_stats()
+{
+    return this->read_pod<log_level_stats>();
+}
+
+Result<std::vector<logline_value_stats>, std::string>
+reader::read_value_stats()
+{
+    auto count = TRY(this->read_pod<uint32_t>());
+    std::vector<logline_value_stats> retval;
+
+    // width, count, total, min, max and the centroid count
+    TRY(this->check_count(count, 5 * sizeof(int64_t) + sizeof(uint32_t)));
+    retval.resize(count);
+    for (auto& lvs : retval) {
+        lvs.lvs_width = TRY(this->read_pod<int64_t>());
+        lvs.lvs_count = TRY(this->read_pod<int64_t>());
+        lvs.lvs_total = TRY(this->read_pod<double>());
+        lvs.lvs_min_value = TRY(this->read_pod<double>());
+        lvs.lvs_max_value = TRY(this->read_pod<double>());
+
+        auto cent_count = TRY(this->read_pod<uint32_t>());
+        for (uint32_t lpc = 0; lpc < cent_count; lpc++) {
+            auto mean = TRY(this->read_pod<double>());
+            auto weight = TRY(this->read_pod<unsigned int>());
+
+            lvs.lvs_tdigest.insert(mean, weight);
+        }
+        lvs.lvs_tdigest.merge();
+    }
+
+    return Ok(std::move(retval));
+}
+
+Result<void, std::string>
+reader::read_opids(ArenaAlloc::Alloc<char>& alloc, log_opid_state& los_out)
+{
+    auto count = TRY(this->read_pod<uint64_t>());
+
+    TRY(this->check_count(count, sizeof(uint32_t)));
+    los_out.los_opid_ranges.reserve(count);
+    for (uint64_t lpc = 0; lpc < count; lpc++) {
+        auto opid = TRY(this->read_frag(alloc));
+        opid_time_range otr;
+
+        otr.otr_range = TRY(this->read_range());
+        otr.otr_level_stats = TRY(this->read_level_stats());
+
+        auto has_index = TRY(this->read_pod<uint8_t>());
+        auto index = TRY(this->read_pod<uint64_t>());
+        if (has_index) {
+            otr.otr_description.lod_index = index;
+        }
+        auto elem_count = TRY(this->read_pod<uint32_t>());
+        for (uint32_t elem_index = 0; elem_index < elem_count; elem_index++) {
+            auto key = TRY(this->read_pod<uint64_t>());
+            auto value = TRY(this->read_str());
+
+            otr.otr_description.lod_elements.insert(key, std::move(value));
+        }
+
+        auto sub_count = TRY(this->read_pod<uint32_t>());
+        TRY(this->check_count(sub_count, sizeof(uint32_t)));
+        otr.otr_sub_ops.reserve(sub_count);
+        for (uint32_t sub_index = 0; sub_index < sub_count; sub_index++) {
+            opid_sub_time_range ostr;
+
+            ostr.ostr_subid = TRY(this->read_frag(alloc));
+            ostr.ostr_range = TRY(this->read_range());
+            ostr.ostr_open = TRY(this->read_pod<uint8_t>()) != 0;
+            ostr.ostr_level_stats = TRY(this->read_level_stats());
+            ostr.ostr_description = TRY(this->read_str());
+            otr.otr_sub_ops.emplace_back(std::move(ostr));
+        }
+
+        los_out.los_opid_ranges.emplace(opid, std::move(otr));
+    }
+
+    return Ok();
+}
+
+Result<void, std::string>
+reader::read_tids(ArenaAlloc::Alloc<char>& alloc,
+                  log_thread_id_state& ltis_out)
+{
+    auto count = TRY(this->read_pod<uint64_t>());
+
+    TRY(this->check_count(count, sizeof(uint32_t)));
+    ltis_out.ltis_tid_ranges.reserve(count);
+    for (uint64_t lpc = 0; lpc < count; lpc++) {
+        auto tid = TRY(this->read_frag(alloc));
+        thread_id_time_range titr;
+
+        titr.titr_range = TRY(this->read_range());
+        titr.titr_level_stats = TRY(this->read_level_stats());
+        ltis_out.ltis_tid_ranges.emplace(tid, titr);
+    }
+
+    return Ok();
+}
+
+std::future<void>
+cleanup()
+{
+    return std::async(
+        std::launch::async, +[]() {
+            auto now = std::filesystem::file_time_type::clock::now();
+            const auto& cfg = injector::get<const config&>();
+            std::vector<std::filesystem::path> to_remove;
+            std::error_code ec;
+
+            for (const auto& cache_subdir :
+                 std::filesystem::directory_iterator(cache_path(), ec))
+            {
+                for (const auto& entry :
+                     std::filesystem::directory_iterator(cache_subdir, ec))
+                {
+                    auto mtime
+                        = std::filesystem::last_write_time(entry.path(), ec);
+                    if (ec) {
+                        continue;
+                    }
+                    auto exp_time = mtime + cfg.lc_index_cache_ttl;
+                    if (now < exp_time) {
+                        continue;
+                    }
+
+                    to_remove.emplace_back(entry.path());
+                }
+            }
+
+            for (auto& entry : to_remove) {
+                log_debug("removing index cache: %s", entry.c_str());
+                std::filesystem::remove(entry, ec);
+            }
+        });
+}
+
+}  // namespace lnav::logfile::index_cache
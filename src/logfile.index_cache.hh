@@ -0,0 +1,183 @@
+/**
+ * Copyright (c) 2026, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file logfile.index_cache.hh
+ */
+
+#ifndef lnav_logfile_index_cache_hh
+#define lnav_logfile_index_cache_hh
+
+#include <filesystem>
+#include <future>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <sys/stat.h>
+
+#include "ArenaAlloc/arenaalloc.h"
+#include "base/auto_fd.hh"
+#include "base/intern_string.hh"
+#include "base/result.h"
+#include "log_format_fwd.hh"
+
+/**
+ * Support for saving the line index of a log file to disk so that it does
+ * not need to be rebuilt from scratch the next time the file is opened.
+ * The files are stored in the "index-cache" directory in the lnav work
+ * directory and are named using a hash of the device/inode of the log file
+ * and a fingerprint of its first few kilobytes.
+ */
+namespace lnav::logfile::index_cache {
+
+/** The version of the on-disk format, bump when the layout changes. */
+static constexpr uint32_t FORMAT_VERSION = 1;
+
+/** The number of bytes at the start of a file used to compute the key. */
+static constexpr size_t HEAD_FINGERPRINT_SIZE = 64 * 1024;
+
+/** The number of bytes before the end of the indexed data that are hashed. */
+static constexpr size_t TAIL_FINGERPRINT_SIZE = 4 * 1024;
+
+std::filesystem::path cache_path();
+
+/**
+ * Compute the path of the cache file for the given log file.
+ *
+ * @param st The stat of the log file.
+ * @param fd The descriptor used to read the head of the file.
+ */
+Result<std::filesystem::path, std::string> path_for(const struct stat& st,
+                                                     int fd);
+
+/**
+ * Hash the TAIL_FINGERPRINT_SIZE bytes that precede the given offset.
+ */
+Result<std::string, std::string> tail_fingerprint(int fd, file_off_t end);
+
+class writer {
+public:
+    explicit writer(auto_fd fd);
+
+    writer& write(const void* data, size_t len);
+
+    template<typename T>
+    writer& write_pod(const T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        return this->write(&value, sizeof(value));
+    }
+
+    writer& write_str(string_fragment sf);
+
+    writer& write_str(const std::string& str)
+    {
+        return this->write_str(string_fragment::from_str(str));
+    }
+
+    writer& write_range(const time_range& tr);
+
+    writer& write_level_stats(const log_level_stats& lls);
+
+    writer& write_value_stats(const std::vector<logline_value_stats>& stats);
+
+    writer& write_opids(const log_opid_state& los);
+
+    writer& write_tids(const log_thread_id_state& ltis);
+
+    Result<void, std::string> finish();
+
+private:
+    Result<void, std::string> flush();
+
+    auto_fd w_fd;
+    std::vector<char> w_buffer;
+    std::optional<std::string> w_error;
+};
+
+class reader {
+public:
+    explicit reader(auto_fd fd);
+
+    Result<void, std::string> read(void* data, size_t len);
+
+    template<typename T>
+    Result<T, std::string> read_pod()
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+
+        T retval;
+
+        TRY(this->read(&retval, sizeof(retval)));
+        return Ok(retval);
+    }
+
+    /**
+     * Check that there is enough data left in the file for the given number
+     * of elements.  Counts read from the file need to be checked before
+     * they are used to allocate memory since the file could be corrupt.
+     *
+     * @param count The number of elements.
+     * @param min_size The minimum number of bytes used by an element.
+     */
+    Result<void, std::string> check_count(uint64_t count, size_t min_size);
+
+    Result<std::string, std::string> read_str();
+
+    Result<string_fragment, std::string> read_frag(
+        ArenaAlloc::Alloc<char>& alloc);
+
+    Result<time_range, std::string> read_range();
+
+    Result<log_level_stats, std::string> read_level_stats();
+
+    Result<std::vector<logline_value_stats>, std::string> read_value_stats();
+
+    Result<void, std::string> read_opids(ArenaAlloc::Alloc<char>& alloc,
+                                         log_opid_state& los_out);
+
+    Result<void, std::string> read_tids(ArenaAlloc::Alloc<char>& alloc,
+                                        log_thread_id_state& ltis_out);
+
+private:
+    auto_fd r_fd;
+    std::vector<char> r_buffer;
+    size_t r_offset{0};
+    /** The number of bytes in the file that have not been read yet. */
+    uint64_t r_remaining{0};
+};
+
+/**
+ * Remove cache files that have not been used within the configured TTL.
+ */
+[[nodiscard]] std::future<void> cleanup();
+
+}  // namespace lnav::logfile::index_cache
+
+#endif
@@ -0,0 +1,357 @@
+/**
+ * Copyright (c) 2026, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file logfile.search_index.cc
+ */
+
+#include <algorithm>
+
+#include "logfile.search_index.hh"
+
+#include <unistd.h>
+
+#include "base/lnav_log.hh"
+#include "logfile.index_cache.hh"
+
+namespace lnav {
+
+namespace {
+
+constexpr size_t READ_SIZE = 256 * 1024;
+constexpr uint32_t TRIGRAM_COUNT = 1U << 24;
+
+inline uint8_t
+fold(uint8_t ch)
+{
+    if ('A' <= ch && ch <= 'Z') {
+        return ch + ('a' - 'A');
+    }
+    return ch;
+}
+
+inline uint32_t
+push_trigram(uint32_t prev, uint8_t ch)
+{
+    return ((prev << 8) | fold(ch)) & (TRIGRAM_COUNT - 1);
+}
+
+}  // namespace
+
+void
+search_index::posting_list::append(uint32_t block)
+{
+    auto delta = block + 1 - this->pl_last;
+
+    while (delta >= 0x80) {
+        this->pl_deltas.push_back(static_cast<uint8_t>(delta | 0x80));
+        delta >>= 7;
+    }
+    this->pl_deltas.push_back(static_cast<uint8_t>(delta));
+    this->pl_last = block + 1;
+}
+
+std::vector<search_index::block_trigrams>
+search_index::scan_blocks(int fd,
+                          const std::vector<block_range>& ranges,
+                          const std::atomic<bool>& cancelled)
+{
+    std::vector<block_trigrams> retval;
+    std::vector<uint64_t> seen(TRIGRAM_COUNT / 64);
+    std::vector<char> buf(READ_SIZE);
+
+    retval.reserve(ranges.size());
+    for (const auto& br : ranges) {
+        if (cancelled.load(std::memory_order_relaxed)) {
+            break;
+        }
+
+        auto& bt = retval.emplace_back();
+        bt.bt_range = br;
+        if (!br.br_indexable) {
+            continue;
+        }
+
+        uint32_t tri = 0;
+        size_t valid = 0;
+        auto off = br.br_start;
+        auto failed = false;
+
+        while (off < br.br_end) {
+            auto want = std::min(static_cast<file_off_t>(buf.size()),
+                                 br.br_end - off);
+            auto rc = pread(fd, buf.data(), want, off);
+            if (rc <= 0) {
+                failed = true;
+                break;
+            }
+            for (ssize_t lpc = 0; lpc < rc; lpc++) {
+                tri = push_trigram(tri, buf[lpc]);
+                if (buf[lpc] == '\n') {
+                    valid = 0;
+                    continue;
+                }
+                valid += 1;
+                if (valid < 3) {
+                    continue;
+                }
+
+                auto& word = seen[tri / 64];
+                auto bit = uint64_t{1} << (tri % 64);
+                if (!(word & bit)) {
+                    word |= bit;
+                    bt.bt_trigrams.push_back(tri);
+                }
+            }
+            off += rc;
+        }
+
+        for (auto key : bt.bt_trigrams) {
+            seen[key / 64] = 0;
+        }
+        if (failed) {
+            log_error("search index: unable to read block at %lld",
+                      (long long) br.br_start);
+            retval.pop_back();
+            break;
+        }
+        std::sort(bt.bt_trigrams.begin(), bt.bt_trigrams.end());
+        bt.bt_indexed = true;
+    }
+
+    return retval;
+}
+
+void
+search_index::add_block(const block_trigrams& bt)
+{
+    auto block = static_cast<uint32_t>(this->si_block_offsets.size());
+
+    this->si_block_offsets.emplace_back(bt.bt_range.br_start);
+    this->si_end_offset = bt.bt_range.br_end;
+    this->si_unindexed.push_back(!bt.bt_indexed);
+    for (auto key : bt.bt_trigrams) {
+        this->si_postings[key].append(block);
+    }
+    this->si_last_literals = std::nullopt;
+    this->si_last_candidates = std::nullopt;
+}
+
+size_t
+search_index::get_size() const
+{
+    size_t retval = this->si_postings.size() * sizeof(posting_list)
+        + this->si_block_offsets.size() * sizeof(file_off_t);
+
+    for (const auto& pair : this->si_postings) {
+        retval += pair.second.pl_deltas.capacity();
+    }
+
+    return retval;
+}
+
+const std::vector<bool>*
+search_index::candidates_for(const std::vector<std::string>& literals) const
+{
+    if (this->si_last_literals && this->si_last_literals.value() == literals) {
+        return this->si_last_candidates ? &this->si_last_candidates.value()
+                                        : nullptr;
+    }
+
+    this->si_last_literals = literals;
+    this->si_last_candidates = std::nullopt;
+
+    std::vector<uint32_t> keys;
+    for (const auto& lit : literals) {
+        uint32_t tri = 0;
+        size_t valid = 0;
+
+        for (auto ch : lit) {
+            tri = push_trigram(tri, ch);
+            if (ch == '\n') {
+                valid = 0;
+                continue;
+            }
+            valid += 1;
+            if (valid >= 3) {
+                keys.push_back(tri);
+            }
+        }
+    }
+    if (keys.empty()) {
+        return nullptr;
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    std::vector<const posting_list*> lists;
+    for (auto key : keys) {
+        auto iter = this->si_postings.find(key);
+        if (iter == this->si_postings.end()) {
+            lists.clear();
+            break;
+        }
+        lists.emplace_back(&iter->second);
+    }
+
+    // Start with the shortest list since it bounds the result.
+    std::sort(lists.begin(), lists.end(), [](const auto* lhs, const auto* rhs) {
+        return lhs->pl_deltas.size() < rhs->pl_deltas.size();
+    });
+
+    auto block_count = this->get_block_count();
+    std::vector<bool> candidates(block_count, false);
+    if (!lists.empty()) {
+        lists.front()->for_each(
+            [&candidates](uint32_t block) { candidates[block] = true; });
+
+        std::vector<bool> present(block_count);
+        for (size_t lpc = 1; lpc < lists.size(); lpc++) {
+            present.assign(block_count, false);
+            lists[lpc]->for_each(
+                [&present](uint32_t block) { present[block] = true; });
+            for (size_t block = 0; block < block_count; block++) {
+                candidates[block] = candidates[block] && present[block];
+            }
+        }
+    }
+    for (size_t block = 0; block < block_count; block++) {
+        if (this->si_unindexed[block]) {
+            candidates[block] = true;
+        }
+    }
+
+    this->si_last_candidates = std::move(candidates);
+    return &this->si_last_candidates.value();
+}
+
+bool
+search_index::may_contain(size_t start,
+                          size_t end,
+                          const std::vector<std::string>& literals) const
+{
+    if (literals.empty() || end <= start
+        || end > this->get_line_count())
+    {
+        return true;
+    }
+
+    const auto* candidates = this->candidates_for(literals);
+    if (candidates == nullptr) {
+        return true;
+    }
+
+    for (auto block = start / BLOCK_LINES; block <= (end - 1) / BLOCK_LINES;
+         block++)
+    {
+        if ((*candidates)[block]) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void
+search_index::clear()
+{
+    this->si_postings.clear();
+    this->si_block_offsets.clear();
+    this->si_end_offset = 0;
+    this->si_unindexed.clear();
+    this->si_last_literals = std::nullopt;
+    this->si_last_candidates = std::nullopt;
+}
+
+template<typename W>
+void
+search_index::save(W& wr) const
+{
+    wr.write_pod(static_cast<uint32_t>(BLOCK_LINES))
+        .write_pod(static_cast<uint64_t>(this->si_block_offsets.size()))
+        .write_pod(static_cast<int64_t>(this->si_end_offset));
+    for (size_t lpc = 0; lpc < this->si_block_offsets.size(); lpc++) {
+        wr.write_pod(static_cast<int64_t>(this->si_block_offsets[lpc]))
+            .write_pod(static_cast<uint8_t>(this->si_unindexed[lpc]));
+    }
+    wr.write_pod(static_cast<uint64_t>(this->si_postings.size()));
+    for (const auto& pair : this->si_postings) {
+        wr.write_pod(pair.first)
+            .write_pod(pair.second.pl_last)
+            .write_pod(static_cast<uint32_t>(pair.second.pl_deltas.size()))
+            .write(pair.second.pl_deltas.data(), pair.second.pl_deltas.size());
+    }
+}
+
+template<typename R>
+Result<void, std::string>
+search_index::load(R& rd)
+{
+    auto block_lines = TRY(rd.template read_pod<uint32_t>());
+    if (block_lines != BLOCK_LINES) {
+        return Err(std::string("block size mismatch"));
+    }
+
+    search_index tmp;
+    auto block_count = TRY(rd.template read_pod<uint64_t>());
+    tmp.si_end_offset = TRY(rd.template read_pod<int64_t>());
+    TRY(rd.check_count(block_count, sizeof(int64_t) + sizeof(uint8_t)));
+    tmp.si_block_offsets.reserve(block_count);
+    tmp.si_unindexed.reserve(block_count);
+    for (uint64_t lpc = 0; lpc < block_count; lpc++) {
+        tmp.si_block_offsets.emplace_back(
+            TRY(rd.template read_pod<int64_t>()));
+        tmp.si_unindexed.push_back(TRY(rd.template read_pod<uint8_t>()) != 0);
+    }
+
+    auto posting_count = TRY(rd.template read_pod<uint64_t>());
+    TRY(rd.check_count(posting_count, 3 * sizeof(uint32_t)));
+    tmp.si_postings.reserve(posting_count);
+    for (uint64_t lpc = 0; lpc < posting_count; lpc++) {
+        auto key = TRY(rd.template read_pod<uint32_t>());
+        auto& pl = tmp.si_postings[key];
+
+        pl.pl_last = TRY(rd.template read_pod<uint32_t>());
+        if (pl.pl_last > block_count) {
+            return Err(std::string("invalid posting list"));
+        }
+        auto len = TRY(rd.template read_pod<uint32_t>());
+        TRY(rd.check_count(len, 1));
+        pl.pl_deltas.resize(len);
+        TRY(rd.read(pl.pl_deltas.data(), len));
+    }
+
+    *this = std::move(tmp);
+
+    return Ok();
+}
+
+template void search_index::save(logfile::index_cache::writer& wr) const;
+template Result<void, std::string> search_index::load(
+    logfile::index_cache::reader& rd);
+
+}  // namespace lnav
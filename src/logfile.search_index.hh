@@ -0,0 +1,184 @@
+/**
+ * Copyright (c) 2026, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file logfile.search_index.hh
+ */
+
+#ifndef lnav_logfile_search_index_hh
+#define lnav_logfile_search_index_hh
+
+#include <atomic>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+#include "base/file_range.hh"
+#include "base/result.h"
+#include "robin_hood/robin_hood.h"
+
+namespace lnav {
+
+/**
+ * An inverted index of the trigrams that appear in the lines of a log file.
+ * The lines are grouped into blocks of BLOCK_LINES and each trigram maps
+ * to the list of blocks that contain it.  A search with a regex can then
+ * skip the blocks that do not contain all of the trigrams from the literal
+ * strings that the regex requires.
+ *
+ * The trigrams are folded to lowercase so the index works for caseless
+ * searches as well.  The index only answers whether a block *might* match,
+ * the lines still need to be checked with the regex.
+ */
+class search_index {
+public:
+    /** The number of lines in a block. */
+    static constexpr size_t BLOCK_LINES = 1024;
+
+    /** The byte range of a block in the file. */
+    struct block_range {
+        file_off_t br_start{0};
+        file_off_t br_end{0};
+        /**
+         * False if the content of the lines in the block does not match the
+         * raw bytes in the file, in which case the block is always a
+         * candidate.
+         */
+        bool br_indexable{true};
+    };
+
+    /** The result of scanning a block. */
+    struct block_trigrams {
+        block_range bt_range;
+        bool bt_indexed{false};
+        std::vector<uint32_t> bt_trigrams;
+    };
+
+    /**
+     * Read the given blocks from the file and collect the distinct trigrams
+     * in each.  This can be run on a background thread since it only uses
+     * the given descriptor.  If the scan is cancelled or there is an error,
+     * the blocks that were scanned so far are returned.
+     */
+    static std::vector<block_trigrams> scan_blocks(
+        int fd,
+        const std::vector<block_range>& ranges,
+        const std::atomic<bool>& cancelled);
+
+    /** Append a block that was returned by scan_blocks(). */
+    void add_block(const block_trigrams& bt);
+
+    size_t get_block_count() const { return this->si_block_offsets.size(); }
+
+    /** @return The number of lines covered by the index. */
+    size_t get_line_count() const
+    {
+        return this->get_block_count() * BLOCK_LINES;
+    }
+
+    /** @return The file offset after the last block in the index. */
+    file_off_t get_end_offset() const { return this->si_end_offset; }
+
+    /** @return The file offset of the start of the given block. */
+    file_off_t get_block_offset(size_t block) const
+    {
+        return this->si_block_offsets[block];
+    }
+
+    /** @return The approximate amount of memory used by the index. */
+    size_t get_size() const;
+
+    /**
+     * Check if any line in the range [start, end) might contain all of the
+     * given literals.  Lines that are not covered by the index always
+     * might.
+     */
+    bool may_contain(size_t start,
+                     size_t end,
+                     const std::vector<std::string>& literals) const;
+
+    void clear();
+
+    /**
+     * Serialize the index using one of the index_cache writers/readers.
+     * These are templates to avoid pulling the index_cache namespace into
+     * logfile.hh, they are instantiated in the implementation file.
+     */
+    template<typename W>
+    void save(W& wr) const;
+
+    template<typename R>
+    Result<void, std::string> load(R& rd);
+
+private:
+    struct posting_list {
+        /** The last block added plus one, zero if the list is empty. */
+        uint32_t pl_last{0};
+        /** The varint-encoded differences between consecutive blocks. */
+        std::vector<uint8_t> pl_deltas;
+
+        void append(uint32_t block);
+
+        template<typename F>
+        void for_each(F func) const
+        {
+            uint32_t curr = 0;
+            uint32_t delta = 0;
+            int shift = 0;
+
+            for (auto byte : this->pl_deltas) {
+                delta |= static_cast<uint32_t>(byte & 0x7f) << shift;
+                if (byte & 0x80) {
+                    shift += 7;
+                    continue;
+                }
+                curr += delta;
+                func(curr - 1);
+                delta = 0;
+                shift = 0;
+            }
+        }
+    };
+
+    const std::vector<bool>* candidates_for(
+        const std::vector<std::string>& literals) const;
+
+    robin_hood::unordered_map<uint32_t, posting_list> si_postings;
+    std::vector<file_off_t> si_block_offsets;
+    file_off_t si_end_offset{0};
+    /** The blocks that could not be indexed and always need to be checked. */
+    std::vector<bool> si_unindexed;
+
+    mutable std::optional<std::vector<std::string>> si_last_literals;
+    mutable std::optional<std::vector<bool>> si_last_candidates;
+};
+
+}  // namespace lnav
+
+#endif
@@ -28,11 +28,13 @@
  */
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <functional>
 #include <future>
 #include <optional>
 #include <string>
+#include <thread>
 #include <unordered_set>
 #include <vector>
 
@@ -45,6 +47,7 @@
 #include "base/distributed_slice.hh"
 #include "base/injector.hh"
 #include "base/itertools.hh"
+#include "base/radix_sort.hh"
 #include "base/string_util.hh"
 #include "bookmarks.hh"
 #include "bookmarks.json.hh"
@@ -55,6 +58,7 @@
 #include "hasher.hh"
 #include "k_merge_tree.h"
 #include "lnav_util.hh"
+#include "log.expr_params.hh"
 #include "log_accel.hh"
 #include "logfile_sub_source.cfg.hh"
 #include "logline_window.hh"
@@ -976,6 +980,69 @@ logfile_sub_source::text_attrs_for_line(textview_curses& lv,
     value_out = std::move(this->lss_token_al.al_attrs);
 }
 
+namespace {
+
+/**
+ * Iterates over the lines of a file in time order for the k-way merge done
+ * by a full sort.  If the file is already sorted, its lines are visited
+ * directly.  Otherwise, the order comes from the radix-sorted keys.
+ */
+class time_ordered_line_iterator {
+public:
+    struct __attribute__((__packed__)) sort_key {
+        uint64_t sk_time;
+        uint32_t sk_line;
+    };
+
+    time_ordered_line_iterator() = default;
+
+    time_ordered_line_iterator(logfile::iterator lines, size_t pos)
+        : tol_lines(lines), tol_pos(pos)
+    {
+    }
+
+    time_ordered_line_iterator(logfile::iterator lines,
+                               const sort_key* keys,
+                               size_t pos)
+        : tol_lines(lines), tol_keys(keys), tol_pos(pos)
+    {
+    }
+
+    logfile::iterator line() const
+    {
+        if (this->tol_keys == nullptr) {
+            return this->tol_lines + this->tol_pos;
+        }
+
+        return this->tol_lines + this->tol_keys[this->tol_pos].sk_line;
+    }
+
+    const logline& operator*() const { return *this->line(); }
+
+    time_ordered_line_iterator& operator++()
+    {
+        this->tol_pos += 1;
+        return *this;
+    }
+
+    bool operator==(const time_ordered_line_iterator& rhs) const
+    {
+        return this->tol_pos == rhs.tol_pos;
+    }
+
+    bool operator!=(const time_ordered_line_iterator& rhs) const
+    {
+        return this->tol_pos != rhs.tol_pos;
+    }
+
+private:
+    logfile::iterator tol_lines;
+    const sort_key* tol_keys{nullptr};
+    size_t tol_pos{0};
+};
+
+}  // namespace
+
 struct logline_cmp {
     explicit logline_cmp(logfile_sub_source& lc) : llss_controller(lc) {}
 
@@ -999,6 +1066,265 @@ struct logline_cmp {
     logfile_sub_source& llss_controller;
 };
 
+namespace {
+
+/**
+ * Stands in for the observers of a file while it is being indexed on a
+ * worker thread.  Progress is only recorded in atomics since the real
+ * observer redraws the UI, which reads the files that are being modified.
+ * The main thread reports the progress while it waits for the workers.
+ * The calls to the logline observer are recorded so they can be replayed
+ * on the main thread once the worker is done.
+ */
+class concurrent_index_observer
+    : public logfile_observer
+    , public logline_observer {
+public:
+    lnav::progress_result_t logfile_indexing(const logfile* lf,
+                                             file_off_t off,
+                                             file_ssize_t total) override
+    {
+        this->cio_offset.store(off, std::memory_order_relaxed);
+        this->cio_total.store(total, std::memory_order_relaxed);
+
+        if (this->logfile_indexing_interrupted()) {
+            return lnav::progress_result_t::interrupt;
+        }
+        return lnav::progress_result_t::ok;
+    }
+
+    bool logfile_indexing_interrupted() const override
+    {
+        return (this->cio_interrupted != nullptr
+                && this->cio_interrupted->load())
+            || (this->cio_real_observer != nullptr
+                && this->cio_real_observer->logfile_indexing_interrupted());
+    }
+
+    void logline_clear(const logfile& lf) override
+    {
+        this->cio_cleared = true;
+        this->cio_rollback_size = 0;
+        this->cio_first_new_line = std::nullopt;
+    }
+
+    void logline_restart(const logfile& lf, file_size_t rollback_size) override
+    {
+        this->cio_rollback_size += rollback_size;
+    }
+
+    bool logline_needs_content(const logfile& lf) const override
+    {
+        return false;
+    }
+
+    bool logline_new_lines(const logfile& lf,
+                           logfile::const_iterator ll_begin,
+                           logfile::const_iterator ll_end,
+                           const shared_buffer_ref& sbr) override
+    {
+        size_t start = std::distance(lf.begin(), ll_begin);
+
+        if (!this->cio_first_new_line || start < this->cio_first_new_line) {
+            this->cio_first_new_line = start;
+        }
+        return false;
+    }
+
+    void logline_eof(const logfile& lf) override {}
+
+    /**
+     * Pass the recorded calls on to the file's real observer.
+     *
+     * @return True if a line that was rolled back now matches a filter and
+     * the index needs to be rebuilt.
+     */
+    bool replay(logfile& lf, logline_observer* llo) const
+    {
+        auto retval = false;
+
+        if (llo == nullptr) {
+            return retval;
+        }
+
+        if (this->cio_cleared) {
+            llo->logline_clear(lf);
+        }
+        if (this->cio_rollback_size > 0) {
+            llo->logline_restart(lf, this->cio_rollback_size);
+        }
+        if (!this->cio_first_new_line) {
+            return retval;
+        }
+
+        auto start = lf.begin() + this->cio_first_new_line.value();
+        if (!llo->logline_needs_content(lf)) {
+            llo->logline_new_lines(lf, start, lf.end(), shared_buffer_ref{});
+        } else {
+            for (auto iter = start; iter != lf.end(); ++iter) {
+                if (iter->get_sub_offset() > 0) {
+                    continue;
+                }
+
+                auto iter_end = std::next(iter);
+                while (iter_end != lf.end() && iter_end->get_sub_offset() != 0)
+                {
+                    ++iter_end;
+                }
+                lf.read_line(iter).then([&](auto sbr) {
+                    auto nl_rc = llo->logline_new_lines(lf, iter, iter_end, sbr);
+                    if (nl_rc && iter == start && this->cio_rollback_size > 0)
+                    {
+                        retval = true;
+                    }
+                });
+            }
+        }
+        llo->logline_eof(lf);
+
+        return retval;
+    }
+
+    /** The file's real observer, which is only asked about interrupts. */
+    const logfile_observer* cio_real_observer{nullptr};
+    /** Set by the main thread when the progress observer interrupts. */
+    const std::atomic<bool>* cio_interrupted{nullptr};
+    std::atomic<file_off_t> cio_offset{0};
+    std::atomic<file_ssize_t> cio_total{0};
+    bool cio_cleared{false};
+    file_size_t cio_rollback_size{0};
+    std::optional<size_t> cio_first_new_line;
+};
+
+}  // namespace
+
+std::map<size_t, logfile::rebuild_result_t>
+logfile_sub_source::index_files_concurrently(
+    const std::vector<size_t>& file_order,
+    std::optional<ui_clock::time_point> deadline)
+{
+    std::map<size_t, logfile::rebuild_result_t> retval;
+    std::vector<size_t> candidates;
+
+    if (this->tss_view->is_paused()) {
+        return retval;
+    }
+
+    for (const auto file_index : file_order) {
+        auto* lf = this->lss_files[file_index]->get_file_ptr();
+
+        if (lf != nullptr && lf->can_index_concurrently()) {
+            candidates.emplace_back(file_index);
+        }
+    }
+
+    auto worker_count = std::min(
+        static_cast<size_t>(std::thread::hardware_concurrency()),
+        candidates.size());
+    if (worker_count < 2) {
+        return retval;
+    }
+
+    std::vector<concurrent_index_observer> observers(candidates.size());
+    std::vector<logfile_observer*> logfile_observers(candidates.size());
+    std::vector<logline_observer*> logline_observers(candidates.size());
+    std::vector<logfile::rebuild_result_t> results(
+        candidates.size(), logfile::rebuild_result_t::NO_NEW_LINES);
+    logfile_observer* progress_observer = nullptr;
+    std::atomic<bool> interrupted{false};
+    // Share the hardware threads between the files so that a large file
+    // that is indexed in parallel does not oversubscribe the machine.
+    auto index_threads = std::max(
+        size_t{1},
+        static_cast<size_t>(std::thread::hardware_concurrency())
+            / worker_count);
+
+    for (size_t lpc = 0; lpc < candidates.size(); lpc++) {
+        auto* lf = this->lss_files[candidates[lpc]]->get_file_ptr();
+
+        logfile_observers[lpc] = lf->get_logfile_observer();
+        if (progress_observer == nullptr) {
+            progress_observer = logfile_observers[lpc];
+        }
+        observers[lpc].cio_real_observer = logfile_observers[lpc];
+        observers[lpc].cio_interrupted = &interrupted;
+        logline_observers[lpc] = lf->exchange_logline_observer(&observers[lpc]);
+        lf->set_logfile_observer(&observers[lpc]);
+        lf->set_index_thread_limit(index_threads);
+    }
+
+    std::atomic<size_t> next_candidate{0};
+    std::vector<std::future<void>> workers;
+    workers.reserve(worker_count);
+    for (size_t lpc = 0; lpc < worker_count; lpc++) {
+        workers.emplace_back(std::async(std::launch::async, [&]() {
+            size_t index;
+
+            while ((index = next_candidate.fetch_add(1)) < candidates.size()) {
+                auto* lf = this->lss_files[candidates[index]]->get_file_ptr();
+
+                results[index] = lf->rebuild_index(deadline);
+            }
+        }));
+    }
+
+    // The progress observer can redraw the UI, so it is only called from
+    // this thread with the combined progress of the workers.  If it asks
+    // for an interrupt, the workers are told to stop.
+    static constexpr auto PROGRESS_INTERVAL = std::chrono::milliseconds(100);
+    for (auto& worker : workers) {
+        while (worker.wait_for(PROGRESS_INTERVAL) != std::future_status::ready)
+        {
+            if (progress_observer == nullptr) {
+                continue;
+            }
+
+            file_off_t curr_off = 0;
+            file_ssize_t curr_total = 0;
+            for (const auto& obs : observers) {
+                curr_off += obs.cio_offset.load(std::memory_order_relaxed);
+                curr_total += obs.cio_total.load(std::memory_order_relaxed);
+            }
+            if (progress_observer->logfile_indexing(
+                    nullptr, curr_off, curr_total)
+                == lnav::progress_result_t::interrupt)
+            {
+                interrupted.store(true);
+            }
+        }
+        worker.get();
+    }
+
+    file_off_t progress_off = 0;
+    file_ssize_t progress_total = 0;
+    for (size_t lpc = 0; lpc < candidates.size(); lpc++) {
+        auto* lf = this->lss_files[candidates[lpc]]->get_file_ptr();
+
+        progress_off += observers[lpc].cio_offset.load();
+        progress_total += observers[lpc].cio_total.load();
+        lf->set_index_thread_limit(0);
+        lf->set_logfile_observer(logfile_observers[lpc]);
+        lf->exchange_logline_observer(logline_observers[lpc]);
+        if (observers[lpc].replay(*lf, logline_observers[lpc])
+            && results[lpc] == logfile::rebuild_result_t::NEW_LINES)
+        {
+            results[lpc] = logfile::rebuild_result_t::NEW_ORDER;
+        }
+        retval[candidates[lpc]] = results[lpc];
+    }
+    if (progress_observer != nullptr) {
+        progress_observer->logfile_indexing(nullptr, 0, 0);
+    }
+
+    log_debug("indexed %lld of %lld bytes in %zu files using %zu threads",
+              (long long) progress_off,
+              (long long) progress_total,
+              candidates.size(),
+              worker_count);
+
+    return retval;
+}
+
 logfile_sub_source::rebuild_result
 logfile_sub_source::rebuild_index(std::optional<ui_clock::time_point> deadline)
 {
@@ -1052,6 +1378,8 @@ logfile_sub_source::rebuild_index(std::optional<ui_clock::time_point> deadline)
                          });
     }
 
+    auto concurrent_results
+        = this->index_files_concurrently(file_order, deadline);
     bool time_left = true;
     this->lss_all_timestamp_flags = 0;
     for (const auto file_index : file_order) {
@@ -1078,8 +1406,14 @@ logfile_sub_source::rebuild_index(std::optional<ui_clock::time_point> deadline)
             this->lss_all_timestamp_flags
                 |= lf->get_format_ptr()->lf_timestamp_flags;
 
-            if (!this->tss_view->is_paused() && time_left) {
-                auto log_rebuild_res = lf->rebuild_index(deadline);
+            auto concurrent_iter = concurrent_results.find(file_index);
+            if (concurrent_iter != concurrent_results.end()
+                || (!this->tss_view->is_paused() && time_left))
+            {
+                auto log_rebuild_res
+                    = concurrent_iter != concurrent_results.end()
+                    ? concurrent_iter->second
+                    : lf->rebuild_index(deadline);
 
                 if (ld.ld_lines_indexed < lf->size()
                     && log_rebuild_res
@@ -1276,7 +1610,6 @@ logfile_sub_source::rebuild_index(std::optional<ui_clock::time_point> deadline)
 
     if (retval != rebuild_result::rr_no_change || force) {
         size_t index_size = 0, start_size = this->lss_index.size();
-        logline_cmp line_cmper(*this);
 
         for (auto& ld : this->lss_files) {
             auto* lf = ld->get_file_ptr();
@@ -1295,6 +1628,13 @@ logfile_sub_source::rebuild_index(std::optional<ui_clock::time_point> deadline)
 
         if (full_sort) {
             log_trace("rebuild_index full sort");
+            auto sort_start = std::chrono::steady_clock::now();
+            std::vector<std::vector<time_ordered_line_iterator::sort_key>>
+                file_keys(this->lss_files.size());
+            kmerge_tree_c<logline, logfile_data, time_ordered_line_iterator>
+                merge(file_count);
+            size_t unsorted_count = 0;
+
             for (auto& ld : this->lss_files) {
                 auto* lf = ld->get_file_ptr();
 
@@ -1302,15 +1642,64 @@ logfile_sub_source::rebuild_index(std::optional<ui_clock::time_point> deadline)
                     continue;
                 }
 
+                index_size += lf->size();
+                if (std::is_sorted(lf->begin(), lf->end())) {
+                    merge.add(ld.get(),
+                              time_ordered_line_iterator(lf->begin(), 0),
+                              time_ordered_line_iterator(lf->begin(),
+                                                         lf->size()));
+                    continue;
+                }
+
+                // The lines in a file are in offset order, so sorting
+                // (time, line number) pairs gives the same order as
+                // comparing the loglines themselves.
+                auto& keys = file_keys[ld->ld_file_index];
+                keys.reserve(lf->size());
                 for (size_t line_index = 0; line_index < lf->size();
                      line_index++)
                 {
-                    const auto lf_iter
-                        = ld->get_file_ptr()->begin() + line_index;
-                    if (lf_iter->is_ignored()) {
+                    const auto& ll = (*lf)[line_index];
+
+                    if (ll.is_ignored()) {
                         continue;
                     }
+                    keys.emplace_back(time_ordered_line_iterator::sort_key{
+                        lnav::radix_key(
+                            ll.get_time<std::chrono::microseconds>().count()),
+                        static_cast<uint32_t>(line_index),
+                    });
+                }
+                lnav::radix_sort(
+                    keys,
+                    [](const time_ordered_line_iterator::sort_key& key) {
+                        return key.sk_time;
+                    },
+                    std::thread::hardware_concurrency());
+                merge.add(ld.get(),
+                          time_ordered_line_iterator(
+                              lf->begin(), keys.data(), 0),
+                          time_ordered_line_iterator(
+                              lf->begin(), keys.data(), keys.size()));
+                unsorted_count += 1;
+            }
+
+            file_off_t index_off = 0;
+            merge.execute();
+            if (this->lss_sorting_observer) {
+                this->lss_sorting_observer(*this, index_off, index_size);
+            }
+            for (;;) {
+                time_ordered_line_iterator tol_iter;
+                logfile_data* ld;
+
+                if (!merge.get_top(ld, tol_iter)) {
+                    break;
+                }
 
+                auto lf_iter = tol_iter.line();
+                if (!lf_iter->is_ignored()) {
+                    auto line_index = lf_iter - ld->get_file_ptr()->begin();
                     content_line_t con_line(
                         ld->ld_file_index * MAX_LINES_PER_FILE + line_index);
 
@@ -1343,19 +1732,26 @@ logfile_sub_source::rebuild_index(std::optional<ui_clock::time_point> deadline)
                     this->lss_index.push_back(
                         indexed_content{con_line, lf_iter});
                 }
-            }
 
-            // XXX get rid of this full sort on the initial run, it's not
-            // needed unless the file is not in time-order
-            if (this->lss_sorting_observer) {
-                this->lss_sorting_observer(*this, 0, this->lss_index.size());
+                merge.next();
+                index_off += 1;
+                if (index_off % 100000 == 0 && this->lss_sorting_observer) {
+                    this->lss_sorting_observer(*this, index_off, index_size);
+                }
             }
-            std::sort(
-                this->lss_index.begin(), this->lss_index.end(), line_cmper);
             if (this->lss_sorting_observer) {
-                this->lss_sorting_observer(
-                    *this, this->lss_index.size(), this->lss_index.size());
+                this->lss_sorting_observer(*this, index_size, index_size);
             }
+
+            auto sort_end = std::chrono::steady_clock::now();
+            log_info("full sort of %zu lines from %d files (%zu unsorted) "
+                     "took %lldms",
+                     this->lss_index.size(),
+                     file_count,
+                     unsorted_count,
+                     (long long) std::chrono::duration_cast<
+                         std::chrono::milliseconds>(sort_end - sort_start)
+                         .count());
         } else {
             kmerge_tree_c<logline, logfile_data, logfile::iterator> merge(
                 file_count);
@@ -1434,6 +1830,7 @@ logfile_sub_source::rebuild_index(std::optional<ui_clock::time_point> deadline)
             }
         }
 
+        auto ef = this->get_filters().get_enabled_filters();
         for (iter = this->lss_files.begin(); iter != this->lss_files.end();
              ++iter)
         {
@@ -1443,14 +1840,15 @@ logfile_sub_source::rebuild_index(std::optional<ui_clock::time_point> deadline)
                 continue;
             }
 
+            // Only the lines that were added since the last time need to be
+            // checked for an incremental update.
+            (*iter)->ld_filter_state.update_exclusion(
+                ef, start_size == 0 ? 0 : (*iter)->ld_lines_indexed);
             (*iter)->ld_lines_indexed = lf->size();
         }
 
         this->lss_filtered_index.reserve(this->lss_index.size());
 
-        uint32_t filter_in_mask, filter_out_mask;
-        this->get_filters().get_enabled_mask(filter_in_mask, filter_out_mask);
-
         if (start_size == 0 && this->lss_index_delegate != nullptr) {
             this->lss_index_delegate->index_start(*this);
         }
@@ -1476,12 +1874,14 @@ logfile_sub_source::rebuild_index(std::optional<ui_clock::time_point> deadline)
             }
 
             if (!this->tss_apply_filters
-                || (!(*ld)->ld_filter_state.excluded(
-                        filter_in_mask, filter_out_mask, line_number)
+                || (!(*ld)->ld_filter_state.excluded(line_number)
                     && this->check_extra_filters(ld, line_iter)))
             {
-                auto eval_res = this->eval_sql_filter(
-                    this->lss_marker_stmt.in(), ld, line_iter);
+                auto eval_res
+                    = this->eval_sql_filter(this->lss_marker_stmt.in(),
+                                            this->lss_marker_predicate,
+                                            ld,
+                                            line_iter);
                 if (eval_res.isErr()) {
                     line_iter->set_expr_mark(false);
                 } else {
@@ -1615,6 +2015,7 @@ logfile_sub_source::text_filters_changed()
         auto* lf = ld->get_file_ptr();
 
         if (lf != nullptr) {
+            ld->ld_filter_state.sync_background_eval();
             ld->ld_filter_state.clear_deleted_filter_state();
             lf->reobserve_from(lf->begin()
                                + ld->ld_filter_state.get_min_count(lf->size()));
@@ -1627,9 +2028,13 @@ logfile_sub_source::text_filters_changed()
     }
 
     auto& vis_bm = this->tss_view->get_bookmarks();
-    uint32_t filtered_in_mask, filtered_out_mask;
+    auto ef = this->get_filters().get_enabled_filters();
 
-    this->get_filters().get_enabled_mask(filtered_in_mask, filtered_out_mask);
+    for (auto& ld : this->lss_files) {
+        if (ld->get_file_ptr() != nullptr) {
+            ld->ld_filter_state.update_exclusion(ef);
+        }
+    }
 
     if (this->lss_index_delegate != nullptr) {
         this->lss_index_delegate->index_start(*this);
@@ -1652,12 +2057,14 @@ logfile_sub_source::text_filters_changed()
         auto line_iter = lf->begin() + line_number;
 
         if (!this->tss_apply_filters
-            || (!(*ld)->ld_filter_state.excluded(
-                    filtered_in_mask, filtered_out_mask, line_number)
+            || (!(*ld)->ld_filter_state.excluded(line_number)
                 && this->check_extra_filters(ld, line_iter)))
         {
-            auto eval_res = this->eval_sql_filter(
-                this->lss_marker_stmt.in(), ld, line_iter);
+            auto eval_res
+                = this->eval_sql_filter(this->lss_marker_stmt.in(),
+                                        this->lss_marker_predicate,
+                                        ld,
+                                        line_iter);
             if (eval_res.isErr()) {
                 line_iter->set_expr_mark(false);
             } else {
@@ -1890,9 +2297,12 @@ logfile_sub_source::set_sql_filter(std::string stmt_str, sqlite3_stmt* stmt)
 
     auto old_filter_iter = this->tss_filters.find(0);
     if (stmt != nullptr) {
+        auto pred = compile_sql_filter(stmt_str);
         auto new_filter
             = std::make_shared<sql_filter>(*this, std::move(stmt_str), stmt);
 
+        new_filter->sf_predicate = std::move(pred);
+
         if (old_filter_iter != this->tss_filters.end()) {
             *old_filter_iter = new_filter;
         } else {
@@ -1923,6 +2333,9 @@ logfile_sub_source::set_sql_marker(std::string stmt_str, sqlite3_stmt* stmt)
 
     auto op_guard = lnav_opid_guard::internal(op);
     log_info("setting SQL marker: %s", stmt_str.c_str());
+    this->lss_marker_predicate = stmt == nullptr
+        ? std::nullopt
+        : compile_sql_filter(stmt_str);
     this->lss_marker_stmt_text = std::move(stmt_str);
     this->lss_marker_stmt = stmt;
 
@@ -1953,8 +2366,8 @@ logfile_sub_source::set_sql_marker(std::string stmt_str, sqlite3_stmt* stmt)
         if (ll->is_continued() || ll->is_ignored()) {
             continue;
         }
-        auto eval_res
-            = this->eval_sql_filter(this->lss_marker_stmt.in(), ld, ll);
+        auto eval_res = this->eval_sql_filter(
+            this->lss_marker_stmt.in(), this->lss_marker_predicate, ld, ll);
 
         if (eval_res.isErr()) {
             ll->set_expr_mark(false);
@@ -2284,6 +2697,68 @@ logfile_sub_source::eval_sql_filter(sqlite3_stmt* stmt,
     }
 }
 
+std::optional<lnav::sql::predicate>
+logfile_sub_source::compile_sql_filter(const std::string& expr)
+{
+    auto retval
+        = lnav::sql::predicate::compile(string_fragment::from_str(expr));
+
+    if (!retval) {
+        log_info("filter expression needs SQLite: %s", expr.c_str());
+        return std::nullopt;
+    }
+    for (const auto& name : retval->get_variables()) {
+        if (!lnav::log::expr_params::is_native(name)) {
+            log_info("filter expression uses %s, which needs SQLite",
+                     name.c_str());
+            return std::nullopt;
+        }
+    }
+
+    log_info("compiled filter expression: %s", expr.c_str());
+    return retval;
+}
+
+Result<bool, lnav::console::user_message>
+logfile_sub_source::eval_sql_filter(
+    sqlite3_stmt* stmt,
+    const std::optional<lnav::sql::predicate>& pred,
+    iterator ld,
+    logfile::const_iterator ll)
+{
+    if (stmt == nullptr) {
+        return Ok(false);
+    }
+
+    if (pred) {
+        auto pred_res = this->eval_predicate(pred.value(), ld, ll);
+        if (pred_res) {
+            return Ok(pred_res.value());
+        }
+    }
+
+    return this->eval_sql_filter(stmt, ld, ll);
+}
+
+std::optional<bool>
+logfile_sub_source::eval_predicate(const lnav::sql::predicate& pred,
+                                   iterator ld,
+                                   logfile::const_iterator ll)
+{
+    lnav::log::expr_params params(*(*ld)->get_file_ptr(), ll);
+    auto& vars = this->lss_predicate_values;
+
+    vars.clear();
+    for (const auto& name : pred.get_variables()) {
+        // Fields that are not in the message are NULL, like an unbound
+        // parameter.
+        vars.emplace_back(params.lookup(name).value_or(
+            lnav::sql::predicate::value{}));
+    }
+
+    return pred.eval(vars);
+}
+
 bool
 logfile_sub_source::check_extra_filters(iterator ld, logfile::iterator ll)
 {
@@ -2580,7 +3055,7 @@ sql_filter::matches(std::optional<line_source> ls_opt,
     }
 
     auto eval_res = this->sf_log_source.eval_sql_filter(
-        this->sf_filter_stmt, ld, ls->ls_line);
+        this->sf_filter_stmt, this->sf_predicate, ld, ls->ls_line);
     if (eval_res.unwrapOr(true)) {
         return false;
     }
@@ -3394,19 +3869,110 @@ logfile_sub_source::text_size_for_line(textview_curses& tc,
     return this->lss_line_size_cache[index].second;
 }
 
+bool
+logfile_sub_source::text_line_may_contain(
+    int row, const std::vector<std::string>& literals)
+{
+    if (this->lss_indexing_in_progress || row < 0
+        || (size_t) row >= this->lss_filtered_index.size())
+    {
+        return true;
+    }
+
+    auto line = this->at(vis_line_t(row));
+    const auto* lf = this->find_file_ptr(line);
+
+    return lf->lines_may_contain(line, line + 1, literals);
+}
+
 int
 logfile_sub_source::get_filtered_count_for(size_t filter_index) const
 {
     int retval = 0;
 
     for (const auto& ld : this->lss_files) {
-        retval += ld->ld_filter_state.lfo_filter_state
-                      .tfs_filter_hits[filter_index];
+        retval += ld->ld_filter_state.lfo_filter_state.get_filter_hits(
+            filter_index);
+    }
+
+    return retval;
+}
+
+std::optional<std::pair<size_t, size_t>>
+logfile_sub_source::get_filter_progress() const
+{
+    std::optional<std::pair<size_t, size_t>> retval;
+
+    for (const auto& ld : this->lss_files) {
+        if (!ld->ld_filter_state.is_background_eval_running()) {
+            continue;
+        }
+
+        auto progress = ld->ld_filter_state.get_background_eval_progress();
+        if (!retval) {
+            retval = std::make_pair(size_t{0}, size_t{0});
+        }
+        retval->first += progress.first;
+        retval->second += progress.second;
     }
 
     return retval;
 }
 
+bool
+logfile_sub_source::update_background_filters()
+{
+    static constexpr auto REFRESH_INTERVAL = std::chrono::seconds(1);
+
+    auto running = false;
+    for (auto& ld : this->lss_files) {
+        if (ld->get_file_ptr() == nullptr) {
+            continue;
+        }
+        if (ld->ld_filter_state.poll_background_eval()) {
+            this->lss_background_filter_pending = true;
+        }
+        running = running || ld->ld_filter_state.is_background_eval_running();
+    }
+
+    if (!this->lss_background_filter_pending) {
+        return false;
+    }
+
+    auto now = ui_clock::now();
+    if (running && now < this->lss_background_filter_refresh + REFRESH_INTERVAL)
+    {
+        return false;
+    }
+
+    this->lss_background_filter_pending = false;
+    this->lss_background_filter_refresh = now;
+    this->text_filters_changed();
+
+    return true;
+}
+
+bool
+logfile_sub_source::finish_background_filters()
+{
+    for (auto& ld : this->lss_files) {
+        if (ld->ld_filter_state.is_background_eval_running()) {
+            ld->ld_filter_state.finish_background_eval();
+            this->lss_background_filter_pending = true;
+        }
+    }
+
+    if (!this->lss_background_filter_pending) {
+        return false;
+    }
+
+    this->lss_background_filter_pending = false;
+    this->lss_background_filter_refresh = ui_clock::now();
+    this->text_filters_changed();
+
+    return true;
+}
+
 std::optional<vis_line_t>
 logfile_sub_source::row_for(const row_info& ri)
 {
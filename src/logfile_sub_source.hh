@@ -46,6 +46,7 @@
 #include "filter_observer.hh"
 #include "log_format.hh"
 #include "logfile.hh"
+#include "sql_predicate.hh"
 #include "strong_int.hh"
 #include "textview_curses.hh"
 
@@ -102,6 +103,8 @@ public:
     std::string to_command() const override;
 
     auto_mem<sqlite3_stmt> sf_filter_stmt{sqlite3_finalize};
+    /** The native version of the statement, if it could be compiled. */
+    std::optional<lnav::sql::predicate> sf_predicate;
     logfile_sub_source& sf_log_source;
 };
 
@@ -208,6 +211,9 @@ public:
 
     size_t text_size_for_line(textview_curses& tc, int row, line_flags_t flags);
 
+    bool text_line_may_contain(
+        int row, const std::vector<std::string>& literals) override;
+
     void text_mark(const bookmark_type_t* bm, vis_line_t line, bool added);
 
     void text_clear_marks(const bookmark_type_t* bm);
@@ -294,6 +300,26 @@ public:
 
     int get_filtered_count_for(size_t filter_index) const;
 
+    std::optional<std::pair<size_t, size_t>> get_filter_progress()
+        const override;
+
+    /**
+     * Merge the results of the filters that are being evaluated in the
+     * background.  The filtered index is rebuilt at most once a second while
+     * the evaluation is running so the view fills in progressively.
+     *
+     * @return True if the filtered index was rebuilt.
+     */
+    bool update_background_filters();
+
+    /**
+     * Wait for the filters that are being evaluated in the background to
+     * finish, for when the results are needed right away.
+     *
+     * @return True if the filtered index was rebuilt.
+     */
+    bool finish_background_filters();
+
     Result<void, lnav::console::user_message> set_sql_filter(
         std::string stmt_str, sqlite3_stmt* stmt);
 
@@ -471,12 +497,14 @@ public:
 
         void clear()
         {
+            this->ld_filter_state.cancel_background_eval();
             this->ld_filter_state.lfo_filter_state.clear();
             this->ld_file_ptr = nullptr;
         }
 
         void set_file(const std::shared_ptr<logfile>& lf)
         {
+            this->ld_filter_state.cancel_background_eval();
             this->ld_filter_state.lfo_filter_state.tfs_logfile = lf;
             this->ld_file_ptr = lf.get();
             this->ld_lines_indexed = 0;
@@ -626,6 +654,25 @@ public:
     Result<bool, lnav::console::user_message> eval_sql_filter(
         sqlite3_stmt* stmt, iterator ld, logfile::const_iterator ll);
 
+    /**
+     * Evaluate a filter expression with the compiled predicate, if there
+     * is one, and fall back to the SQLite statement when the predicate
+     * cannot decide.
+     */
+    Result<bool, lnav::console::user_message> eval_sql_filter(
+        sqlite3_stmt* stmt,
+        const std::optional<lnav::sql::predicate>& pred,
+        iterator ld,
+        logfile::const_iterator ll);
+
+    /**
+     * Compile a filter expression into a native predicate.
+     *
+     * @return The predicate or nullopt if the expression needs SQLite.
+     */
+    static std::optional<lnav::sql::predicate> compile_sql_filter(
+        const std::string& expr);
+
     void invalidate_sql_filter();
 
     void set_line_meta_changed() { this->lss_line_meta_changed = true; }
@@ -733,10 +780,20 @@ private:
 
     bool check_extra_filters(iterator ld, logfile::iterator ll);
 
+    std::optional<bool> eval_predicate(const lnav::sql::predicate& pred,
+                                       iterator ld,
+                                       logfile::const_iterator ll);
+
+    std::map<size_t, logfile::rebuild_result_t> index_files_concurrently(
+        const std::vector<size_t>& file_order,
+        std::optional<ui_clock::time_point> deadline);
+
     size_t lss_basename_width = 0;
     size_t lss_filename_width = 0;
     line_context_t lss_line_context{line_context_t::none};
     bool lss_force_rebuild{false};
+    bool lss_background_filter_pending{false};
+    ui_clock::time_point lss_background_filter_refresh;
     std::vector<std::unique_ptr<logfile_data>> lss_files;
     unsigned int lss_all_timestamp_flags{0};
 
@@ -747,7 +804,9 @@ private:
     bookmarks<content_line_t>::type lss_user_marks{
         bookmarks<content_line_t>::create_array()};
     auto_mem<sqlite3_stmt> lss_marker_stmt{sqlite3_finalize};
+    std::optional<lnav::sql::predicate> lss_marker_predicate;
     std::string lss_marker_stmt_text;
+    std::vector<lnav::sql::predicate::value> lss_predicate_values;
 
     line_flags_t lss_token_flags{0};
     iterator lss_token_file_data;
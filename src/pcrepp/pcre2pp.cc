@@ -32,6 +32,8 @@
 #include "pcre2pp.hh"
 
 #include <algorithm>
+#include <cctype>
+#include <cstring>
 
 #include "config.h"
 #include "ww898/cp_utf8.hpp"
@@ -211,6 +213,557 @@ code::get_capture_count() const
     return retval;
 }
 
+code::start_info
+code::get_start_info() const
+{
+    start_info retval;
+    uint32_t all_options = 0;
+    uint32_t min_length = 0;
+    uint32_t first_code_type = 0;
+
+    pcre2_pattern_info(this->p_code.in(), PCRE2_INFO_ALLOPTIONS, &all_options);
+    retval.si_anchored = (all_options & PCRE2_ANCHORED) != 0;
+    pcre2_pattern_info(this->p_code.in(), PCRE2_INFO_MINLENGTH, &min_length);
+    retval.si_min_length = min_length;
+    pcre2_pattern_info(
+        this->p_code.in(), PCRE2_INFO_FIRSTCODETYPE, &first_code_type);
+    if (first_code_type == 1) {
+        uint32_t first_code_unit = 0;
+
+        pcre2_pattern_info(
+            this->p_code.in(), PCRE2_INFO_FIRSTCODEUNIT, &first_code_unit);
+        if (first_code_unit < 256) {
+            std::bitset<256> first_bytes;
+
+            // The first code unit can be matched caselessly, so allow
+            // both cases.
+            first_bytes.set(first_code_unit);
+            first_bytes.set(tolower(first_code_unit));
+            first_bytes.set(toupper(first_code_unit));
+            retval.si_first_bytes = first_bytes;
+        }
+    } else if (first_code_type == 0) {
+        const uint8_t* bitmap = nullptr;
+
+        pcre2_pattern_info(this->p_code.in(), PCRE2_INFO_FIRSTBITMAP, &bitmap);
+        if (bitmap != nullptr) {
+            std::bitset<256> first_bytes;
+
+            for (size_t lpc = 0; lpc < 256; lpc++) {
+                if (bitmap[lpc / 8] & (1U << (lpc % 8))) {
+                    first_bytes.set(lpc);
+                }
+            }
+            retval.si_first_bytes = first_bytes;
+        }
+    }
+
+    return retval;
+}
+
+std::vector<std::string>
+code::get_required_literals() const
+{
+    static constexpr size_t MIN_LITERAL_LENGTH = 3;
+    // The escapes that match something other than their own text and are
+    // handled by skip_escape_argument() below.
+    static constexpr const char* KNOWN_ESCAPES
+        = "0123456789ABDEGHKNPRSVWXZabcdefghknoprstvwxz";
+
+    std::vector<std::string> retval;
+    uint32_t all_options = 0;
+
+    pcre2_pattern_info(this->p_code.in(), PCRE2_INFO_ALLOPTIONS, &all_options);
+    // These options change the syntax in ways that are not handled below.
+    if (all_options
+        & (PCRE2_EXTENDED | PCRE2_EXTENDED_MORE | PCRE2_ALT_BSUX
+           | PCRE2_ALLOW_EMPTY_CLASS))
+    {
+        return retval;
+    }
+
+    const auto& pat = this->p_pattern;
+    if (all_options & PCRE2_LITERAL) {
+        if (pat.size() >= MIN_LITERAL_LENGTH) {
+            retval.emplace_back(pat);
+        }
+        return retval;
+    }
+    // Backtracking control verbs, like (*ACCEPT), can end a match before
+    // the rest of the pattern is reached.
+    if (pat.find("(*") != std::string::npos) {
+        return retval;
+    }
+
+    // A caseless match can use characters outside of ASCII, like the Kelvin
+    // sign for 'k', so those characters cannot be required.
+    auto caseless = (all_options & PCRE2_CASELESS) != 0;
+    for (auto pos = pat.find("(?"); pos != std::string::npos;
+         pos = pat.find("(?", pos + 2))
+    {
+        auto negated = false;
+        for (auto lpc = pos + 2; lpc < pat.size()
+             && (isalpha(pat[lpc]) || pat[lpc] == '^' || pat[lpc] == '-');
+             lpc++)
+        {
+            if (pat[lpc] == '-') {
+                negated = true;
+            } else if (!negated && pat[lpc] == 'x') {
+                return {};
+            } else if (!negated && pat[lpc] == 'i') {
+                caseless = true;
+            }
+        }
+    }
+
+    std::string curr;
+    auto flush = [&]() {
+        if (curr.size() >= MIN_LITERAL_LENGTH) {
+            retval.emplace_back(curr);
+        }
+        curr.clear();
+    };
+    auto add_char = [&](char ch) {
+        auto uch = (unsigned char) ch;
+
+        if (caseless
+            && (uch >= 0x80 || tolower(uch) == 'k' || tolower(uch) == 's'))
+        {
+            flush();
+        } else {
+            curr.push_back(ch);
+        }
+    };
+    // Remove the last character since it was made optional by a quantifier.
+    // The pattern is UTF-8, so all the bytes of the character are removed.
+    auto drop_last = [&]() {
+        while (!curr.empty() && ((unsigned char) curr.back() & 0xc0) == 0x80)
+        {
+            curr.pop_back();
+        }
+        if (!curr.empty()) {
+            curr.pop_back();
+        }
+        flush();
+    };
+    // Skip over the end of a "{...}", "<...>", or '...' argument.
+    auto skip_delimited = [&](size_t pos) {
+        auto close = pat[pos] == '{' ? '}' : (pat[pos] == '<' ? '>' : '\'');
+        auto end = pat.find(close, pos + 1);
+
+        return end == std::string::npos ? pat.size() : end + 1;
+    };
+    // Skip over the argument of an escape like "\x41" or "\p{L}".
+    auto skip_escape_argument = [&](size_t pos, char esc) {
+        auto has_arg = [&](const char* openers) {
+            return pos < pat.size() && pat[pos] != '\0'
+                && strchr(openers, pat[pos]) != nullptr;
+        };
+
+        switch (esc) {
+            case 'x':
+                if (has_arg("{")) {
+                    return skip_delimited(pos);
+                }
+                for (auto lpc = 0; lpc < 2 && pos < pat.size()
+                     && isxdigit((unsigned char) pat[pos]);
+                     lpc++)
+                {
+                    pos += 1;
+                }
+                break;
+            case 'o':
+            case 'N':
+                if (has_arg("{")) {
+                    return skip_delimited(pos);
+                }
+                break;
+            case 'p':
+            case 'P':
+                if (has_arg("{")) {
+                    return skip_delimited(pos);
+                }
+                if (pos < pat.size()) {
+                    pos += 1;
+                }
+                break;
+            case 'g':
+            case 'k':
+                if (has_arg("{<'")) {
+                    return skip_delimited(pos);
+                }
+                if (has_arg("+-")) {
+                    pos += 1;
+                }
+                while (pos < pat.size() && isdigit((unsigned char) pat[pos])) {
+                    pos += 1;
+                }
+                break;
+            case 'c':
+                if (pos < pat.size()) {
+                    pos += 1;
+                }
+                break;
+            default:
+                // Octal escapes and back references.
+                if (isdigit((unsigned char) esc)) {
+                    while (pos < pat.size()
+                           && isdigit((unsigned char) pat[pos]))
+                    {
+                        pos += 1;
+                    }
+                }
+                break;
+        }
+
+        return pos;
+    };
+
+    size_t index = 0;
+    while (index < pat.size()) {
+        auto ch = pat[index];
+
+        switch (ch) {
+            case '|':
+                // Alternation at the top level means nothing is required.
+                return {};
+            case '(': {
+                // Skip over the group since it might be optional or contain
+                // alternatives.
+                flush();
+                auto depth = 0;
+                auto in_class = false;
+                for (; index < pat.size(); index++) {
+                    if (pat[index] == '\\') {
+                        if (index + 1 < pat.size() && pat[index + 1] == 'Q') {
+                            return {};
+                        }
+                        index += 1;
+                    } else if (in_class) {
+                        if (pat.compare(index, 2, "[:") == 0) {
+                            auto end = pat.find(":]", index + 2);
+                            if (end == std::string::npos) {
+                                return {};
+                            }
+                            index = end + 1;
+                            continue;
+                        }
+                        if (pat[index] == ']') {
+                            in_class = false;
+                        }
+                    } else if (pat[index] == '[') {
+                        in_class = true;
+                        if (index + 1 < pat.size() && pat[index + 1] == ']') {
+                            index += 1;
+                        }
+                    } else if (pat[index] == '(') {
+                        depth += 1;
+                    } else if (pat[index] == ')') {
+                        depth -= 1;
+                        if (depth == 0) {
+                            break;
+                        }
+                    }
+                }
+                if (depth != 0) {
+                    return {};
+                }
+                index += 1;
+                break;
+            }
+            case ')':
+                return {};
+            case '[': {
+                flush();
+                index += 1;
+                if (index < pat.size() && pat[index] == '^') {
+                    index += 1;
+                }
+                if (index < pat.size() && pat[index] == ']') {
+                    index += 1;
+                }
+                while (index < pat.size() && pat[index] != ']') {
+                    if (pat[index] == '\\') {
+                        if (index + 1 < pat.size() && pat[index + 1] == 'Q') {
+                            return {};
+                        }
+                        index += 1;
+                    } else if (pat.compare(index, 2, "[:") == 0) {
+                        auto end = pat.find(":]", index + 2);
+                        if (end == std::string::npos) {
+                            return {};
+                        }
+                        index = end + 1;
+                    }
+                    index += 1;
+                }
+                if (index >= pat.size()) {
+                    return {};
+                }
+                index += 1;
+                break;
+            }
+            case '?':
+            case '*':
+                drop_last();
+                index += 1;
+                break;
+            case '{': {
+                // A "{n}", "{n,}", "{n,m}" or "{,m}" quantifier, where
+                // a minimum of zero makes the last character optional.
+                auto lpc = index + 1;
+                auto has_digits = false;
+                auto min_is_zero = true;
+                auto in_max = false;
+                for (; lpc < pat.size(); lpc++) {
+                    auto qch = pat[lpc];
+
+                    if (isdigit((unsigned char) qch)) {
+                        has_digits = true;
+                        if (!in_max && qch != '0') {
+                            min_is_zero = false;
+                        }
+                    } else if (qch == ',' && !in_max) {
+                        in_max = true;
+                    } else if (qch != ' ') {
+                        break;
+                    }
+                }
+                if (has_digits && lpc < pat.size() && pat[lpc] == '}') {
+                    if (min_is_zero) {
+                        drop_last();
+                    } else {
+                        flush();
+                    }
+                    index = lpc + 1;
+                } else {
+                    // Not a quantifier, so the brace is taken literally,
+                    // but it is not required to keep things simple.
+                    flush();
+                    index += 1;
+                }
+                break;
+            }
+            case '+':
+                flush();
+                index += 1;
+                break;
+            case '.':
+            case '^':
+            case '$':
+                flush();
+                index += 1;
+                break;
+            case '\\': {
+                if (index + 1 >= pat.size()) {
+                    return {};
+                }
+                auto next = pat[index + 1];
+                if (next == 'Q') {
+                    auto end = pat.find("\\E", index + 2);
+                    auto lit_end = end == std::string::npos ? pat.size() : end;
+                    for (auto lpc = index + 2; lpc < lit_end; lpc++) {
+                        add_char(pat[lpc]);
+                    }
+                    index = end == std::string::npos ? pat.size() : end + 2;
+                } else if (!isalnum((unsigned char) next)) {
+                    add_char(next);
+                    index += 2;
+                } else if (strchr(KNOWN_ESCAPES, next) != nullptr) {
+                    flush();
+                    index = skip_escape_argument(index + 2, next);
+                } else {
+                    // Nothing can be required if the escape is not
+                    // understood.
+                    return {};
+                }
+                break;
+            }
+            default:
+                add_char(ch);
+                index += 1;
+                break;
+        }
+    }
+    flush();
+
+    return retval;
+}
+
+namespace {
+
+inline uint8_t
+fold_ascii(uint8_t ch)
+{
+    if ('A' <= ch && ch <= 'Z') {
+        return ch + ('a' - 'A');
+    }
+    return ch;
+}
+
+}  // namespace
+
+size_t
+code_set::add(std::shared_ptr<code> co)
+{
+    auto retval = this->cs_entries.size();
+    auto literals = co->get_required_literals();
+
+    for (auto& lit : literals) {
+        std::transform(lit.begin(), lit.end(), lit.begin(), fold_ascii);
+    }
+    std::sort(literals.begin(), literals.end());
+    literals.erase(std::unique(literals.begin(), literals.end()),
+                   literals.end());
+
+    auto& ent = this->cs_entries.emplace_back();
+    ent.e_code = std::move(co);
+    ent.e_literal_count = literals.size();
+    for (auto& lit : literals) {
+        this->cs_literals.emplace_back(std::move(lit), retval);
+    }
+    this->cs_compiled = false;
+
+    return retval;
+}
+
+void
+code_set::clear()
+{
+    this->cs_entries.clear();
+    this->cs_literals.clear();
+    this->cs_compiled = false;
+    this->cs_transitions.clear();
+    this->cs_outputs.clear();
+    this->cs_literal_generation.clear();
+}
+
+void
+code_set::compile()
+{
+    static constexpr uint32_t NO_STATE = UINT32_MAX;
+
+    this->cs_transitions.assign(256, NO_STATE);
+    this->cs_outputs.assign(1, {});
+
+    // Build the trie of the literals.
+    for (uint32_t lit_index = 0; lit_index < this->cs_literals.size();
+         lit_index++)
+    {
+        uint32_t state = 0;
+
+        for (auto ch : this->cs_literals[lit_index].first) {
+            auto& next = this->cs_transitions[state * 256 + (uint8_t) ch];
+            if (next == NO_STATE) {
+                next = this->cs_outputs.size();
+                this->cs_outputs.emplace_back();
+                this->cs_transitions.resize(this->cs_transitions.size() + 256,
+                                            NO_STATE);
+            }
+            state = this->cs_transitions[state * 256 + (uint8_t) ch];
+        }
+        this->cs_outputs[state].emplace_back(lit_index);
+    }
+
+    // Compute the fail links breadth-first and turn the trie into a
+    // complete transition table.
+    std::vector<uint32_t> fail(this->cs_outputs.size(), 0);
+    std::vector<uint32_t> queue;
+    for (size_t ch = 0; ch < 256; ch++) {
+        auto& next = this->cs_transitions[ch];
+        if (next == NO_STATE) {
+            next = 0;
+        } else {
+            queue.emplace_back(next);
+        }
+    }
+    for (size_t qi = 0; qi < queue.size(); qi++) {
+        auto state = queue[qi];
+        auto& outputs = this->cs_outputs[state];
+        const auto& fail_outputs = this->cs_outputs[fail[state]];
+
+        outputs.insert(outputs.end(), fail_outputs.begin(), fail_outputs.end());
+        for (size_t ch = 0; ch < 256; ch++) {
+            auto& next = this->cs_transitions[state * 256 + ch];
+            auto fail_next = this->cs_transitions[fail[state] * 256 + ch];
+            if (next == NO_STATE) {
+                next = fail_next;
+            } else {
+                fail[next] = fail_next;
+                queue.emplace_back(next);
+            }
+        }
+    }
+
+    this->cs_literal_generation.assign(this->cs_literals.size(), 0);
+    this->cs_compiled = true;
+}
+
+size_t
+code_set::find_in(string_fragment in,
+                  uint32_t options,
+                  std::vector<bool>& matched_out)
+{
+    if (!this->cs_compiled) {
+        this->compile();
+    }
+
+    this->cs_generation += 1;
+    if (this->cs_generation == 0) {
+        // Wrapped around, reset so stale generations cannot collide.
+        std::fill(this->cs_literal_generation.begin(),
+                  this->cs_literal_generation.end(),
+                  0);
+        for (auto& ent : this->cs_entries) {
+            ent.e_generation = 0;
+        }
+        this->cs_generation = 1;
+    }
+
+    auto gen = this->cs_generation;
+    if (!this->cs_literals.empty()) {
+        uint32_t state = 0;
+
+        for (auto ch : in) {
+            state = this->cs_transitions[state * 256 + fold_ascii(ch)];
+            for (auto lit_index : this->cs_outputs[state]) {
+                if (this->cs_literal_generation[lit_index] == gen) {
+                    continue;
+                }
+                this->cs_literal_generation[lit_index] = gen;
+
+                auto& ent
+                    = this->cs_entries[this->cs_literals[lit_index].second];
+                if (ent.e_generation != gen) {
+                    ent.e_generation = gen;
+                    ent.e_hits = 0;
+                }
+                ent.e_hits += 1;
+            }
+        }
+    }
+
+    size_t retval = 0;
+    matched_out.assign(this->cs_entries.size(), false);
+    for (size_t lpc = 0; lpc < this->cs_entries.size(); lpc++) {
+        const auto& ent = this->cs_entries[lpc];
+
+        if (ent.e_literal_count > 0
+            && (ent.e_generation != gen || ent.e_hits < ent.e_literal_count))
+        {
+            continue;
+        }
+
+        auto find_res = ent.e_code->find_in(in, options).ignore_error();
+        if (find_res) {
+            matched_out[lpc] = true;
+            retval += 1;
+        }
+    }
+
+    return retval;
+}
+
 std::vector<string_fragment>
 code::get_captures() const
 {
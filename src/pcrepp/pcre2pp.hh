@@ -32,6 +32,7 @@
 
 #define PCRE2_CODE_UNIT_WIDTH 8
 
+#include <bitset>
 #include <memory>
 #include <optional>
 #include <string>
@@ -282,6 +283,28 @@ public:
 
     size_t get_capture_count() const;
 
+    struct start_info {
+        /** True if a match can only start at the beginning of the subject. */
+        bool si_anchored{false};
+        /** The bytes that a match can start with, if they are known. */
+        std::optional<std::bitset<256>> si_first_bytes;
+        /** The minimum number of bytes needed for a match. */
+        size_t si_min_length{0};
+    };
+
+    /**
+     * @return What PCRE2 has worked out about where a match can start.
+     */
+    start_info get_start_info() const;
+
+    /**
+     * @return Literal strings that must appear in any subject that this
+     * pattern matches, ignoring ASCII case.  The list does not need to be
+     * complete, but it is empty if any part of the pattern is not
+     * understood, so every literal that is returned is required.
+     */
+    std::vector<std::string> get_required_literals() const;
+
     int name_index(const char* name) const;
 
     std::vector<string_fragment> get_captures() const;
@@ -331,6 +354,63 @@ private:
     match_data p_match_proto;
 };
 
+/**
+ * A set of patterns that are checked against a subject together.  The
+ * literals required by each pattern are found in a single pass over the
+ * subject with an Aho-Corasick automaton, then only the patterns whose
+ * literals were all found need to be run.  The set keeps scratch state, so
+ * it cannot be shared between threads.
+ */
+class code_set {
+public:
+    /**
+     * Add a pattern to the set.
+     *
+     * @return The position of the pattern in the results of find_in().
+     */
+    size_t add(std::shared_ptr<code> co);
+
+    size_t size() const { return this->cs_entries.size(); }
+
+    bool empty() const { return this->cs_entries.empty(); }
+
+    void clear();
+
+    /**
+     * Check the subject against all of the patterns in the set.
+     *
+     * @param in The subject.
+     * @param options The options to pass to pcre2_match().
+     * @param matched_out Resized to the number of patterns and set to true
+     *   for the patterns that matched.
+     * @return The number of patterns that matched.
+     */
+    size_t find_in(string_fragment in,
+                   uint32_t options,
+                   std::vector<bool>& matched_out);
+
+private:
+    struct entry {
+        std::shared_ptr<code> e_code;
+        uint32_t e_literal_count{0};
+        uint32_t e_generation{0};
+        uint32_t e_hits{0};
+    };
+
+    void compile();
+
+    std::vector<entry> cs_entries;
+    /** The literals of all the patterns and the entry they belong to. */
+    std::vector<std::pair<std::string, uint32_t>> cs_literals;
+    bool cs_compiled{false};
+    /** The goto function of the automaton, indexed by state * 256 + byte. */
+    std::vector<uint32_t> cs_transitions;
+    /** The literals that end at each state, including through fail links. */
+    std::vector<std::vector<uint32_t>> cs_outputs;
+    std::vector<uint32_t> cs_literal_generation;
+    uint32_t cs_generation{0};
+};
+
 template<typename T, std::size_t N>
 std::optional<string_fragment>
 match_data::operator[](const T (&name)[N]) const
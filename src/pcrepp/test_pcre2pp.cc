@@ -27,10 +27,13 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <chrono>
+
 #include "config.h"
 
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #include "doctest/doctest.h"
+#include "fmt/format.h"
 #include "pcre2pp.hh"
 
 TEST_CASE("marks")
@@ -325,3 +328,438 @@ TEST_CASE("anchored")
     CHECK_FALSE(re.find_in(sub2).ignore_error().has_value());
     CHECK_FALSE(re.find_in(sub3).ignore_error().has_value());
 }
+
+TEST_CASE("start info")
+{
+    {
+        auto co = lnav::pcre2pp::code::from_const(R"(^\[(\d+)\] .*)");
+        auto si = co.get_start_info();
+
+        CHECK(si.si_anchored);
+        REQUIRE(si.si_first_bytes.has_value());
+        CHECK(si.si_first_bytes->test('['));
+        CHECK_FALSE(si.si_first_bytes->test('a'));
+        CHECK(si.si_min_length == 4);
+    }
+
+    {
+        auto co = lnav::pcre2pp::code::from_const(R"(^(?:\d+|foo) )");
+        auto si = co.get_start_info();
+
+        CHECK(si.si_anchored);
+        REQUIRE(si.si_first_bytes.has_value());
+        CHECK(si.si_first_bytes->test('0'));
+        CHECK(si.si_first_bytes->test('f'));
+        CHECK_FALSE(si.si_first_bytes->test('b'));
+    }
+
+    {
+        auto co = lnav::pcre2pp::code::from_const(R"(\d+ foo)");
+        auto si = co.get_start_info();
+
+        CHECK_FALSE(si.si_anchored);
+    }
+}
+
+TEST_CASE("required literals")
+{
+    {
+        auto co = lnav::pcre2pp::code::from_const(
+            R"(request-id=([a-f0-9]+) failed\.)");
+        auto lits = co.get_required_literals();
+
+        REQUIRE(lits.size() == 2);
+        CHECK(lits[0] == "request-id=");
+        CHECK(lits[1] == " failed.");
+    }
+
+    {
+        auto co = lnav::pcre2pp::code::from_const(R"(colou?r \d+ items)");
+        auto lits = co.get_required_literals();
+
+        REQUIRE(lits.size() == 2);
+        CHECK(lits[0] == "colo");
+        CHECK(lits[1] == " items");
+    }
+
+    {
+        auto co = lnav::pcre2pp::code::from_const(R"(abcdef|ghijkl)");
+
+        CHECK(co.get_required_literals().empty());
+    }
+
+    {
+        auto co = lnav::pcre2pp::code::from_const(R"(start (foo|bar) end)");
+        auto lits = co.get_required_literals();
+
+        REQUIRE(lits.size() == 2);
+        CHECK(lits[0] == "start ");
+        CHECK(lits[1] == " end");
+    }
+
+    {
+        auto co = lnav::pcre2pp::code::from_const(R"(\Qa.b*c\E[xyz]+)");
+        auto lits = co.get_required_literals();
+
+        REQUIRE(lits.size() == 1);
+        CHECK(lits[0] == "a.b*c");
+    }
+
+    {
+        auto co = lnav::pcre2pp::code::from_const(R"((?i)disk full)");
+        auto lits = co.get_required_literals();
+
+        REQUIRE(lits.size() == 1);
+        CHECK(lits[0] == " full");
+    }
+
+    {
+        auto co = lnav::pcre2pp::code::from_const(R"((?x) abc def)");
+
+        CHECK(co.get_required_literals().empty());
+    }
+
+    {
+        auto co
+            = lnav::pcre2pp::code::from_const(R"(error \d{3} occurred)");
+        auto lits = co.get_required_literals();
+
+        REQUIRE(lits.size() == 2);
+        CHECK(lits[0] == "error ");
+        CHECK(lits[1] == " occurred");
+    }
+
+    {
+        auto co = lnav::pcre2pp::code::from_const(R"(ab{2}cdef)");
+        auto lits = co.get_required_literals();
+
+        REQUIRE(lits.size() == 1);
+        CHECK(lits[0] == "cdef");
+    }
+
+    {
+        auto co = lnav::pcre2pp::code::from_const(R"(abc{2,}def)");
+        auto lits = co.get_required_literals();
+
+        REQUIRE(lits.size() == 2);
+        CHECK(lits[0] == "abc");
+        CHECK(lits[1] == "def");
+    }
+
+    {
+        auto co = lnav::pcre2pp::code::from_const(R"(\x41BCDE)");
+        auto lits = co.get_required_literals();
+
+        REQUIRE(lits.size() == 1);
+        CHECK(lits[0] == "BCDE");
+    }
+
+    {
+        auto co = lnav::pcre2pp::code::from_const(R"(\x{41}BCDE\o{101}xyz)");
+        auto lits = co.get_required_literals();
+
+        REQUIRE(lits.size() == 2);
+        CHECK(lits[0] == "BCDE");
+        CHECK(lits[1] == "xyz");
+    }
+
+    {
+        auto co = lnav::pcre2pp::code::from_const(R"(id=\p{L}xyz\PLabc)");
+        auto lits = co.get_required_literals();
+
+        REQUIRE(lits.size() == 3);
+        CHECK(lits[0] == "id=");
+        CHECK(lits[1] == "xyz");
+        CHECK(lits[2] == "abc");
+    }
+
+    {
+        auto co = lnav::pcre2pp::code::from_const(R"(fo{0}oba)");
+        auto lits = co.get_required_literals();
+
+        REQUIRE(lits.size() == 1);
+        CHECK(lits[0] == "oba");
+    }
+
+    {
+        auto co = lnav::pcre2pp::code::from_const(R"(abcd{0,2}efg)");
+        auto lits = co.get_required_literals();
+
+        REQUIRE(lits.size() == 2);
+        CHECK(lits[0] == "abc");
+        CHECK(lits[1] == "efg");
+    }
+
+    {
+        auto co = lnav::pcre2pp::code::from_const(
+            R"((?<word>abc) \g{word}xyz \k<word>ghi)");
+        auto lits = co.get_required_literals();
+
+        REQUIRE(lits.size() == 2);
+        CHECK(lits[0] == "xyz ");
+        CHECK(lits[1] == "ghi");
+    }
+
+    {
+        // The whole multi-byte character is optional, not just its last
+        // byte.
+        auto co = lnav::pcre2pp::code::from_const(R"(cafés? au lait)");
+        auto lits = co.get_required_literals();
+
+        REQUIRE(lits.size() == 2);
+        CHECK(lits[0] == "caf\xc3\xa9");
+        CHECK(lits[1] == " au lait");
+    }
+
+    {
+        auto co = lnav::pcre2pp::code::from_const(R"(café?)");
+        auto lits = co.get_required_literals();
+
+        REQUIRE(lits.size() == 1);
+        CHECK(lits[0] == "caf");
+    }
+
+    {
+        auto co = lnav::pcre2pp::code::from_const(R"(abc(*ACCEPT)def)");
+
+        CHECK(co.get_required_literals().empty());
+    }
+}
+
+TEST_CASE("code_set")
+{
+    lnav::pcre2pp::code_set cs;
+    std::vector<bool> matched;
+
+    cs.add(lnav::pcre2pp::code::from_const(R"(disk \w+ full)").to_shared());
+    cs.add(lnav::pcre2pp::code::from_const(R"((?i)timeout)").to_shared());
+    cs.add(lnav::pcre2pp::code::from_const(R"(\d{3})").to_shared());
+    cs.add(lnav::pcre2pp::code::from_const(R"(disk)").to_shared());
+
+    CHECK(cs.find_in("the disk sda full"_frag, 0, matched) == 2);
+    REQUIRE(matched.size() == 4);
+    CHECK(matched[0]);
+    CHECK_FALSE(matched[1]);
+    CHECK_FALSE(matched[2]);
+    CHECK(matched[3]);
+
+    CHECK(cs.find_in("request TIMEOUT after 500ms"_frag, 0, matched) == 2);
+    CHECK_FALSE(matched[0]);
+    CHECK(matched[1]);
+    CHECK(matched[2]);
+    CHECK_FALSE(matched[3]);
+
+    CHECK(cs.find_in("the disk is fine"_frag, 0, matched) == 1);
+    CHECK(matched[3]);
+
+    CHECK(cs.find_in(""_frag, 0, matched) == 0);
+
+    cs.clear();
+    CHECK(cs.find_in("disk"_frag, 0, matched) == 0);
+    CHECK(matched.empty());
+}
+
+TEST_CASE("code_set quantified and escaped patterns")
+{
+    static const char* PATTERNS[] = {
+        R"(error \d{3} occurred)",
+        R"(ab{2}cdef)",
+        R"(\x41BCDE)",
+        R"(id=\p{L}xyz)",
+        R"(fo{0}oba)",
+        R"([[:digit:]]] end)",
+        R"(\u0041bcd)",
+    };
+    static const char* SUBJECTS[] = {
+        "an error 404 occurred",
+        "xabbcdefx",
+        "ABCDE",
+        "id=Qxyz",
+        "foba",
+        "7] end",
+        "u0041bcd",
+        "nothing to see here",
+    };
+
+    lnav::pcre2pp::code_set cs;
+    std::vector<lnav::pcre2pp::code> codes;
+    std::vector<bool> matched;
+
+    for (const auto* pat : PATTERNS) {
+        auto compile_res = lnav::pcre2pp::code::from(
+            string_fragment::from_c_str(pat));
+        if (compile_res.isErr()) {
+            // Some escapes are only valid with certain options.
+            continue;
+        }
+        codes.emplace_back(compile_res.unwrap());
+        cs.add(lnav::pcre2pp::code::from(string_fragment::from_c_str(pat))
+                   .unwrap()
+                   .to_shared());
+    }
+
+    // The set has to agree with running each pattern on its own.
+    for (const auto* subject : SUBJECTS) {
+        auto sf = string_fragment::from_c_str(subject);
+
+        cs.find_in(sf, 0, matched);
+        REQUIRE(matched.size() == codes.size());
+        for (size_t lpc = 0; lpc < codes.size(); lpc++) {
+            CAPTURE(subject);
+            CAPTURE(lpc);
+            CHECK(matched[lpc]
+                  == codes[lpc].find_in(sf).ignore_error().has_value());
+        }
+    }
+}
+
+TEST_CASE("code_set multi-byte and verb patterns")
+{
+    static const char* PATTERNS[] = {
+        R"(café?)",
+        R"(cafés? au lait)",
+        R"(abc(*ACCEPT)def)",
+        R"(naïve?)",
+        R"(x(*COMMIT)yzw)",
+    };
+    static const char* SUBJECTS[] = {
+        "caf",
+        "a café",
+        "café au lait",
+        "cafés au lait",
+        "caf au lait",
+        "abc",
+        "abcdef",
+        "naï",
+        "naïve",
+        "na",
+        "xyzw",
+        "nothing to see here",
+    };
+
+    lnav::pcre2pp::code_set cs;
+    std::vector<lnav::pcre2pp::code> codes;
+    std::vector<bool> matched;
+
+    for (const auto* pat : PATTERNS) {
+        auto pat_sf = string_fragment::from_c_str(pat);
+
+        codes.emplace_back(lnav::pcre2pp::code::from(pat_sf).unwrap());
+        cs.add(lnav::pcre2pp::code::from(pat_sf).unwrap().to_shared());
+    }
+
+    // The literals used to skip patterns must not hide any matches.
+    for (const auto* subject : SUBJECTS) {
+        auto sf = string_fragment::from_c_str(subject);
+
+        cs.find_in(sf, 0, matched);
+        REQUIRE(matched.size() == codes.size());
+        for (size_t lpc = 0; lpc < codes.size(); lpc++) {
+            CAPTURE(subject);
+            CAPTURE(lpc);
+            CHECK(matched[lpc]
+                  == codes[lpc].find_in(sf).ignore_error().has_value());
+        }
+    }
+
+    CHECK(cs.find_in("caf"_frag, 0, matched) == 1);
+    CHECK(matched[0]);
+    CHECK(cs.find_in("abc"_frag, 0, matched) == 1);
+    CHECK(matched[2]);
+}
+
+/**
+ * Compares running a list of filter patterns one after another against
+ * checking them as a code_set.  Run it with:
+ *
+ *   test_pcre2pp --no-skip -tc="code_set-benchmark"
+ */
+TEST_CASE("code_set-benchmark" * doctest::skip())
+{
+    static constexpr size_t LINE_COUNT = 100 * 1000;
+    static const char* PATTERNS[] = {
+        R"(connection reset by peer)",
+        R"((?i)timed? ?out after \d+ms)",
+        R"(user=alice\b)",
+        R"(disk \S+ is full)",
+        R"(status=5\d\d)",
+        R"(GET /api/v\d/health)",
+        R"(segfault at [0-9a-f]+)",
+        R"((?i)out of memory)",
+        R"(retrying in \d+ seconds)",
+        R"(certificate has expired)",
+        R"(deadlock detected)",
+        R"(session \w+ closed)",
+        R"(kernel: oom-killer)",
+        R"(ssh.*Failed password)",
+        R"(cache miss for key \w+)",
+        R"(replica lag \d+ seconds)",
+        R"((?i)permission denied)",
+        R"(slow query: \d+ ms)",
+        R"(heartbeat missed from node\d+)",
+        R"(unexpected EOF while reading)",
+    };
+
+    std::vector<std::string> lines;
+    lines.reserve(LINE_COUNT);
+    for (size_t lpc = 0; lpc < LINE_COUNT; lpc++) {
+        lines.emplace_back(fmt::format(
+            FMT_STRING("2024-05-0{} 12:{:02}:{:02} host{} app[{}]: request "
+                       "{} completed status={} in {}ms user=bob"),
+            lpc % 9 + 1,
+            lpc % 60,
+            lpc % 59,
+            lpc % 7,
+            1000 + lpc % 97,
+            lpc,
+            lpc % 50 == 0 ? 503 : 200,
+            lpc % 300));
+        if (lpc % 1000 == 0) {
+            lines.back().append(" connection reset by peer");
+        }
+    }
+
+    std::vector<std::shared_ptr<lnav::pcre2pp::code>> codes;
+    for (const auto* pat : PATTERNS) {
+        codes.emplace_back(lnav::pcre2pp::code::from(string_fragment::from_c_str(pat))
+                               .unwrap()
+                               .to_shared());
+    }
+
+    for (const size_t filter_count : {1, 5, 10, 15, 20}) {
+        size_t seq_hits = 0;
+        auto seq_start = std::chrono::steady_clock::now();
+        for (const auto& line : lines) {
+            auto sf = string_fragment::from_str(line);
+            for (size_t lpc = 0; lpc < filter_count; lpc++) {
+                if (codes[lpc]->find_in(sf).ignore_error()) {
+                    seq_hits += 1;
+                }
+            }
+        }
+        auto seq_end = std::chrono::steady_clock::now();
+
+        lnav::pcre2pp::code_set cs;
+        std::vector<bool> matched;
+        size_t set_hits = 0;
+        for (size_t lpc = 0; lpc < filter_count; lpc++) {
+            cs.add(codes[lpc]);
+        }
+        auto set_start = std::chrono::steady_clock::now();
+        for (const auto& line : lines) {
+            set_hits += cs.find_in(string_fragment::from_str(line), 0, matched);
+        }
+        auto set_end = std::chrono::steady_clock::now();
+
+        CHECK(seq_hits == set_hits);
+        auto seq_secs
+            = std::chrono::duration<double>(seq_end - seq_start).count();
+        auto set_secs
+            = std::chrono::duration<double>(set_end - set_start).count();
+        MESSAGE(fmt::format(FMT_STRING("{:2} filters: sequential {:.2f}M "
+                                       "lines/s, code_set {:.2f}M lines/s"),
+                            filter_count,
+                            LINE_COUNT / seq_secs / 1e6,
+                            LINE_COUNT / set_secs / 1e6));
+    }
+}
@@ -113,6 +113,76 @@ public:
     std::vector<vis_line_t> fss_lines;
 };
 
+namespace {
+
+using cached_value = lnav::column_cache::cached_value;
+using cell_kind = lnav::column_cache::cell_kind;
+
+/**
+ * Get the numeric value of a column for a message, using the column cache of
+ * the file when possible.
+ *
+ * @param values_provider Function that extracts the message values when they
+ *   are not in the cache.
+ */
+template<typename F>
+std::optional<cached_value>
+numeric_value_for(logfile* lf,
+                  size_t line,
+                  intern_string_t colname,
+                  F values_provider)
+{
+    auto& cache = lf->get_column_cache();
+    auto cv_opt = cache.lookup(line, colname);
+
+    if (!cv_opt || cv_opt->cv_kind == cell_kind::uncached) {
+        const auto& values = values_provider();
+
+        cache.record(line, values);
+        auto lv_iter = find_if(values.begin(),
+                               values.end(),
+                               logline_value_name_cmp(&colname));
+        if (lv_iter == values.end()) {
+            return std::nullopt;
+        }
+        cv_opt = lnav::column_cache::to_cached_value(*lv_iter);
+    }
+
+    switch (cv_opt->cv_kind) {
+        case cell_kind::integer:
+        case cell_kind::real:
+            return cv_opt;
+        default:
+            return std::nullopt;
+    }
+}
+
+std::optional<cached_value>
+numeric_value_for(const logline_window::logmsg_info& msg_info,
+                  intern_string_t colname)
+{
+    return numeric_value_for(
+        msg_info.get_file_ptr(),
+        msg_info.get_file_line_number(),
+        colname,
+        [&msg_info]() -> const std::vector<logline_value>& {
+            return msg_info.get_values().lvv_values;
+        });
+}
+
+bool
+in_range(const cached_value& cv, double range_min, double range_max)
+{
+    if (cv.cv_kind == cell_kind::real) {
+        return range_min <= cv.cv_value.cv_real
+            && cv.cv_value.cv_real < range_max;
+    }
+
+    return range_min <= cv.cv_value.cv_int && cv.cv_value.cv_int < range_max;
+}
+
+}  // namespace
+
 log_spectro_value_source::log_spectro_value_source(intern_string_t colname)
     : lsvs_colname(colname)
 {
@@ -215,31 +285,23 @@ log_spectro_value_source::spectro_row(spectrogram_request& sr,
             break;
         }
 
-        const auto& values = msg_info.get_values();
-        auto lv_iter = find_if(values.lvv_values.begin(),
-                               values.lvv_values.end(),
-                               logline_value_name_cmp(&this->lsvs_colname));
-
-        if (lv_iter != values.lvv_values.end()) {
-            switch (lv_iter->lv_meta.lvm_kind) {
-                case value_kind_t::VALUE_FLOAT:
-                    row_out.add_value(sr,
-                                      spectrogram_row::value_type::real,
-                                      lv_iter->lv_value.d,
-                                      ll.is_marked());
-                    row_out.sr_tdigest.insert(lv_iter->lv_value.d);
-                    break;
-                case value_kind_t::VALUE_INTEGER: {
-                    row_out.add_value(sr,
-                                      spectrogram_row::value_type::integer,
-                                      lv_iter->lv_value.i,
-                                      ll.is_marked());
-                    row_out.sr_tdigest.insert(lv_iter->lv_value.i);
-                    break;
-                }
-                default:
-                    break;
-            }
+        auto cv_opt = numeric_value_for(msg_info, this->lsvs_colname);
+        if (!cv_opt) {
+            continue;
+        }
+
+        if (cv_opt->cv_kind == cell_kind::real) {
+            row_out.add_value(sr,
+                              spectrogram_row::value_type::real,
+                              cv_opt->cv_value.cv_real,
+                              ll.is_marked());
+            row_out.sr_tdigest.insert(cv_opt->cv_value.cv_real);
+        } else {
+            row_out.add_value(sr,
+                              spectrogram_row::value_type::integer,
+                              cv_opt->cv_value.cv_int,
+                              ll.is_marked());
+            row_out.sr_tdigest.insert(cv_opt->cv_value.cv_int);
         }
     }
 
@@ -265,32 +327,9 @@ log_spectro_value_source::spectro_row(spectrogram_request& sr,
                 break;
             }
 
-            const auto& values = msg_info.get_values();
-            auto lv_iter = find_if(values.lvv_values.begin(),
-                                   values.lvv_values.end(),
-                                   logline_value_name_cmp(&this->lsvs_colname));
-
-            if (lv_iter != values.lvv_values.end()) {
-                switch (lv_iter->lv_meta.lvm_kind) {
-                    case value_kind_t::VALUE_FLOAT:
-                        if (range_min <= lv_iter->lv_value.d
-                            && lv_iter->lv_value.d < range_max)
-                        {
-                            retval->fss_lines.emplace_back(
-                                msg_info.get_vis_line());
-                        }
-                        break;
-                    case value_kind_t::VALUE_INTEGER:
-                        if (range_min <= lv_iter->lv_value.i
-                            && lv_iter->lv_value.i < range_max)
-                        {
-                            retval->fss_lines.emplace_back(
-                                msg_info.get_vis_line());
-                        }
-                        break;
-                    default:
-                        break;
-                }
+            auto cv_opt = numeric_value_for(msg_info, this->lsvs_colname);
+            if (cv_opt && in_range(cv_opt.value(), range_min, range_max)) {
+                retval->fss_lines.emplace_back(msg_info.get_vis_line());
             }
         }
 
@@ -349,39 +388,30 @@ log_spectro_value_source::spectro_mark(textview_curses& tc,
             continue;
         }
 
-        values.clear();
-        lf->read_full_message(ll, values.lvv_sbr);
-        values.lvv_sbr.erase_ansi();
-        sa.clear();
-        format->annotate(lf.get(), cl, sa, values);
-
-        auto lv_iter = find_if(values.lvv_values.begin(),
-                               values.lvv_values.end(),
-                               logline_value_name_cmp(&this->lsvs_colname));
-
-        if (lv_iter != values.lvv_values.end()) {
-            switch (lv_iter->lv_meta.lvm_kind) {
-                case value_kind_t::VALUE_FLOAT:
-                    if (range_min <= lv_iter->lv_value.d
-                        && lv_iter->lv_value.d <= range_max)
-                    {
-                        log_tc.set_user_mark(&textview_curses::BM_USER,
-                                             curr_line,
-                                             op == mark_op_t::add);
-                    }
-                    break;
-                case value_kind_t::VALUE_INTEGER:
-                    if (range_min <= lv_iter->lv_value.i
-                        && lv_iter->lv_value.i <= range_max)
-                    {
-                        log_tc.set_user_mark(&textview_curses::BM_USER,
-                                             curr_line,
-                                             op == mark_op_t::add);
-                    }
-                    break;
-                default:
-                    break;
-            }
+        auto cv_opt = numeric_value_for(
+            lf.get(),
+            cl,
+            this->lsvs_colname,
+            [&]() -> const std::vector<logline_value>& {
+                values.clear();
+                lf->read_full_message(ll, values.lvv_sbr);
+                values.lvv_sbr.erase_ansi();
+                sa.clear();
+                format->annotate(lf.get(), cl, sa, values);
+                return values.lvv_values;
+            });
+        if (!cv_opt) {
+            continue;
+        }
+
+        auto matched = cv_opt->cv_kind == cell_kind::real
+            ? (range_min <= cv_opt->cv_value.cv_real
+               && cv_opt->cv_value.cv_real <= range_max)
+            : (range_min <= cv_opt->cv_value.cv_int
+               && cv_opt->cv_value.cv_int <= range_max);
+        if (matched) {
+            log_tc.set_user_mark(
+                &textview_curses::BM_USER, curr_line, op == mark_op_t::add);
         }
     }
 }
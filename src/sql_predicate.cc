@@ -0,0 +1,1189 @@
+/**
+ * Copyright (c) 2026, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *
+ * @file sql_predicate.cc
+ */
+
+#include <algorithm>
+#include <string>
+
+#include "sql_predicate.hh"
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#include "pcrepp/pcre2pp.hh"
+
+namespace lnav::sql {
+
+namespace {
+
+/** The same limit SQLite places on LIKE and GLOB patterns. */
+constexpr size_t MAX_PATTERN_LENGTH = 50000;
+
+enum class token_kind : uint8_t {
+    eof,
+    keyword,
+    variable,
+    string,
+    integer,
+    real,
+    lparen,
+    rparen,
+    comma,
+    eq,
+    ne,
+    lt,
+    le,
+    gt,
+    ge,
+    minus,
+    plus,
+    other,
+};
+
+struct token {
+    token_kind t_kind{token_kind::eof};
+    string_fragment t_text;
+    std::string t_string;
+    int64_t t_int{0};
+    double t_real{0.0};
+
+    bool is_keyword(const char* kw) const
+    {
+        return this->t_kind == token_kind::keyword
+            && this->t_text.length() == (int) strlen(kw)
+            && strncasecmp(this->t_text.data(), kw, this->t_text.length())
+            == 0;
+    }
+};
+
+bool
+is_id_char(char ch)
+{
+    return isalnum((unsigned char) ch) || ch == '_' || ch == '$'
+        || (ch & 0x80);
+}
+
+class lexer {
+public:
+    explicit lexer(string_fragment sf) : l_input(sf) {}
+
+    token next()
+    {
+        token retval;
+        const auto* data = this->l_input.data();
+        auto len = (size_t) this->l_input.length();
+
+        while (this->l_pos < len && isspace((unsigned char) data[this->l_pos]))
+        {
+            this->l_pos += 1;
+        }
+        if (this->l_pos >= len) {
+            return retval;
+        }
+
+        auto start = this->l_pos;
+        auto ch = data[start];
+        auto peek = start + 1 < len ? data[start + 1] : '\0';
+
+        retval.t_kind = token_kind::other;
+        this->l_pos += 1;
+        switch (ch) {
+            case '(':
+                retval.t_kind = token_kind::lparen;
+                break;
+            case ')':
+                retval.t_kind = token_kind::rparen;
+                break;
+            case ',':
+                retval.t_kind = token_kind::comma;
+                break;
+            case '=':
+                retval.t_kind = token_kind::eq;
+                if (peek == '=') {
+                    this->l_pos += 1;
+                }
+                break;
+            case '!':
+                if (peek == '=') {
+                    retval.t_kind = token_kind::ne;
+                    this->l_pos += 1;
+                }
+                break;
+            case '<':
+                if (peek == '=') {
+                    retval.t_kind = token_kind::le;
+                    this->l_pos += 1;
+                } else if (peek == '>') {
+                    retval.t_kind = token_kind::ne;
+                    this->l_pos += 1;
+                } else if (peek != '<') {
+                    retval.t_kind = token_kind::lt;
+                }
+                break;
+            case '>':
+                if (peek == '=') {
+                    retval.t_kind = token_kind::ge;
+                    this->l_pos += 1;
+                } else if (peek != '>') {
+                    retval.t_kind = token_kind::gt;
+                }
+                break;
+            case '-':
+                if (peek != '-' && peek != '>') {
+                    retval.t_kind = token_kind::minus;
+                }
+                break;
+            case '+':
+                retval.t_kind = token_kind::plus;
+                break;
+            case '\'':
+                this->lex_string(retval);
+                break;
+            case ':':
+            case '@':
+            case '$':
+                this->lex_variable(retval);
+                break;
+            default:
+                if (isdigit((unsigned char) ch)
+                    || (ch == '.' && isdigit((unsigned char) peek)))
+                {
+                    this->lex_number(retval);
+                } else if (isalpha((unsigned char) ch) || ch == '_'
+                           || (ch & 0x80))
+                {
+                    while (this->l_pos < len && is_id_char(data[this->l_pos]))
+                    {
+                        this->l_pos += 1;
+                    }
+                    retval.t_kind = token_kind::keyword;
+                }
+                break;
+        }
+        retval.t_text = this->l_input.sub_range(start, this->l_pos);
+
+        return retval;
+    }
+
+private:
+    void lex_string(token& tok)
+    {
+        const auto* data = this->l_input.data();
+        auto len = (size_t) this->l_input.length();
+
+        while (this->l_pos < len) {
+            auto ch = data[this->l_pos];
+
+            this->l_pos += 1;
+            if (ch == '\'') {
+                if (this->l_pos < len && data[this->l_pos] == '\'') {
+                    this->l_pos += 1;
+                } else {
+                    tok.t_kind = token_kind::string;
+                    return;
+                }
+            }
+            tok.t_string.push_back(ch);
+        }
+    }
+
+    void lex_variable(token& tok)
+    {
+        const auto* data = this->l_input.data();
+        auto len = (size_t) this->l_input.length();
+        auto start = this->l_pos;
+
+        while (this->l_pos < len && is_id_char(data[this->l_pos])) {
+            this->l_pos += 1;
+        }
+        if (this->l_pos == start) {
+            return;
+        }
+        // TCL-style variable suffixes are not supported.
+        if (data[start - 1] == '$' && this->l_pos < len
+            && (data[this->l_pos] == ':' || data[this->l_pos] == '('))
+        {
+            return;
+        }
+        tok.t_kind = token_kind::variable;
+    }
+
+    void lex_number(token& tok)
+    {
+        const auto* data = this->l_input.data();
+        auto len = (size_t) this->l_input.length();
+        auto start = this->l_pos - 1;
+        auto is_real = false;
+
+        while (this->l_pos < len && isdigit((unsigned char) data[this->l_pos]))
+        {
+            this->l_pos += 1;
+        }
+        if (data[start] == '.'
+            || (this->l_pos < len && data[this->l_pos] == '.'))
+        {
+            is_real = true;
+            if (data[start] != '.') {
+                this->l_pos += 1;
+            }
+            while (this->l_pos < len
+                   && isdigit((unsigned char) data[this->l_pos]))
+            {
+                this->l_pos += 1;
+            }
+        }
+        if (this->l_pos < len
+            && (data[this->l_pos] == 'e' || data[this->l_pos] == 'E'))
+        {
+            auto exp_pos = this->l_pos + 1;
+
+            if (exp_pos < len
+                && (data[exp_pos] == '+' || data[exp_pos] == '-'))
+            {
+                exp_pos += 1;
+            }
+            if (exp_pos >= len || !isdigit((unsigned char) data[exp_pos])) {
+                return;
+            }
+            is_real = true;
+            this->l_pos = exp_pos;
+            while (this->l_pos < len
+                   && isdigit((unsigned char) data[this->l_pos]))
+            {
+                this->l_pos += 1;
+            }
+        }
+        // Hex literals, digit separators, and the like are left to SQLite.
+        if (this->l_pos < len && is_id_char(data[this->l_pos])) {
+            return;
+        }
+
+        auto num_str = std::string(&data[start], this->l_pos - start);
+        if (is_real) {
+            tok.t_kind = token_kind::real;
+            tok.t_real = strtod(num_str.c_str(), nullptr);
+            return;
+        }
+
+        errno = 0;
+        tok.t_int = strtoll(num_str.c_str(), nullptr, 10);
+        if (errno == ERANGE) {
+            // SQLite turns integers that are too large into reals.
+            return;
+        }
+        tok.t_kind = token_kind::integer;
+    }
+
+    string_fragment l_input;
+    size_t l_pos{0};
+};
+
+using value = predicate::value;
+
+value
+from_bool(bool b)
+{
+    return value::from_int(b ? 1 : 0);
+}
+
+/**
+ * @return The truth value of the given value, NULL for NULL, or nullopt if
+ *   the value is text, which SQLite would convert to a number first.
+ */
+std::optional<value>
+truth_of(const value& val)
+{
+    switch (val.v_kind) {
+        case value::kind::null:
+            return val;
+        case value::kind::integer:
+            return from_bool(val.v_int != 0);
+        case value::kind::real:
+            return from_bool(val.v_real != 0.0);
+        case value::kind::text:
+            break;
+    }
+
+    return std::nullopt;
+}
+
+/**
+ * Convert the value to text in the same way SQLite would.  Reals are not
+ * converted since SQLite's formatting of them is not replicated here.
+ */
+std::optional<string_fragment>
+text_of(const value& val, char* buf, size_t buf_len)
+{
+    switch (val.v_kind) {
+        case value::kind::text:
+            return val.v_text;
+        case value::kind::integer: {
+            auto len = snprintf(buf, buf_len, "%lld", (long long) val.v_int);
+            return string_fragment::from_bytes(buf, len);
+        }
+        default:
+            break;
+    }
+
+    return std::nullopt;
+}
+
+uint32_t
+read_utf8(string_fragment sf, int& pos)
+{
+    const auto* data = (const unsigned char*) sf.data();
+    uint32_t retval = data[pos];
+
+    pos += 1;
+    if (retval >= 0xc0) {
+        retval &= retval >= 0xf0 ? 0x07 : retval >= 0xe0 ? 0x0f : 0x1f;
+        while (pos < sf.length() && (data[pos] & 0xc0) == 0x80) {
+            retval = (retval << 6) | (data[pos] & 0x3f);
+            pos += 1;
+        }
+    }
+
+    return retval;
+}
+
+uint32_t
+fold_ascii(uint32_t ch)
+{
+    if ('A' <= ch && ch <= 'Z') {
+        return ch + ('a' - 'A');
+    }
+    return ch;
+}
+
+/**
+ * Match a GLOB character class that starts after the '['.
+ *
+ * @return True if the character is in the class, false if it is not or
+ *   nullopt if the class is not terminated.
+ */
+std::optional<bool>
+match_class(string_fragment pat, int& pos, uint32_t ch)
+{
+    auto invert = false;
+    auto seen = false;
+    uint32_t prev = 0;
+
+    if (pos < pat.length() && pat.data()[pos] == '^') {
+        invert = true;
+        pos += 1;
+    }
+    if (pos < pat.length() && pat.data()[pos] == ']') {
+        seen = ch == ']';
+        pos += 1;
+    }
+    while (pos < pat.length() && pat.data()[pos] != ']') {
+        auto curr = read_utf8(pat, pos);
+
+        if (curr == '-' && prev != 0 && pos < pat.length()
+            && pat.data()[pos] != ']')
+        {
+            auto hi = read_utf8(pat, pos);
+
+            if (prev <= ch && ch <= hi) {
+                seen = true;
+            }
+            prev = 0;
+        } else {
+            if (curr == ch) {
+                seen = true;
+            }
+            prev = curr;
+        }
+    }
+    if (pos >= pat.length()) {
+        return std::nullopt;
+    }
+    pos += 1;
+
+    return seen != invert;
+}
+
+/**
+ * Match a LIKE or GLOB pattern against a string.  The patterns only have
+ * one multi-character wildcard and every other element consumes a single
+ * character, so the usual backtracking to the last wildcard is enough.
+ */
+bool
+match_pattern(string_fragment pat, string_fragment str, bool glob)
+{
+    const uint32_t match_all = glob ? '*' : '%';
+    const uint32_t match_one = glob ? '?' : '_';
+    int pat_pos = 0;
+    int str_pos = 0;
+    int star_pat = -1;
+    int star_str = 0;
+
+    while (str_pos < str.length()) {
+        auto next_str = str_pos;
+        auto ch = read_utf8(str, next_str);
+        auto matched = false;
+
+        if (pat_pos < pat.length()) {
+            auto next_pat = pat_pos;
+            auto pch = read_utf8(pat, next_pat);
+
+            if (pch == match_all) {
+                star_pat = next_pat;
+                star_str = str_pos;
+                pat_pos = next_pat;
+                continue;
+            }
+            if (pch == match_one) {
+                matched = true;
+            } else if (glob && pch == '[') {
+                auto class_res = match_class(pat, next_pat, ch);
+
+                if (!class_res) {
+                    return false;
+                }
+                matched = class_res.value();
+            } else if (glob) {
+                matched = pch == ch;
+            } else {
+                matched = fold_ascii(pch) == fold_ascii(ch);
+            }
+            if (matched) {
+                pat_pos = next_pat;
+                str_pos = next_str;
+                continue;
+            }
+        }
+        if (star_pat == -1) {
+            return false;
+        }
+        read_utf8(str, star_str);
+        pat_pos = star_pat;
+        str_pos = star_str;
+    }
+    while (pat_pos < pat.length()) {
+        auto pch = read_utf8(pat, pat_pos);
+
+        if (pch != match_all) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+}  // namespace
+
+class predicate::compiler {
+public:
+    explicit compiler(string_fragment expr) : c_lexer(expr)
+    {
+        this->advance();
+    }
+
+    std::optional<predicate> compile()
+    {
+        auto root = this->parse_or();
+
+        if (!root || this->c_token.t_kind != token_kind::eof) {
+            return std::nullopt;
+        }
+        this->c_pred.p_root = root.value();
+
+        return std::move(this->c_pred);
+    }
+
+private:
+    void advance() { this->c_token = this->c_lexer.next(); }
+
+    bool accept_keyword(const char* kw)
+    {
+        if (this->c_token.is_keyword(kw)) {
+            this->advance();
+            return true;
+        }
+        return false;
+    }
+
+    uint32_t add_node(node&& nd)
+    {
+        this->c_pred.p_nodes.emplace_back(std::move(nd));
+        return this->c_pred.p_nodes.size() - 1;
+    }
+
+    uint32_t add_node(op nop, std::vector<uint32_t> args, bool negate = false)
+    {
+        node nd;
+
+        nd.n_op = nop;
+        nd.n_args = std::move(args);
+        nd.n_negate = negate;
+        return this->add_node(std::move(nd));
+    }
+
+    std::optional<uint32_t> parse_or()
+    {
+        auto lhs = this->parse_and();
+
+        while (lhs && this->accept_keyword("OR")) {
+            auto rhs = this->parse_and();
+            if (!rhs) {
+                return std::nullopt;
+            }
+            lhs = this->add_node(op::logical_or, {lhs.value(), rhs.value()});
+        }
+
+        return lhs;
+    }
+
+    std::optional<uint32_t> parse_and()
+    {
+        auto lhs = this->parse_not();
+
+        while (lhs && this->accept_keyword("AND")) {
+            auto rhs = this->parse_not();
+            if (!rhs) {
+                return std::nullopt;
+            }
+            lhs = this->add_node(op::logical_and, {lhs.value(), rhs.value()});
+        }
+
+        return lhs;
+    }
+
+    std::optional<uint32_t> parse_not()
+    {
+        if (this->accept_keyword("NOT")) {
+            auto arg = this->parse_not();
+            if (!arg) {
+                return std::nullopt;
+            }
+            return this->add_node(op::logical_not, {arg.value()});
+        }
+
+        return this->parse_equality();
+    }
+
+    std::optional<uint32_t> parse_equality()
+    {
+        auto lhs = this->parse_relational();
+
+        while (lhs) {
+            auto kind = this->c_token.t_kind;
+
+            if (kind == token_kind::eq || kind == token_kind::ne) {
+                this->advance();
+                auto rhs = this->parse_relational();
+                if (!rhs) {
+                    return std::nullopt;
+                }
+                auto retval = this->add_node(op::compare,
+                                             {lhs.value(), rhs.value()});
+                this->c_pred.p_nodes[retval].n_cmp
+                    = kind == token_kind::eq ? cmp::eq : cmp::ne;
+                lhs = retval;
+                continue;
+            }
+            if (this->accept_keyword("ISNULL")) {
+                lhs = this->add_node(op::is_null, {lhs.value()});
+                continue;
+            }
+            if (this->accept_keyword("NOTNULL")) {
+                lhs = this->add_node(op::is_null, {lhs.value()}, true);
+                continue;
+            }
+            if (this->accept_keyword("IS")) {
+                auto negate = this->accept_keyword("NOT");
+
+                if (this->accept_keyword("NULL")) {
+                    lhs = this->add_node(op::is_null, {lhs.value()}, negate);
+                    continue;
+                }
+                // "IS TRUE", "IS FALSE", and "IS DISTINCT FROM" are
+                // special forms that are left to SQLite.
+                if (this->c_token.is_keyword("TRUE")
+                    || this->c_token.is_keyword("FALSE")
+                    || this->c_token.is_keyword("DISTINCT"))
+                {
+                    return std::nullopt;
+                }
+                auto rhs = this->parse_relational();
+                if (!rhs) {
+                    return std::nullopt;
+                }
+                lhs = this->add_node(
+                    op::is, {lhs.value(), rhs.value()}, negate);
+                continue;
+            }
+
+            auto negate = false;
+            if (this->accept_keyword("NOT")) {
+                if (this->accept_keyword("NULL")) {
+                    lhs = this->add_node(op::is_null, {lhs.value()}, true);
+                    continue;
+                }
+                negate = true;
+            }
+            if (this->accept_keyword("LIKE")) {
+                lhs = this->parse_pattern(op::like, lhs.value(), negate);
+            } else if (this->accept_keyword("GLOB")) {
+                lhs = this->parse_pattern(op::glob, lhs.value(), negate);
+            } else if (this->accept_keyword("REGEXP")) {
+                auto rhs = this->parse_relational();
+                if (!rhs) {
+                    return std::nullopt;
+                }
+                lhs = this->add_regexp(lhs.value(), rhs.value(), negate);
+            } else if (this->accept_keyword("BETWEEN")) {
+                lhs = this->parse_between(lhs.value(), negate);
+            } else if (this->accept_keyword("IN")) {
+                lhs = this->parse_in(lhs.value(), negate);
+            } else if (negate) {
+                return std::nullopt;
+            } else {
+                break;
+            }
+        }
+
+        return lhs;
+    }
+
+    std::optional<uint32_t> parse_pattern(op nop, uint32_t lhs, bool negate)
+    {
+        auto rhs = this->parse_relational();
+
+        if (!rhs || this->c_token.is_keyword("ESCAPE")) {
+            return std::nullopt;
+        }
+
+        return this->add_node(nop, {lhs, rhs.value()}, negate);
+    }
+
+    std::optional<uint32_t> parse_between(uint32_t lhs, bool negate)
+    {
+        auto low = this->parse_relational();
+        if (!low || !this->accept_keyword("AND")) {
+            return std::nullopt;
+        }
+        auto high = this->parse_relational();
+        if (!high) {
+            return std::nullopt;
+        }
+
+        return this->add_node(
+            op::between, {lhs, low.value(), high.value()}, negate);
+    }
+
+    std::optional<uint32_t> parse_in(uint32_t lhs, bool negate)
+    {
+        if (this->c_token.t_kind != token_kind::lparen) {
+            return std::nullopt;
+        }
+        this->advance();
+        if (this->c_token.is_keyword("SELECT")
+            || this->c_token.is_keyword("WITH")
+            || this->c_token.is_keyword("VALUES"))
+        {
+            return std::nullopt;
+        }
+
+        std::vector<uint32_t> args{lhs};
+        if (this->c_token.t_kind != token_kind::rparen) {
+            while (true) {
+                auto elem = this->parse_or();
+                if (!elem) {
+                    return std::nullopt;
+                }
+                args.emplace_back(elem.value());
+                if (this->c_token.t_kind != token_kind::comma) {
+                    break;
+                }
+                this->advance();
+            }
+        }
+        if (this->c_token.t_kind != token_kind::rparen) {
+            return std::nullopt;
+        }
+        this->advance();
+
+        return this->add_node(op::in_list, std::move(args), negate);
+    }
+
+    std::optional<uint32_t> add_regexp(uint32_t str, uint32_t re, bool negate)
+    {
+        const auto& re_node = this->c_pred.p_nodes[re];
+
+        // The pattern needs to be known ahead of time so it can be compiled
+        // once, errors in the pattern are left for SQLite to report.
+        if (re_node.n_op != op::literal
+            || re_node.n_value.v_kind != value::kind::text)
+        {
+            return std::nullopt;
+        }
+        auto compile_res
+            = pcre2pp::code::from(string_fragment::from_str(re_node.n_text));
+        if (compile_res.isErr()) {
+            return std::nullopt;
+        }
+
+        auto retval = this->add_node(op::regexp, {str}, negate);
+        this->c_pred.p_nodes[retval].n_regex
+            = compile_res.unwrap().to_shared();
+
+        return retval;
+    }
+
+    std::optional<uint32_t> parse_relational()
+    {
+        auto lhs = this->parse_primary();
+
+        while (lhs) {
+            cmp ncmp;
+
+            switch (this->c_token.t_kind) {
+                case token_kind::lt:
+                    ncmp = cmp::lt;
+                    break;
+                case token_kind::le:
+                    ncmp = cmp::le;
+                    break;
+                case token_kind::gt:
+                    ncmp = cmp::gt;
+                    break;
+                case token_kind::ge:
+                    ncmp = cmp::ge;
+                    break;
+                default:
+                    return lhs;
+            }
+            this->advance();
+            auto rhs = this->parse_primary();
+            if (!rhs) {
+                return std::nullopt;
+            }
+            lhs = this->add_node(op::compare, {lhs.value(), rhs.value()});
+            this->c_pred.p_nodes[lhs.value()].n_cmp = ncmp;
+        }
+
+        return lhs;
+    }
+
+    std::optional<uint32_t> parse_primary()
+    {
+        node nd;
+        auto tok = std::move(this->c_token);
+
+        this->advance();
+        switch (tok.t_kind) {
+            case token_kind::lparen: {
+                auto retval = this->parse_or();
+                if (this->c_token.t_kind != token_kind::rparen) {
+                    return std::nullopt;
+                }
+                this->advance();
+                return retval;
+            }
+            case token_kind::minus:
+            case token_kind::plus: {
+                auto neg = tok.t_kind == token_kind::minus;
+
+                if (this->c_token.t_kind == token_kind::integer) {
+                    nd.n_value = value::from_int(neg ? -this->c_token.t_int
+                                                     : this->c_token.t_int);
+                } else if (this->c_token.t_kind == token_kind::real) {
+                    nd.n_value = value::from_real(
+                        neg ? -this->c_token.t_real : this->c_token.t_real);
+                } else {
+                    return std::nullopt;
+                }
+                this->advance();
+                break;
+            }
+            case token_kind::integer:
+                nd.n_value = value::from_int(tok.t_int);
+                break;
+            case token_kind::real:
+                nd.n_value = value::from_real(tok.t_real);
+                break;
+            case token_kind::string:
+                nd.n_value.v_kind = value::kind::text;
+                nd.n_text = std::move(tok.t_string);
+                break;
+            case token_kind::variable: {
+                auto name = tok.t_text.to_string();
+                auto& vars = this->c_pred.p_variables;
+                auto iter = std::find(vars.begin(), vars.end(), name);
+
+                nd.n_op = op::variable;
+                nd.n_var = std::distance(vars.begin(), iter);
+                if (iter == vars.end()) {
+                    vars.emplace_back(std::move(name));
+                }
+                break;
+            }
+            case token_kind::keyword:
+                if (tok.is_keyword("NULL")) {
+                    break;
+                }
+                if (tok.is_keyword("TRUE") || tok.is_keyword("FALSE")) {
+                    nd.n_value = from_bool(tok.is_keyword("TRUE"));
+                    break;
+                }
+                if (tok.is_keyword("regexp")
+                    && this->c_token.t_kind == token_kind::lparen)
+                {
+                    return this->parse_regexp_call();
+                }
+                return std::nullopt;
+            default:
+                return std::nullopt;
+        }
+
+        return this->add_node(std::move(nd));
+    }
+
+    std::optional<uint32_t> parse_regexp_call()
+    {
+        this->advance();
+        auto re = this->parse_or();
+        if (!re || this->c_token.t_kind != token_kind::comma) {
+            return std::nullopt;
+        }
+        this->advance();
+        auto str = this->parse_or();
+        if (!str || this->c_token.t_kind != token_kind::rparen) {
+            return std::nullopt;
+        }
+        this->advance();
+
+        return this->add_regexp(str.value(), re.value(), false);
+    }
+
+    lexer c_lexer;
+    token c_token;
+    predicate c_pred;
+};
+
+std::optional<predicate>
+predicate::compile(string_fragment expr)
+{
+    return compiler(expr).compile();
+}
+
+std::optional<bool>
+predicate::eval(const std::vector<value>& vars) const
+{
+    if (this->p_nodes.empty()) {
+        return std::nullopt;
+    }
+
+    auto res = this->eval_node(this->p_root, vars);
+    if (!res) {
+        return std::nullopt;
+    }
+
+    auto truth = truth_of(res.value());
+    if (!truth) {
+        return std::nullopt;
+    }
+
+    return !truth->is_null() && truth->v_int != 0;
+}
+
+std::optional<value>
+predicate::eval_node(uint32_t index, const std::vector<value>& vars) const
+{
+    const auto& nd = this->p_nodes[index];
+
+    switch (nd.n_op) {
+        case op::literal:
+            if (nd.n_value.v_kind == value::kind::text) {
+                return value::from_text(string_fragment::from_str(nd.n_text));
+            }
+            return nd.n_value;
+        case op::variable:
+            return vars[nd.n_var];
+        case op::logical_and:
+        case op::logical_or: {
+            // A false operand decides an AND and a true one decides an OR,
+            // no matter what the other operand is.
+            auto decider = nd.n_op == op::logical_or ? 1 : 0;
+            auto saw_null = false;
+
+            for (auto arg : nd.n_args) {
+                auto res = this->eval_node(arg, vars);
+                if (!res) {
+                    return std::nullopt;
+                }
+                auto truth = truth_of(res.value());
+                if (!truth) {
+                    return std::nullopt;
+                }
+                if (truth->is_null()) {
+                    saw_null = true;
+                } else if (truth->v_int == decider) {
+                    return truth;
+                }
+            }
+            if (saw_null) {
+                return value{};
+            }
+            return from_bool(decider == 0);
+        }
+        case op::logical_not: {
+            auto res = this->eval_node(nd.n_args[0], vars);
+            if (!res) {
+                return std::nullopt;
+            }
+            auto truth = truth_of(res.value());
+            if (!truth || truth->is_null()) {
+                return truth;
+            }
+            return from_bool(truth->v_int == 0);
+        }
+        case op::compare: {
+            auto lhs = this->eval_node(nd.n_args[0], vars);
+            auto rhs = this->eval_node(nd.n_args[1], vars);
+            if (!lhs || !rhs) {
+                return std::nullopt;
+            }
+            if (lhs->is_null() || rhs->is_null()) {
+                return value{};
+            }
+
+            auto rc = value::compare(lhs.value(), rhs.value());
+            switch (nd.n_cmp) {
+                case cmp::eq:
+                    return from_bool(rc == 0);
+                case cmp::ne:
+                    return from_bool(rc != 0);
+                case cmp::lt:
+                    return from_bool(rc < 0);
+                case cmp::le:
+                    return from_bool(rc <= 0);
+                case cmp::gt:
+                    return from_bool(rc > 0);
+                case cmp::ge:
+                    return from_bool(rc >= 0);
+            }
+            break;
+        }
+        case op::is: {
+            auto lhs = this->eval_node(nd.n_args[0], vars);
+            auto rhs = this->eval_node(nd.n_args[1], vars);
+            if (!lhs || !rhs) {
+                return std::nullopt;
+            }
+
+            bool same;
+            if (lhs->is_null() || rhs->is_null()) {
+                same = lhs->is_null() && rhs->is_null();
+            } else {
+                same = value::compare(lhs.value(), rhs.value()) == 0;
+            }
+            return from_bool(same != nd.n_negate);
+        }
+        case op::is_null: {
+            auto arg = this->eval_node(nd.n_args[0], vars);
+            if (!arg) {
+                return std::nullopt;
+            }
+            return from_bool(arg->is_null() != nd.n_negate);
+        }
+        case op::between: {
+            auto arg = this->eval_node(nd.n_args[0], vars);
+            auto low = this->eval_node(nd.n_args[1], vars);
+            auto high = this->eval_node(nd.n_args[2], vars);
+            if (!arg || !low || !high) {
+                return std::nullopt;
+            }
+            if (arg->is_null()) {
+                return value{};
+            }
+
+            // Evaluated as "arg >= low AND arg <= high".
+            auto above = low->is_null()
+                ? value{}
+                : from_bool(value::compare(arg.value(), low.value()) >= 0);
+            auto below = high->is_null()
+                ? value{}
+                : from_bool(value::compare(arg.value(), high.value()) <= 0);
+            value retval;
+            if ((!above.is_null() && above.v_int == 0)
+                || (!below.is_null() && below.v_int == 0))
+            {
+                retval = from_bool(false);
+            } else if (!above.is_null() && !below.is_null()) {
+                retval = from_bool(true);
+            }
+            if (nd.n_negate && !retval.is_null()) {
+                retval.v_int = !retval.v_int;
+            }
+            return retval;
+        }
+        case op::in_list: {
+            // An empty list is always false, even for a NULL.
+            if (nd.n_args.size() == 1) {
+                return from_bool(nd.n_negate);
+            }
+
+            auto arg = this->eval_node(nd.n_args[0], vars);
+            if (!arg) {
+                return std::nullopt;
+            }
+            if (arg->is_null()) {
+                return value{};
+            }
+
+            auto saw_null = false;
+            for (size_t lpc = 1; lpc < nd.n_args.size(); lpc++) {
+                auto elem = this->eval_node(nd.n_args[lpc], vars);
+                if (!elem) {
+                    return std::nullopt;
+                }
+                if (elem->is_null()) {
+                    saw_null = true;
+                } else if (value::compare(arg.value(), elem.value()) == 0) {
+                    return from_bool(!nd.n_negate);
+                }
+            }
+            if (saw_null) {
+                return value{};
+            }
+            return from_bool(nd.n_negate);
+        }
+        case op::like:
+        case op::glob: {
+            auto str = this->eval_node(nd.n_args[0], vars);
+            auto pat = this->eval_node(nd.n_args[1], vars);
+            if (!str || !pat) {
+                return std::nullopt;
+            }
+            if (str->is_null() || pat->is_null()) {
+                return value{};
+            }
+
+            char str_buf[32];
+            char pat_buf[32];
+            auto str_sf = text_of(str.value(), str_buf, sizeof(str_buf));
+            auto pat_sf = text_of(pat.value(), pat_buf, sizeof(pat_buf));
+            if (!str_sf || !pat_sf
+                || (size_t) pat_sf->length() > MAX_PATTERN_LENGTH)
+            {
+                return std::nullopt;
+            }
+
+            auto matched = match_pattern(
+                pat_sf.value(), str_sf.value(), nd.n_op == op::glob);
+            return from_bool(matched != nd.n_negate);
+        }
+        case op::regexp: {
+            auto str = this->eval_node(nd.n_args[0], vars);
+            if (!str) {
+                return std::nullopt;
+            }
+            if (str->is_null()) {
+                return value{};
+            }
+
+            char str_buf[32];
+            auto str_sf = text_of(str.value(), str_buf, sizeof(str_buf));
+            if (!str_sf) {
+                return std::nullopt;
+            }
+
+            auto matched = nd.n_regex->find_in(str_sf.value())
+                               .ignore_error()
+                               .has_value();
+            return from_bool(matched != nd.n_negate);
+        }
+    }
+
+    return std::nullopt;
+}
+
+int
+predicate::value::compare(const value& lhs, const value& rhs)
+{
+    auto rank = [](const value& val) {
+        switch (val.v_kind) {
+            case kind::null:
+                return 0;
+            case kind::integer:
+            case kind::real:
+                return 1;
+            case kind::text:
+                return 2;
+        }
+        return 0;
+    };
+
+    auto lhs_rank = rank(lhs);
+    auto rhs_rank = rank(rhs);
+    if (lhs_rank != rhs_rank) {
+        return lhs_rank - rhs_rank;
+    }
+
+    switch (lhs.v_kind) {
+        case kind::null:
+            return 0;
+        case kind::text: {
+            auto min_len
+                = std::min(lhs.v_text.length(), rhs.v_text.length());
+            auto rc = memcmp(lhs.v_text.data(), rhs.v_text.data(), min_len);
+            if (rc != 0) {
+                return rc;
+            }
+            return lhs.v_text.length() - rhs.v_text.length();
+        }
+        case kind::integer:
+        case kind::real:
+            break;
+    }
+
+    if (lhs.v_kind == kind::integer && rhs.v_kind == kind::integer) {
+        return (lhs.v_int > rhs.v_int) - (lhs.v_int < rhs.v_int);
+    }
+
+    // A long double can hold every 64-bit integer exactly, so large
+    // integers are not rounded before they are compared with a real.
+    auto lhs_d = lhs.v_kind == kind::integer ? (long double) lhs.v_int
+                                             : (long double) lhs.v_real;
+    auto rhs_d = rhs.v_kind == kind::integer ? (long double) rhs.v_int
+                                             : (long double) rhs.v_real;
+
+    return (lhs_d > rhs_d) - (lhs_d < rhs_d);
+}
+
+}  // namespace lnav::sql
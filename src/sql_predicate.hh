@@ -0,0 +1,204 @@
+/**
+ * Copyright (c) 2026, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *
+ * @file sql_predicate.hh
+ */
+
+#ifndef lnav_sql_predicate_hh
+#define lnav_sql_predicate_hh
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+#include "base/intern_string.hh"
+
+namespace lnav::pcre2pp {
+class code;
+}
+
+namespace lnav::sql {
+
+/**
+ * A native evaluator for the simple SQL expressions that are typically
+ * passed to the ":filter-expr" and ":mark-expr" commands, like:
+ *
+ *   :log_level = 'error' AND :sc_status >= 500
+ *
+ * Running such an expression through SQLite for every message means
+ * binding every parameter and stepping the VM, which dominates the cost
+ * of filtering large files.  The predicate is compiled into a flat tree of
+ * nodes that is evaluated directly against the values of the parameters.
+ *
+ * Only a subset of SQL is supported: literals, parameters, comparisons,
+ * AND/OR/NOT, IS [NOT] NULL, BETWEEN, IN-lists, LIKE, GLOB and REGEXP with
+ * a literal pattern.  The semantics follow SQLite, including NULL handling
+ * and the ordering of values of different types.  Expressions outside of
+ * the subset are not compiled and are left to SQLite.
+ */
+class predicate {
+public:
+    /** The value of a parameter or an intermediate result. */
+    struct value {
+        enum class kind : uint8_t {
+            null,
+            integer,
+            real,
+            text,
+        };
+
+        static value from_int(int64_t i)
+        {
+            value retval;
+
+            retval.v_kind = kind::integer;
+            retval.v_int = i;
+            return retval;
+        }
+
+        static value from_real(double d)
+        {
+            value retval;
+
+            retval.v_kind = kind::real;
+            retval.v_real = d;
+            return retval;
+        }
+
+        static value from_text(string_fragment sf)
+        {
+            value retval;
+
+            retval.v_kind = kind::text;
+            retval.v_text = sf;
+            return retval;
+        }
+
+        bool is_null() const { return this->v_kind == kind::null; }
+
+        /**
+         * Compare two values in the order SQLite sorts values without an
+         * affinity: NULLs first, then numbers, then text compared with the
+         * BINARY collation.
+         *
+         * @return A negative number, zero, or a positive number if the left
+         *   value sorts before, the same as, or after the right value.
+         */
+        static int compare(const value& lhs, const value& rhs);
+
+        kind v_kind{kind::null};
+        int64_t v_int{0};
+        double v_real{0.0};
+        string_fragment v_text;
+    };
+
+    /**
+     * Compile the given expression.
+     *
+     * @return The predicate or nullopt if the expression uses syntax that
+     *   is not supported and should be evaluated by SQLite.
+     */
+    static std::optional<predicate> compile(string_fragment expr);
+
+    /**
+     * @return The names of the parameters used by the expression, including
+     *   the leading ':', '@', or '$'.  The values passed to eval() must be
+     *   in the same order.
+     */
+    const std::vector<std::string>& get_variables() const
+    {
+        return this->p_variables;
+    }
+
+    /**
+     * Evaluate the expression with the given parameter values.
+     *
+     * @return The result of the expression or nullopt if it cannot be
+     *   determined natively for these values, in which case SQLite should
+     *   be consulted.  A NULL result is treated as false, like in a WHERE
+     *   clause.
+     */
+    std::optional<bool> eval(const std::vector<value>& vars) const;
+
+private:
+    enum class op : uint8_t {
+        literal,
+        variable,
+        logical_and,
+        logical_or,
+        logical_not,
+        compare,
+        is,
+        is_null,
+        between,
+        in_list,
+        like,
+        glob,
+        regexp,
+    };
+
+    enum class cmp : uint8_t {
+        eq,
+        ne,
+        lt,
+        le,
+        gt,
+        ge,
+    };
+
+    struct node {
+        op n_op{op::literal};
+        cmp n_cmp{cmp::eq};
+        bool n_negate{false};
+        /** The indexes of the operands in p_nodes. */
+        std::vector<uint32_t> n_args;
+        /** The literal value, text values are stored in n_text. */
+        value n_value;
+        std::string n_text;
+        /** The index into p_variables. */
+        size_t n_var{0};
+        std::shared_ptr<pcre2pp::code> n_regex;
+    };
+
+    class compiler;
+
+    std::optional<value> eval_node(uint32_t index,
+                                   const std::vector<value>& vars) const;
+
+    std::vector<node> p_nodes;
+    uint32_t p_root{0};
+    std::vector<std::string> p_variables;
+};
+
+}  // namespace lnav::sql
+
+#endif
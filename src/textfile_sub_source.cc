@@ -556,16 +556,15 @@ textfile_sub_source::text_filters_changed()
     }
 
     auto* lfo = (line_filter_observer*) lf->get_logline_observer();
-    uint32_t filter_in_mask, filter_out_mask;
 
     lfo->clear_deleted_filter_state();
     lf->reobserve_from(lf->begin() + lfo->get_min_count(lf->size()));
 
-    this->get_filters().get_enabled_mask(filter_in_mask, filter_out_mask);
+    lfo->update_exclusion(this->get_filters().get_enabled_filters());
     lfo->lfo_filter_state.tfs_index.clear();
     for (uint32_t lpc = 0; lpc < lf->size(); lpc++) {
         if (this->tss_apply_filters) {
-            if (lfo->excluded(filter_in_mask, filter_out_mask, lpc)) {
+            if (lfo->excluded(lpc)) {
                 continue;
             }
             if (lf->has_line_metadata()) {
@@ -649,7 +648,7 @@ textfile_sub_source::get_filtered_count_for(size_t filter_index) const
     }
 
     auto* lfo = dynamic_cast<line_filter_observer*>(lf->get_logline_observer());
-    return lfo->lfo_filter_state.tfs_filter_hits[filter_index];
+    return lfo->lfo_filter_state.get_filter_hits(filter_index);
 }
 
 std::optional<text_format_t>
@@ -1040,14 +1039,11 @@ textfile_sub_source::rescan_files(textfile_sub_source::scan_callback& callback,
                 }
             }
 
-            uint32_t filter_in_mask, filter_out_mask;
-
-            this->get_filters().get_enabled_mask(filter_in_mask,
-                                                 filter_out_mask);
             auto* lfo = (line_filter_observer*) lf->get_logline_observer();
+            lfo->update_exclusion(this->get_filters().get_enabled_filters(),
+                                  old_size);
             for (uint32_t lpc = old_size; lpc < lf->size(); lpc++) {
-                if (this->tss_apply_filters
-                    && lfo->excluded(filter_in_mask, filter_out_mask, lpc))
+                if (this->tss_apply_filters && lfo->excluded(lpc))
                 {
                     continue;
                 }
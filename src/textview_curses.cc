@@ -88,6 +88,7 @@ const std::array<string_fragment, text_time_translator::ZOOM_COUNT>
 void
 text_filter::revert_to_last(logfile_filter_state& lfs, size_t rollback_size)
 {
+    lfs.ensure_filter(this->lf_index);
     require(lfs.tfs_lines_for_message[this->lf_index] == 0);
 
     lfs.tfs_message_matched[this->lf_index]
@@ -105,7 +106,7 @@ text_filter::revert_to_last(logfile_filter_state& lfs, size_t rollback_size)
         lfs.tfs_filter_count[this->lf_index] -= 1;
         size_t line_number = lfs.tfs_filter_count[this->lf_index];
 
-        lfs.tfs_mask[line_number] &= ~(((uint32_t) 1) << this->lf_index);
+        lfs.tfs_masks[this->lf_index].set(line_number, false);
     }
     if (lfs.tfs_lines_for_message[this->lf_index] > 0) {
         require(lfs.tfs_lines_for_message[this->lf_index] >= rollback_size);
@@ -122,28 +123,36 @@ text_filter::add_line(logfile_filter_state& lfs,
                       logfile::const_iterator ll,
                       const shared_buffer_ref& line)
 {
+    return this->add_line_result(
+        lfs, ll, this->matches(line_source{*lfs.tfs_logfile, ll}, line));
+}
+
+bool
+text_filter::add_line_result(logfile_filter_state& lfs,
+                             logfile::const_iterator ll,
+                             bool matched)
+{
+    lfs.ensure_filter(this->lf_index);
     if (ll->is_message()) {
         this->end_of_message(lfs);
     }
-    auto retval = this->matches(line_source{*lfs.tfs_logfile, ll}, line);
 
     lfs.tfs_message_matched[this->lf_index]
-        = lfs.tfs_message_matched[this->lf_index] || retval;
+        = lfs.tfs_message_matched[this->lf_index] || matched;
     lfs.tfs_lines_for_message[this->lf_index] += 1;
-    if (retval) {
+    if (matched) {
         lfs.tfs_hits_for_message[this->lf_index] += 1;
     }
 
-    return retval;
+    return matched;
 }
 
 void
 text_filter::end_of_message(logfile_filter_state& lfs)
 {
-    uint32_t mask = 0;
-
-    mask = ((uint32_t) 1U << this->lf_index);
+    lfs.ensure_filter(this->lf_index);
 
+    auto& mask = lfs.tfs_masks[this->lf_index];
     for (size_t lpc = 0; lpc < lfs.tfs_lines_for_message[this->lf_index]; lpc++)
     {
         size_t line_number = lfs.tfs_filter_count[this->lf_index];
@@ -152,11 +161,7 @@ text_filter::end_of_message(logfile_filter_state& lfs)
         if (line_number == lfs.tfs_logfile->size()) {
             continue;
         }
-        if (lfs.tfs_message_matched[this->lf_index]) {
-            lfs.tfs_mask[line_number] |= mask;
-        } else {
-            lfs.tfs_mask[line_number] &= ~mask;
-        }
+        mask.set(line_number, lfs.tfs_message_matched[this->lf_index]);
         lfs.tfs_filter_count[this->lf_index] += 1;
     }
     lfs.tfs_filter_hits[this->lf_index]
@@ -1506,12 +1511,11 @@ filter_stack::find(size_t index)
     return this->fs_filters.end();
 }
 
-std::optional<size_t>
+size_t
 filter_stack::next_index()
 {
-    bool used[32];
+    std::vector<bool> used;
 
-    memset(used, 0, sizeof(used));
     for (auto& iter : *this) {
         if (iter->lf_deleted) {
             continue;
@@ -1519,19 +1523,19 @@ filter_stack::next_index()
 
         size_t index = iter->get_index();
 
+        if (index >= used.size()) {
+            used.resize(index + 1);
+        }
         require(used[index] == false);
 
         used[index] = true;
     }
-    for (size_t lpc = this->fs_reserved;
-         lpc < logfile_filter_state::MAX_FILTERS;
-         lpc++)
-    {
+    for (size_t lpc = this->fs_reserved; lpc < used.size(); lpc++) {
         if (!used[lpc]) {
             return lpc;
         }
     }
-    return std::nullopt;
+    return std::max(this->fs_reserved, used.size());
 }
 
 std::shared_ptr<text_filter>
@@ -1563,59 +1567,30 @@ filter_stack::delete_filter(const std::string& id)
     return false;
 }
 
-void
-filter_stack::get_mask(uint32_t& filter_mask)
+filter_stack::enabled_filters
+filter_stack::get_enabled_filters() const
 {
-    filter_mask = 0;
-    for (auto& iter : *this) {
-        std::shared_ptr<text_filter> tf = iter;
+    enabled_filters retval;
 
-        if (tf->lf_deleted) {
+    for (const auto& tf : *this) {
+        if (tf->lf_deleted || !tf->is_enabled()) {
             continue;
         }
-        if (tf->is_enabled()) {
-            uint32_t bit = (1UL << tf->get_index());
-
-            switch (tf->get_type()) {
-                case text_filter::EXCLUDE:
-                case text_filter::INCLUDE:
-                    filter_mask |= bit;
-                    break;
-                default:
-                    ensure(0);
-                    break;
-            }
-        }
-    }
-}
 
-void
-filter_stack::get_enabled_mask(uint32_t& filter_in_mask,
-                               uint32_t& filter_out_mask)
-{
-    filter_in_mask = filter_out_mask = 0;
-    for (auto& iter : *this) {
-        std::shared_ptr<text_filter> tf = iter;
-
-        if (tf->lf_deleted) {
-            continue;
-        }
-        if (tf->is_enabled()) {
-            uint32_t bit = (1UL << tf->get_index());
-
-            switch (tf->get_type()) {
-                case text_filter::EXCLUDE:
-                    filter_out_mask |= bit;
-                    break;
-                case text_filter::INCLUDE:
-                    filter_in_mask |= bit;
-                    break;
-                default:
-                    ensure(0);
-                    break;
-            }
+        switch (tf->get_type()) {
+            case text_filter::EXCLUDE:
+                retval.ef_exclude.emplace_back(tf->get_index());
+                break;
+            case text_filter::INCLUDE:
+                retval.ef_include.emplace_back(tf->get_index());
+                break;
+            default:
+                ensure(0);
+                break;
         }
     }
+
+    return retval;
 }
 
 void
@@ -1708,18 +1683,6 @@ text_sub_source::text_crumbs_for_line(int line,
 logfile_filter_state::logfile_filter_state(std::shared_ptr<logfile> lf)
     : tfs_logfile(std::move(lf))
 {
-    memset(this->tfs_filter_count, 0, sizeof(this->tfs_filter_count));
-    memset(this->tfs_filter_hits, 0, sizeof(this->tfs_filter_hits));
-    memset(this->tfs_message_matched, 0, sizeof(this->tfs_message_matched));
-    memset(this->tfs_lines_for_message, 0, sizeof(this->tfs_lines_for_message));
-    memset(this->tfs_hits_for_message, 0, sizeof(this->tfs_hits_for_message));
-    memset(this->tfs_last_message_matched,
-           0,
-           sizeof(this->tfs_last_message_matched));
-    memset(this->tfs_last_lines_for_message,
-           0,
-           sizeof(this->tfs_last_lines_for_message));
-    this->tfs_mask.reserve(64 * 1024);
 }
 
 void
@@ -1733,24 +1696,20 @@ void
 logfile_filter_state::clear_for_rebuild()
 {
     log_debug("clearing filter state");
-    memset(this->tfs_filter_count, 0, sizeof(this->tfs_filter_count));
-    memset(this->tfs_filter_hits, 0, sizeof(this->tfs_filter_hits));
-    memset(this->tfs_message_matched, 0, sizeof(this->tfs_message_matched));
-    memset(this->tfs_lines_for_message, 0, sizeof(this->tfs_lines_for_message));
-    memset(this->tfs_hits_for_message, 0, sizeof(this->tfs_hits_for_message));
-    memset(this->tfs_last_message_matched,
-           0,
-           sizeof(this->tfs_last_message_matched));
-    memset(this->tfs_last_lines_for_message,
-           0,
-           sizeof(this->tfs_last_lines_for_message));
-    this->tfs_mask.clear();
+    for (size_t lpc = 0; lpc < this->tfs_filter_count.size(); lpc++) {
+        this->clear_filter_state(lpc);
+    }
+    this->tfs_line_count = 0;
     this->tfs_index.clear();
 }
 
 void
 logfile_filter_state::clear_filter_state(size_t index)
 {
+    if (index >= this->tfs_filter_count.size()) {
+        return;
+    }
+
     this->tfs_filter_count[index] = 0;
     this->tfs_filter_hits[index] = 0;
     this->tfs_message_matched[index] = false;
@@ -1758,38 +1717,48 @@ logfile_filter_state::clear_filter_state(size_t index)
     this->tfs_hits_for_message[index] = 0;
     this->tfs_last_message_matched[index] = false;
     this->tfs_last_lines_for_message[index] = 0;
+    this->tfs_last_hits_for_message[index] = 0;
+    this->tfs_masks[index].clear();
 }
 
 void
-logfile_filter_state::clear_deleted_filter_state(uint32_t used_mask)
+logfile_filter_state::clear_deleted_filter_state(const std::vector<bool>& used)
 {
-    for (int lpc = 0; lpc < MAX_FILTERS; lpc++) {
-        if (!(used_mask & (1L << lpc))) {
+    for (size_t lpc = 0; lpc < this->tfs_filter_count.size(); lpc++) {
+        if (lpc >= used.size() || !used[lpc]) {
             this->clear_filter_state(lpc);
         }
     }
-    for (size_t lpc = 0; lpc < this->tfs_mask.size(); lpc++) {
-        this->tfs_mask[lpc] &= used_mask;
-    }
 }
 
 void
-logfile_filter_state::resize(size_t newsize)
+logfile_filter_state::ensure_filter(size_t index)
 {
-    size_t old_mask_size = this->tfs_mask.size();
-
-    this->tfs_mask.resize(newsize);
-    if (newsize > old_mask_size) {
-        memset(&this->tfs_mask[old_mask_size],
-               0,
-               sizeof(uint32_t) * (newsize - old_mask_size));
+    if (index < this->tfs_filter_count.size()) {
+        return;
     }
+
+    auto count = index + 1;
+    this->tfs_filter_count.resize(count);
+    this->tfs_filter_hits.resize(count);
+    this->tfs_message_matched.resize(count);
+    this->tfs_lines_for_message.resize(count);
+    this->tfs_hits_for_message.resize(count);
+    this->tfs_last_message_matched.resize(count);
+    this->tfs_last_lines_for_message.resize(count);
+    this->tfs_last_hits_for_message.resize(count);
+    this->tfs_masks.resize(count);
 }
 
 void
-logfile_filter_state::reserve(size_t expected)
+logfile_filter_state::resize(size_t newsize)
 {
-    this->tfs_mask.reserve(expected);
+    if (newsize < this->tfs_line_count) {
+        for (auto& mask : this->tfs_masks) {
+            mask.truncate(newsize);
+        }
+    }
+    this->tfs_line_count = newsize;
 }
 
 std::optional<size_t>
@@ -40,6 +40,7 @@
 
 #include "base/enum_util.hh"
 #include "base/func_util.hh"
+#include "base/line_bitmap.hh"
 #include "base/lnav.console.hh"
 #include "base/lnav_log.hh"
 #include "base/result.h"
@@ -73,26 +74,54 @@ public:
 
     void clear_filter_state(size_t index);
 
-    void clear_deleted_filter_state(uint32_t used_mask);
+    /**
+     * Clear the state of the filters that are no longer in use.
+     *
+     * @param used Flags indexed by the filter index that are true for the
+     *   filters that are still in use.
+     */
+    void clear_deleted_filter_state(const std::vector<bool>& used);
 
-    void resize(size_t newsize);
+    /** Make room for the state of the filter with the given index. */
+    void ensure_filter(size_t index);
 
-    void reserve(size_t expected);
+    size_t get_filter_count(size_t index) const
+    {
+        return index < this->tfs_filter_count.size()
+            ? this->tfs_filter_count[index]
+            : 0;
+    }
 
-    std::optional<size_t> content_line_to_vis_line(uint32_t line);
+    int get_filter_hits(size_t index) const
+    {
+        return index < this->tfs_filter_hits.size()
+            ? this->tfs_filter_hits[index]
+            : 0;
+    }
+
+    /** @return True if the line is part of a message matched by the filter. */
+    bool is_matched(size_t index, size_t line) const
+    {
+        return index < this->tfs_masks.size()
+            && this->tfs_masks[index].contains(line);
+    }
+
+    void resize(size_t newsize);
 
-    const static int MAX_FILTERS = 32;
+    std::optional<size_t> content_line_to_vis_line(uint32_t line);
 
     std::shared_ptr<logfile> tfs_logfile;
-    size_t tfs_filter_count[MAX_FILTERS];
-    int tfs_filter_hits[MAX_FILTERS];
-    bool tfs_message_matched[MAX_FILTERS];
-    size_t tfs_lines_for_message[MAX_FILTERS];
-    size_t tfs_hits_for_message[MAX_FILTERS];
-    bool tfs_last_message_matched[MAX_FILTERS];
-    size_t tfs_last_lines_for_message[MAX_FILTERS];
-    size_t tfs_last_hits_for_message[MAX_FILTERS];
-    std::vector<uint32_t> tfs_mask;
+    std::vector<size_t> tfs_filter_count;
+    std::vector<int> tfs_filter_hits;
+    std::vector<bool> tfs_message_matched;
+    std::vector<size_t> tfs_lines_for_message;
+    std::vector<size_t> tfs_hits_for_message;
+    std::vector<bool> tfs_last_message_matched;
+    std::vector<size_t> tfs_last_lines_for_message;
+    std::vector<size_t> tfs_last_hits_for_message;
+    /** The lines matched by each filter, indexed by the filter index. */
+    std::vector<lnav::line_bitmap> tfs_masks;
+    size_t tfs_line_count{0};
     std::vector<uint32_t> tfs_index;
 };
 
@@ -133,6 +162,14 @@ public:
                   logfile_const_iterator ll,
                   const shared_buffer_ref& line);
 
+    /**
+     * Record the result of matching a line that was checked outside of
+     * matches(), like with a pcre2pp::code_set.
+     */
+    bool add_line_result(logfile_filter_state& lfs,
+                         logfile_const_iterator ll,
+                         bool matched);
+
     void end_of_message(logfile_filter_state& lfs);
 
     struct line_source {
@@ -145,6 +182,15 @@ public:
 
     virtual std::string to_command() const = 0;
 
+    /**
+     * @return The regex used by this filter if matches() is equivalent to
+     * searching for it in the line, otherwise nullptr.
+     */
+    virtual std::shared_ptr<lnav::pcre2pp::code> get_regex() const
+    {
+        return nullptr;
+    }
+
     bool operator==(const std::string& rhs) const { return this->lf_id == rhs; }
 
     bool lf_deleted{false};
@@ -193,6 +239,11 @@ public:
             + this->lf_id;
     }
 
+    std::shared_ptr<lnav::pcre2pp::code> get_regex() const override
+    {
+        return this->pf_pcre;
+    }
+
 protected:
     std::shared_ptr<lnav::pcre2pp::code> pf_pcre;
 };
@@ -220,13 +271,7 @@ public:
 
     bool empty() const { return this->fs_filters.empty(); };
 
-    bool full() const
-    {
-        return (this->fs_reserved + this->fs_filters.size())
-            == logfile_filter_state::MAX_FILTERS;
-    }
-
-    std::optional<size_t> next_index();
+    size_t next_index();
 
     void add_filter(const std::shared_ptr<text_filter>& filter);
 
@@ -253,9 +298,13 @@ public:
 
     bool delete_filter(const std::string& id);
 
-    void get_mask(uint32_t& filter_mask);
+    /** The indexes of the enabled filters, grouped by type. */
+    struct enabled_filters {
+        std::vector<size_t> ef_include;
+        std::vector<size_t> ef_exclude;
+    };
 
-    void get_enabled_mask(uint32_t& filter_in_mask, uint32_t& filter_out_mask);
+    enabled_filters get_enabled_filters() const;
 
     uint32_t fs_generation{0};
 
@@ -522,6 +571,19 @@ public:
                                       int line,
                                       line_flags_t raw = 0) = 0;
 
+    /**
+     * Check if the raw value of a line might contain all of the given
+     * literal strings, ignoring ASCII case.  Sources that have an index of
+     * their content can use this to let searches skip lines.
+     *
+     * @return False if the line cannot contain the literals.
+     */
+    virtual bool text_line_may_contain(int line,
+                                       const std::vector<std::string>& literals)
+    {
+        return true;
+    }
+
     /**
      * Inform the source that the given line has been marked/unmarked.  This
      * callback function can be used to translate between between visible line
@@ -581,6 +643,17 @@ public:
 
     virtual size_t get_filtered_after() const { return 0; }
 
+    /**
+     * @return The number of lines the filters have been applied to and the
+     * total number of lines if the filters are still being applied in the
+     * background.
+     */
+    virtual std::optional<std::pair<size_t, size_t>> get_filter_progress()
+        const
+    {
+        return std::nullopt;
+    }
+
     virtual void update_filter_hash_state(hasher& h) const;
 
     virtual std::optional<text_format_t> get_text_format() const
@@ -819,6 +892,21 @@ public:
     std::optional<line_info> grep_value_for_line(vis_line_t line,
                                                  std::string& value_out);
 
+    bool grep_may_match(vis_line_t line,
+                        const std::vector<std::string>& literals) override
+    {
+        return this->tc_sub_source == nullptr
+            || this->tc_sub_source->text_line_may_contain(line, literals);
+    }
+
+    std::optional<vis_line_t> grep_line_count() override
+    {
+        if (this->tc_sub_source == nullptr) {
+            return std::nullopt;
+        }
+        return vis_line_t(this->tc_sub_source->text_line_count());
+    }
+
     void grep_quiesce()
     {
         if (this->tc_sub_source != nullptr) {
@@ -1164,7 +1164,7 @@ timeline_source::rebuild_indexes()
             filtered_in_count += 1;
         }
     }
-    this->ts_filter_hits = {};
+    this->ts_filter_hits.clear();
 
     this->ts_time_order.clear();
     this->ts_time_order.reserve(this->ts_active_opids.size());
@@ -1221,6 +1221,9 @@ timeline_source::rebuild_indexes()
                 }
                 for (const auto sbr : {&sbr_opid, &sbr_desc}) {
                     if (filt->matches(std::nullopt, *sbr)) {
+                        if (filt->get_index() >= this->ts_filter_hits.size()) {
+                            this->ts_filter_hits.resize(filt->get_index() + 1);
+                        }
                         this->ts_filter_hits[filt->get_index()] += 1;
                         switch (filt->get_type()) {
                             case text_filter::INCLUDE:
@@ -1632,6 +1635,10 @@ timeline_source::get_filtered_count() const
 int
 timeline_source::get_filtered_count_for(size_t filter_index) const
 {
+    if (filter_index >= this->ts_filter_hits.size()) {
+        return 0;
+    }
+
     return this->ts_filter_hits[filter_index];
 }
 
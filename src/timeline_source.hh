@@ -30,7 +30,6 @@
 #ifndef lnav_timeline_source_hh
 #define lnav_timeline_source_hh
 
-#include <array>
 #include <functional>
 #include <memory>
 #include <optional>
@@ -225,7 +224,7 @@ public:
     std::chrono::microseconds ts_lower_bound{};
     std::chrono::microseconds ts_upper_bound{};
     size_t ts_filtered_count{0};
-    std::array<size_t, logfile_filter_state::MAX_FILTERS> ts_filter_hits{};
+    std::vector<size_t> ts_filter_hits;
     exec_context* ts_exec_context{nullptr};
     bool ts_preview_focused{false};
     std::vector<row_info> ts_preview_rows;
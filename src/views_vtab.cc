@@ -1024,10 +1024,7 @@ CREATE TABLE lnav_db.lnav_view_filters (
         auto filter_index
             = lang.value_or(filter_lang_t::REGEX) == filter_lang_t::REGEX
             ? fs.next_index()
-            : std::make_optional(size_t{0});
-        if (!filter_index) {
-            throw sqlite_func_error("Too many filters");
-        }
+            : size_t{0};
         auto conflict_mode = sqlite3_vtab_on_conflict(mod_vt->v_db);
         std::shared_ptr<text_filter> tf;
         switch (lang.value_or(filter_lang_t::REGEX)) {
@@ -1038,7 +1035,7 @@ CREATE TABLE lnav_db.lnav_view_filters (
                 auto pf = std::make_shared<pcre_filter>(
                     type.value_or(text_filter::type_t::EXCLUDE),
                     pattern->get_pattern(),
-                    *filter_index,
+                    filter_index,
                     pattern);
                 auto new_cmd = pf->to_command();
                 for (auto& filter : fs) {
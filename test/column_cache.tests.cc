@@ -0,0 +1,194 @@
+/**
+ * Copyright (c) 2026, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <vector>
+
+#include "config.h"
+#include "lnav_config.hh"
+#include "logfile.column_cache.hh"
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+
+using lnav::column_cache;
+using cell_kind = column_cache::cell_kind;
+
+static std::vector<logline_value>
+int_values(int64_t value)
+{
+    static const auto NUM_NAME = intern_string::lookup("num");
+
+    return {
+        logline_value(logline_value_meta(NUM_NAME,
+                                         value_kind_t::VALUE_INTEGER,
+                                         logline_value_meta::table_column{0}),
+                      value),
+    };
+}
+
+static void
+record_lines(column_cache& cc, size_t count)
+{
+    for (size_t lpc = 0; lpc < count; lpc++) {
+        cc.record(lpc, int_values(lpc));
+    }
+}
+
+TEST_CASE("column_cache hit and miss")
+{
+    lnav_config.lc_logfile.lc_column_cache_max_size = 1024 * 1024;
+
+    column_cache cc;
+    auto level_meta = logline_value_meta(intern_string::lookup("level"),
+                                         value_kind_t::VALUE_TEXT,
+                                         logline_value_meta::table_column{1});
+    level_meta.lvm_identifier = true;
+    std::vector<logline_value> values = {
+        logline_value(logline_value_meta(intern_string::lookup("num"),
+                                         value_kind_t::VALUE_INTEGER,
+                                         logline_value_meta::table_column{0}),
+                      int64_t{42}),
+        logline_value(level_meta, string_fragment::from_const("info")),
+        logline_value(logline_value_meta(intern_string::lookup("body"),
+                                         value_kind_t::VALUE_TEXT),
+                      string_fragment::from_const("hello, world")),
+        logline_value(logline_value_meta(intern_string::lookup("ratio"),
+                                         value_kind_t::VALUE_FLOAT),
+                      1.5),
+        logline_value(logline_value_meta(intern_string::lookup("empty"),
+                                         value_kind_t::VALUE_NULL)),
+    };
+
+    CHECK_FALSE(cc.lookup(3, intern_string::lookup("num")).has_value());
+    cc.record(3, values);
+    CHECK(cc.get_size() > 0);
+
+    CHECK_FALSE(cc.lookup(2, intern_string::lookup("num")).has_value());
+    CHECK_FALSE(cc.lookup(4, intern_string::lookup("num")).has_value());
+
+    auto num = cc.lookup(3, intern_string::lookup("num"));
+    REQUIRE(num.has_value());
+    CHECK(num->cv_kind == cell_kind::integer);
+    CHECK(num->cv_value.cv_int == 42);
+
+    auto by_col = cc.lookup(3, logline_value_meta::table_column{1});
+    REQUIRE(by_col.has_value());
+    CHECK(by_col->cv_kind == cell_kind::text);
+    CHECK(by_col->get_text().to_string() == "info");
+
+    auto body = cc.lookup(3, intern_string::lookup("body"));
+    REQUIRE(body.has_value());
+    CHECK(body->cv_kind == cell_kind::uncached);
+
+    auto ratio = cc.lookup(3, intern_string::lookup("ratio"));
+    REQUIRE(ratio.has_value());
+    CHECK(ratio->cv_kind == cell_kind::real);
+    CHECK(ratio->cv_value.cv_real == 1.5);
+
+    auto empty = cc.lookup(3, intern_string::lookup("empty"));
+    REQUIRE(empty.has_value());
+    CHECK(empty->cv_kind == cell_kind::none);
+
+    // The line was recorded, but without this column.
+    auto missing = cc.lookup(3, intern_string::lookup("missing"));
+    REQUIRE(missing.has_value());
+    CHECK(missing->cv_kind == cell_kind::none);
+    CHECK_FALSE(
+        cc.lookup(3, logline_value_meta::table_column{7}).has_value());
+}
+
+TEST_CASE("column_cache invalidation")
+{
+    lnav_config.lc_logfile.lc_column_cache_max_size = 1024 * 1024;
+
+    column_cache cc;
+
+    cc.sync(1);
+    record_lines(cc, 10);
+    CHECK(cc.lookup(9, intern_string::lookup("num")).has_value());
+
+    cc.truncate(5);
+    CHECK(cc.lookup(4, intern_string::lookup("num")).has_value());
+    CHECK_FALSE(cc.lookup(5, intern_string::lookup("num")).has_value());
+
+    // Recording a truncated line again should store the new value.
+    cc.record(5, int_values(500));
+    CHECK(cc.lookup(5, intern_string::lookup("num"))->cv_value.cv_int == 500);
+
+    cc.sync(1);
+    CHECK(cc.lookup(0, intern_string::lookup("num")).has_value());
+
+    cc.sync(2);
+    CHECK_FALSE(cc.lookup(0, intern_string::lookup("num")).has_value());
+    CHECK(cc.get_size() == 0);
+}
+
+TEST_CASE("column_cache eviction")
+{
+    static constexpr size_t LINES = 50;
+
+    column_cache cc1;
+    column_cache cc2;
+    column_cache cc3;
+
+    // Enough room for two of the caches, but not three.
+    lnav_config.lc_logfile.lc_column_cache_max_size = 1600;
+
+    record_lines(cc1, LINES);
+    record_lines(cc2, LINES);
+    REQUIRE(cc1.get_size() > 0);
+    REQUIRE(cc2.get_size() > 0);
+    REQUIRE(cc1.get_size() + cc2.get_size() <= 1600);
+    REQUIRE(cc1.get_size() * 3 > 1600);
+
+    // Touch the first cache so that the second is the least recently used.
+    CHECK(cc1.lookup(0, intern_string::lookup("num")).has_value());
+
+    record_lines(cc3, LINES);
+    CHECK(cc1.get_size() > 0);
+    CHECK(cc2.get_size() == 0);
+    CHECK(cc3.get_size() > 0);
+    CHECK(cc1.lookup(LINES - 1, intern_string::lookup("num")).has_value());
+    CHECK_FALSE(cc2.lookup(0, intern_string::lookup("num")).has_value());
+    CHECK(cc3.lookup(LINES - 1, intern_string::lookup("num")).has_value());
+
+    // A cache that cannot fit on its own stops recording until cleared.
+    record_lines(cc2, LINES * 8);
+    CHECK(cc2.get_size() == 0);
+    CHECK_FALSE(cc2.lookup(0, intern_string::lookup("num")).has_value());
+    cc2.record(0, int_values(1));
+    CHECK_FALSE(cc2.lookup(0, intern_string::lookup("num")).has_value());
+
+    cc1.clear();
+    cc3.clear();
+    cc2.clear();
+    cc2.record(0, int_values(1));
+    CHECK(cc2.lookup(0, intern_string::lookup("num")).has_value());
+}
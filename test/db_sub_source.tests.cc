@@ -0,0 +1,166 @@
+/**
+ * Copyright (c) 2026, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+
+#include <string>
+#include <vector>
+
+#include "config.h"
+#include "db_sub_source.hh"
+#include "fmt/format.h"
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+
+static void
+push_row(db_label_source& dls,
+         const std::vector<db_label_source::column_value_t>& values)
+{
+    dls.dls_row_cursors.emplace_back(dls.dls_cell_container.end_cursor());
+    dls.dls_push_column = 0;
+    for (const auto& value : values) {
+        dls.push_column(value);
+    }
+}
+
+static std::vector<int64_t>
+displayed_ids(const db_label_source& dls)
+{
+    std::vector<int64_t> retval;
+
+    for (size_t row = 0; row < dls.dls_row_cursors.size(); row++) {
+        retval.emplace_back(
+            dls.get_cell_as_int64(vis_line_t(row), 0).value_or(-1));
+    }
+
+    return retval;
+}
+
+TEST_CASE("db_label_source sort and filter rows")
+{
+    db_label_source dls;
+    const std::vector<db_label_source::column_value_t> values = {
+        int64_t{3},
+        string_fragment::from_const("b"),
+        null_value_t{},
+        2.5,
+        string_fragment::from_const("a"),
+        int64_t{10},
+        null_value_t{},
+        10.0,
+        string_fragment::from_const("10"),
+        int64_t{9007199254740993},
+        int64_t{9007199254740992},
+    };
+    std::vector<std::string> times;
+
+    dls.push_header("id", SQLITE_INTEGER);
+    dls.push_header("value", SQLITE_TEXT);
+    dls.push_header("log_time", SQLITE_TEXT);
+    for (size_t lpc = 0; lpc < values.size(); lpc++) {
+        times.emplace_back(
+            fmt::format(FMT_STRING("2026-01-01T00:00:{:02}.000"), lpc));
+    }
+    for (size_t lpc = 0; lpc < values.size(); lpc++) {
+        push_row(dls,
+                 {
+                     (int64_t) lpc,
+                     values[lpc],
+                     string_fragment::from_str(times[lpc]),
+                 });
+    }
+    REQUIRE(dls.has_log_time_column());
+    REQUIRE(dls.dls_time_column.size() == values.size());
+    auto expected_times = dls.dls_time_column;
+
+    SUBCASE("nulls, then numbers, then text")
+    {
+        dls.toggle_sort_rows(1);
+        CHECK(dls.is_reordered());
+        // Equal values keep their order and big integers are not
+        // compared as doubles.
+        CHECK(displayed_ids(dls)
+              == std::vector<int64_t>{2, 6, 3, 0, 5, 7, 10, 9, 8, 4, 1});
+        // The times are no longer in order, so there is no time column.
+        CHECK_FALSE(dls.has_log_time_column());
+
+        dls.toggle_sort_rows(1);
+        CHECK(displayed_ids(dls)
+              == std::vector<int64_t>{1, 4, 8, 9, 10, 5, 7, 0, 3, 2, 6});
+
+        dls.toggle_sort_rows(1);
+        CHECK(displayed_ids(dls)
+              == std::vector<int64_t>{2, 6, 3, 0, 5, 7, 10, 9, 8, 4, 1});
+    }
+
+    SUBCASE("sorting another column starts in ascending order")
+    {
+        dls.toggle_sort_rows(1);
+        dls.toggle_sort_rows(1);
+        dls.toggle_sort_rows(0);
+        CHECK(displayed_ids(dls)
+              == std::vector<int64_t>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10});
+        CHECK(dls.has_log_time_column());
+    }
+
+    SUBCASE("filter the sorted rows and then restore them")
+    {
+        dls.sort_rows(1, false);
+        // Row 5 is the integer 10, which is equal to the real 10.0.
+        REQUIRE(displayed_ids(dls)[5] == 5);
+        dls.filter_rows(1, 5_vl);
+        CHECK(displayed_ids(dls) == std::vector<int64_t>{5, 7});
+        CHECK(dls.text_line_count() == 2);
+        // The remaining times are in order again.
+        REQUIRE(dls.has_log_time_column());
+        CHECK(dls.dls_time_column
+              == std::vector<timeval>{expected_times[5], expected_times[7]});
+
+        dls.filter_rows(1, 0_vl);
+        CHECK(displayed_ids(dls) == std::vector<int64_t>{5, 7});
+
+        dls.reset_row_order();
+        CHECK_FALSE(dls.is_reordered());
+        CHECK(displayed_ids(dls)
+              == std::vector<int64_t>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10});
+        CHECK(dls.dls_time_column == expected_times);
+        CHECK(dls.time_for_row(3_vl)->ri_time == expected_times[3]);
+    }
+
+    SUBCASE("filter on a null or text value")
+    {
+        dls.filter_rows(1, 2_vl);
+        CHECK(displayed_ids(dls) == std::vector<int64_t>{2, 6});
+
+        dls.reset_row_order();
+        dls.filter_rows(1, 8_vl);
+        CHECK(displayed_ids(dls) == std::vector<int64_t>{8});
+    }
+}
@@ -42,6 +42,7 @@
 #include <unistd.h>
 
 #include "base/auto_fd.hh"
+#include "base/lnav_log.hh"
 #include "base/string_util.hh"
 #include "config.h"
 #include "line_buffer.hh"
@@ -57,9 +58,12 @@ main(int argc, char* argv[])
     int offseti = 0;
     off_t offset = 0;
     int count = 1000;
+    bool immutable = false;
+    bool cache = false;
+    bool truncate_mapped = false;
     struct stat st;
 
-    while ((c = getopt(argc, argv, "o:i:n:c:")) != -1) {
+    while ((c = getopt(argc, argv, "o:i:n:c:md:Ct")) != -1) {
         switch (c) {
             case 'o':
                 if (sscanf(optarg, "%d", &offseti) != 1) {
@@ -87,6 +91,19 @@ main(int argc, char* argv[])
                     retval = EXIT_FAILURE;
                 }
                 break;
+            case 'm':
+                immutable = true;
+                break;
+            case 'C':
+                cache = true;
+                break;
+            case 't':
+                truncate_mapped = true;
+                immutable = true;
+                break;
+            case 'd':
+                lnav_log_file = fopen(optarg, "w");
+                break;
             case 'i': {
                 FILE* file;
 
@@ -145,7 +162,39 @@ main(int argc, char* argv[])
             int fd2 = (argc > 1) ? fd_cmp.get() : fd.get();
             assert(fd2 >= 0);
             lb.set_fd(fd);
-            if (index.size() == 0) {
+            lb.set_immutable(immutable);
+            if (cache) {
+                lb.enable_cache();
+            }
+            if (truncate_mapped) {
+                auto li = lb.load_next_line(last_range).unwrap();
+                auto before = lb.read_range(li.li_file_range)
+                                  .unwrap()
+                                  .to_string_fragment()
+                                  .to_string();
+                auto_fd wfd = auto_fd(open(argv[0], O_WRONLY));
+
+                if (wfd == -1 || ftruncate(wfd, 0) == -1) {
+                    perror("truncate");
+                    return EXIT_FAILURE;
+                }
+
+                // The mapped pages are gone now, so touching them raises a
+                // SIGBUS that the mapping has to absorb.
+                auto faulted = lb.read_range(li.li_file_range).unwrap();
+                volatile size_t sum = 0;
+                for (size_t lpc = 0; lpc < faulted.length(); lpc++) {
+                    sum = sum + faulted.get_data()[lpc];
+                }
+
+                // This read should be served from the buffer instead.
+                auto after = lb.read_range(li.li_file_range)
+                                 .unwrap()
+                                 .to_string_fragment()
+                                 .to_string();
+                printf("%s", before.c_str());
+                printf("%s", after.c_str());
+            } else if (index.size() == 0) {
                 while (count) {
                     auto load_result = lb.load_next_line(last_range);
 
@@ -42,6 +42,7 @@
 #include "base/isc.hh"
 #include "base/opt_util.hh"
 #include "config.h"
+#include "lnav_config.hh"
 #include "log_format.hh"
 #include "log_format_loader.hh"
 #include "logfile.hh"
@@ -54,6 +55,7 @@ typedef enum {
     MODE_LINE_COUNT,
     MODE_TIMES,
     MODE_LEVELS,
+    MODE_INDEX,
 } dl_mode_t;
 
 static auto bound_file_options_hier
@@ -71,6 +73,7 @@ main(int argc, char* argv[])
     int c, retval = EXIT_SUCCESS;
     dl_mode_t mode = MODE_NONE;
     string expected_format;
+    const char* append_path = nullptr;
 
     {
         static auto builtin_formats
@@ -92,8 +95,18 @@ main(int argc, char* argv[])
         load_formats(paths, errors);
     }
 
-    while ((c = getopt(argc, argv, "ef:ltv")) != -1) {
+    while ((c = getopt(argc, argv, "a:ef:ilp:tv")) != -1) {
         switch (c) {
+            case 'a':
+                append_path = optarg;
+                break;
+            case 'i':
+                mode = MODE_INDEX;
+                break;
+            case 'p':
+                lnav_config.lc_logfile.lc_parallel_index_chunk_size
+                    = strtoull(optarg, nullptr, 10);
+                break;
             case 'f':
                 expected_format = optarg;
                 break;
@@ -140,6 +153,22 @@ main(int argc, char* argv[])
         assert(!lf->is_closed());
         lf->rebuild_index();
         assert(!lf->is_closed());
+        if (append_path != nullptr) {
+            // Grow the file after the format has been detected so the new
+            // lines are eligible for the parallel indexer.
+            auto* in = fopen(append_path, "r");
+            auto* out = fopen(argv[0], "a");
+            char buffer[8192];
+            size_t rc;
+
+            assert(in != nullptr && out != nullptr);
+            while ((rc = fread(buffer, 1, sizeof(buffer), in)) > 0) {
+                fwrite(buffer, 1, rc, out);
+            }
+            fclose(in);
+            fclose(out);
+            stat(argv[0], &st);
+        }
         lf->rebuild_index();
         assert(!lf->is_closed());
         assert(lf->get_activity().la_polls == 3);
@@ -197,6 +226,22 @@ main(int argc, char* argv[])
                         "%.*s 0x%x\n", level_sf.length(), level_sf.data(), flags);
                 }
                 break;
+            case MODE_INDEX:
+                for (auto& iter : *lf) {
+                    auto level_sf = iter.get_level_name();
+
+                    printf("%lld %lld %.*s %d %d %d\n",
+                           (long long) iter.get_offset(),
+                           (long long) iter
+                               .get_time<std::chrono::microseconds>()
+                               .count(),
+                           level_sf.length(),
+                           level_sf.data(),
+                           iter.is_continued(),
+                           iter.is_time_skewed(),
+                           iter.is_ignored());
+                }
+                break;
         }
     }
 
@@ -0,0 +1,185 @@
+/**
+ * Copyright (c) 2026, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <stdio.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/injector.bind.hh"
+#include "base/injector.hh"
+#include "base/isc.hh"
+#include "config.h"
+#include "fmt/format.h"
+#include "lnav_config.hh"
+#include "log_format.hh"
+#include "log_format_loader.hh"
+#include "logfile.hh"
+#include "logfile_sub_source.hh"
+#include "textview_curses.hh"
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+
+static auto bound_file_options_hier
+    = injector::bind<lnav::safe_file_options_hier>::to_singleton();
+
+static void
+load_builtin_formats()
+{
+    static auto builtin_formats
+        = injector::get<std::vector<std::shared_ptr<log_format>>>();
+    auto& root_formats = log_format::get_root_formats();
+
+    root_formats.insert(
+        root_formats.begin(), builtin_formats.begin(), builtin_formats.end());
+    builtin_formats.clear();
+
+    std::vector<lnav::console::user_message> errors;
+    std::vector<std::filesystem::path> paths;
+
+    load_formats(paths, errors);
+}
+
+static void
+append_access_log(const std::string& path,
+                  size_t file_index,
+                  size_t start,
+                  size_t count)
+{
+    auto* out = fopen(path.c_str(), "a");
+
+    REQUIRE(out != nullptr);
+    for (auto lpc = start; lpc < start + count; lpc++) {
+        auto secs = lpc * 4 + file_index;
+
+        // Throw in an out-of-order message and an error now and then.
+        if (lpc % 211 == 0 && secs > 30) {
+            secs -= 30;
+        }
+        fmt::print(out,
+                   "10.0.{}.{} - - [20/Jul/2009:{:02}:{:02}:{:02} +0000] "
+                   "\"GET /page/{} HTTP/1.0\" {} {} \"-\" \"curl/7.1\"\n",
+                   file_index,
+                   lpc % 250,
+                   secs / 3600,
+                   (secs / 60) % 60,
+                   secs % 60,
+                   lpc,
+                   lpc % 97 == 0 ? 500 : 200,
+                   lpc * 7);
+    }
+    fclose(out);
+}
+
+TEST_CASE("logfile_sub_source concurrent indexing")
+{
+    static constexpr size_t FILE_COUNT = 4;
+    static constexpr size_t HEAD_LINES = 300;
+    static constexpr size_t TAIL_LINES = 2000;
+
+    load_builtin_formats();
+    // Small chunks so the files are also indexed in parallel internally.
+    lnav_config.lc_logfile.lc_parallel_index_chunk_size = 4096;
+
+    isc::supervisor root_superv(injector::get<isc::service_list>());
+    textview_curses tc;
+    logfile_sub_source lss;
+    std::vector<std::string> paths;
+    std::vector<std::shared_ptr<logfile>> files;
+
+    tc.set_sub_source(&lss);
+    for (size_t lpc = 0; lpc < FILE_COUNT; lpc++) {
+        auto path = fmt::format(FMT_STRING("concurrent-index-{}.log"), lpc);
+
+        remove(path.c_str());
+        append_access_log(path, lpc, 0, HEAD_LINES);
+
+        auto open_res = logfile::open(path, logfile_open_options{});
+        REQUIRE(open_res.isOk());
+        auto lf = open_res.unwrap();
+
+        // Detect the format and lock it in.
+        lf->rebuild_index();
+        lf->rebuild_index();
+        REQUIRE(lf->get_format() != nullptr);
+        REQUIRE(lf->size() == HEAD_LINES);
+        lss.insert_file(lf);
+        paths.emplace_back(path);
+        files.emplace_back(lf);
+    }
+    lss.rebuild_index();
+    CHECK(lss.text_line_count() == FILE_COUNT * HEAD_LINES);
+
+    for (size_t lpc = 0; lpc < FILE_COUNT; lpc++) {
+        append_access_log(paths[lpc], lpc, HEAD_LINES, TAIL_LINES);
+        REQUIRE(files[lpc]->can_index_concurrently());
+    }
+    lss.rebuild_index();
+    CHECK(lss.text_line_count() == FILE_COUNT * (HEAD_LINES + TAIL_LINES));
+
+    // The result should be the same as indexing each file on its own.
+    for (size_t lpc = 0; lpc < FILE_COUNT; lpc++) {
+        const auto& lf = files[lpc];
+        auto open_res = logfile::open(paths[lpc], logfile_open_options{});
+        REQUIRE(open_res.isOk());
+        auto expected_lf = open_res.unwrap();
+
+        expected_lf->rebuild_index();
+        expected_lf->rebuild_index();
+        REQUIRE(lf->size() == expected_lf->size());
+        for (size_t line = 0; line < lf->size(); line++) {
+            const auto& ll = (*lf)[line];
+            const auto& expected_ll = (*expected_lf)[line];
+
+            CAPTURE(lpc);
+            CAPTURE(line);
+            CHECK(ll.get_offset() == expected_ll.get_offset());
+            CHECK(ll.get_time<std::chrono::microseconds>()
+                  == expected_ll.get_time<std::chrono::microseconds>());
+            CHECK(ll.get_msg_level() == expected_ll.get_msg_level());
+            CHECK(ll.is_time_skewed() == expected_ll.is_time_skewed());
+        }
+    }
+
+    // The merged index should still be in time order.
+    for (auto vl = 1_vl; vl < vis_line_t(lss.text_line_count()); ++vl) {
+        auto* prev_ll = lss.find_line(lss.at(vl - 1_vl));
+        auto* ll = lss.find_line(lss.at(vl));
+
+        CAPTURE(vl);
+        CHECK(!(*ll < *prev_ll));
+    }
+
+    for (const auto& path : paths) {
+        remove(path.c_str());
+    }
+}
@@ -0,0 +1,224 @@
+/**
+ * Copyright (c) 2026, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <string>
+#include <vector>
+
+#include "config.h"
+
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include "doctest/doctest.h"
+#include "sql_predicate.hh"
+
+using lnav::sql::predicate;
+using value = predicate::value;
+
+static std::optional<bool>
+eval_expr(const char* expr, const std::vector<value>& vars = {})
+{
+    auto pred = predicate::compile(string_fragment::from_c_str(expr));
+
+    REQUIRE(pred.has_value());
+    REQUIRE(pred->get_variables().size() == vars.size());
+    return pred->eval(vars);
+}
+
+TEST_CASE("sql_predicate unsupported")
+{
+    const char* EXPRS[] = {
+        "log_level = 'error'",
+        ":a + 1 > 2",
+        ":a || 'b' = 'ab'",
+        "lower(:a) = 'b'",
+        ":a LIKE 'b%' ESCAPE '\\'",
+        ":a IN (SELECT 1)",
+        ":a IS TRUE",
+        ":a REGEXP :b",
+        ":a REGEXP '('",
+        "\"a\" = 'a'",
+        "0x10 = 16",
+        ":a = 1 -- comment",
+        "$a::b = 1",
+        "(:a, :b) = (1, 2)",
+        ":a = ",
+    };
+
+    for (const auto* expr : EXPRS) {
+        CAPTURE(expr);
+        CHECK_FALSE(
+            predicate::compile(string_fragment::from_c_str(expr)).has_value());
+    }
+}
+
+TEST_CASE("sql_predicate variables")
+{
+    auto pred = predicate::compile(
+        string_fragment::from_c_str(":a = 1 OR :b = 2 OR :a = 3 OR $HOME"));
+
+    REQUIRE(pred.has_value());
+    CHECK(pred->get_variables()
+          == std::vector<std::string>{":a", ":b", "$HOME"});
+}
+
+TEST_CASE("sql_predicate comparisons")
+{
+    auto err = value::from_text(string_fragment::from_const("error"));
+
+    CHECK(eval_expr(":log_level = 'error'", {err}) == true);
+    CHECK(eval_expr(":log_level == 'error'", {err}) == true);
+    CHECK(eval_expr(":log_level != 'error'", {err}) == false);
+    CHECK(eval_expr(":log_level <> 'info'", {err}) == true);
+    CHECK(eval_expr(":log_level > 'debug'", {err}) == true);
+    CHECK(eval_expr(":log_level < 'debug'", {err}) == false);
+    CHECK(eval_expr(":sc_status >= 500", {value::from_int(503)}) == true);
+    CHECK(eval_expr(":sc_status >= 500", {value::from_int(200)}) == false);
+    CHECK(eval_expr(":val < 1.5", {value::from_int(1)}) == true);
+    CHECK(eval_expr(":val = 2", {value::from_real(2.0)}) == true);
+    CHECK(eval_expr(":val > -1", {value::from_int(0)}) == true);
+    CHECK(eval_expr("1 < 2 = 1") == true);
+
+    // Without an affinity, numbers always sort before text.
+    auto num_str = value::from_text(string_fragment::from_const("500"));
+    CHECK(eval_expr(":sc_status = 500", {num_str}) == false);
+    CHECK(eval_expr(":sc_status > 500", {num_str}) == true);
+}
+
+TEST_CASE("sql_predicate null handling")
+{
+    value null_val;
+
+    CHECK(eval_expr(":a = 1", {null_val}) == false);
+    CHECK(eval_expr("NOT (:a = 1)", {null_val}) == false);
+    CHECK(eval_expr(":a IS NULL", {null_val}) == true);
+    CHECK(eval_expr(":a IS NOT NULL", {null_val}) == false);
+    CHECK(eval_expr(":a ISNULL", {null_val}) == true);
+    CHECK(eval_expr(":a NOTNULL", {value::from_int(1)}) == true);
+    CHECK(eval_expr(":a NOT NULL", {null_val}) == false);
+    CHECK(eval_expr(":a IS 1", {null_val}) == false);
+    CHECK(eval_expr(":a IS NOT 1", {null_val}) == true);
+    CHECK(eval_expr(":a = 1 OR 1", {null_val}) == true);
+    CHECK(eval_expr(":a = 1 AND 0", {null_val}) == false);
+    CHECK(eval_expr("NOT (:a = 1 AND 1)", {null_val}) == false);
+    CHECK(eval_expr("NULL") == false);
+    CHECK(eval_expr("TRUE AND NOT FALSE") == true);
+}
+
+TEST_CASE("sql_predicate text truthiness")
+{
+    // SQLite converts text to a number, which is left to it.
+    CHECK(eval_expr(":a", {value::from_text(string_fragment::from_const("1"))})
+          == std::nullopt);
+    CHECK(eval_expr(":a AND 0",
+                    {value::from_text(string_fragment::from_const("1"))})
+          == std::nullopt);
+    CHECK(eval_expr("0 AND :a",
+                    {value::from_text(string_fragment::from_const("1"))})
+          == false);
+}
+
+TEST_CASE("sql_predicate in and between")
+{
+    CHECK(eval_expr(":a IN (1, 2, 3)", {value::from_int(2)}) == true);
+    CHECK(eval_expr(":a IN (1, 2, 3)", {value::from_int(4)}) == false);
+    CHECK(eval_expr(":a NOT IN (1, 2, 3)", {value::from_int(4)}) == true);
+    CHECK(eval_expr(":a IN (1, NULL)", {value::from_int(4)}) == false);
+    CHECK(eval_expr(":a NOT IN (1, NULL)", {value::from_int(4)}) == false);
+    CHECK(eval_expr(":a IN ()", {value{}}) == false);
+    CHECK(eval_expr(":a NOT IN ()", {value{}}) == true);
+    CHECK(eval_expr(":a IN ('info', 'error')",
+                    {value::from_text(string_fragment::from_const("error"))})
+          == true);
+    CHECK(eval_expr(":a BETWEEN 1 AND 10", {value::from_int(10)}) == true);
+    CHECK(eval_expr(":a BETWEEN 1 AND 10", {value::from_int(11)}) == false);
+    CHECK(eval_expr(":a NOT BETWEEN 1 AND 10", {value::from_int(11)})
+          == true);
+    CHECK(eval_expr(":a BETWEEN 1 AND 10 AND 0", {value::from_int(5)})
+          == false);
+}
+
+TEST_CASE("sql_predicate patterns")
+{
+    auto msg = value::from_text(
+        string_fragment::from_const("Failed password for root"));
+
+    CHECK(eval_expr(":a LIKE 'failed%'", {msg}) == true);
+    CHECK(eval_expr(":a LIKE '%PASSWORD%'", {msg}) == true);
+    CHECK(eval_expr(":a LIKE 'F_iled%root'", {msg}) == true);
+    CHECK(eval_expr(":a LIKE 'failed'", {msg}) == false);
+    CHECK(eval_expr(":a NOT LIKE 'x%'", {msg}) == true);
+    CHECK(eval_expr(":a GLOB 'Failed*'", {msg}) == true);
+    CHECK(eval_expr(":a GLOB 'failed*'", {msg}) == false);
+    CHECK(eval_expr(":a GLOB '[A-F]?iled*ro[^x]t'", {msg}) == true);
+    CHECK(eval_expr(":a GLOB '*[]]*'", {msg}) == false);
+    CHECK(eval_expr(":a GLOB '[abc'", {msg}) == false);
+    CHECK(eval_expr(":a GLOB '[]-a]'",
+                    {value::from_text(string_fragment::from_const("-"))})
+          == true);
+    CHECK(eval_expr(":a GLOB '*a*b*c'",
+                    {value::from_text(string_fragment::from_const("xaxbxbc"))})
+          == true);
+    CHECK(eval_expr(":a LIKE '%'", {value{}}) == false);
+    CHECK(eval_expr(":a LIKE '12%'", {value::from_int(123)}) == true);
+    CHECK(eval_expr(":a LIKE '12%'", {value::from_real(12.5)})
+          == std::nullopt);
+    CHECK(eval_expr(":a LIKE '_'",
+                    {value::from_text(string_fragment::from_const("\xc3\xa9"))})
+          == true);
+}
+
+TEST_CASE("sql_predicate regexp")
+{
+    auto msg = value::from_text(
+        string_fragment::from_const("Failed password for root"));
+
+    CHECK(eval_expr(":a REGEXP 'pass\\w+'", {msg}) == true);
+    CHECK(eval_expr(":a NOT REGEXP '^root'", {msg}) == true);
+    CHECK(eval_expr("regexp('for (root|admin)$', :a)", {msg}) == true);
+    CHECK(eval_expr(":a REGEXP 'x'", {value{}}) == false);
+    CHECK(eval_expr("NOT (:a REGEXP 'x')", {value{}}) == false);
+}
+
+TEST_CASE("sql_predicate value ordering")
+{
+    auto abc = value::from_text(string_fragment::from_const("abc"));
+    auto abcd = value::from_text(string_fragment::from_const("abcd"));
+    auto big = value::from_int(9007199254740993LL);
+
+    CHECK(value::compare(value{}, value{}) == 0);
+    CHECK(value::compare(value{}, value::from_int(-1)) < 0);
+    CHECK(value::compare(value::from_real(1e300), abc) < 0);
+    CHECK(value::compare(abc, value{}) > 0);
+    CHECK(value::compare(value::from_int(2), value::from_real(2.0)) == 0);
+    CHECK(value::compare(value::from_int(2), value::from_real(2.5)) < 0);
+    CHECK(value::compare(big, value::from_real(9007199254740992.0)) > 0);
+    CHECK(value::compare(abc, abcd) < 0);
+    CHECK(value::compare(abcd, abc) > 0);
+    CHECK(value::compare(abc, abc) == 0);
+}
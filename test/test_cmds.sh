@@ -722,3 +722,64 @@ run_cap_test ${lnav_test} -n \
 run_cap_test ${lnav_test} -n \
     -c ':echo Hello, $XYZ!' \
     ${test_dir}/logfile_access_log.0
+
+# Filters with quantified and escaped patterns are checked together using
+# the literals they require.  The result should be the same as checking a
+# single pattern that cannot be split into literals.
+${lnav_test} -n \
+    -c ':filter-out \x43RON\[\d+\]' \
+    -c ':filter-out dnsmasq\[\d{4}\]: read' \
+    -c ':filter-out avahi-daemon\[\d{1,5}\]: \p{Lu}\w+ new' \
+    ${test_dir}/logfile_filter.0 > filter-set-quantified.out
+on_error_fail_with "filters with quantified patterns failed?"
+
+grep -q -e 'CRON\[' -e 'dnsmasq\[1840\]: read' filter-set-quantified.out
+if test $? -eq 0; then
+    echo "filters with quantified patterns did not hide the lines"
+    exit 1
+fi
+
+run_test ${lnav_test} -n \
+    -c ':filter-out \x43RON\[\d+\]|dnsmasq\[\d{4}\]: read|avahi-daemon\[\d{1,5}\]: \p{Lu}\w+ new' \
+    ${test_dir}/logfile_filter.0
+
+check_output "filter set does not match a single filter" \
+    < filter-set-quantified.out
+
+# Filters evaluated on worker threads should hide the same lines as the
+# filters evaluated inline.
+awk 'BEGIN {
+    for (lpc = 0; lpc < 3000; lpc++) {
+        printf("Jan  1 %02d:%02d:%02d host worker[%d]: request %d %s\n",
+               int(lpc / 3600), int(lpc / 60) % 60, lpc % 60,
+               100 + lpc % 7, lpc,
+               (lpc % 3 == 0) ? "failed" : "succeeded");
+    }
+}' > background-filter.0
+
+run_test ${lnav_test} -n \
+    -c ':filter-in request \d+ (failed|succeeded)' \
+    -c ':filter-out worker\[10[35]\]' \
+    -c ':filter-out request \d*7 failed' \
+    background-filter.0
+cp $(test_filename) background-filter.inline
+
+export HOME="./background-filter-config"
+rm -rf ./background-filter-config
+mkdir -p $HOME/.lnav
+
+${lnav_test} -Nn \
+    -c ':config /tuning/logfile/background-filter-min-lines 10' \
+    -c ':config /tuning/logfile/background-filter-chunk-lines 7'
+
+run_test ${lnav_test} -d background-filter.err -n \
+    -c ':filter-in request \d+ (failed|succeeded)' \
+    -c ':filter-out worker\[10[35]\]' \
+    -c ':filter-out request \d*7 failed' \
+    background-filter.0
+
+check_output "background filters do not match the inline filters" \
+    < background-filter.inline
+
+grep -q "starting background filter" background-filter.err
+on_error_fail_with "filters were not evaluated in the background?"
@@ -30,3 +30,54 @@ run_cap_test env TEST_COMMENT="delete the configuration" ${lnav_test} -nN \
 
 run_cap_test env TEST_COMMENT="config should be gone now" ${lnav_test} -nN \
    -c ':config /log/watch-expressions'
+
+# A message that is still being written should only be checked once the
+# rest of it is appended, and the lines that are read again after the
+# append should not produce duplicate events.
+${lnav_test} -nN \
+   -c ':config /log/watch-expressions/big-response/expr :sc_bytes > 50000'
+
+head -2 ${test_dir}/logfile_access_log.0 > watch-partial.0
+printf '192.168.202.254 - - [20/Jul/2009:22:59:29 +0000] "GET /vmw/vSphere/default/vmkernel.gz HTTP/1.0" 200 78' >> watch-partial.0
+
+run_test ${lnav_test} -n \
+   -c ":shexec echo '929 \"-\" \"gPXE/0.9.7\"' >> watch-partial.0" \
+   -c ":rebuild" \
+   -c ":shexec echo '192.168.202.254 - - [20/Jul/2009:22:59:30 +0000] \"GET /vmw/vSphere/default/sys.vgz HTTP/1.0\" 200 90000 \"-\" \"gPXE/0.9.7\"' >> watch-partial.0" \
+   -c ":rebuild" \
+   -c ":shexec echo '192.168.202.254 - - [20/Jul/2009:22:59:31 +0000] \"GET /vmw/vSphere/default/cim.vgz HTTP/1.0\" 404 120 \"-\" \"gPXE/0.9.7\"' >> watch-partial.0" \
+   -c ":rebuild" \
+   -c ";SELECT jget(content, '/line-number') AS line_number FROM lnav_events WHERE jget(content, '/watch-name') = 'big-response'" \
+   -c ':write-csv-to -' \
+   watch-partial.0
+
+cat > watch-partial.expected <<EOF2
+line_number
+2
+3
+EOF2
+
+check_output "watch expressions did not see the completed line once" \
+   < watch-partial.expected
+
+# The last message in a file that does not end with a newline should still
+# be checked once nothing more is appended to it.
+head -2 ${test_dir}/logfile_access_log.0 > watch-partial.1
+printf '192.168.202.254 - - [20/Jul/2009:22:59:29 +0000] "GET /vmw/vSphere/default/vmkernel.gz HTTP/1.0" 200 78929 "-" "gPXE/0.9.7"' >> watch-partial.1
+
+run_test ${lnav_test} -n \
+   -c ":rebuild" \
+   -c ";SELECT jget(content, '/line-number') AS line_number FROM lnav_events WHERE jget(content, '/watch-name') = 'big-response'" \
+   -c ':write-csv-to -' \
+   watch-partial.1
+
+cat > watch-partial.expected <<EOF2
+line_number
+2
+EOF2
+
+check_output "watch expressions did not see the unterminated last line" \
+   < watch-partial.expected
+
+${lnav_test} -nN \
+   -c ':reset-config /log/watch-expressions/big-response/'
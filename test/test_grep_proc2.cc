@@ -33,6 +33,8 @@
 #include <sys/types.h>
 #include <sys/wait.h>
 
+#include <set>
+
 #include "config.h"
 #include "grep_proc.hh"
 #include "vis_line.hh"
@@ -79,11 +81,36 @@ class my_sleeper_source : public grep_proc_source<vis_line_t> {
     }
 };
 
+/** A source with a match every 1000 lines that can be grown. */
+class my_counted_source : public grep_proc_source<vis_line_t> {
+public:
+    std::optional<line_info> grep_value_for_line(vis_line_t line_number,
+                                                 string& value_out) override
+    {
+        if (line_number >= this->mcs_line_count) {
+            return std::nullopt;
+        }
+
+        value_out = (line_number % 1000) == 0 ? "foobar" : "baz";
+        return line_info{};
+    }
+
+    std::optional<vis_line_t> grep_line_count() override
+    {
+        return vis_line_t(this->mcs_line_count);
+    }
+
+    int mcs_line_count{0};
+};
+
 class my_sink : public grep_proc_sink<vis_line_t> {
 public:
     my_sink() : ms_finished(false) {};
 
-    void grep_match(grep_proc<vis_line_t>& gp, vis_line_t line) override {}
+    void grep_match(grep_proc<vis_line_t>& gp, vis_line_t line) override
+    {
+        this->ms_matches.insert(line);
+    }
 
     void grep_end(grep_proc<vis_line_t>& gp) override
     {
@@ -91,13 +118,12 @@ public:
     }
 
     bool ms_finished;
+    std::set<int> ms_matches;
 };
 
 static void
-looper(grep_proc<vis_line_t>& gp)
+looper(grep_proc<vis_line_t>& gp, my_sink& msink)
 {
-    my_sink msink;
-
     gp.set_sink(&msink);
 
     while (!msink.ms_finished) {
@@ -126,7 +152,43 @@ main(int argc, char* argv[])
         gp.queue_request(10_vl, gp.until_line(14_vl));
         gp.queue_request(0_vl, gp.until_line(3_vl));
         gp.start();
-        looper(gp);
+
+        my_sink msink;
+        looper(gp, msink);
+    }
+
+    {
+        // A search to the end is split into several tasks, but the matches
+        // and the highest line should be the same as a single one.
+        my_counted_source mcs;
+        grep_proc<vis_line_t> gp(code, mcs, psuperv);
+        std::set<int> expected;
+
+        mcs.mcs_line_count = 25'000;
+        for (int lpc = 0; lpc < mcs.mcs_line_count; lpc += 1000) {
+            expected.insert(lpc);
+        }
+
+        gp.queue_request(0_vl, gp.until_eof(mcs.mcs_line_count));
+        gp.start();
+
+        my_sink msink;
+        looper(gp, msink);
+        assert(msink.ms_matches == expected);
+
+        // Continuing from the highest line should only find the new lines.
+        mcs.mcs_line_count = 31'000;
+        expected.clear();
+        for (int lpc = 25'000; lpc < mcs.mcs_line_count; lpc += 1000) {
+            expected.insert(lpc);
+        }
+
+        gp.queue_request(-1_vl, gp.until_eof(0_vl));
+        gp.start();
+
+        my_sink msink2;
+        looper(gp, msink2);
+        assert(msink2.ms_matches == expected);
     }
 
     {
@@ -75,4 +75,101 @@ run_test ./drive_line_buffer -i lb-3.index -n 10 lb-3.gz lb-3.dat
 
 check_output "Random gzipped reads don't match input" <<EOF
 All done
-EOF
\ No newline at end of file
+EOF
+
+run_test ./drive_line_buffer -m -i lb-3.index -n 10 lb-3.dat
+
+check_output "Random mapped reads don't match input" <<EOF
+All done
+EOF
+
+# A mapped file that is truncated should be read normally afterward.
+cp lb-2.dat lb-trunc.dat
+head -1 lb-2.dat > lb-trunc.expected
+head -1 lb-2.dat >> lb-trunc.expected
+rm -f lb-trunc.err
+run_test ./drive_line_buffer -d lb-trunc.err -t lb-trunc.dat
+on_error_fail_with "reading a truncated mapped file crashed"
+
+check_output "truncated mapped file was not read from the buffer" \
+    < lb-trunc.expected
+
+grep -q "file was truncated while mapped, reading normally" lb-trunc.err
+on_error_fail_with "truncated mapping was not detected"
+
+# Only short numeric suffixes are treated as rotated files and mapped.
+cp lb-2.dat lb-rotated.1
+cp lb-2.dat lb-rotated.2024
+rm -f lb-rotated.1.err lb-rotated.2024.err
+run_test ${lnav_test} -n -d lb-rotated.1.err lb-rotated.1
+grep -q "mapped [0-9]* bytes of immutable file" lb-rotated.1.err
+on_error_fail_with "rotated file was not mapped"
+
+run_test ${lnav_test} -n -d lb-rotated.2024.err lb-rotated.2024
+if grep -q "mapped [0-9]* bytes of immutable file" lb-rotated.2024.err; then
+    echo "error: a file with a year suffix was mapped"
+    exit 1
+fi
+
+# A multi-member gzip file that is large enough to have syncpoints.
+rm -rf lb-4.gz lb-4-tmp
+mkdir lb-4-tmp
+split -b 3000000 lb-3.dat lb-4.part.
+for part in lb-4.part.*; do
+    gzip -c -1 $part >> lb-4.gz
+done
+rm -f lb-4.part.*
+
+run_test env TMPDIR=lb-4-tmp ./drive_line_buffer -d lb-4.0.err \
+    -c 100000000 lb-4.gz
+
+gzip -dc lb-4.gz | \
+    check_output "multi-member gzip reads don't match input"
+
+grep -q "saved [1-9][0-9]* syncpoints to gzip index" lb-4.0.err
+on_error_fail_with "gzip index was not saved"
+
+run_test env TMPDIR=lb-4-tmp ./drive_line_buffer -d lb-4.1.err -C \
+    -c 100000000 lb-4.gz
+
+gzip -dc lb-4.gz | \
+    check_output "parallel decompressed cache doesn't match input"
+
+grep -q "loaded [1-9][0-9]* syncpoints from gzip index" lb-4.1.err
+on_error_fail_with "gzip index was not loaded on reopen"
+
+grep -q "decompressed [1-9][0-9]* bytes using syncpoints" lb-4.1.err
+on_error_fail_with "cache was not decompressed in parallel"
+
+if [ "$BZIP2_SUPPORT" -eq 1 ] && [ x"$BZIP2_CMD" != x"" ] ; then
+    $BZIP2_CMD -z -c -1 lb-3.dat > lb-3.bz2
+
+    run_test ./drive_line_buffer -i lb-3.index -n 10 lb-3.bz2 lb-3.dat
+
+    check_output "Random bzip2 reads don't match input" <<EOF
+All done
+EOF
+fi
+
+if [ "$ZSTD_SUPPORT" -eq 1 ] && [ x"$ZSTD_CMD" != x"" ] ; then
+    $ZSTD_CMD -q -c lb-3.dat > lb-3.zst
+
+    run_test ./drive_line_buffer -i lb-3.index -n 10 lb-3.zst lb-3.dat
+
+    check_output "Random zstd reads don't match input" <<EOF
+All done
+EOF
+
+    rm -f lb-3.multi.zst
+    split -b 1048576 lb-3.dat lb-3.part.
+    for part in lb-3.part.*; do
+        $ZSTD_CMD -q -c $part >> lb-3.multi.zst
+    done
+    rm -f lb-3.part.*
+
+    run_test ./drive_line_buffer -i lb-3.index -n 10 lb-3.multi.zst lb-3.dat
+
+    check_output "Random multi-frame zstd reads don't match input" <<EOF
+All done
+EOF
+fi
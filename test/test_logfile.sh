@@ -814,3 +814,68 @@ run_cap_test env TZ=UTC ${lnav_test} -n \
     -c ';select session_start from ts_value_log' \
     -c ':write-csv-to -' \
     ${test_dir}/logfile_ts_value.0
+
+# The index saved on the first open should be restored on the second and
+# produce the same results.
+export HOME="./index-cache-config"
+export TMPDIR="index-cache-tmp"
+rm -rf ./index-cache-config ./index-cache-tmp
+mkdir -p $HOME/.lnav ./index-cache-tmp
+cp ${test_dir}/logfile_access_log.0 index-cache.0
+
+${lnav_test} -Nn -c ':config /tuning/logfile/index-cache-min-size 1'
+
+run_test ${lnav_test} -n \
+    -c ';SELECT format, lines FROM lnav_file' \
+    -c ':write-csv-to -' \
+    -c ';SELECT log_line, log_time, log_level, log_mark FROM all_logs' \
+    -c ':write-csv-to -' \
+    index-cache.0
+cp $(test_filename) index-cache.first
+
+ls index-cache-tmp/lnav-user-*-work/index-cache/*/*.idx > /dev/null
+on_error_fail_with "index cache was not saved?"
+
+run_test ${lnav_test} -d index-cache.err -n \
+    -c ';SELECT format, lines FROM lnav_file' \
+    -c ':write-csv-to -' \
+    -c ';SELECT log_line, log_time, log_level, log_mark FROM all_logs' \
+    -c ':write-csv-to -' \
+    index-cache.0
+
+check_output "restored index does not match the original" < index-cache.first
+
+grep -q "restored .* from index cache" index-cache.err
+on_error_fail_with "index cache was not restored?"
+
+# Lines indexed in parallel should match the index built by the serial loop.
+# The first part of the file is indexed before the rest is appended so that
+# the format is locked in when the parallel indexer runs.
+rm -f parallel-index-*
+awk 'BEGIN {
+    for (i = 0; i < 3300; i++) {
+        secs = i;
+        if (i % 211 == 0) {
+            secs = (i > 30) ? i - 30 : 0;
+        }
+        if (i > 0 && i % 333 == 0) {
+            printf("garbage line %d\n", i);
+        }
+        printf("192.168.202.%d - - [20/Jul/2009:%02d:%02d:%02d +0000] " \
+               "\"GET /page/%d HTTP/1.0\" %d %d \"-\" \"gPXE/0.9.7\"\n",
+               i % 250, int(secs / 3600), int(secs / 60) % 60, secs % 60,
+               i, (i % 97 == 0) ? 500 : 200, i * 7);
+    }
+}' > parallel-index-full.log
+head -n 300 parallel-index-full.log > parallel-index-head.log
+tail -n +301 parallel-index-full.log > parallel-index-tail.log
+
+./drive_logfile -f access_log -i parallel-index-full.log \
+    > parallel-index-serial.out
+on_error_fail_with "serial index of generated access log failed?"
+
+run_test ./drive_logfile -f access_log -p 4096 -a parallel-index-tail.log \
+    -i parallel-index-head.log
+
+check_output "parallel index does not match the serial index" \
+    < parallel-index-serial.out
@@ -973,3 +973,62 @@ run_cap_test ${lnav_test} -n \
 run_cap_test ${lnav_test} -n \
     -c ";SELECT * FROM all_opids" \
     ${test_dir}/logfile_vpxd.0
+
+check_aggregate() {
+    local msg="$1"
+    local path="$2"
+    local where="$3"
+    local filter="$4"
+    shift 4
+
+    local setup=()
+    if test -n "${filter}"; then
+        setup=(-c ":filter-out ${filter}")
+    fi
+    local agg_where=""
+    local sql_where=""
+    if test -n "${where}"; then
+        agg_where=", '$(echo "${where}" | sed -e "s/'/''/g")'"
+        sql_where="WHERE $(echo "${where}" | sed -e 's/:\([a-z_]*\)/\1/g')"
+    fi
+
+    run_test ${lnav_test} -n \
+        "${setup[@]}" \
+        -c ";SELECT sc_status, cs_method, count(*) AS total, sum(sc_bytes) AS bytes, min(sc_bytes) AS smallest, max(cs_uri_stem) AS last_uri, round(avg(sc_bytes), 3) AS mean FROM access_log ${sql_where} GROUP BY sc_status, cs_method ORDER BY sc_status, cs_method" \
+        -c ":write-csv-to -" \
+        "$@"
+    cp $(test_filename) sql_aggregate.expected
+
+    rm -f sql_aggregate.err
+    run_test ${lnav_test} -d sql_aggregate.err -n \
+        "${setup[@]}" \
+        -c ";SELECT jget(groups, '/sc_status') AS sc_status, jget(groups, '/cs_method') AS cs_method, jget(results, '/total') AS total, jget(results, '/bytes') AS bytes, jget(results, '/smallest') AS smallest, jget(results, '/last_uri') AS last_uri, round(jget(results, '/mean'), 3) AS mean FROM lnav_aggregate('access_log', 'sc_status, cs_method', 'count(*) AS total, sum(sc_bytes) AS bytes, min(sc_bytes) AS smallest, max(cs_uri_stem) AS last_uri, avg(sc_bytes) AS mean'${agg_where}) ORDER BY sc_status, cs_method" \
+        -c ":write-csv-to -" \
+        "$@"
+    check_output "lnav_aggregate does not match GROUP BY -- ${msg}" \
+        < sql_aggregate.expected
+
+    grep -q "aggregate: .* is ${path}" sql_aggregate.err
+    on_error_fail_with "lnav_aggregate did not take the expected path -- ${msg}"
+}
+
+gzip -c ${test_dir}/logfile_shop_access_log.0 > sql_aggregate_access_log.gz
+
+check_aggregate "workers" "read by the workers" "" "" \
+    ${test_dir}/logfile_shop_access_log.0
+
+check_aggregate "workers with a where" "read by the workers" \
+    ":sc_bytes > 5000 AND :cs_method = 'GET'" "" \
+    ${test_dir}/logfile_shop_access_log.0
+
+check_aggregate "workers with a filter" "read by the workers" \
+    ":sc_status != 200" "/image/" \
+    ${test_dir}/logfile_shop_access_log.0
+
+check_aggregate "main thread" "aggregated on the main thread" "" "" \
+    sql_aggregate_access_log.gz
+
+check_aggregate "main thread with a where and filter" \
+    "aggregated on the main thread" \
+    ":sc_bytes BETWEEN 1000 AND 20000" "/image/" \
+    sql_aggregate_access_log.gz
@@ -94,3 +94,161 @@ run_cap_test ${lnav_test} -d sql_index.err -n \
     -c ":write-csv-to -" \
     -c ":switch-to-view log" \
     ${test_dir}/logfile_shop_access_log.0
+
+# The ORDER BY, LIMIT, and OFFSET that are handled by the log tables should
+# return the same rows as SQLite does on its own.  A unary plus on a column
+# keeps SQLite from passing the term down to the table.  The ties in
+# log_time come out of a descending scan in reverse line order.  Any
+# commands in PUSHDOWN_SETUP are run before the queries.
+check_pushdown() {
+    local msg="$1"
+    local pushed="$2"
+    local unpushed="$3"
+    shift 3
+
+    local setup=()
+    if test -n "${PUSHDOWN_SETUP}"; then
+        setup=(-c "${PUSHDOWN_SETUP}")
+    fi
+
+    run_test ${lnav_test} -n \
+        "${setup[@]}" \
+        -c ";${unpushed}" \
+        -c ":write-csv-to -" \
+        "$@"
+    cp $(test_filename) sql_pushdown.expected
+
+    rm -f sql_pushdown.err
+    run_test ${lnav_test} -d sql_pushdown.err -n \
+        "${setup[@]}" \
+        -c ";${pushed}" \
+        -c ":write-csv-to -" \
+        "$@"
+    check_output "${msg}" < sql_pushdown.expected
+
+    grep -q "consuming ORDER BY" sql_pushdown.err
+    on_error_fail_with "ORDER BY was not pushed down -- ${msg}"
+}
+
+check_pushdown "ORDER BY log_time DESC with LIMIT and OFFSET" \
+    "SELECT log_line, log_time, cs_uri_stem FROM access_log ORDER BY log_time DESC LIMIT 7 OFFSET 25" \
+    "SELECT log_line, log_time, cs_uri_stem FROM access_log ORDER BY +log_time DESC, +log_line DESC LIMIT 7 OFFSET 25" \
+    ${test_dir}/logfile_shop_access_log.0
+
+check_pushdown "ORDER BY log_time ASC with LIMIT and OFFSET over files" \
+    "SELECT log_line, log_time, log_format FROM all_logs ORDER BY log_time LIMIT 5 OFFSET 3" \
+    "SELECT log_line, log_time, log_format FROM all_logs ORDER BY +log_time, +log_line LIMIT 5 OFFSET 3" \
+    ${test_dir}/logfile_access_log.* \
+    ${test_dir}/logfile_shop_access_log.0
+
+check_pushdown "lower bound on log_line with ORDER BY log_line DESC" \
+    "SELECT log_line, log_time FROM all_logs WHERE log_line >= 990 ORDER BY log_line DESC" \
+    "SELECT log_line, log_time FROM all_logs WHERE +log_line >= 990 ORDER BY +log_line DESC" \
+    ${test_dir}/logfile_shop_access_log.0
+
+check_pushdown "range on log_line with ORDER BY log_line DESC and LIMIT" \
+    "SELECT log_line, log_time FROM all_logs WHERE log_line >= 100 AND log_line < 200 ORDER BY log_line DESC LIMIT 4 OFFSET 2" \
+    "SELECT log_line, log_time FROM all_logs WHERE +log_line >= 100 AND +log_line < 200 ORDER BY +log_line DESC LIMIT 4 OFFSET 2" \
+    ${test_dir}/logfile_shop_access_log.0
+
+check_pushdown "LIMIT with a constraint that is checked again by SQLite" \
+    "SELECT log_line, log_time, sc_status FROM access_log WHERE sc_status = 404 ORDER BY log_time DESC LIMIT 5 OFFSET 2" \
+    "SELECT log_line, log_time, sc_status FROM access_log WHERE sc_status = 404 ORDER BY +log_time DESC, +log_line DESC LIMIT 5 OFFSET 2" \
+    ${test_dir}/logfile_shop_access_log.0
+
+PUSHDOWN_SETUP=":filter-out /image/" \
+check_pushdown "LIMIT and OFFSET with lines hidden by a filter" \
+    "SELECT log_line, log_time, cs_uri_stem FROM access_log ORDER BY log_time DESC LIMIT 6 OFFSET 10" \
+    "SELECT log_line, log_time, cs_uri_stem FROM access_log ORDER BY +log_time DESC, +log_line DESC LIMIT 6 OFFSET 10" \
+    ${test_dir}/logfile_shop_access_log.0
+
+# The lines found through the column indexes should be the same as the
+# ones found by SQLite checking every row.  Each query is run twice, so
+# the second one uses the index built by the first, and then again after
+# a filter change, which should not rebuild the index since it is kept by
+# the file.
+check_column_index() {
+    local msg="$1"
+    local indexed="$2"
+    local unindexed="$3"
+    shift 3
+
+    run_test ${lnav_test} -n \
+        -c ";${unindexed}" \
+        -c ":write-csv-to -" \
+        -c ";${unindexed}" \
+        -c ":write-csv-to -" \
+        -c ":filter-out /image/" \
+        -c ";${unindexed}" \
+        -c ":write-csv-to -" \
+        "$@"
+    cp $(test_filename) sql_column_index.expected
+
+    rm -f sql_column_index.err
+    run_test ${lnav_test} -d sql_column_index.err -n \
+        -c ";${indexed}" \
+        -c ":write-csv-to -" \
+        -c ";${indexed}" \
+        -c ":write-csv-to -" \
+        -c ":filter-out /image/" \
+        -c ";${indexed}" \
+        -c ":write-csv-to -" \
+        "$@"
+    check_output "${msg}" < sql_column_index.expected
+
+    grep -q "using the column indexes of the files" sql_column_index.err
+    on_error_fail_with "column index was not used -- ${msg}"
+
+    local builds
+    builds=$(grep -c "indexing column values for lines \[0:" \
+        sql_column_index.err)
+    if test "${builds}" -ne 1; then
+        echo "column index was built ${builds} times -- ${msg}"
+        exit 1
+    fi
+}
+
+check_column_index "equality lookup on a column" \
+    "SELECT log_line, c_ip, cs_uri_stem FROM access_log WHERE c_ip = '66.249.66.194'" \
+    "SELECT log_line, c_ip, cs_uri_stem FROM access_log WHERE +c_ip = '66.249.66.194'" \
+    ${test_dir}/logfile_shop_access_log.0
+
+check_column_index "equality lookup with a descending line bound" \
+    "SELECT log_line, c_ip FROM access_log WHERE log_line < 700 AND c_ip = '130.185.74.243' ORDER BY log_line DESC LIMIT 3" \
+    "SELECT log_line, c_ip FROM access_log WHERE +log_line < 700 AND +c_ip = '130.185.74.243' ORDER BY +log_line DESC LIMIT 3" \
+    ${test_dir}/logfile_shop_access_log.0
+
+check_column_index "lookup with no matches" \
+    "SELECT log_line FROM access_log WHERE c_ip = '10.0.0.1'" \
+    "SELECT log_line FROM access_log WHERE +c_ip = '10.0.0.1'" \
+    ${test_dir}/logfile_shop_access_log.0
+
+check_column_index "join between log tables" \
+    "SELECT a.log_line, b.log_line FROM access_log AS a JOIN access_log AS b ON b.c_ip = a.c_ip WHERE a.log_line < 40 ORDER BY 1, 2" \
+    "SELECT a.log_line, b.log_line FROM access_log AS a JOIN access_log AS b ON +b.c_ip = a.c_ip WHERE a.log_line < 40 ORDER BY 1, 2" \
+    ${test_dir}/logfile_shop_access_log.0
+
+# A tiny limit on the size of the column indexes makes the file drop them,
+# but the results should not change.
+export HOME="./column-index-config"
+rm -rf ./column-index-config
+mkdir -p $HOME/.lnav
+
+${lnav_test} -Nn -c ':config /tuning/logfile/value-index-max-size 512'
+
+run_test ${lnav_test} -n \
+    -c ";SELECT log_line, c_ip, cs_uri_stem FROM access_log WHERE +c_ip = '66.249.66.194'" \
+    -c ":write-csv-to -" \
+    ${test_dir}/logfile_shop_access_log.0
+cp $(test_filename) sql_column_index.expected
+
+rm -f sql_column_index.err
+run_test ${lnav_test} -d sql_column_index.err -n \
+    -c ";SELECT log_line, c_ip, cs_uri_stem FROM access_log WHERE c_ip = '66.249.66.194'" \
+    -c ":write-csv-to -" \
+    ${test_dir}/logfile_shop_access_log.0
+check_output "full column indexes changed the results" \
+    < sql_column_index.expected
+
+grep -q "over the size limit" sql_column_index.err
+on_error_fail_with "column indexes were not limited?"